@@ -0,0 +1,665 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Runs a server on the offscreen display with a number of wl_shm clients, each
+ * redrawing its window as fast as frame callbacks allow, and reports:
+ *   - how long the compositor takes over each stage of a frame,
+ *   - commit to present latency, as the server and as the clients see it,
+ *   - CPU time per composited frame, and
+ *   - how much the server's resident memory grows with each client.
+ *
+ * The clients are separate processes, so only the server's own CPU and memory
+ * are counted. Options after "--" go to the server, which runs with
+ * --offscreen; pick a graphics platform providing EGL (and llvmpipe, if there
+ * is no GPU) as for any other server.
+ */
+
+#include "mir/server.h"
+#include "mir/compositor/frame_timings.h"
+#include "mir/time/duration_histogram.h"
+
+#include <wayland-client.h>
+
+#include <boost/throw_exception.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace mc = mir::compositor;
+namespace mt = mir::time;
+
+using namespace std::chrono;
+
+namespace
+{
+struct Options
+{
+    int clients{4};
+    int seconds{10};
+    int width{512};
+    int height{512};
+    bool json{false};
+    std::vector<char const*> server_args;
+};
+
+/// What each client process sends back when it is told to stop
+struct ClientResult
+{
+    uint64_t frames;
+    mt::DurationHistogram::Summary commit_to_frame_done;
+};
+
+void throw_errno(char const* what)
+{
+    BOOST_THROW_EXCEPTION(std::system_error(errno, std::system_category(), what));
+}
+
+/// An endlessly redrawing wl_shell window, drawn to shared memory
+class ShmClient
+{
+public:
+    ShmClient(std::string const& socket_name, int width, int height)
+        : width{width},
+          height{height},
+          display{wl_display_connect(socket_name.c_str())}
+    {
+        if (!display)
+            throw_errno("Failed to connect to the server");
+
+        auto const registry = wl_display_get_registry(display);
+        wl_registry_add_listener(registry, &registry_listener, this);
+        wl_display_roundtrip(display);
+
+        if (!compositor || !shm || !shell)
+            BOOST_THROW_EXCEPTION(std::runtime_error("Server lacks wl_compositor, wl_shm or wl_shell"));
+
+        surface = wl_compositor_create_surface(compositor);
+        auto const shell_surface = wl_shell_get_shell_surface(shell, surface);
+        wl_shell_surface_add_listener(shell_surface, &shell_surface_listener, this);
+        wl_shell_surface_set_toplevel(shell_surface);
+
+        create_buffers();
+    }
+
+    ~ShmClient()
+    {
+        wl_display_disconnect(display);
+    }
+
+    /// Draws until stop becomes readable
+    auto run(int stop) -> ClientResult
+    {
+        draw();
+
+        pollfd fds[]{{wl_display_get_fd(display), POLLIN, 0}, {stop, POLLIN, 0}};
+        for (;;)
+        {
+            while (wl_display_prepare_read(display) != 0)
+                wl_display_dispatch_pending(display);
+            wl_display_flush(display);
+
+            if (poll(fds, 2, -1) < 0 && errno != EINTR)
+                throw_errno("Failed to wait for the server");
+
+            if (fds[1].revents)
+            {
+                wl_display_cancel_read(display);
+                break;
+            }
+
+            if (fds[0].revents & POLLIN)
+                wl_display_read_events(display);
+            else
+                wl_display_cancel_read(display);
+
+            if (wl_display_dispatch_pending(display) < 0)
+                BOOST_THROW_EXCEPTION(std::runtime_error("Lost the connection to the server"));
+        }
+
+        return {frames, latency.summary()};
+    }
+
+private:
+    static int const buffer_count{3};
+
+    struct Buffer
+    {
+        ShmClient* client;
+        wl_buffer* buffer;
+        uint32_t* pixels;
+        bool busy;
+    };
+
+    void create_buffers()
+    {
+        auto const stride = width * 4;
+        auto const buffer_size = stride * height;
+        auto const pool_size = buffer_size * buffer_count;
+
+        char name[] = "/dev/shm/mir-benchmark-XXXXXX";
+        auto const fd = mkostemp(name, O_CLOEXEC);
+        if (fd < 0)
+            throw_errno("Failed to create shared memory");
+        unlink(name);
+
+        if (posix_fallocate(fd, 0, pool_size))
+            throw_errno("Failed to allocate shared memory");
+
+        auto const data = mmap(nullptr, pool_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (data == MAP_FAILED)
+            throw_errno("Failed to map shared memory");
+
+        auto const pool = wl_shm_create_pool(shm, fd, pool_size);
+        close(fd);
+
+        for (int i = 0; i != buffer_count; ++i)
+        {
+            buffers[i].client = this;
+            buffers[i].buffer = wl_shm_pool_create_buffer(
+                pool, i * buffer_size, width, height, stride, WL_SHM_FORMAT_ARGB8888);
+            buffers[i].pixels = reinterpret_cast<uint32_t*>(static_cast<char*>(data) + i * buffer_size);
+            buffers[i].busy = false;
+            wl_buffer_add_listener(buffers[i].buffer, &buffer_listener, &buffers[i]);
+        }
+
+        wl_shm_pool_destroy(pool);
+    }
+
+    void draw()
+    {
+        Buffer* free_buffer{nullptr};
+        for (auto& buffer : buffers)
+        {
+            if (!buffer.busy)
+                free_buffer = &buffer;
+        }
+
+        if (!free_buffer)
+        {
+            waiting_for_buffer = true;
+            return;
+        }
+
+        // Something changes every frame, as in a real client
+        std::fill(free_buffer->pixels, free_buffer->pixels + width * height, 0xff000000 | frames * 0x010101);
+        free_buffer->busy = true;
+
+        auto const callback = wl_surface_frame(surface);
+        wl_callback_add_listener(callback, &frame_listener, this);
+        wl_surface_attach(surface, free_buffer->buffer, 0, 0);
+        wl_surface_damage(surface, 0, 0, width, height);
+
+        committed = steady_clock::now();
+        wl_surface_commit(surface);
+    }
+
+    static void new_global(void* data, wl_registry* registry, uint32_t id, char const* interface, uint32_t)
+    {
+        auto const self = static_cast<ShmClient*>(data);
+
+        if (strcmp(interface, "wl_compositor") == 0)
+            self->compositor = static_cast<wl_compositor*>(wl_registry_bind(registry, id, &wl_compositor_interface, 3));
+        else if (strcmp(interface, "wl_shm") == 0)
+            self->shm = static_cast<wl_shm*>(wl_registry_bind(registry, id, &wl_shm_interface, 1));
+        else if (strcmp(interface, "wl_shell") == 0)
+            self->shell = static_cast<wl_shell*>(wl_registry_bind(registry, id, &wl_shell_interface, 1));
+    }
+
+    static void global_remove(void*, wl_registry*, uint32_t) {}
+
+    static void ping(void*, wl_shell_surface* shell_surface, uint32_t serial)
+    {
+        wl_shell_surface_pong(shell_surface, serial);
+    }
+
+    static void configure(void*, wl_shell_surface*, uint32_t, int32_t, int32_t) {}
+    static void popup_done(void*, wl_shell_surface*) {}
+
+    static void frame_done(void* data, wl_callback* callback, uint32_t)
+    {
+        auto const self = static_cast<ShmClient*>(data);
+        wl_callback_destroy(callback);
+
+        self->latency.record(steady_clock::now() - self->committed);
+        ++self->frames;
+        self->draw();
+    }
+
+    static void buffer_released(void* data, wl_buffer*)
+    {
+        auto const buffer = static_cast<Buffer*>(data);
+        buffer->busy = false;
+
+        if (buffer->client->waiting_for_buffer)
+        {
+            buffer->client->waiting_for_buffer = false;
+            buffer->client->draw();
+        }
+    }
+
+    static wl_registry_listener const registry_listener;
+    static wl_shell_surface_listener const shell_surface_listener;
+    static wl_callback_listener const frame_listener;
+    static wl_buffer_listener const buffer_listener;
+
+    int const width;
+    int const height;
+    wl_display* const display;
+    wl_compositor* compositor{nullptr};
+    wl_shm* shm{nullptr};
+    wl_shell* shell{nullptr};
+    wl_surface* surface{nullptr};
+    Buffer buffers[buffer_count];
+    bool waiting_for_buffer{false};
+
+    steady_clock::time_point committed;
+    mt::DurationHistogram latency;
+    uint64_t frames{0};
+};
+
+wl_registry_listener const ShmClient::registry_listener{&ShmClient::new_global, &ShmClient::global_remove};
+wl_shell_surface_listener const ShmClient::shell_surface_listener{
+    &ShmClient::ping, &ShmClient::configure, &ShmClient::popup_done};
+wl_callback_listener const ShmClient::frame_listener{&ShmClient::frame_done};
+wl_buffer_listener const ShmClient::buffer_listener{&ShmClient::buffer_released};
+
+/// A client process, forked before the server starts so it shares nothing with it
+class ClientProcess
+{
+public:
+    ClientProcess(Options const& options)
+    {
+        int to_client[2];
+        int from_client[2];
+        if (pipe2(to_client, O_CLOEXEC) || pipe2(from_client, O_CLOEXEC))
+            throw_errno("Failed to create pipes");
+
+        pid = fork();
+        if (pid < 0)
+            throw_errno("Failed to fork client");
+
+        if (pid == 0)
+        {
+            close(to_client[1]);
+            close(from_client[0]);
+            _exit(run_client(options, to_client[0], from_client[1]));
+        }
+
+        close(to_client[0]);
+        close(from_client[1]);
+        control = to_client[1];
+        results = from_client[0];
+    }
+
+    ~ClientProcess()
+    {
+        close(control);
+        close(results);
+        waitpid(pid, nullptr, 0);
+    }
+
+    void start(std::string const& socket_name)
+    {
+        auto const message = socket_name + '\n';
+        if (write(control, message.data(), message.size()) != static_cast<ssize_t>(message.size()))
+            throw_errno("Failed to start client");
+    }
+
+    auto stop() -> ClientResult
+    {
+        // Not closing the pipe: the clients forked after this one hold it open too
+        char const stop{'\n'};
+        if (write(control, &stop, 1) != 1)
+            throw_errno("Failed to stop client");
+
+        ClientResult result{};
+        if (read(results, &result, sizeof result) != sizeof result)
+            BOOST_THROW_EXCEPTION(std::runtime_error("Client failed"));
+
+        return result;
+    }
+
+private:
+    static int run_client(Options const& options, int control, int results)
+    {
+        try
+        {
+            std::string socket_name;
+            char c;
+            while (read(control, &c, 1) == 1 && c != '\n')
+                socket_name += c;
+
+            if (socket_name.empty())
+                return EXIT_FAILURE;
+
+            ShmClient client{socket_name, options.width, options.height};
+
+            // Anything more on the control pipe tells us to stop
+            auto const result = client.run(control);
+            return write(results, &result, sizeof result) == sizeof result ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+        catch (std::exception const& error)
+        {
+            std::cerr << "Client failed: " << error.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    pid_t pid;
+    int control;
+    int results;
+};
+
+/// Resident memory, in KiB
+auto resident_kib() -> long
+{
+    std::ifstream status{"/proc/self/status"};
+    for (std::string line; std::getline(status, line);)
+    {
+        if (line.compare(0, 6, "VmRSS:") == 0)
+            return std::stol(line.substr(6));
+    }
+    return 0;
+}
+
+/// CPU time used by the process and by its compositor threads
+struct CpuTimes
+{
+    nanoseconds process;
+    nanoseconds compositor;
+};
+
+auto cpu_times() -> CpuTimes
+{
+    auto const tick = duration_cast<nanoseconds>(seconds{1}) / sysconf(_SC_CLK_TCK);
+
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    auto const process =
+        seconds{usage.ru_utime.tv_sec + usage.ru_stime.tv_sec} +
+        microseconds{usage.ru_utime.tv_usec + usage.ru_stime.tv_usec};
+
+    nanoseconds compositor{0};
+    if (auto const tasks = opendir("/proc/self/task"))
+    {
+        while (auto const task = readdir(tasks))
+        {
+            if (task->d_name[0] == '.')
+                continue;
+
+            std::string const path = std::string{"/proc/self/task/"} + task->d_name;
+
+            std::string name;
+            std::getline(std::ifstream{path + "/comm"}, name);
+            if (name != "Mir/Comp")
+                continue;
+
+            // utime and stime are the 14th and 15th fields, and the name (field 2) may contain spaces
+            std::string stat;
+            std::getline(std::ifstream{path + "/stat"}, stat);
+            std::istringstream fields{stat.substr(stat.rfind(')') + 2)};
+            std::string skipped;
+            for (int field = 3; field != 14; ++field)
+                fields >> skipped;
+
+            long utime{0}, stime{0};
+            fields >> utime >> stime;
+            compositor += (utime + stime) * tick;
+        }
+        closedir(tasks);
+    }
+
+    return {process, compositor};
+}
+
+auto parse(int argc, char const* argv[]) -> Options
+{
+    Options options;
+    options.server_args = {argv[0], "--offscreen"};
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string const arg{argv[i]};
+
+        if (arg == "--")
+        {
+            options.server_args.insert(options.server_args.end(), argv + i + 1, argv + argc);
+            break;
+        }
+        else if (arg == "--json")
+        {
+            options.json = true;
+        }
+        else if (arg == "--clients" && i + 1 < argc)
+        {
+            options.clients = std::atoi(argv[++i]);
+        }
+        else if (arg == "--seconds" && i + 1 < argc)
+        {
+            options.seconds = std::atoi(argv[++i]);
+        }
+        else if (arg == "--size" && i + 1 < argc &&
+                 sscanf(argv[++i], "%dx%d", &options.width, &options.height) == 2)
+        {
+        }
+        else
+        {
+            std::cout<<"Usage: "<<argv[0]<<" [--clients N] [--seconds S] [--size WxH] [--json] [-- <server options>]"
+                     <<std::endl;
+            exit(1);
+        }
+    }
+
+    if (options.clients < 1 || options.seconds < 1 || options.width < 1 || options.height < 1)
+    {
+        std::cout<<"Clients, seconds and size must be positive"<<std::endl;
+        exit(1);
+    }
+
+    return options;
+}
+
+struct Results
+{
+    Options const& options;
+    std::vector<mc::FrameTimings::Summary> stages;
+    uint64_t frames;
+    nanoseconds process_cpu_per_frame;
+    nanoseconds compositor_cpu_per_frame;
+    long kib_per_client;
+    uint64_t client_frames;
+    mt::DurationHistogram::Summary commit_to_frame_done;
+};
+
+void print_table(Results const& results)
+{
+    auto const print = [](std::string const& name, mt::DurationHistogram::Summary const& summary)
+        {
+            std::cout<<name<<"\t"<<summary.count<<"\t"<<summary.mean.count()<<"\t"<<summary.median.count()
+                     <<"\t"<<summary.p90.count()<<"\t"<<summary.p99.count()<<"\t"<<summary.max.count()<<std::endl;
+        };
+
+    std::cout<<"measurement\tcount\tmean (us)\tmedian (us)\tp90 (us)\tp99 (us)\tmax (us)"<<std::endl;
+    for (int stage = 0; stage != mc::FrameTimings::stage_count; ++stage)
+        print(mc::FrameTimings::name_of(static_cast<mc::FrameTimings::Stage>(stage)), results.stages[stage]);
+    print("client commit to frame done", results.commit_to_frame_done);
+
+    std::cout<<std::endl;
+    std::cout<<"clients\t"<<results.options.clients<<std::endl;
+    std::cout<<"frames composited\t"<<results.frames<<std::endl;
+    std::cout<<"client frames\t"<<results.client_frames<<std::endl;
+    std::cout<<"server CPU per frame (us)\t"<<duration_cast<microseconds>(results.process_cpu_per_frame).count()
+             <<std::endl;
+    std::cout<<"compositor CPU per frame (us)\t"
+             <<duration_cast<microseconds>(results.compositor_cpu_per_frame).count()<<std::endl;
+    std::cout<<"server memory per client (KiB)\t"<<results.kib_per_client<<std::endl;
+}
+
+void print_json(Results const& results)
+{
+    std::cout<<"{\"clients\":"<<results.options.clients
+             <<",\"seconds\":"<<results.options.seconds
+             <<",\"width\":"<<results.options.width
+             <<",\"height\":"<<results.options.height
+             <<",\"frames\":"<<results.frames
+             <<",\"client_frames\":"<<results.client_frames
+             <<",\"server_cpu_per_frame_us\":"<<duration_cast<microseconds>(results.process_cpu_per_frame).count()
+             <<",\"compositor_cpu_per_frame_us\":"
+             <<duration_cast<microseconds>(results.compositor_cpu_per_frame).count()
+             <<",\"server_memory_per_client_kib\":"<<results.kib_per_client
+             <<",\"stages\":{";
+    for (int stage = 0; stage != mc::FrameTimings::stage_count; ++stage)
+    {
+        std::cout<<(stage ? "," : "")<<"\""
+                 <<mc::FrameTimings::name_of(static_cast<mc::FrameTimings::Stage>(stage))<<"\":";
+        mt::write_json(std::cout, results.stages[stage]);
+    }
+    std::cout<<"},\"client_commit_to_frame_done\":";
+    mt::write_json(std::cout, results.commit_to_frame_done);
+    std::cout<<"}"<<std::endl;
+}
+
+/// Merges summaries, weighting by their sample counts; the tail percentiles are the worst of them
+auto merge(std::vector<mt::DurationHistogram::Summary> const& summaries) -> mt::DurationHistogram::Summary
+{
+    mt::DurationHistogram::Summary merged{};
+    for (auto const& summary : summaries)
+    {
+        auto const total = merged.count + summary.count;
+        if (!total)
+            continue;
+
+        auto const weighted = [&](microseconds a, microseconds b)
+            { return microseconds{(a.count() * merged.count + b.count() * summary.count) / total}; };
+
+        merged.mean = weighted(merged.mean, summary.mean);
+        merged.median = weighted(merged.median, summary.median);
+        merged.p90 = weighted(merged.p90, summary.p90);
+        merged.p99 = std::max(merged.p99, summary.p99);
+        merged.p999 = std::max(merged.p999, summary.p999);
+        merged.max = std::max(merged.max, summary.max);
+        merged.count = total;
+    }
+    return merged;
+}
+}
+
+int main(int argc, char const* argv[])
+{
+    auto const options = parse(argc, argv);
+
+    // Before the server has any threads
+    std::vector<std::unique_ptr<ClientProcess>> clients;
+    for (int i = 0; i != options.clients; ++i)
+        clients.push_back(std::make_unique<ClientProcess>(options));
+
+    // Without a GPU, use llvmpipe
+    setenv("LIBGL_ALWAYS_SOFTWARE", "1", 0);
+    // So the server picks a free socket name
+    unsetenv("WAYLAND_DISPLAY");
+
+    // The server keeps these for as long as it runs
+    auto server_args = options.server_args;
+    mir::Server server;
+    server.set_command_line(server_args.size(), server_args.data());
+
+    std::promise<void> started;
+    server.add_init_callback([&] { started.set_value(); });
+    server.apply_settings();
+
+    std::thread server_thread{[&] { server.run(); }};
+    if (started.get_future().wait_for(seconds{30}) != std::future_status::ready)
+    {
+        std::cerr<<"Server failed to start"<<std::endl;
+        exit(1);
+    }
+
+    auto const socket_name = server.wayland_display().value();
+    auto const frame_timings = server.the_frame_timings();
+    auto const kib_before_clients = resident_kib();
+
+    for (auto const& client : clients)
+        client->start(socket_name);
+
+    // Let the clients connect and settle before measuring
+    std::this_thread::sleep_for(seconds{1});
+    auto const kib_with_clients = resident_kib();
+    frame_timings->reset();
+    auto const cpu_before = cpu_times();
+
+    std::this_thread::sleep_for(seconds{options.seconds});
+
+    auto const cpu_after = cpu_times();
+    Results results{options, {}, 0, {}, {}, (kib_with_clients - kib_before_clients) / options.clients, 0, {}};
+
+    auto const outputs = frame_timings->outputs();
+    for (int stage = 0; stage != mc::FrameTimings::stage_count; ++stage)
+    {
+        std::vector<mc::FrameTimings::Summary> per_output;
+        for (auto const output : outputs)
+            per_output.push_back(frame_timings->summary(output, static_cast<mc::FrameTimings::Stage>(stage)));
+        results.stages.push_back(merge(per_output));
+    }
+    results.frames = results.stages[static_cast<int>(mc::FrameTimings::Stage::render)].count;
+
+    std::vector<ClientResult> client_results;
+    for (auto const& client : clients)
+        client_results.push_back(client->stop());
+    clients.clear();
+
+    std::vector<mt::DurationHistogram::Summary> client_latencies;
+    for (auto const& result : client_results)
+    {
+        results.client_frames += result.frames;
+        client_latencies.push_back(result.commit_to_frame_done);
+    }
+    results.commit_to_frame_done = merge(client_latencies);
+
+    if (results.frames)
+    {
+        results.process_cpu_per_frame = (cpu_after.process - cpu_before.process) / results.frames;
+        results.compositor_cpu_per_frame = (cpu_after.compositor - cpu_before.compositor) / results.frames;
+    }
+
+    server.stop();
+    server_thread.join();
+
+    if (options.json)
+        print_json(results);
+    else
+        print_table(results);
+
+    exit(0);
+}
@@ -0,0 +1,146 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/input/surface_input_dispatcher.h"
+#include "mir/input/input_latencies.h"
+#include "mir/input/scene.h"
+#include "mir/input/surface.h"
+#include "mir/events/event_builders.h"
+#include "mir/time/steady_clock.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+namespace mi = mir::input;
+namespace mev = mir::events;
+namespace geom = mir::geometry;
+
+using namespace std::chrono;
+
+namespace
+{
+class BenchmarkSurface : public mi::Surface
+{
+public:
+    BenchmarkSurface(geom::Rectangle const& area)
+        : area{area}
+    {
+    }
+
+    std::string name() const override { return {}; }
+    geom::Rectangle input_bounds() const override { return area; }
+    bool input_area_contains(geom::Point const& point) const override { return area.contains(point); }
+    std::shared_ptr<mir::graphics::CursorImage> cursor_image() const override { return nullptr; }
+    mi::InputReceptionMode reception_mode() const override { return mi::InputReceptionMode::normal; }
+
+    void consume(MirEvent const* event) override
+    {
+        auto const pev = mir_input_event_get_pointer_event(mir_event_get_input_event(event));
+        position_sum += mir_pointer_event_axis_value(pev, mir_pointer_axis_x);
+    }
+
+    float position_sum{0};
+
+private:
+    geom::Rectangle const area;
+};
+
+class BenchmarkScene : public mi::Scene
+{
+public:
+    BenchmarkScene(std::shared_ptr<mi::Surface> const& surface)
+        : surface{surface}
+    {
+    }
+
+    void for_each(std::function<void(std::shared_ptr<mi::Surface> const&)> const& callback) override
+    {
+        callback(surface);
+    }
+
+    void add_observer(std::shared_ptr<mir::scene::Observer> const&) override {}
+    void remove_observer(std::weak_ptr<mir::scene::Observer> const&) override {}
+    void add_input_visualization(std::shared_ptr<mir::graphics::Renderable> const&) override {}
+    void remove_input_visualization(std::weak_ptr<mir::graphics::Renderable> const&) override {}
+    void emit_scene_changed() override {}
+
+private:
+    std::shared_ptr<mi::Surface> const surface;
+};
+
+auto motion_to(int i) -> mir::EventUPtr
+{
+    return mev::make_event(MirInputDeviceId{1}, nanoseconds{i}, std::vector<uint8_t>{}, mir_input_event_modifier_none,
+        mir_pointer_action_motion, 0, 100.0f + i % 200, 100.0f + i % 100, 0.0f, 0.0f, 1.0f, 1.0f);
+}
+
+template<typename Operation>
+auto events_per_second(int events, Operation const& operation) -> long
+{
+    auto const start = steady_clock::now();
+    for (int i = 0; i != events; ++i)
+        operation(i);
+    auto const duration = duration_cast<nanoseconds>(steady_clock::now() - start);
+
+    return duration.count() ? static_cast<long>(events * 1.0e9 / duration.count()) : 0;
+}
+
+auto dispatch_rate(int events, geom::Point const& surface_position) -> long
+{
+    auto const surface = std::make_shared<BenchmarkSurface>(geom::Rectangle{surface_position, {1920, 1080}});
+    auto const latencies = std::make_shared<mi::InputLatencies>(std::make_shared<mir::time::SteadyClock>());
+    mi::SurfaceInputDispatcher dispatcher{std::make_shared<BenchmarkScene>(surface), latencies};
+    dispatcher.start();
+
+    auto const rate = events_per_second(events, [&](int i) { dispatcher.dispatch(motion_to(i)); });
+
+    // Keep the deliveries from being optimised away
+    if (surface->position_sum < 0)
+        std::abort();
+
+    dispatcher.stop();
+    return rate;
+}
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 2)
+    {
+        std::cout<<"Usage: "<<argv[0]<<" <events per measurement>"<<std::endl;
+        exit(1);
+    }
+
+    int const events = std::atoi(argv[1]);
+
+    auto const event = motion_to(0);
+    unsigned built = 0;
+
+    std::cout<<"measurement\tevents/s"<<std::endl;
+    std::cout<<"make_event\t"<<events_per_second(events, [&](int i) { built += !!motion_to(i); })<<std::endl;
+    std::cout<<"clone_event\t"<<events_per_second(events, [&](int) { built += !!mev::clone_event(*event); })<<std::endl;
+    std::cout<<"dispatch to a surface at the origin\t"<<dispatch_rate(events, {0, 0})<<std::endl;
+    std::cout<<"dispatch to a surface needing a copy\t"<<dispatch_rate(events, {20, 20})<<std::endl;
+
+    // Keep the events from being optimised away
+    if (built != 2u * events)
+        std::abort();
+
+    exit(0);
+}
@@ -0,0 +1,210 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Passes touch events from one thread to another, the way the server passes them to a client: serialized and written
+ * to a socket, and through a shared-memory event ring. Measures the latency from sending each event to the reader
+ * having deserialized it, both with the reader woken for each event (as for a finger moving at the display's rate)
+ * and with a burst of events sent as fast as they can be.
+ */
+
+#include "mir/events/event.h"
+#include "mir/events/event_builders.h"
+#include "mir/events/event_ring.h"
+#include "mir/events/input_event.h"
+#include "mir/time/duration_histogram.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace mev = mir::events;
+namespace mt = mir::time;
+
+using namespace std::chrono;
+
+namespace
+{
+auto const interval = milliseconds{2};
+
+/// A touch event, stamped with when it was sent
+auto make_touch(int i) -> mir::EventUPtr
+{
+    auto event = mev::make_event(
+        MirInputDeviceId{1},
+        duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()),
+        {},
+        mir_input_event_modifier_none);
+
+    for (int touch = 0; touch != 2; ++touch)
+    {
+        mev::add_touch(
+            *event, touch, mir_touch_action_change, mir_touch_tooltype_finger,
+            100.0f + i % 500, 200.0f + touch * 50, 1.0f, 10.0f, 10.0f, 10.0f);
+    }
+
+    return event;
+}
+
+void record(mt::DurationHistogram& latency, MirEvent const& event)
+{
+    auto const sent = nanoseconds{event.to_input()->event_time()};
+    latency.record(steady_clock::now().time_since_epoch() - sent);
+}
+
+void wait_for(int fd)
+{
+    pollfd pfd{fd, POLLIN, 0};
+    poll(&pfd, 1, -1);
+}
+
+/// Sends count events, at the given interval, to a reader, which calls received() for each
+auto measure(
+    int count,
+    milliseconds interval,
+    std::function<void(MirEvent const&)> const& send,
+    std::function<void(std::function<void(MirEvent const&)> const&)> const& receive) -> mt::DurationHistogram::Summary
+{
+    mt::DurationHistogram latency;
+
+    std::thread reader{[&]
+        {
+            int received{0};
+            while (received != count)
+            {
+                receive([&](MirEvent const& event)
+                    {
+                        record(latency, event);
+                        ++received;
+                    });
+            }
+        }};
+
+    for (int i = 0; i != count; ++i)
+    {
+        send(*make_touch(i));
+
+        if (interval != milliseconds::zero())
+            std::this_thread::sleep_for(interval);
+    }
+
+    reader.join();
+    return latency.summary();
+}
+
+auto over_socket(int count, milliseconds interval) -> mt::DurationHistogram::Summary
+{
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) < 0)
+    {
+        std::cerr<<"Failed to create socket pair"<<std::endl;
+        exit(1);
+    }
+    mir::Fd const writer{fds[0]};
+    mir::Fd const reader{fds[1]};
+
+    // Like the RPC channel: a size, then the serialized event, in one write
+    auto const send = [&](MirEvent const& event)
+        {
+            auto const bytes = MirEvent::serialize(&event);
+            uint32_t const size = bytes.size();
+            iovec iov[]{{const_cast<uint32_t*>(&size), sizeof size}, {const_cast<char*>(bytes.data()), bytes.size()}};
+            if (writev(writer, iov, 2) != static_cast<ssize_t>(sizeof size + bytes.size()))
+                exit(1);
+        };
+
+    auto const receive = [&](std::function<void(MirEvent const&)> const& received)
+        {
+            wait_for(reader);
+
+            uint32_t size;
+            if (read(reader, &size, sizeof size) != sizeof size)
+                exit(1);
+
+            std::string bytes(size, '\0');
+            for (size_t done = 0; done != size;)
+            {
+                auto const result = read(reader, &bytes[done], size - done);
+                if (result <= 0)
+                    exit(1);
+                done += result;
+            }
+
+            received(*MirEvent::deserialize(bytes));
+        };
+
+    return measure(count, interval, send, receive);
+}
+
+auto through_ring(int count, milliseconds interval) -> mt::DurationHistogram::Summary
+{
+    // Big enough that a burst isn't dropped: we're measuring latency, not overruns
+    mev::EventRing writer{size_t(count) * 512};
+    mev::EventRing reader{writer.shm_fd(), writer.notify_fd()};
+
+    auto const send = [&](MirEvent const& event)
+        {
+            writer.push(MirEvent::serialized_size(&event), [&](void* data) { MirEvent::serialize_into(&event, data); });
+        };
+
+    auto const receive = [&](std::function<void(MirEvent const&)> const& received)
+        {
+            wait_for(reader.notify_fd());
+            reader.consume([&](void const* data, size_t size) { received(*MirEvent::deserialize(data, size)); });
+        };
+
+    auto const result = measure(count, interval, send, receive);
+
+    if (writer.dropped())
+        std::cerr<<writer.dropped()<<" event(s) dropped"<<std::endl;
+
+    return result;
+}
+
+void print(std::string const& name, mt::DurationHistogram::Summary const& summary)
+{
+    std::cout<<name<<"\t"<<summary.count<<"\t"<<summary.mean.count()<<"\t"<<summary.median.count()
+             <<"\t"<<summary.p90.count()<<"\t"<<summary.p99.count()<<"\t"<<summary.max.count()<<std::endl;
+}
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 2 || std::atoi(argv[1]) < 1)
+    {
+        std::cout<<"Usage: "<<argv[0]<<" <events per measurement>"<<std::endl;
+        exit(1);
+    }
+
+    int const events = std::atoi(argv[1]);
+
+    std::cout<<"touch event latency\tevents\tmean (us)\tmedian (us)\tp90 (us)\tp99 (us)\tmax (us)"<<std::endl;
+    print("socket, one at a time", over_socket(events, interval));
+    print("ring, one at a time", through_ring(events, interval));
+    print("socket, burst", over_socket(events, milliseconds::zero()));
+    print("ring, burst", through_ring(events, milliseconds::zero()));
+
+    exit(0);
+}
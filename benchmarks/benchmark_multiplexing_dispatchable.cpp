@@ -18,21 +18,28 @@
 
 #include "mir/dispatch/multiplexing_dispatchable.h"
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <iostream>
-#include <vector>
 #include <memory>
-#include <chrono>
+#include <system_error>
 #include <thread>
+#include <vector>
 #include <poll.h>
 #include <unistd.h>
 
 namespace md = mir::dispatch;
 
-class TestDispatchable : public md::Dispatchable
+using Clock = std::chrono::steady_clock;
+
+namespace
+{
+// Stands in for an input device: each event is a timestamp written by a producer
+class TimestampSource : public md::Dispatchable
 {
 public:
-    TestDispatchable(uint64_t limit)
-        : dispatch_limit{limit}
+    TimestampSource()
     {
         int pipefds[2];
         if (pipe(pipefds) < 0)
@@ -42,11 +49,14 @@ public:
 
         read_fd = mir::Fd{pipefds[0]};
         write_fd = mir::Fd{pipefds[1]};
+    }
 
-        char dummy{0};
-        if (::write(write_fd, &dummy, sizeof(dummy)) != sizeof(dummy))
+    void produce()
+    {
+        int64_t const now = Clock::now().time_since_epoch().count();
+        if (::write(write_fd, &now, sizeof(now)) != sizeof(now))
         {
-            throw std::system_error{errno, std::system_category(), "Failed to mark dispatchable"};
+            throw std::system_error{errno, std::system_category(), "Failed to write event"};
         }
     }
 
@@ -54,60 +64,75 @@ public:
     {
         return read_fd;
     }
+
     bool dispatch(md::FdEvents) override
     {
-        ++dispatch_count;
-        return (dispatch_count < dispatch_limit);
+        int64_t sent;
+        if (::read(read_fd, &sent, sizeof(sent)) != sizeof(sent))
+        {
+            throw std::system_error{errno, std::system_category(), "Failed to read event"};
+        }
+
+        total_latency += Clock::now().time_since_epoch().count() - sent;
+        ++dispatched;
+        return true;
     }
+
     md::FdEvents relevant_events() const override
     {
         return md::FdEvent::readable;
     }
 
+    static std::atomic<uint64_t> dispatched;
+    static std::atomic<int64_t> total_latency;
+
 private:
-    static thread_local uint64_t dispatch_count;
-    uint64_t const dispatch_limit;
     mir::Fd read_fd, write_fd;
 };
 
-thread_local uint64_t TestDispatchable::dispatch_count = 0;
+std::atomic<uint64_t> TimestampSource::dispatched{0};
+std::atomic<int64_t> TimestampSource::total_latency{0};
 
-bool fd_is_readable(int fd)
+struct Result
 {
-    struct pollfd poller {
-        fd,
-        POLLIN,
-        0
-    };
-    return poll(&poller, 1, 0);
-}
+    double events_per_second;
+    int64_t mean_latency_ns;
+};
 
-int main(int argc, char** argv)
+Result run(int thread_count, int batch_size, int source_count, uint64_t event_count)
 {
-    if (argc != 3)
+    TimestampSource::dispatched = 0;
+    TimestampSource::total_latency = 0;
+
+    auto const dispatcher = std::make_shared<md::MultiplexingDispatchable>(batch_size);
+    std::vector<std::shared_ptr<TimestampSource>> sources;
+    for (int i = 0; i != source_count; ++i)
     {
-        std::cout<<"Usage: "<<argv[0]<<" <number of threads> <dispatch count>"<<std::endl;
-        exit(1);
+        sources.push_back(std::make_shared<TimestampSource>());
+        dispatcher->add_watch(sources.back());
     }
 
-    int const thread_count = std::atoi(argv[1]);
-    uint64_t const dispatch_count = std::atoll(argv[2]);
-
-    auto dispatcher = std::make_shared<md::MultiplexingDispatchable>();
-    dispatcher->add_watch(std::make_shared<TestDispatchable>(dispatch_count / thread_count), md::DispatchReentrancy::reentrant);
-
-    auto start = std::chrono::steady_clock::now();
+    auto const start = Clock::now();
 
     std::vector<std::thread> thread_loops;
     for (int i = 0; i < thread_count; ++i)
     {
-        thread_loops.emplace_back([](md::Dispatchable& dispatch)
-        {
-            while(fd_is_readable(dispatch.watch_fd()))
+        thread_loops.emplace_back([&dispatcher, event_count]()
             {
-                dispatch.dispatch(md::FdEvent::readable);
-            }
-        }, std::ref(*dispatcher));
+                pollfd poller{dispatcher->watch_fd(), POLLIN, 0};
+                while (TimestampSource::dispatched < event_count)
+                {
+                    if (poll(&poller, 1, 10) > 0)
+                        dispatcher->dispatch(md::FdEvent::readable);
+                }
+            });
+    }
+
+    // Events arrive in bursts across all sources, as from a high-rate pointer
+    // plus a multitouch panel
+    for (uint64_t produced = 0; produced < event_count; ++produced)
+    {
+        sources[produced % source_count]->produce();
     }
 
     for (auto& thread : thread_loops)
@@ -115,7 +140,38 @@ int main(int argc, char** argv)
         thread.join();
     }
 
-    auto duration = std::chrono::steady_clock::now() - start;
-    std::cout<<"Dispatching "<<dispatch_count<<" times took "<<std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()<<"ns"<<std::endl;
+    auto const duration = std::chrono::duration<double>(Clock::now() - start);
+    return Result{
+        event_count / duration.count(),
+        TimestampSource::total_latency / static_cast<int64_t>(event_count)};
+}
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 5)
+    {
+        std::cout<<"Usage: "<<argv[0]<<" <max number of threads> <number of sources> <batch size> <event count>"<<std::endl;
+        exit(1);
+    }
+
+    int const max_threads = std::atoi(argv[1]);
+    int const source_count = std::atoi(argv[2]);
+    int const batch_size = std::atoi(argv[3]);
+    uint64_t const event_count = std::atoll(argv[4]);
+
+    std::cout<<"threads\tbatch\tevents/s\tmean latency (ns)"<<std::endl;
+    for (int threads = 1; threads <= max_threads; threads *= 2)
+    {
+        for (auto const batch : {1, batch_size})
+        {
+            auto const result = run(threads, batch, source_count, event_count);
+            std::cout<<threads<<"\t"<<batch<<"\t"<<static_cast<uint64_t>(result.events_per_second)
+                     <<"\t"<<result.mean_latency_ns<<std::endl;
+
+            if (batch_size == 1)
+                break;
+        }
+    }
     exit(0);
 }
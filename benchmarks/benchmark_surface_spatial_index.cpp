@@ -0,0 +1,131 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/input/surface_spatial_index.h"
+#include "mir/input/surface.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace mi = mir::input;
+namespace geom = mir::geometry;
+
+namespace
+{
+class BenchmarkSurface : public mi::Surface
+{
+public:
+    BenchmarkSurface(geom::Rectangle const& area)
+        : area{area}
+    {
+    }
+
+    std::string name() const override { return {}; }
+    geom::Rectangle input_bounds() const override { return area; }
+    bool input_area_contains(geom::Point const& point) const override { return area.contains(point); }
+    std::shared_ptr<mir::graphics::CursorImage> cursor_image() const override { return nullptr; }
+    mi::InputReceptionMode reception_mode() const override { return mi::InputReceptionMode::normal; }
+    void consume(MirEvent const*) override {}
+
+private:
+    geom::Rectangle const area;
+};
+
+// What SurfaceInputDispatcher did before it had an index
+std::shared_ptr<mi::Surface> linear_search(
+    std::vector<std::shared_ptr<mi::Surface>> const& surfaces,
+    geom::Point const& point)
+{
+    std::shared_ptr<mi::Surface> top_target;
+    for (auto const& surface : surfaces)
+    {
+        if (surface->input_area_contains(point))
+            top_target = surface;
+    }
+    return top_target;
+}
+
+template<typename Search>
+std::chrono::nanoseconds time_per_lookup(std::vector<geom::Point> const& points, Search const& search)
+{
+    unsigned found = 0;
+    auto const start = std::chrono::steady_clock::now();
+    for (auto const& point : points)
+    {
+        if (search(point))
+            ++found;
+    }
+    auto const duration = std::chrono::steady_clock::now() - start;
+
+    // Keep the searches from being optimised away
+    if (found > points.size())
+        std::abort();
+
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(duration) / points.size();
+}
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 3)
+    {
+        std::cout<<"Usage: "<<argv[0]<<" <max surface count> <lookups per count>"<<std::endl;
+        exit(1);
+    }
+
+    int const max_surfaces = std::atoi(argv[1]);
+    int const lookups = std::atoi(argv[2]);
+
+    // Windows of typical sizes scattered over a 4K desktop
+    geom::Size const desktop{3840, 2160};
+    std::mt19937 generator{42};
+    std::uniform_int_distribution<int> width{200, 1200};
+    std::uniform_int_distribution<int> height{150, 900};
+    std::uniform_int_distribution<int> x{0, desktop.width.as_int()};
+    std::uniform_int_distribution<int> y{0, desktop.height.as_int()};
+
+    std::vector<geom::Point> points;
+    for (int i = 0; i != lookups; ++i)
+        points.emplace_back(x(generator), y(generator));
+
+    std::vector<std::shared_ptr<mi::Surface>> surfaces;
+    mi::SurfaceSpatialIndex index;
+
+    std::cout<<"surfaces\tlinear (ns/lookup)\tindexed (ns/lookup)"<<std::endl;
+    for (int count = 1; count <= max_surfaces; count *= 2)
+    {
+        while (static_cast<int>(surfaces.size()) < count)
+        {
+            surfaces.push_back(std::make_shared<BenchmarkSurface>(geom::Rectangle{
+                {x(generator), y(generator)},
+                {width(generator), height(generator)}}));
+        }
+        index.rebuild(surfaces);
+
+        auto const linear = time_per_lookup(
+            points, [&](geom::Point const& point) { return linear_search(surfaces, point); });
+        auto const indexed = time_per_lookup(
+            points, [&](geom::Point const& point) { return index.surface_at(point); });
+
+        std::cout<<count<<"\t"<<linear.count()<<"\t"<<indexed.count()<<std::endl;
+    }
+
+    exit(0);
+}
@@ -0,0 +1,163 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/thread/mpsc_queue.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mth = mir::thread;
+
+using Clock = std::chrono::steady_clock;
+using Work = std::function<void()>;
+
+namespace
+{
+// What WaylandExecutor and BasicThreadPool used before the lock-free queue
+class LockedQueue
+{
+public:
+    void push(Work&& work)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        queue.push_back(std::move(work));
+    }
+
+    auto pop() -> std::experimental::optional<Work>
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        if (queue.empty())
+            return {};
+
+        std::experimental::optional<Work> work{std::move(queue.front())};
+        queue.pop_front();
+        return work;
+    }
+
+private:
+    std::mutex mutex;
+    std::deque<Work> queue;
+};
+
+struct Result
+{
+    double items_per_second;
+    std::chrono::nanoseconds median;
+    std::chrono::nanoseconds p99;
+    std::chrono::nanoseconds p999;
+};
+
+// Producers (standing in for compositor threads) queue work that records how long it waited to be run;
+// a single consumer (standing in for the Wayland thread) runs it as soon as it can. With no interval the
+// producers queue as fast as they can, which measures throughput; with an interval the queue stays short and
+// the latencies are those of the hop between threads.
+template<typename Queue>
+auto measure(int producers, int items_per_producer, std::chrono::nanoseconds interval) -> Result
+{
+    Queue queue;
+    int const total = producers * items_per_producer;
+
+    std::vector<std::chrono::nanoseconds> latencies;
+    latencies.reserve(total);
+
+    auto const start = Clock::now();
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i != producers; ++i)
+    {
+        threads.emplace_back(
+            [&queue, &latencies, items_per_producer, interval]
+            {
+                auto next = Clock::now();
+                for (int item = 0; item != items_per_producer; ++item)
+                {
+                    // Spin rather than sleep, so the timing isn't at the mercy of the scheduler
+                    while (Clock::now() < next)
+                    {
+                    }
+                    next += interval;
+
+                    queue.push(
+                        [&latencies, queued = Clock::now()]
+                        {
+                            latencies.push_back(Clock::now() - queued);
+                        });
+                }
+            });
+    }
+
+    while (static_cast<int>(latencies.size()) != total)
+    {
+        if (auto work = queue.pop())
+            work.value()();
+    }
+
+    auto const duration = Clock::now() - start;
+
+    for (auto& thread : threads)
+        thread.join();
+
+    std::sort(latencies.begin(), latencies.end());
+    auto const percentile = [&](double p) { return latencies[static_cast<size_t>(p * (total - 1))]; };
+
+    return Result{
+        total / std::chrono::duration<double>(duration).count(),
+        percentile(0.5),
+        percentile(0.99),
+        percentile(0.999)};
+}
+
+void report(char const* name, int producers, std::chrono::nanoseconds interval, Result const& result)
+{
+    std::cout<<name<<"\t"<<producers<<"\t"<<interval.count()<<"\t"
+             <<static_cast<long>(result.items_per_second)<<"\t"
+             <<result.median.count()<<"\t"
+             <<result.p99.count()<<"\t"
+             <<result.p999.count()<<std::endl;
+}
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 4)
+    {
+        std::cout<<"Usage: "<<argv[0]<<" <max producer threads> <items per producer> <interval (ns)>"<<std::endl;
+        exit(1);
+    }
+
+    int const max_producers = std::atoi(argv[1]);
+    int const items_per_producer = std::atoi(argv[2]);
+    std::chrono::nanoseconds const paced{std::atol(argv[3])};
+
+    std::cout<<"queue\tproducers\tinterval (ns)\titems/s\tmedian (ns)\tp99 (ns)\tp99.9 (ns)"<<std::endl;
+    for (int producers = 1; producers <= max_producers; producers *= 2)
+    {
+        for (auto const interval : {std::chrono::nanoseconds{0}, paced})
+        {
+            report("locked", producers, interval, measure<LockedQueue>(producers, items_per_producer, interval));
+            report("mpsc", producers, interval, measure<mth::MpscQueue<Work>>(producers, items_per_producer, interval));
+        }
+    }
+
+    exit(0);
+}
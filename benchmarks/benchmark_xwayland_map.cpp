@@ -0,0 +1,230 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Maps windows on $DISPLAY and measures how long each takes to be exposed, with the X server otherwise quiet and
+ * while another client changes _NET_WM_NAME as fast as it can, as some legacy apps do.
+ *
+ * Run it against Mir's Xwayland to measure its window manager, and against Xvfb (which has no window manager) for a
+ * baseline. Normal windows are mapped by the window manager, override-redirect ones (menus, tooltips) by the X server
+ * alone, though the window manager still manages both.
+ */
+
+#include "mir/time/duration_histogram.h"
+
+#include <xcb/xcb.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <poll.h>
+
+namespace mt = mir::time;
+
+using namespace std::chrono;
+
+namespace
+{
+auto const expose_timeout = seconds{5};
+
+auto connect() -> xcb_connection_t*
+{
+    auto const connection = xcb_connect(nullptr, nullptr);
+    if (xcb_connection_has_error(connection))
+    {
+        std::cerr<<"Failed to connect to $DISPLAY"<<std::endl;
+        exit(1);
+    }
+    return connection;
+}
+
+auto intern(xcb_connection_t* connection, char const* name) -> xcb_atom_t
+{
+    auto const reply = xcb_intern_atom_reply(
+        connection,
+        xcb_intern_atom(connection, 0, strlen(name), name),
+        nullptr);
+    auto const atom = reply ? reply->atom : XCB_ATOM_NONE;
+    free(reply);
+    return atom;
+}
+
+auto create_window(xcb_connection_t* connection, bool override_redirect) -> xcb_window_t
+{
+    auto const screen = xcb_setup_roots_iterator(xcb_get_setup(connection)).data;
+    auto const window = xcb_generate_id(connection);
+
+    uint32_t const values[]{
+        override_redirect,
+        XCB_EVENT_MASK_EXPOSURE | XCB_EVENT_MASK_STRUCTURE_NOTIFY};
+
+    xcb_create_window(
+        connection,
+        XCB_COPY_FROM_PARENT,
+        window,
+        screen->root,
+        0, 0, 200, 100,
+        0,
+        XCB_WINDOW_CLASS_INPUT_OUTPUT,
+        screen->root_visual,
+        XCB_CW_OVERRIDE_REDIRECT | XCB_CW_EVENT_MASK,
+        values);
+
+    return window;
+}
+
+/// Changes the name of a window of its own, as fast as the X server takes it, until destroyed
+class PropertySpammer
+{
+public:
+    PropertySpammer()
+        : thread{[this] { run(); }}
+    {
+    }
+
+    ~PropertySpammer()
+    {
+        stopping = true;
+        thread.join();
+    }
+
+private:
+    void run()
+    {
+        auto const connection = connect();
+        auto const net_wm_name = intern(connection, "_NET_WM_NAME");
+        auto const utf8_string = intern(connection, "UTF8_STRING");
+
+        auto const window = create_window(connection, false);
+        xcb_map_window(connection, window);
+
+        for (uint64_t i = 0; !stopping; ++i)
+        {
+            auto const name = "Spinner " + std::to_string(i);
+            xcb_change_property(
+                connection, XCB_PROP_MODE_REPLACE, window, net_wm_name, utf8_string, 8, name.size(), name.c_str());
+
+            // A round trip now and then, so we don't queue up more than the X server can take
+            if (i % 100 == 0)
+                free(xcb_get_input_focus_reply(connection, xcb_get_input_focus(connection), nullptr));
+        }
+
+        xcb_disconnect(connection);
+    }
+
+    std::atomic<bool> stopping{false};
+    std::thread thread;
+};
+
+/// Waits for the window to be exposed, returning false if it isn't in time
+auto wait_for_expose(xcb_connection_t* connection, xcb_window_t window) -> bool
+{
+    auto const deadline = steady_clock::now() + expose_timeout;
+
+    for (;;)
+    {
+        while (auto const event = xcb_poll_for_event(connection))
+        {
+            bool const exposed =
+                (event->response_type & ~0x80) == XCB_EXPOSE &&
+                reinterpret_cast<xcb_expose_event_t*>(event)->window == window;
+            free(event);
+
+            if (exposed)
+                return true;
+        }
+
+        auto const remaining = duration_cast<milliseconds>(deadline - steady_clock::now());
+        if (remaining <= milliseconds::zero())
+            return false;
+
+        pollfd fd{xcb_get_file_descriptor(connection), POLLIN, 0};
+        poll(&fd, 1, remaining.count());
+    }
+}
+
+auto map_latency(xcb_connection_t* connection, int windows, bool override_redirect) -> mt::DurationHistogram::Summary
+{
+    auto const net_wm_name = intern(connection, "_NET_WM_NAME");
+    auto const utf8_string = intern(connection, "UTF8_STRING");
+    std::string const name{"Benchmark"};
+
+    mt::DurationHistogram latency;
+    int timeouts{0};
+
+    for (int i = 0; i != windows; ++i)
+    {
+        auto const window = create_window(connection, override_redirect);
+        xcb_change_property(
+            connection, XCB_PROP_MODE_REPLACE, window, net_wm_name, utf8_string, 8, name.size(), name.c_str());
+        xcb_change_property(
+            connection, XCB_PROP_MODE_REPLACE, window, XCB_ATOM_WM_NAME, XCB_ATOM_STRING, 8, name.size(), name.c_str());
+
+        auto const mapped = steady_clock::now();
+        xcb_map_window(connection, window);
+        xcb_flush(connection);
+
+        if (wait_for_expose(connection, window))
+            latency.record(steady_clock::now() - mapped);
+        else
+            ++timeouts;
+
+        xcb_destroy_window(connection, window);
+        xcb_flush(connection);
+    }
+
+    if (timeouts)
+        std::cerr<<timeouts<<" window(s) were not exposed within "<<expose_timeout.count()<<"s"<<std::endl;
+
+    return latency.summary();
+}
+
+void print(std::string const& name, mt::DurationHistogram::Summary const& summary)
+{
+    std::cout<<name<<"\t"<<summary.count<<"\t"<<summary.mean.count()<<"\t"<<summary.median.count()
+             <<"\t"<<summary.p90.count()<<"\t"<<summary.p99.count()<<"\t"<<summary.max.count()<<std::endl;
+}
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 2 || std::atoi(argv[1]) < 1)
+    {
+        std::cout<<"Usage: "<<argv[0]<<" <windows per measurement>"<<std::endl;
+        exit(1);
+    }
+
+    int const windows = std::atoi(argv[1]);
+    auto const connection = connect();
+
+    std::cout<<"map to expose\twindows\tmean (us)\tmedian (us)\tp90 (us)\tp99 (us)\tmax (us)"<<std::endl;
+    print("normal", map_latency(connection, windows, false));
+    print("override-redirect", map_latency(connection, windows, true));
+    {
+        PropertySpammer const spammer;
+        print("normal, with _NET_WM_NAME spam", map_latency(connection, windows, false));
+        print("override-redirect, with _NET_WM_NAME spam", map_latency(connection, windows, true));
+    }
+
+    xcb_disconnect(connection);
+    exit(0);
+}
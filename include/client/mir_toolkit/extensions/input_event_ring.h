@@ -0,0 +1,52 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_INPUT_EVENT_RING_H
+#define MIR_INPUT_EVENT_RING_H
+
+#include "mir_toolkit/mir_extension_core.h"
+#include "mir_toolkit/client_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct MirInputEventRingV1
+{
+    /**
+     * Receive the window's input events through memory shared with the server,
+     * rather than over the connection's socket. They are still delivered to
+     * the window's event handler, but on a thread of their own.
+     *
+     * If the window doesn't keep up with its input, the server drops input
+     * events rather than waiting for it.
+     *
+     * \param [in] window  The window
+     * \return             Whether the server now sends input events this way
+     */
+    bool (*enable)(MirWindow* window);
+
+} MirInputEventRingV1;
+
+static inline MirInputEventRingV1 const* mir_input_event_ring_v1(MirConnection* connection)
+{
+    return (MirInputEventRingV1 const*) mir_connection_request_extension(connection, "mir_input_event_ring", 1);
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif //MIR_INPUT_EVENT_RING_H
@@ -22,6 +22,7 @@
 #include "mir/dispatch/dispatchable.h"
 #include "mir/posix_rw_mutex.h"
 
+#include <atomic>
 #include <functional>
 #include <initializer_list>
 #include <list>
@@ -53,8 +54,23 @@ enum class DispatchReentrancy
 class MultiplexingDispatchable final : public Dispatchable
 {
 public:
+    /// The most ready dispatchees a single dispatch() can handle
+    static int constexpr max_batch_size{32};
+
     MultiplexingDispatchable();
     MultiplexingDispatchable(std::initializer_list<std::shared_ptr<Dispatchable>> dispatchees);
+    /**
+     * \brief Create a multiplexer that handles up to \p max_events_per_dispatch
+     *        ready dispatchees on each call to dispatch()
+     *
+     * Batching saves a wakeup per event when many sources are ready at once,
+     * at the cost of one thread handling the whole batch; it suits
+     * multiplexers dispatched from a single thread.
+     *
+     * \throws std::invalid_argument if \p max_events_per_dispatch is not
+     *         between 1 and max_batch_size
+     */
+    explicit MultiplexingDispatchable(int max_events_per_dispatch);
     virtual ~MultiplexingDispatchable() noexcept;
 
     MultiplexingDispatchable& operator=(MultiplexingDispatchable const&) = delete;
@@ -99,6 +115,9 @@ private:
     std::list<std::pair<std::shared_ptr<Dispatchable>, bool>> dispatchee_holder;
 
     Fd epoll_fd;
+    int const max_events_per_dispatch;
+    /// Bumped by every remove_watch() so a batch can tell if its later events went stale
+    std::atomic<unsigned> removal_count{0};
 };
 }
 }
@@ -85,6 +85,32 @@ public:
      */
     virtual NativeDisplayBuffer* native_display_buffer() = 0;
 
+    /** As overlay(), but the hardware may take just some of renderlist
+     *  (for example, the topmost renderables on overlay planes) and leave
+     *  the rest to be rendered beneath them.
+     *  \param [in] renderlist
+     *      The renderables that should appear on the screen.
+     *  \param [out] to_render
+     *      If this returns false, the renderables (in stacking order) the
+     *      caller should render another way, such as with OpenGL.
+     *  \returns
+     *      True if the hardware has taken the whole list, so nothing needs
+     *      to be rendered; False if to_render must be rendered.
+     *
+     *  The default is all or nothing, depending on overlay().
+    **/
+    virtual bool overlay_partially(RenderableList const& renderlist, RenderableList& to_render)
+    {
+        if (overlay(renderlist))
+        {
+            to_render.clear();
+            return true;
+        }
+
+        to_render = renderlist;
+        return false;
+    }
+
 protected:
     DisplayBuffer() = default;
     DisplayBuffer(DisplayBuffer const& c) = delete;
@@ -185,6 +185,25 @@ typedef EGLBoolean (EGLAPIENTRYP PFNEGLQUERYDMABUFFORMATSEXTPROC) (EGLDisplay dp
 typedef EGLBoolean (EGLAPIENTRYP PFNEGLQUERYDMABUFMODIFIERSEXTPROC) (EGLDisplay dpy, EGLint format, EGLint max_modifiers, EGLuint64KHR *modifiers, EGLBoolean *external_only, EGLint *num_modifiers);
 #endif /* EGL_EXT_image_dma_buf_import_modifiers */
 
+#ifndef EGL_EXT_buffer_age
+#define EGL_EXT_buffer_age 1
+#define EGL_BUFFER_AGE_EXT                0x313D
+#endif /* EGL_EXT_buffer_age */
+
+#ifndef EGL_KHR_swap_buffers_with_damage
+#define EGL_KHR_swap_buffers_with_damage 1
+typedef EGLBoolean (EGLAPIENTRYP PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC) (EGLDisplay dpy, EGLSurface surface, const EGLint *rects, EGLint n_rects);
+#endif /* EGL_KHR_swap_buffers_with_damage */
+
+#ifndef EGL_ANDROID_native_fence_sync
+#define EGL_ANDROID_native_fence_sync 1
+#define EGL_SYNC_NATIVE_FENCE_ANDROID     0x3144
+#define EGL_SYNC_NATIVE_FENCE_FD_ANDROID  0x3145
+#define EGL_SYNC_NATIVE_FENCE_SIGNALED_ANDROID 0x3146
+#define EGL_NO_NATIVE_FENCE_FD_ANDROID    -1
+typedef EGLint (EGLAPIENTRYP PFNEGLDUPNATIVEFENCEFDANDROIDPROC) (EGLDisplay dpy, EGLSyncKHR sync);
+#endif /* EGL_ANDROID_native_fence_sync */
+
 /*
  * Just enough polyfill for rawhide headers...
  */
@@ -317,6 +336,42 @@ struct EGLExtensions
         PFNEGLQUERYDMABUFFORMATSEXTPROC const eglQueryDmaBufFormatsExt;
         PFNEGLQUERYDMABUFMODIFIERSEXTPROC const eglQueryDmaBufModifiersExt;
     };
+
+    /// EGL_KHR_swap_buffers_with_damage, or the equivalent EGL_EXT_swap_buffers_with_damage
+    struct SwapBuffersWithDamage
+    {
+        SwapBuffersWithDamage(EGLDisplay dpy);
+
+        static auto maybe_swap_buffers_with_damage(EGLDisplay dpy) -> std::optional<SwapBuffersWithDamage>;
+
+        PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC const eglSwapBuffersWithDamage;
+    };
+
+    /// EGL_ANDROID_native_fence_sync, for getting a sync_file fd that signals when rendering completes
+    struct NativeFenceSync
+    {
+        NativeFenceSync(EGLDisplay dpy);
+
+        static auto maybe_native_fence_sync(EGLDisplay dpy) -> std::optional<NativeFenceSync>;
+
+        PFNEGLCREATESYNCKHRPROC const eglCreateSyncKHR;
+        PFNEGLDESTROYSYNCKHRPROC const eglDestroySyncKHR;
+        PFNEGLDUPNATIVEFENCEFDANDROIDPROC const eglDupNativeFenceFDANDROID;
+    };
+
+    /// EGL_KHR_fence_sync (and EGL_KHR_wait_sync, if present), for ordering GL work across contexts
+    struct FenceSync
+    {
+        FenceSync(EGLDisplay dpy);
+
+        static auto maybe_fence_sync(EGLDisplay dpy) -> std::optional<FenceSync>;
+
+        PFNEGLCREATESYNCKHRPROC const eglCreateSyncKHR;
+        PFNEGLDESTROYSYNCKHRPROC const eglDestroySyncKHR;
+        PFNEGLCLIENTWAITSYNCKHRPROC const eglClientWaitSyncKHR;
+        /// Null without EGL_KHR_wait_sync, in which case wait with eglClientWaitSyncKHR
+        PFNEGLWAITSYNCKHRPROC const eglWaitSyncKHR;
+    };
 };
 
 }
@@ -20,7 +20,9 @@
 #define MIR_GRAPHICS_GRAPHIC_BUFFER_ALLOCATOR_H_
 
 #include "mir/graphics/buffer.h"
+#include "mir/geometry/rectangle.h"
 
+#include <experimental/optional>
 #include <vector>
 #include <memory>
 #include <functional>
@@ -85,10 +87,28 @@ public:
         std::function<void()>&& on_consumed,
         std::function<void()>&& on_release) = 0;
 
+    /**
+     * Import a wl_shm buffer
+     *
+     * Successive buffers committed to a surface usually differ only in the client's damage.
+     * Passing the previous buffer and the damage allows the GPU resources of \a previous
+     * (such as its texture) to be taken over and only the damaged parts updated.
+     *
+     * \param buffer [in]           The wl_shm buffer to import
+     * \param wayland_executor [in] An Executor that spawns tasks on the Wayland event loop
+     * \param on_consumed [in]      Closure to call when the compositor has consumed the buffer
+     * \param previous [in]         The buffer last imported for the same surface, or nullptr.
+     *                              Once the returned buffer has been rendered, rendering
+     *                              \a previous may show the newer content.
+     * \param damage [in]           The parts of \a buffer (in buffer coordinates) that differ
+     *                              from \a previous, or nullopt if that isn't known
+     */
     virtual auto buffer_from_shm(
         wl_resource* buffer,
         std::shared_ptr<mir::Executor> wayland_executor,
-        std::function<void()>&& on_consumed) -> std::shared_ptr<Buffer> = 0;
+        std::function<void()>&& on_consumed,
+        std::shared_ptr<Buffer> const& previous,
+        std::experimental::optional<std::vector<geometry::Rectangle>> const& damage) -> std::shared_ptr<Buffer> = 0;
 
 protected:
     GraphicBufferAllocator() = default;
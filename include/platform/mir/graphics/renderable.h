@@ -21,6 +21,7 @@
 
 #include <experimental/optional>
 #include <mir/geometry/rectangle.h>
+#include <mir/graphics/buffer_id.h>
 #include <glm/glm.hpp>
 #include <memory>
 #include <vector>
@@ -73,6 +74,37 @@ public:
     virtual bool shaped() const = 0;  // meaning the pixel format has alpha
 
     virtual unsigned int swap_interval() const = 0;
+
+    /**
+     * The regions of buffer() (in buffer coordinates) that have changed since
+     * the buffer identified by \a previous was current.
+     *
+     * \returns
+     *      The damaged rectangles, which are empty if nothing has changed; or
+     *      nullopt if the damage is unknown, in which case the whole
+     *      renderable must be treated as damaged.
+     *
+     * The default is nullopt, for renderables that do not track damage.
+     */
+    virtual std::experimental::optional<std::vector<geometry::Rectangle>>
+        damage_since(BufferID /*previous*/) const
+    {
+        return std::experimental::nullopt;
+    }
+
+    /**
+     * The parts of screen_position() (in the same, untransformed, coordinates)
+     * that are known to be fully opaque even though the renderable is shaped.
+     *
+     * This is a hint (from wl_surface.set_opaque_region, for example) that
+     * allows content behind to be culled and blending to be skipped. An empty
+     * region, the default, promises nothing. It does not account for alpha().
+     */
+    virtual std::vector<geometry::Rectangle> opaque_region() const
+    {
+        return {};
+    }
+
 protected:
     Renderable() = default;
     Renderable(Renderable const&) = delete;
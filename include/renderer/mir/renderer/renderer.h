@@ -23,6 +23,8 @@
 #include "mir/graphics/renderable.h"
 #include "mir_toolkit/common.h"
 #include <glm/glm.hpp>
+#include <unordered_map>
+#include <vector>
 
 namespace mir
 {
@@ -32,6 +34,8 @@ namespace renderer
 class Renderer
 {
 public:
+    using VisibleRegions = std::unordered_map<graphics::Renderable::ID, std::vector<geometry::Rectangle>>;
+
     virtual ~Renderer() = default;
 
     virtual void set_viewport(geometry::Rectangle const& rect) = 0;
@@ -39,6 +43,21 @@ public:
     virtual void render(graphics::RenderableList const&) const = 0;
     virtual void suspend() = 0; // called when render() is skipped
 
+    /**
+     * Limits the next render() to the areas (in screen coordinates) that have
+     * changed since the previous render(). Without this, render() redraws
+     * everything, which is also what the default does.
+     */
+    virtual void set_damage(std::vector<geometry::Rectangle> const& /*damage*/) {}
+
+    /**
+     * Limits the next render() to drawing each listed renderable (by ID) only
+     * within the given areas (in screen coordinates), typically those not
+     * hidden by opaque renderables above it. Unlisted renderables are drawn
+     * whole, as are all renderables by default.
+     */
+    virtual void set_visible_regions(VisibleRegions const& /*regions*/) {}
+
 protected:
     Renderer() = default;
     Renderer(const Renderer&) = delete;
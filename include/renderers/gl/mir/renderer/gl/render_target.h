@@ -19,6 +19,10 @@
 #ifndef MIR_RENDERER_GL_RENDER_TARGET_H_
 #define MIR_RENDERER_GL_RENDER_TARGET_H_
 
+#include <mir/geometry/rectangle.h>
+
+#include <vector>
+
 namespace mir
 {
 namespace renderer
@@ -41,6 +45,24 @@ public:
      * free GL-related resources such as textures and buffers.
      */
     virtual void swap_buffers() = 0;
+    /**
+     * Swap buffers, hinting that only the damaged rectangles (in GL window
+     * coordinates, with the origin at the bottom left) have changed.
+     *
+     * Targets that cannot make use of the hint simply swap_buffers().
+     */
+    virtual void swap_buffers_with_damage(std::vector<geometry::Rectangle> const& /*damage*/)
+    {
+        swap_buffers();
+    }
+    /**
+     * The number of swaps since the buffer about to be drawn to was drawn to,
+     * as defined by EGL_EXT_buffer_age. Zero if its content is unknown.
+     */
+    virtual int buffer_age() const
+    {
+        return 0;
+    }
     /** Binds any necessary resources (fbos, textures if any)
      * in preparation for drawing.
      */
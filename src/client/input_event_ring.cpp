@@ -0,0 +1,40 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "input_event_ring.h"
+#include "mir_toolkit/extensions/input_event_ring.h"
+
+#include "mir/uncaught.h"
+
+#include "mir_surface.h"
+
+namespace
+{
+bool enable(MirWindow* window)
+try
+{
+    return window->enable_input_ring();
+}
+catch (std::exception const& e)
+{
+    MIR_LOG_UNCAUGHT_EXCEPTION(e);
+    return false;
+}
+
+MirInputEventRingV1 const impl{&enable};
+}
+
+MirInputEventRingV1 const* const mir::input_event_ring::v1 = &impl;
@@ -0,0 +1,30 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_INPUT_EVENT_RING_V1_H
+#define MIR_INPUT_EVENT_RING_V1_H
+
+typedef struct MirInputEventRingV1 MirInputEventRingV1;
+
+namespace mir
+{
+namespace input_event_ring
+{
+extern MirInputEventRingV1 const* const v1;
+}
+}
+
+#endif //MIR_INPUT_EVENT_RING_V1_H
@@ -18,6 +18,7 @@
 
 #include "mir_connection.h"
 #include "drag_and_drop.h"
+#include "input_event_ring.h"
 #include "mir_surface.h"
 #include "mir_prompt_session.h"
 #include "mir_toolkit/extensions/graphics_module.h"
@@ -54,6 +55,7 @@
 
 #include <algorithm>
 #include <cstddef>
+#include <cstring>
 #include <unistd.h>
 #include <signal.h>
 
@@ -1394,11 +1396,14 @@ auto MirConnection::create_render_surface_with_content(
 }
 #pragma GCC diagnostic pop
 
-void* MirConnection::request_interface(char const* /*name*/, int /*version*/)
+void* MirConnection::request_interface(char const* name, int version)
 {
     if (!platform)
         BOOST_THROW_EXCEPTION(std::invalid_argument("cannot query extensions before connecting to server"));
 
+    if (!strcmp(name, "mir_input_event_ring") && version == 1)
+        return const_cast<MirInputEventRingV1*>(mir::input_event_ring::v1);
+
     return nullptr;
 }
 
@@ -1427,7 +1432,8 @@ void MirConnection::set_base_input_configuration(MirInputConfig const* config)
 }
 
 void MirConnection::enumerate_extensions(
-    void* /*context*/,
-    void (*/*enumerator*/)(void* context, char const* extension, int version))
+    void* context,
+    void (*enumerator)(void* context, char const* extension, int version))
 {
+    enumerator(context, "mir_input_event_ring", 1);
 }
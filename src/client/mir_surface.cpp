@@ -29,6 +29,8 @@
 #include "mir/client/client_buffer.h"
 #include "mir/mir_buffer_stream.h"
 #include "mir/dispatch/threaded_dispatcher.h"
+#include "mir/dispatch/readable_fd.h"
+#include "mir/events/event_ring.h"
 #include "mir/input/xkb_mapper.h"
 #include "mir/cookie/cookie.h"
 #include "mir_cookie.h"
@@ -48,6 +50,7 @@ namespace mircv = mi::receiver;
 namespace mp = mir::protobuf;
 namespace gp = google::protobuf;
 namespace md = mir::dispatch;
+namespace mev = mir::events;
 
 using mir::client::FrameClock;
 
@@ -140,6 +143,7 @@ MirSurface::MirSurface(
       keymapper(std::make_shared<mircv::XKBMapper>()),
       configure_result{mcl::make_protobuf_object<mir::protobuf::SurfaceSetting>()},
       frame_clock(std::make_shared<FrameClock>()),
+      input_ring_fds{mcl::make_protobuf_object<mir::protobuf::SocketFD>()},
       creation_handle(handle),
       size({surface_proto.width(), surface_proto.height()}),
       format(static_cast<MirPixelFormat>(surface_proto.pixel_format())),
@@ -203,6 +207,9 @@ MirSurface::~MirSurface()
         valid_surfaces.erase(this);
     }
 
+    // Join the ring's thread before taking the lock, which it takes to dispatch each event
+    input_ring_thread.reset();
+
     std::lock_guard<decltype(mutex)> lock(mutex);
 
     input_thread.reset();
@@ -287,6 +294,60 @@ MirWaitHandle* MirSurface::request_persistent_id(MirWindowIdCallback callback, v
     return &persistent_id_wait_handle;
 }
 
+void MirSurface::acquired_input_ring()
+{
+    input_ring_wait_handle.result_received();
+}
+
+bool MirSurface::enable_input_ring()
+{
+    if (!server)
+        return false;
+
+    {
+        std::lock_guard<decltype(mutex)> lock{mutex};
+        if (input_ring)
+            return true;
+
+        input_ring_wait_handle.expect_result();
+        server->request_input_ring(
+            &surface->id(),
+            input_ring_fds.get(),
+            gp::NewCallback(this, &MirSurface::acquired_input_ring));
+    }
+
+    input_ring_wait_handle.wait_for_all();
+
+    std::lock_guard<decltype(mutex)> lock{mutex};
+
+    if (input_ring_fds->has_error() || input_ring_fds->fd_size() != 2)
+    {
+        for (auto i = 0, end = input_ring_fds->fd_size(); i != end; ++i)
+            close(input_ring_fds->fd(i));
+        return false;
+    }
+
+    auto const ring = std::make_shared<mev::EventRing>(
+        mir::Fd{input_ring_fds->fd(0)}, mir::Fd{input_ring_fds->fd(1)});
+
+    // Any input events the server sent over the socket before switching are still dispatched from there
+    auto const reader = std::make_shared<md::ReadableFd>(
+        ring->notify_fd(),
+        [this, ring]
+        {
+            ring->consume(
+                [this](void const* data, size_t size)
+                {
+                    auto const event = MirEvent::deserialize(data, size);
+                    handle_event(*event);
+                });
+        });
+
+    input_ring = ring;
+    input_ring_thread = std::make_shared<md::ThreadedDispatcher>("Mir/Input Ring", reader);
+    return true;
+}
+
 MirWaitHandle* MirSurface::configure_cursor(MirCursorConfiguration const* cursor)
 {
     mp::CursorSetting setting;
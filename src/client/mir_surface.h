@@ -46,6 +46,10 @@ namespace dispatch
 {
 class ThreadedDispatcher;
 }
+namespace events
+{
+class EventRing;
+}
 namespace input
 {
 namespace receiver
@@ -56,6 +60,7 @@ class XKBMapper;
 namespace protobuf
 {
 class PersistentSurfaceId;
+class SocketFD;
 class Surface;
 class SurfaceParameters;
 class SurfaceSetting;
@@ -218,6 +223,10 @@ public:
     static bool is_valid(MirSurface* query);
 
     MirWaitHandle* request_persistent_id(MirWindowIdCallback callback, void* context);
+
+    /// Switches input events to a shared-memory ring from the server, read on a thread of their own
+    /// \returns false if the server doesn't provide one
+    bool enable_input_ring();
     MirConnection* connection() const;
 
     std::shared_ptr<mir::client::FrameClock> get_frame_clock() const;
@@ -230,6 +239,7 @@ private:
     void on_configured();
     void on_cursor_configured();
     void acquired_persistent_id(MirWindowIdCallback callback, void* context);
+    void acquired_input_ring();
     void request_operation(MirCookie const* cookie, mir::protobuf::RequestOperation operation) const;
     void request_operation(MirCookie const* cookie, mir::protobuf::RequestOperation operation, mir::optional_value<uint32_t> hint) const;
 
@@ -250,6 +260,7 @@ private:
     MirWaitHandle configure_wait_handle;
     MirWaitHandle configure_cursor_wait_handle;
     MirWaitHandle persistent_id_wait_handle;
+    MirWaitHandle input_ring_wait_handle;
 
     //Deprecated functions can cause MirSurfaces to be created with a default stream
     std::shared_ptr<MirBufferStream> default_stream;
@@ -270,6 +281,10 @@ private:
 
     std::shared_ptr<mir::dispatch::ThreadedDispatcher> input_thread;
 
+    std::unique_ptr<mir::protobuf::SocketFD> const input_ring_fds;
+    std::shared_ptr<mir::events::EventRing> input_ring;
+    std::shared_ptr<mir::dispatch::ThreadedDispatcher> input_ring_thread;
+
     //a bit batty, but the creation handle has to exist for as long as the MirSurface does,
     //as we don't really manage the lifetime of MirWaitHandle sensibly.
     std::shared_ptr<MirWaitHandle> const creation_handle;
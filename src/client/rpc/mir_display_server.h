@@ -143,6 +143,10 @@ public:
         mir::protobuf::SurfaceId const* request,
         mir::protobuf::PersistentSurfaceId* response,
         google::protobuf::Closure* done) override;
+    void request_input_ring(
+        mir::protobuf::SurfaceId const* request,
+        mir::protobuf::SocketFD* response,
+        google::protobuf::Closure* done) override;
     void pong(
         mir::protobuf::PingEvent const* request,
         mir::protobuf::Void* response,
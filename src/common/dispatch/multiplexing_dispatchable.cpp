@@ -31,6 +31,7 @@
 #include <string.h>
 #include <system_error>
 #include <algorithm>
+#include <array>
 
 namespace md = mir::dispatch;
 
@@ -72,9 +73,25 @@ private:
 }
 
 md::MultiplexingDispatchable::MultiplexingDispatchable()
+    : MultiplexingDispatchable(1)
+{
+}
+
+md::MultiplexingDispatchable::MultiplexingDispatchable(int max_events_per_dispatch)
     : lifetime_mutex{PosixRWMutex::Type::PreferWriterNonRecursive},
-      epoll_fd{mir::Fd{::epoll_create1(EPOLL_CLOEXEC)}}
+      epoll_fd{mir::Fd{::epoll_create1(EPOLL_CLOEXEC)}},
+      max_events_per_dispatch{max_events_per_dispatch}
 {
+    if (max_events_per_dispatch < 1)
+    {
+        BOOST_THROW_EXCEPTION((std::invalid_argument{"Must dispatch at least one event at a time"}));
+    }
+
+    if (max_events_per_dispatch > max_batch_size)
+    {
+        BOOST_THROW_EXCEPTION((std::invalid_argument{"Too many events to dispatch at a time"}));
+    }
+
     if (epoll_fd == mir::Fd::invalid)
     {
         BOOST_THROW_EXCEPTION((std::system_error{errno,
@@ -108,43 +125,98 @@ bool md::MultiplexingDispatchable::dispatch(md::FdEvents events)
         return false;
     }
 
-    std::shared_ptr<md::Dispatchable> source;
-    bool rearm_source{false};
-    epoll_event event;
+    struct ReadySource
+    {
+        std::shared_ptr<md::Dispatchable> source;
+        bool rearm{false};
+        epoll_event event;
+    };
+
+    // Concurrent dispatch()es each need their own batch, so keep it on the stack
+    std::array<epoll_event, max_batch_size> epoll_events;
+    std::array<ReadySource, max_batch_size> ready_sources;
+    auto const ready = ready_sources.data();
+
+    int ready_count;
+    unsigned removals_seen;
 
     {
         std::shared_lock<decltype(lifetime_mutex)> lock{lifetime_mutex};
 
-        auto result = epoll_wait(epoll_fd, &event, 1, 0);
+        ready_count = epoll_wait(epoll_fd, epoll_events.data(), max_events_per_dispatch, 0);
 
-        if (result < 0)
+        if (ready_count < 0)
         {
             BOOST_THROW_EXCEPTION((std::system_error{errno,
                                                      std::system_category(),
                                                      "Failed to wait on fds"}));
         }
 
-        if (result == 0)
+        if (ready_count == 0)
         {
             // Some other thread must have stolen the event we were woken for;
             // that's ok, just return.
             return true;
         }
 
-        auto event_source = reinterpret_cast<decltype(dispatchee_holder)::pointer>(event.data.ptr);
+        removals_seen = removal_count;
+        for (int i = 0; i != ready_count; ++i)
+        {
+            auto event_source = reinterpret_cast<decltype(dispatchee_holder)::pointer>(epoll_events[i].data.ptr);
 
-        source = event_source->first;
-        rearm_source = event_source->second;
+            ready[i].source = event_source->first;
+            ready[i].rearm = event_source->second;
+            ready[i].event = epoll_events[i];
+        }
     }
 
-    if (!source->dispatch(epoll_to_fd_event(event)))
+    auto const rearm = [this](ReadySource& item)
+        {
+            item.event.events = fd_event_to_epoll(item.source->relevant_events()) | EPOLLONESHOT;
+            epoll_ctl(epoll_fd, EPOLL_CTL_MOD, item.source->watch_fd(), &item.event);
+        };
+
+    auto const is_still_watched = [this](ReadySource const& item)
+        {
+            std::shared_lock<decltype(lifetime_mutex)> lock{lifetime_mutex};
+            return std::any_of(
+                dispatchee_holder.begin(), dispatchee_holder.end(),
+                [&item](std::pair<std::shared_ptr<Dispatchable>, bool> const& candidate)
+                {
+                    return candidate.first == item.source;
+                });
+        };
+
+    auto item = ready;
+    auto const end = ready + ready_count;
+    try
     {
-        remove_watch(source);
+        for (; item != end; ++item)
+        {
+            // An earlier dispatch in this batch may have removed a watch; don't
+            // dispatch an event for a source that is no longer being watched.
+            if (item != ready && removal_count != removals_seen && !is_still_watched(*item))
+                continue;
+
+            if (!item->source->dispatch(epoll_to_fd_event(item->event)))
+            {
+                remove_watch(item->source);
+            }
+            else if (item->rearm)
+            {
+                rearm(*item);
+            }
+        }
     }
-    else if (rearm_source)
+    catch (...)
     {
-        event.events = fd_event_to_epoll(source->relevant_events()) | EPOLLONESHOT;
-        epoll_ctl(epoll_fd, EPOLL_CTL_MOD, source->watch_fd(), &event);
+        // The rest of the batch won't be dispatched now, but mustn't be left disarmed
+        while (++item != end)
+        {
+            if (item->rearm)
+                rearm(*item);
+        }
+        throw;
     }
 
     return true;
@@ -223,6 +295,7 @@ void md::MultiplexingDispatchable::remove_watch(Fd const& fd)
     }
 
     std::unique_lock<decltype(lifetime_mutex)> lock{lifetime_mutex};
+    ++removal_count;
     dispatchee_holder.remove_if([&fd](std::pair<std::shared_ptr<Dispatchable>,bool> const& candidate)
     {
         return candidate.first->watch_fd() == fd;
@@ -35,9 +35,70 @@
 
 #include <capnp/serialize.h>
 
+#include <new>
 
 namespace ml = mir::logging;
 
+namespace
+{
+// Events are mostly destroyed on the thread that created them (the input thread, or the
+// Wayland thread for its copies), so a free list per thread needs no locking and is rarely empty.
+class EventBlockPool
+{
+public:
+    ~EventBlockPool()
+    {
+        destroyed = true;
+        while (count)
+            ::operator delete(blocks[--count]);
+    }
+
+    auto take() -> void*
+    {
+        return count ? blocks[--count] : nullptr;
+    }
+
+    auto give(void* block) -> bool
+    {
+        if (count == max_blocks)
+            return false;
+
+        blocks[count++] = block;
+        return true;
+    }
+
+    static thread_local bool destroyed;
+
+private:
+    // Enough for a burst of events, without holding on to much memory
+    static std::size_t constexpr max_blocks = 32;
+    void* blocks[max_blocks];
+    std::size_t count{0};
+};
+
+thread_local bool EventBlockPool::destroyed{false};
+thread_local EventBlockPool pool;
+}
+
+void* MirEvent::operator new(std::size_t size)
+{
+    if (size == sizeof(MirEvent) && !EventBlockPool::destroyed)
+    {
+        if (auto const block = pool.take())
+            return block;
+    }
+
+    return ::operator new(size);
+}
+
+void MirEvent::operator delete(void* block, std::size_t size) noexcept
+{
+    if (size == sizeof(MirEvent) && !EventBlockPool::destroyed && pool.give(block))
+        return;
+
+    ::operator delete(block);
+}
+
 MirEvent::MirEvent(MirEvent const& e)
 {
     auto reader = e.event.asReader();
@@ -55,10 +116,15 @@ MirEvent& MirEvent::operator=(MirEvent const& e)
 
 // TODO Look at replacing the surface event serializer with a capnproto layer
 mir::EventUPtr MirEvent::deserialize(std::string const& bytes)
+{
+    return deserialize(bytes.data(), bytes.size());
+}
+
+mir::EventUPtr MirEvent::deserialize(void const* data, std::size_t size)
 {
     auto e = mir::EventUPtr(new MirEvent, [](MirEvent* ev) { delete ev; });
     kj::ArrayPtr<::capnp::word const> words(reinterpret_cast<::capnp::word const*>(
-        bytes.data()), bytes.size() / sizeof(::capnp::word));
+        data), size / sizeof(::capnp::word));
 
     initMessageBuilderFromFlatArrayCopy(words, e->message);
     e->event = e->message.getRoot<mir::capnp::Event>();
@@ -74,6 +140,17 @@ std::string MirEvent::serialize(MirEvent const* event)
     return {reinterpret_cast<char*>(flat_event.asBytes().begin()), flat_event.asBytes().size()};
 }
 
+std::size_t MirEvent::serialized_size(MirEvent const* event)
+{
+    return ::capnp::computeSerializedSizeInWords(const_cast<MirEvent*>(event)->message) * sizeof(::capnp::word);
+}
+
+void MirEvent::serialize_into(MirEvent const* event, void* data)
+{
+    kj::ArrayOutputStream output{kj::arrayPtr(static_cast<kj::byte*>(data), serialized_size(event))};
+    ::capnp::writeMessage(output, const_cast<MirEvent*>(event)->message);
+}
+
 MirEventType MirEvent::type() const
 {
     switch (event.asReader().which())
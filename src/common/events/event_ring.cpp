@@ -0,0 +1,242 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/events/event_ring.h"
+#include "mir/anonymous_shm_file.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <atomic>
+#include <new>
+#include <stdexcept>
+#include <system_error>
+
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace mev = mir::events;
+
+/// Each position counts the bytes ever written (or read), so the ring is empty when they're equal
+struct mev::EventRing::Header
+{
+    alignas(64) std::atomic<uint64_t> written;
+    alignas(64) std::atomic<uint64_t> read;
+    alignas(64) std::atomic<uint64_t> dropped;
+};
+
+static_assert(
+    std::atomic<uint64_t>::is_always_lock_free,
+    "Ring positions are shared between processes, so must not need a lock");
+
+namespace
+{
+/// Every event starts on a word boundary, after a word holding its size
+size_t const word{sizeof(uint64_t)};
+
+/// In place of an event's size: the event didn't fit before the end of the ring, so starts at the beginning
+uint64_t const skip_to_start{~uint64_t{0}};
+
+auto round_up(size_t size) -> size_t
+{
+    return (size + word - 1) & ~(word - 1);
+}
+
+auto checked_capacity(size_t capacity) -> size_t
+{
+    if (capacity < word)
+        BOOST_THROW_EXCEPTION(std::invalid_argument("Event ring too small"));
+
+    return round_up(capacity);
+}
+
+auto create_eventfd() -> mir::Fd
+{
+    auto const fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (fd < 0)
+        BOOST_THROW_EXCEPTION(std::system_error(errno, std::system_category(), "Failed to create eventfd"));
+
+    return mir::Fd{fd};
+}
+
+/// The reader's view of a ring, which is just a mapping of the writer's
+class MappedShmFile : public mir::ShmFile
+{
+public:
+    MappedShmFile(mir::Fd const& fd, size_t size)
+        : fd_{fd},
+          size{size},
+          mapping{mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)}
+    {
+        if (mapping == MAP_FAILED)
+            BOOST_THROW_EXCEPTION(std::system_error(errno, std::system_category(), "Failed to map event ring"));
+    }
+
+    ~MappedShmFile() noexcept
+    {
+        munmap(mapping, size);
+    }
+
+    void* base_ptr() const override { return mapping; }
+    int fd() const override { return fd_; }
+
+private:
+    mir::Fd const fd_;
+    size_t const size;
+    void* const mapping;
+};
+}
+
+auto mev::EventRing::header_size() -> size_t
+{
+    return round_up(sizeof(Header));
+}
+
+auto mev::EventRing::checked_size(Fd const& shm) -> size_t
+{
+    struct stat status;
+    if (fstat(shm, &status) < 0)
+        BOOST_THROW_EXCEPTION(std::system_error(errno, std::system_category(), "Failed to size event ring"));
+
+    size_t const size = status.st_size;
+    if (size < header_size() + word || (size - header_size()) % word)
+        BOOST_THROW_EXCEPTION(std::invalid_argument("Not an event ring"));
+
+    return size;
+}
+
+mev::EventRing::EventRing(size_t capacity)
+    : shm{std::make_unique<AnonymousShmFile>(header_size() + checked_capacity(capacity))},
+      notify{create_eventfd()},
+      capacity{checked_capacity(capacity)},
+      header{new (shm->base_ptr()) Header{}},
+      data{static_cast<char*>(shm->base_ptr()) + header_size()}
+{
+}
+
+mev::EventRing::EventRing(Fd const& shm_fd, Fd const& notify)
+    : shm{std::make_unique<MappedShmFile>(shm_fd, checked_size(shm_fd))},
+      notify{notify},
+      capacity{checked_size(shm_fd) - header_size()},
+      header{static_cast<Header*>(shm->base_ptr())},
+      data{static_cast<char*>(shm->base_ptr()) + header_size()}
+{
+}
+
+mev::EventRing::~EventRing() = default;
+
+auto mev::EventRing::shm_fd() const -> Fd
+{
+    auto const fd = dup(shm->fd());
+    if (fd < 0)
+        BOOST_THROW_EXCEPTION(std::system_error(errno, std::system_category(), "Failed to duplicate event ring"));
+
+    return Fd{fd};
+}
+
+auto mev::EventRing::notify_fd() const -> Fd
+{
+    return notify;
+}
+
+auto mev::EventRing::push(size_t size, std::function<void(void* data)> const& write) -> bool
+{
+    // Only we change written, but read comes from the other process and may be nonsense
+    auto const written = header->written.load(std::memory_order_relaxed);
+    auto const used = written - header->read.load(std::memory_order_acquire);
+
+    auto const length = word + round_up(size);
+    auto const offset = written % capacity;
+    auto const before_end = capacity - offset;
+    auto const needed = length <= before_end ? length : before_end + length;
+
+    if (size > capacity || used > capacity || needed > capacity - used)
+    {
+        header->dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    auto position = written;
+    if (length > before_end)
+    {
+        *reinterpret_cast<uint64_t*>(data + offset) = skip_to_start;
+        position += before_end;
+    }
+
+    auto const record = data + position % capacity;
+    *reinterpret_cast<uint64_t*>(record) = size;
+    write(record + word);
+
+    header->written.store(position + length, std::memory_order_seq_cst);
+
+    // If the reader had caught up it may be asleep. If it hadn't, it'll see this event before it sleeps.
+    if (header->read.load(std::memory_order_seq_cst) == written)
+    {
+        uint64_t const one{1};
+        if (::write(notify, &one, sizeof one) < 0 && errno != EAGAIN)
+            BOOST_THROW_EXCEPTION(std::system_error(errno, std::system_category(), "Failed to signal event ring"));
+    }
+
+    return true;
+}
+
+auto mev::EventRing::consume(std::function<void(void const* data, size_t size)> const& read) -> size_t
+{
+    // Clear any wakeup first, so an event pushed after we've looked wakes us again
+    uint64_t wakeups;
+    if (::read(notify, &wakeups, sizeof wakeups) < 0 && errno != EAGAIN)
+        BOOST_THROW_EXCEPTION(std::system_error(errno, std::system_category(), "Failed to read event ring signal"));
+
+    size_t events{0};
+    auto position = header->read.load(std::memory_order_relaxed);
+
+    for (;;)
+    {
+        auto const written = header->written.load(std::memory_order_seq_cst);
+        if (position == written)
+            break;
+
+        if (written - position > capacity)
+            BOOST_THROW_EXCEPTION(std::runtime_error("Corrupt event ring"));
+
+        auto const offset = position % capacity;
+        auto const size = *reinterpret_cast<uint64_t const*>(data + offset);
+
+        if (size == skip_to_start)
+        {
+            position += capacity - offset;
+        }
+        else
+        {
+            if (size > capacity || word + round_up(size) > capacity - offset)
+                BOOST_THROW_EXCEPTION(std::runtime_error("Corrupt event ring"));
+
+            read(data + offset + word, size);
+            position += word + round_up(size);
+            ++events;
+        }
+
+        header->read.store(position, std::memory_order_seq_cst);
+    }
+
+    return events;
+}
+
+auto mev::EventRing::dropped() const -> uint64_t
+{
+    return header->dropped.load(std::memory_order_relaxed);
+}
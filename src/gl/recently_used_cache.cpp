@@ -20,6 +20,7 @@
 #include "recently_used_cache.h"
 #include "mir/graphics/buffer.h"
 #include "mir/renderer/gl/texture_source.h"
+#include "mir_toolkit/common.h"
 
 #include <stdexcept>
 #include <boost/throw_exception.hpp>
@@ -29,11 +30,26 @@ namespace mgl = mir::gl;
 namespace geom = mir::geometry;
 namespace mrgl = mir::renderer::gl;
 
+mgl::RecentlyUsedCache::RecentlyUsedCache(size_t budget_bytes)
+    : budget_bytes{budget_bytes}
+{
+}
+
 std::shared_ptr<mgl::Texture> mgl::RecentlyUsedCache::load(mg::Renderable const& renderable)
 {
     auto const& buffer = renderable.buffer();
     auto buffer_id = buffer->id();
-    auto& texture = textures[renderable.id()];
+    auto const inserted = textures.try_emplace(renderable.id());
+    auto& texture = inserted.first->second;
+    if (inserted.second)
+    {
+        lru.push_front(renderable.id());
+        texture.lru_position = lru.begin();
+    }
+    else
+    {
+        lru.splice(lru.begin(), lru, texture.lru_position);
+    }
     texture.texture->bind();
 
     auto const texture_source = dynamic_cast<mrgl::TextureSource*>(buffer->native_buffer_base());
@@ -44,7 +60,19 @@ std::shared_ptr<mgl::Texture> mgl::RecentlyUsedCache::load(mg::Renderable const&
     {
         texture_source->bind();
         texture.resource = buffer;
+        texture.bound_buffer = buffer;
         texture.last_bound_buffer = buffer_id;
+
+        auto const size = buffer->size();
+        stats.resident_bytes -= texture.bytes;
+        texture.bytes = size_t(size.width.as_uint32_t()) * size.height.as_uint32_t() *
+                        MIR_BYTES_PER_PIXEL(buffer->pixel_format());
+        stats.resident_bytes += texture.bytes;
+        ++stats.rebinds;
+    }
+    else
+    {
+        ++stats.hits;
     }
     texture_source->secure_for_render();
 
@@ -62,19 +90,36 @@ void mgl::RecentlyUsedCache::invalidate()
 
 void mgl::RecentlyUsedCache::drop_unused()
 {
-    auto t = textures.begin();
-    while (t != textures.end())
+    // Walk from the least recently used end so that eviction stops at the
+    // textures drawn in the last frame
+    auto id = lru.end();
+    while (id != lru.begin())
     {
-        auto& tex = t->second;
+        auto& tex = textures.at(*--id);
         tex.resource.reset();
         if (tex.used)
         {
             tex.used = false;
-            ++t;
         }
-        else
+        else if (tex.bound_buffer.expired())
+        {
+            // Nothing can draw this binding again, whatever the budget
+            stats.resident_bytes -= tex.bytes;
+            ++stats.expiries;
+            textures.erase(*id);
+            id = lru.erase(id);
+        }
+        else if (stats.resident_bytes > budget_bytes)
         {
-            t = textures.erase(t);
+            stats.resident_bytes -= tex.bytes;
+            ++stats.evictions;
+            textures.erase(*id);
+            id = lru.erase(id);
         }
     }
 }
+
+auto mgl::RecentlyUsedCache::statistics() const -> Statistics
+{
+    return stats;
+}
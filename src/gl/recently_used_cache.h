@@ -24,6 +24,8 @@
 #include "mir/gl/texture.h"
 #include "mir/graphics/buffer_id.h"
 #include "mir/graphics/renderable.h"
+#include <cstdint>
+#include <list>
 #include <unordered_map>
 
 namespace mir
@@ -31,13 +33,38 @@ namespace mir
 namespace graphics { class Buffer; }
 namespace gl
 {
+/**
+ * Keeps textures for renderables that have recently been drawn.
+ *
+ * Textures are retained after their renderable stops being drawn (e.g. while it
+ * is occluded) so that it reappearing with the same buffer needs no rebind. A
+ * texture that was not drawn in the last frame is freed as soon as the buffer
+ * bound to it is gone (its renderable has been destroyed or moved on to another
+ * buffer), and once the cache exceeds its byte budget the least recently used of
+ * the rest are freed too.
+ */
 class RecentlyUsedCache : public TextureCache
 {
 public:
+    struct Statistics
+    {
+        uint64_t hits;          ///< Loads that reused the existing binding
+        uint64_t rebinds;       ///< Loads that had to bind a buffer to the texture
+        uint64_t evictions;     ///< Textures freed to stay within budget
+        uint64_t expiries;      ///< Textures freed because their buffer was gone
+        size_t resident_bytes;  ///< Estimated size of all cached textures
+    };
+
+    static size_t constexpr default_budget_bytes{64 * 1024 * 1024};
+
+    explicit RecentlyUsedCache(size_t budget_bytes = default_budget_bytes);
+
     std::shared_ptr<Texture> load(graphics::Renderable const& renderable) override;
     void invalidate() override;
     void drop_unused() override;
 
+    auto statistics() const -> Statistics;
+
 private:
     struct Entry
     {
@@ -49,9 +76,16 @@ private:
         bool used{true};
         bool valid_binding{false};
         std::shared_ptr<graphics::Buffer> resource;
+        std::weak_ptr<graphics::Buffer> bound_buffer;
+        size_t bytes{0};
+        std::list<graphics::Renderable::ID>::iterator lru_position;
     };
 
+    size_t const budget_bytes;
     std::unordered_map<graphics::Renderable::ID, Entry> textures;
+    /// Most recently loaded first
+    std::list<graphics::Renderable::ID> lru;
+    Statistics stats{0, 0, 0, 0, 0};
 };
 }
 }
@@ -25,6 +25,7 @@
 
 #include <capnp/message.h>
 
+#include <cstdint>
 #include <cstring>
 
 struct MirEvent
@@ -67,10 +68,26 @@ struct MirEvent
     static mir::EventUPtr deserialize(std::string const& bytes);
     static std::string serialize(MirEvent const* event);
 
+    // For writing straight into (and reading from) shared memory, without a string in between
+    static mir::EventUPtr deserialize(void const* data, std::size_t size);
+    static std::size_t serialized_size(MirEvent const* event);
+    static void serialize_into(MirEvent const* event, void* data);
+
+    // Events are created and destroyed for every input sample, and on more than one thread.
+    // Their storage is recycled through a per-thread free list rather than going back to the heap.
+    static void* operator new(std::size_t size);
+    static void operator delete(void* block, std::size_t size) noexcept;
+
 protected:
     MirEvent() = default;
 
-    ::capnp::MallocMessageBuilder message;
+    // Room for the message of any input event, so that building (or copying) one doesn't
+    // allocate. Larger messages, such as keymaps, overflow into heap allocated segments.
+    static std::size_t constexpr first_segment_words = 64;
+    alignas(::capnp::word) std::uint64_t first_segment[first_segment_words]{};
+
+    ::capnp::MallocMessageBuilder message{
+        kj::arrayPtr(reinterpret_cast<::capnp::word*>(first_segment), first_segment_words)};
     mir::capnp::Event::Builder event{message.initRoot<mir::capnp::Event>()};
 };
 
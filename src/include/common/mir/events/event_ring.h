@@ -0,0 +1,87 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_EVENTS_EVENT_RING_H_
+#define MIR_EVENTS_EVENT_RING_H_
+
+#include "mir/fd.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+namespace mir
+{
+class ShmFile;
+
+namespace events
+{
+/**
+ * A queue of serialized events in memory shared between one writer and one reader, in different processes.
+ *
+ * Events are written straight into the shared memory and read from it in place, so passing one takes no socket
+ * writes or reads. The writer signals an eventfd when it writes into an empty ring, so the reader can sleep until
+ * there is something to read.
+ *
+ * The writer never blocks: an event that doesn't fit is dropped, and counted. The writer doesn't trust anything
+ * the reader can write into the shared memory, beyond the reader getting its own events wrong.
+ */
+class EventRing
+{
+public:
+    /// Creates a ring holding up to capacity bytes of events (rounded up to whole words)
+    explicit EventRing(size_t capacity);
+
+    /// Maps a ring created by another process, from its shm_fd() and notify_fd()
+    EventRing(Fd const& shm, Fd const& notify);
+
+    ~EventRing();
+
+    auto shm_fd() const -> Fd;
+    auto notify_fd() const -> Fd;
+
+    /// Writes an event of the given size, which write() serializes into the (word aligned) memory it is given
+    /// \returns false, having dropped the event, if the reader hasn't left room for it
+    auto push(size_t size, std::function<void(void* data)> const& write) -> bool;
+
+    /// Reads every event waiting, passing each to read() in place
+    /// \returns the number of events read
+    auto consume(std::function<void(void const* data, size_t size)> const& read) -> size_t;
+
+    /// How many events the writer has dropped
+    auto dropped() const -> uint64_t;
+
+private:
+    EventRing(EventRing const&) = delete;
+    EventRing& operator=(EventRing const&) = delete;
+
+    struct Header;
+    static auto header_size() -> size_t;
+    /// The size of the writer's ring, if the fd holds one
+    static auto checked_size(Fd const& shm) -> size_t;
+
+    std::unique_ptr<ShmFile> const shm;
+    Fd const notify;
+    /// Kept here rather than read from the shared memory, which the other process could scribble on
+    size_t const capacity;
+    Header* const header;
+    char* const data;
+};
+}
+}
+
+#endif /* MIR_EVENTS_EVENT_RING_H_ */
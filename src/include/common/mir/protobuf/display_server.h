@@ -142,6 +142,10 @@ public:
         mir::protobuf::SurfaceId const* request,
         mir::protobuf::PersistentSurfaceId* response,
         google::protobuf::Closure* done) = 0;
+    virtual void request_input_ring(
+        mir::protobuf::SurfaceId const* request,
+        mir::protobuf::SocketFD* response,
+        google::protobuf::Closure* done) = 0;
     virtual void pong(
         mir::protobuf::PingEvent const* request,
         mir::protobuf::Void* response,
@@ -21,11 +21,14 @@
 #define MIR_COMPOSITOR_BUFFER_STREAM_H_
 
 #include "mir/geometry/size.h"
+#include "mir/geometry/rectangle.h"
 #include "mir/frontend/buffer_stream.h"
 #include "mir_toolkit/common.h"
 #include "mir/graphics/buffer_id.h"
 
+#include <experimental/optional>
 #include <memory>
+#include <vector>
 
 namespace mir
 {
@@ -42,6 +45,21 @@ class BufferStream : public frontend::BufferStream
 public:
     virtual ~BufferStream() = default;
 
+    using frontend::BufferStream::submit_buffer;
+    /// Submits a buffer of which only damage (in buffer coordinates) differs from the previous buffer
+    virtual void submit_buffer(
+        std::shared_ptr<graphics::Buffer> const& buffer,
+        std::vector<geometry::Rectangle> const& damage) = 0;
+    /// The damage (in buffer coordinates) of the buffers submitted after previous, up to and including current.
+    /// nullopt if the damage is not known, and the whole of current should be considered damaged.
+    virtual auto damage_between(graphics::BufferID previous, graphics::BufferID current) const
+        -> std::experimental::optional<std::vector<geometry::Rectangle>> = 0;
+
+    /// Sets the area (in logical coordinates, like stream_size()) the client promises to fill with opaque pixels,
+    /// whatever the alpha channel of its buffers says
+    virtual void set_opaque_region(std::vector<geometry::Rectangle> const& region) = 0;
+    virtual auto opaque_region() const -> std::vector<geometry::Rectangle> = 0;
+
     virtual auto lock_compositor_buffer(void const* user_id) -> std::shared_ptr<graphics::Buffer> = 0;
     /// Logical size of the stream (may be different than buffer sizes if scaled)
     virtual auto stream_size() -> geometry::Size = 0;
@@ -35,6 +35,8 @@ public:
     virtual void renderables_in_frame(SubCompositorId id, graphics::RenderableList const& renderables) = 0;
     virtual void rendered_frame(SubCompositorId id) = 0;
     virtual void finished_frame(SubCompositorId id) = 0;
+    /// The finished frame has been posted and is on screen (or, in clone mode, queued to be)
+    virtual void presented_frame(SubCompositorId id) = 0;
     virtual void started() = 0;
     virtual void stopped() = 0;
     virtual void scheduled() = 0;
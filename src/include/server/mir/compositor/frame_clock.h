@@ -0,0 +1,54 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_COMPOSITOR_FRAME_CLOCK_H_
+#define MIR_COMPOSITOR_FRAME_CLOCK_H_
+
+#include <chrono>
+#include <functional>
+
+namespace mir
+{
+namespace geometry { struct Rectangle; }
+namespace compositor
+{
+/**
+ * The cadence at which frames reach the screen, each output at its own rate.
+ */
+class FrameClock
+{
+public:
+    using Callback = std::function<void(std::chrono::steady_clock::time_point presented)>;
+
+    /**
+     * Call callback once the next frame of the output showing most of area has
+     * been presented, and make sure there will be such a frame.
+     *
+     * If no output shows any of area the callback is called immediately. The
+     * callback may be called from a compositor thread, so must not block.
+     */
+    virtual void on_next_frame(geometry::Rectangle const& area, Callback&& callback) = 0;
+
+protected:
+    FrameClock() = default;
+    virtual ~FrameClock() = default;
+    FrameClock(FrameClock const&) = delete;
+    FrameClock& operator=(FrameClock const&) = delete;
+};
+}
+}
+
+#endif /* MIR_COMPOSITOR_FRAME_CLOCK_H_ */
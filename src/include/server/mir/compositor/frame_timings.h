@@ -0,0 +1,90 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_COMPOSITOR_FRAME_TIMINGS_H_
+#define MIR_COMPOSITOR_FRAME_TIMINGS_H_
+
+#include "mir/geometry/rectangle.h"
+#include "mir/time/duration_histogram.h"
+
+#include <array>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace mir
+{
+namespace compositor
+{
+/**
+ * Histograms of how long each stage of compositing takes, for each output.
+ *
+ * Recording a sample is cheap enough to leave on in production, so occasional stalls (the p99 and worse) can be
+ * caught without tracing. See time::DurationHistogram for the precision of the reported percentiles.
+ */
+class FrameTimings
+{
+public:
+    enum class Stage
+    {
+        acquire,            ///< Gathering the scene's renderables (and their buffers)
+        render,             ///< Rendering them, including the swap on renderers that swap as they render
+        present,            ///< Posting the frame until it is on screen (page flip to present)
+        commit_to_present,  ///< From the scene change that scheduled the frame (typically a client commit)
+    };
+    static int constexpr stage_count{4};
+
+    using OutputId = void const*;
+
+    using Summary = time::DurationHistogram::Summary;
+
+    FrameTimings() = default;
+
+    void add_output(OutputId id, geometry::Rectangle const& area);
+    void record(OutputId id, Stage stage, std::chrono::nanoseconds duration);
+
+    /// The outputs seen so far, in the order they were added
+    auto outputs() const -> std::vector<OutputId>;
+    auto summary(OutputId id, Stage stage) const -> Summary;
+
+    /// Every output's summaries, and the area each output covers
+    auto to_json() const -> std::string;
+
+    /// Forgets all samples, keeping the outputs
+    void reset();
+
+    static auto name_of(Stage stage) -> char const*;
+
+private:
+    FrameTimings(FrameTimings const&) = delete;
+    FrameTimings& operator=(FrameTimings const&) = delete;
+
+    struct Output
+    {
+        unsigned index;
+        geometry::Rectangle area;
+        std::array<time::DurationHistogram, stage_count> stages;
+    };
+
+    std::mutex mutable mutex;
+    std::map<OutputId, Output> outputs_;
+};
+}
+}
+
+#endif // MIR_COMPOSITOR_FRAME_TIMINGS_H_
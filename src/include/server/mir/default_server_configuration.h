@@ -55,6 +55,9 @@ class Drawer;
 class DisplayBufferCompositorFactory;
 class Compositor;
 class CompositorReport;
+class FrameTimings;
+class FrameClock;
+class FrameClocks;
 }
 namespace frontend
 {
@@ -70,6 +73,7 @@ class EventSink;
 class DisplayChanger;
 class InputConfigurationChanger;
 class SurfaceStack;
+class Screencast;
 }
 
 namespace shell
@@ -143,6 +147,7 @@ class TouchVisualizer;
 class CursorImages;
 class Seat;
 class KeyMapper;
+class InputLatencies;
 }
 
 namespace logging
@@ -248,6 +253,8 @@ public:
      * configurable interfaces for modifying compositor
      *  @{ */
     virtual std::shared_ptr<compositor::CompositorReport> the_compositor_report();
+    /// Histograms of each output's frame timings, recorded by the default compositor report
+    virtual std::shared_ptr<compositor::FrameTimings> the_frame_timings();
     virtual std::shared_ptr<compositor::DisplayBufferCompositorFactory> the_display_buffer_compositor_factory();
     virtual std::shared_ptr<compositor::DisplayBufferCompositorFactory> wrap_display_buffer_compositor_factory(
         std::shared_ptr<compositor::DisplayBufferCompositorFactory> const& wrapped);
@@ -260,6 +267,12 @@ public:
     virtual std::shared_ptr<compositor::Scene>                  the_scene();
     /** @} */
 
+    /// Captures regions of the screen into client provided buffers
+    virtual std::shared_ptr<frontend::Screencast> the_screencast();
+
+    /// The per-output frame timing driven by the_compositor()
+    std::shared_ptr<compositor::FrameClock> the_frame_clock();
+
     /** @name frontend configuration - dependencies
      * dependencies of frontend on the rest of the Mir
      *  @{ */
@@ -349,6 +362,7 @@ public:
     virtual std::shared_ptr<input::InputDeviceRegistry> the_input_device_registry();
     virtual std::shared_ptr<input::InputDeviceHub> the_input_device_hub();
     virtual std::shared_ptr<input::SurfaceInputDispatcher> the_surface_input_dispatcher();
+    virtual std::shared_ptr<input::InputLatencies> the_input_latencies();
     /** @} */
 
     /** @name logging configuration - customization
@@ -407,6 +421,7 @@ protected:
     CachedPtr<input::SurfaceInputDispatcher>    surface_input_dispatcher;
     CachedPtr<input::DefaultInputDeviceHub>    default_input_device_hub;
     CachedPtr<input::InputDeviceHub>    input_device_hub;
+    CachedPtr<input::InputLatencies>    input_latencies;
     CachedPtr<dispatch::MultiplexingDispatchable> input_reading_multiplexer;
     CachedPtr<input::InputDispatcher> input_dispatcher;
     CachedPtr<shell::InputTargeter> input_targeter;
@@ -443,6 +458,8 @@ protected:
     CachedPtr<compositor::DisplayBufferCompositorFactory> display_buffer_compositor_factory;
     CachedPtr<compositor::Compositor> compositor;
     CachedPtr<compositor::CompositorReport> compositor_report;
+    CachedPtr<compositor::FrameTimings> frame_timings;
+    CachedPtr<frontend::Screencast> screencast;
     CachedPtr<logging::Logger> logger;
     CachedPtr<graphics::DisplayReport> display_report;
     CachedPtr<time::Clock> clock;
@@ -486,6 +503,10 @@ private:
 
     std::shared_ptr<scene::BroadcastingSessionEventSink> the_broadcasting_session_event_sink();
 
+    CachedPtr<compositor::FrameClocks> frame_clocks;
+
+    std::shared_ptr<compositor::FrameClocks> the_frame_clocks();
+
     auto report_factory(char const* report_opt) -> std::unique_ptr<report::ReportFactory>;
 
     CachedPtr<shell::detail::FrontendShell> frontend_shell;
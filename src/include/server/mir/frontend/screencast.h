@@ -22,7 +22,9 @@
 #include "mir/int_wrapper.h"
 #include "mir/graphics/display_configuration.h"
 
+#include <chrono>
 #include <memory>
+#include <vector>
 
 namespace mir
 {
@@ -33,6 +35,16 @@ namespace detail { struct ScreencastSessionIdTag; }
 
 typedef IntWrapper<detail::ScreencastSessionIdTag,uint32_t> ScreencastSessionId;
 
+/// What capturing into a client buffer produced
+struct ScreencastFrame
+{
+    /// When the output frame that was captured was presented
+    std::chrono::steady_clock::time_point presented;
+
+    /// The areas of the buffer (in buffer coordinates) that changed since the previous capture
+    std::vector<geometry::Rectangle> damage;
+};
+
 class Screencast
 {
 public:
@@ -46,7 +58,13 @@ public:
         MirMirrorMode mirror_mode) = 0;
     virtual void destroy_session(ScreencastSessionId id) = 0;
     virtual std::shared_ptr<graphics::Buffer> capture(ScreencastSessionId id) = 0;
-    virtual void capture(ScreencastSessionId id, std::shared_ptr<graphics::Buffer> const& buffer) = 0;
+    /**
+     * Render the session's region into a buffer the client provided.
+     *
+     * Waits for the next frame of the outputs showing the region, so captures
+     * are paced to the display.
+     */
+    virtual ScreencastFrame capture(ScreencastSessionId id, std::shared_ptr<graphics::Buffer> const& buffer) = 0;
 
 protected:
     Screencast() = default;
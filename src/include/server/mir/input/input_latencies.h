@@ -0,0 +1,97 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_INPUT_INPUT_LATENCIES_H_
+#define MIR_INPUT_INPUT_LATENCIES_H_
+
+#include "mir/time/duration_histogram.h"
+#include "mir_toolkit/event.h"
+
+#include <array>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace mir
+{
+namespace time
+{
+class Clock;
+}
+namespace input
+{
+/**
+ * Histograms of how long input events take to reach each stage of the input pipeline, for each device.
+ *
+ * Latencies are measured from the event's timestamp, which the input platform takes from the kernel, so each
+ * stage includes the time the event spent queued before the server read it.
+ */
+class InputLatencies
+{
+public:
+    enum class Stage
+    {
+        received,   ///< The input platform has read and translated the event
+        dispatched, ///< The event has been delivered to the surface it targets
+        sent,       ///< The event has been sent to the surface's client
+    };
+    static int constexpr stage_count{3};
+
+    using Summary = time::DurationHistogram::Summary;
+
+    explicit InputLatencies(std::shared_ptr<time::Clock> const& clock);
+
+    void add_device(MirInputDeviceId id, std::string const& name);
+
+    /// Records the time from the event's timestamp until now
+    void record(MirInputEvent const* event, Stage stage);
+    void record(MirInputDeviceId id, Stage stage, std::chrono::nanoseconds latency);
+
+    /// The devices seen so far, in the order they were added
+    auto devices() const -> std::vector<MirInputDeviceId>;
+    auto summary(MirInputDeviceId id, Stage stage) const -> Summary;
+
+    /// Every device's summaries, and the name of each device
+    auto to_json() const -> std::string;
+
+    /// Forgets all samples, keeping the devices
+    void reset();
+
+    static auto name_of(Stage stage) -> char const*;
+
+private:
+    InputLatencies(InputLatencies const&) = delete;
+    InputLatencies& operator=(InputLatencies const&) = delete;
+
+    struct Device
+    {
+        unsigned index;
+        std::string name;
+        std::array<time::DurationHistogram, stage_count> stages;
+    };
+
+    std::shared_ptr<time::Clock> const clock;
+
+    std::mutex mutable mutex;
+    std::map<MirInputDeviceId, Device> devices_;
+};
+}
+}
+
+#endif // MIR_INPUT_INPUT_LATENCIES_H_
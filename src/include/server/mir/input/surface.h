@@ -49,6 +49,8 @@ public:
     virtual std::string name() const = 0;
     virtual geometry::Rectangle input_bounds() const = 0;
     virtual bool input_area_contains(geometry::Point const& point) const = 0;
+    /// A rectangle enclosing every point for which input_area_contains() can be true
+    virtual geometry::Rectangle input_area_bounds() const { return input_bounds(); }
     virtual std::shared_ptr<graphics::CursorImage> cursor_image() const = 0;
     virtual InputReceptionMode reception_mode() const = 0;
     virtual void consume(MirEvent const* event) = 0;
@@ -34,15 +34,16 @@ namespace mir
 template<class Observer>
 class ObserverRegistrar;
 
-namespace compositor { class Compositor; class DisplayBufferCompositorFactory; class CompositorReport; }
+namespace compositor { class Compositor; class DisplayBufferCompositorFactory; class CompositorReport; class FrameTimings; }
 namespace graphics { class Cursor; class Platform; class Display; class GLConfig; class DisplayConfigurationPolicy; class DisplayConfigurationObserver; }
-namespace input { class CompositeEventFilter; class InputDispatcher; class CursorListener; class CursorImages; class TouchVisualizer; class InputDeviceHub;}
+namespace input { class CompositeEventFilter; class InputDispatcher; class CursorListener; class CursorImages; class TouchVisualizer; class InputDeviceHub; class InputLatencies;}
 namespace logging { class Logger; }
 namespace options { class Option; }
 namespace frontend
 {
 class SessionAuthorizer;
 class SessionMediatorObserver;
+class Screencast;
 class MirClientSession;
 }
 namespace cookie
@@ -351,6 +352,12 @@ public:
     /// \return the compositor report.
     auto the_compositor_report() const -> std::shared_ptr<compositor::CompositorReport>;
 
+    /// \return histograms of each output's frame timings (unless the compositor report is overridden).
+    auto the_frame_timings() const -> std::shared_ptr<compositor::FrameTimings>;
+
+    /// \return the screencast, which renders regions of the screen into dmabuf buffers.
+    auto the_screencast() const -> std::shared_ptr<frontend::Screencast>;
+
     /// \return the composite event filter.
     auto the_composite_event_filter() const -> std::shared_ptr<input::CompositeEventFilter>;
 
@@ -419,6 +426,9 @@ public:
     /// \return the input device hub
     auto the_input_device_hub() const -> std::shared_ptr<input::InputDeviceHub>;
 
+    /// \return histograms of each input device's event latencies through the server
+    auto the_input_latencies() const -> std::shared_ptr<input::InputLatencies>;
+
     /// \return the application not responding detector
     auto the_application_not_responding_detector() const ->
         std::shared_ptr<scene::ApplicationNotRespondingDetector>;
@@ -0,0 +1,102 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_THREAD_MPSC_QUEUE_H_
+#define MIR_THREAD_MPSC_QUEUE_H_
+
+#include <atomic>
+#include <experimental/optional>
+
+namespace mir
+{
+namespace thread
+{
+/**
+ * A first-in, first-out queue that any number of threads can push to at once, without locking, and one thread
+ * pops from.
+ *
+ * Items are held in a linked list, each in its own node, with a dummy node at the consumer's end. A push is a
+ * single atomic exchange followed by linking the previous node to the new one. Between the two, the consumer
+ * sees the queue end before the new item; the producer is expected to signal the consumer once push() returns,
+ * so an item caught in that window is picked up on the consumer's next pass.
+ */
+template<typename T>
+class MpscQueue
+{
+public:
+    MpscQueue()
+        : head{new Node},
+          tail{head.load()}
+    {
+    }
+
+    ~MpscQueue()
+    {
+        while (pop())
+        {
+        }
+        delete tail;
+    }
+
+    /// Safe to call from any number of threads concurrently
+    void push(T&& item)
+    {
+        auto const node = new Node{std::move(item)};
+        auto const previous = head.exchange(node, std::memory_order_acq_rel);
+        previous->next.store(node, std::memory_order_release);
+    }
+
+    /// Must only be called from one thread at a time
+    auto pop() -> std::experimental::optional<T>
+    {
+        auto const next = tail->next.load(std::memory_order_acquire);
+        if (!next)
+            return {};
+
+        // next becomes the dummy node, so its item is moved out and the old dummy is freed
+        std::experimental::optional<T> item{std::move(next->item)};
+        next->item = std::experimental::nullopt;
+        delete tail;
+        tail = next;
+        return item;
+    }
+
+    /// Must only be called from the thread that pops
+    auto empty() const -> bool
+    {
+        return !tail->next.load(std::memory_order_acquire);
+    }
+
+private:
+    MpscQueue(MpscQueue const&) = delete;
+    MpscQueue& operator=(MpscQueue const&) = delete;
+
+    struct Node
+    {
+        Node() = default;
+        explicit Node(T&& item) : item{std::move(item)} {}
+
+        std::experimental::optional<T> item;
+        std::atomic<Node*> next{nullptr};
+    };
+
+    std::atomic<Node*> head; ///< The most recently pushed node, shared by producers
+    Node* tail;              ///< The dummy node before the oldest item, owned by the consumer
+};
+}
+}
+
+#endif // MIR_THREAD_MPSC_QUEUE_H_
@@ -0,0 +1,69 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_TIME_DURATION_HISTOGRAM_H_
+#define MIR_TIME_DURATION_HISTOGRAM_H_
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+
+namespace mir
+{
+namespace time
+{
+/**
+ * A histogram of durations, cheap enough to record into on every frame or input event.
+ *
+ * Durations are bucketed by the microsecond on a log-linear scale, with eight buckets to each power of two, so
+ * reported percentiles are the largest duration in their bucket and within 12.5% of the true value.
+ * Not synchronised; owners are expected to serialise access.
+ */
+class DurationHistogram
+{
+public:
+    struct Summary
+    {
+        uint64_t count;
+        std::chrono::microseconds mean;
+        std::chrono::microseconds median;
+        std::chrono::microseconds p90;
+        std::chrono::microseconds p99;
+        std::chrono::microseconds p999;
+        std::chrono::microseconds max;
+    };
+
+    void record(std::chrono::nanoseconds duration);
+    auto summary() const -> Summary;
+
+private:
+    static int constexpr bucket_count{232};
+
+    auto percentile(double fraction) const -> std::chrono::microseconds;
+
+    std::array<uint64_t, bucket_count> buckets{};
+    uint64_t count{0};
+    std::chrono::microseconds sum{0};
+    std::chrono::microseconds max{0};
+};
+
+/// Writes the summary as a JSON object, with durations in microseconds
+void write_json(std::ostream& out, DurationHistogram::Summary const& summary);
+}
+}
+
+#endif // MIR_TIME_DURATION_HISTOGRAM_H_
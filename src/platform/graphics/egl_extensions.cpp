@@ -207,3 +207,128 @@ mg::EGLExtensions::EXTImageDmaBufImportModifiers::EXTImageDmaBufImportModifiers(
             std::runtime_error{"EGL_EXT_image_dma_buf_import_modifiers not supported"}));
     }
 }
+
+namespace
+{
+auto swap_buffers_with_damage_proc(EGLDisplay dpy) -> PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC
+{
+    auto const egl_extensions = eglQueryString(dpy, EGL_EXTENSIONS);
+    if (!egl_extensions)
+    {
+        return nullptr;
+    }
+
+    if (strstr(egl_extensions, "EGL_KHR_swap_buffers_with_damage"))
+    {
+        return reinterpret_cast<PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC>(
+            eglGetProcAddress("eglSwapBuffersWithDamageKHR"));
+    }
+
+    // The EXT variant has an identical signature (other than const correctness)
+    if (strstr(egl_extensions, "EGL_EXT_swap_buffers_with_damage"))
+    {
+        return reinterpret_cast<PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC>(
+            eglGetProcAddress("eglSwapBuffersWithDamageEXT"));
+    }
+
+    return nullptr;
+}
+}
+
+mg::EGLExtensions::SwapBuffersWithDamage::SwapBuffersWithDamage(EGLDisplay dpy)
+    : eglSwapBuffersWithDamage{swap_buffers_with_damage_proc(dpy)}
+{
+    if (!eglSwapBuffersWithDamage)
+    {
+        BOOST_THROW_EXCEPTION((
+            std::runtime_error{"EGL_KHR_swap_buffers_with_damage not supported"}));
+    }
+}
+
+auto mg::EGLExtensions::SwapBuffersWithDamage::maybe_swap_buffers_with_damage(EGLDisplay dpy)
+    -> std::optional<SwapBuffersWithDamage>
+{
+    try
+    {
+        return SwapBuffersWithDamage{dpy};
+    }
+    catch (std::runtime_error const&)
+    {
+        return {};
+    }
+}
+
+mg::EGLExtensions::NativeFenceSync::NativeFenceSync(EGLDisplay dpy)
+    : eglCreateSyncKHR{
+          reinterpret_cast<PFNEGLCREATESYNCKHRPROC>(eglGetProcAddress("eglCreateSyncKHR"))},
+      eglDestroySyncKHR{
+          reinterpret_cast<PFNEGLDESTROYSYNCKHRPROC>(eglGetProcAddress("eglDestroySyncKHR"))},
+      eglDupNativeFenceFDANDROID{
+          reinterpret_cast<PFNEGLDUPNATIVEFENCEFDANDROIDPROC>(eglGetProcAddress("eglDupNativeFenceFDANDROID"))}
+{
+    auto const egl_extensions = eglQueryString(dpy, EGL_EXTENSIONS);
+    if (!egl_extensions ||
+        !strstr(egl_extensions, "EGL_ANDROID_native_fence_sync") ||
+        !eglCreateSyncKHR || !eglDestroySyncKHR || !eglDupNativeFenceFDANDROID)
+    {
+        BOOST_THROW_EXCEPTION((
+            std::runtime_error{"EGL_ANDROID_native_fence_sync not supported"}));
+    }
+}
+
+auto mg::EGLExtensions::NativeFenceSync::maybe_native_fence_sync(EGLDisplay dpy)
+    -> std::optional<NativeFenceSync>
+{
+    try
+    {
+        return NativeFenceSync{dpy};
+    }
+    catch (std::runtime_error const&)
+    {
+        return {};
+    }
+}
+
+namespace
+{
+auto wait_sync_proc(EGLDisplay dpy) -> PFNEGLWAITSYNCKHRPROC
+{
+    auto const egl_extensions = eglQueryString(dpy, EGL_EXTENSIONS);
+    if (!egl_extensions || !strstr(egl_extensions, "EGL_KHR_wait_sync"))
+        return nullptr;
+
+    return reinterpret_cast<PFNEGLWAITSYNCKHRPROC>(eglGetProcAddress("eglWaitSyncKHR"));
+}
+}
+
+mg::EGLExtensions::FenceSync::FenceSync(EGLDisplay dpy)
+    : eglCreateSyncKHR{
+          reinterpret_cast<PFNEGLCREATESYNCKHRPROC>(eglGetProcAddress("eglCreateSyncKHR"))},
+      eglDestroySyncKHR{
+          reinterpret_cast<PFNEGLDESTROYSYNCKHRPROC>(eglGetProcAddress("eglDestroySyncKHR"))},
+      eglClientWaitSyncKHR{
+          reinterpret_cast<PFNEGLCLIENTWAITSYNCKHRPROC>(eglGetProcAddress("eglClientWaitSyncKHR"))},
+      eglWaitSyncKHR{wait_sync_proc(dpy)}
+{
+    auto const egl_extensions = eglQueryString(dpy, EGL_EXTENSIONS);
+    if (!egl_extensions ||
+        !strstr(egl_extensions, "EGL_KHR_fence_sync") ||
+        !eglCreateSyncKHR || !eglDestroySyncKHR || !eglClientWaitSyncKHR)
+    {
+        BOOST_THROW_EXCEPTION((
+            std::runtime_error{"EGL_KHR_fence_sync not supported"}));
+    }
+}
+
+auto mg::EGLExtensions::FenceSync::maybe_fence_sync(EGLDisplay dpy)
+    -> std::optional<FenceSync>
+{
+    try
+    {
+        return FenceSync{dpy};
+    }
+    catch (std::runtime_error const&)
+    {
+        return {};
+    }
+}
@@ -49,6 +49,7 @@ char const* const mo::fatal_except_opt            = "on-fatal-error-except";
 char const* const mo::debug_opt                   = "debug";
 char const* const mo::composite_delay_opt         = "composite-delay";
 char const* const mo::enable_key_repeat_opt       = "enable-key-repeat";
+char const* const mo::coalesce_pointer_motion_opt = "coalesce-pointer-motion";
 char const* const mo::x11_display_opt             = "enable-x11";
 char const* const mo::x11_scale_opt               = "x11-scale";
 char const* const mo::wayland_extensions_opt      = "wayland-extensions";
@@ -194,6 +195,10 @@ mo::DefaultConfiguration::DefaultConfiguration(
             "Cursor (mouse pointer) to use [{auto,null,software}]")
         (enable_key_repeat_opt, po::value<bool>()->default_value(true),
              "Enable server generated key repeat")
+        (coalesce_pointer_motion_opt, po::value<std::string>()->default_value(off_opt_value),
+            "Send clients pointer motion once a frame, merged, instead of as it arrives "
+            "[{off,frame,resample}]. \"resample\" also predicts the position at the next frame. "
+            "The outputs under the pointer are redrawn every frame while it moves, even with a hardware cursor.")
         (fatal_except_opt, "On \"fatal error\" conditions [e.g. drivers behaving "
             "in unexpected ways] throw an exception (instead of a core dump)")
         (debug_opt, "Enable extra development debugging. "
@@ -19,6 +19,7 @@
 
 #include "buffer_from_wl_shm.h"
 #include "shm_buffer.h"
+#include "shm_texture.h"
 
 #include "mir/renderer/sw/pixel_source.h"
 #include "mir/executor.h"
@@ -313,14 +314,24 @@ public:
         mir::geometry::Size const& size,
         mir::geometry::Stride stride,
         MirPixelFormat format,
-        std::function<void()>&& on_consumed)
+        std::function<void()>&& on_consumed,
+        std::shared_ptr<mgc::ShmTexture> texture,
+        std::experimental::optional<std::vector<mir::geometry::Rectangle>> const& damage)
         : ShmBuffer(size, format, std::move(egl_delegate)),
           on_consumed{std::move(on_consumed)},
           buffer{std::move(buffer)},
-          stride_{stride}
+          stride_{stride},
+          texture{std::move(texture)},
+          frame{this->texture->add_frame(damage)}
     {
     }
 
+    /// The texture a buffer of this size and format committed after us can take over
+    auto texture_for(mir::geometry::Size const& size, MirPixelFormat format) const -> std::shared_ptr<mgc::ShmTexture>
+    {
+        return texture->compatible_with(size, format) ? texture : nullptr;
+    }
+
     std::shared_ptr<mg::NativeBuffer> native_buffer_handle() const override
     {
         BOOST_THROW_EXCEPTION((std::logic_error{"Attempt to get mirclient handle for Wayland Shm buffer"}));
@@ -328,19 +339,26 @@ public:
 
     void bind() override
     {
-        ShmBuffer::bind();
-        std::lock_guard<std::mutex> lock{consumption_mutex};
-        if (!uploaded)
         {
-            read_internal(
-                [this](unsigned char const* pixels)
-                {
-                    upload_to_texture(pixels, stride());
-                });
-            on_consumed();
-            on_consumed = [](){};
-            uploaded = true;
+            std::lock_guard<std::mutex> lock{consumption_mutex};
+            if (!uploaded)
+            {
+                read_internal(
+                    [this](unsigned char const* pixels)
+                    {
+                        texture->update_to(frame, pixels, stride());
+                    });
+                on_consumed();
+                on_consumed = [](){};
+                uploaded = true;
+            }
         }
+        texture->bind();
+    }
+
+    void add_syncpoint() override
+    {
+        texture->add_syncpoint();
     }
 
     void write(unsigned char const* /*pixels*/, size_t /*size*/) override
@@ -386,27 +404,41 @@ private:
     std::function<void()> on_consumed;
     SharedWlBuffer const buffer;
     mir::geometry::Stride const stride_;
+    std::shared_ptr<mgc::ShmTexture> const texture;
+    uint64_t const frame;
 };
 
 auto mg::wayland::buffer_from_wl_shm(
     wl_resource* buffer,
     std::shared_ptr<Executor> executor,
     std::shared_ptr<common::EGLContextExecutor> egl_delegate,
-    std::function<void()>&& on_consumed) -> std::shared_ptr<Buffer>
+    std::function<void()>&& on_consumed,
+    std::shared_ptr<Buffer> const& previous,
+    std::experimental::optional<std::vector<geometry::Rectangle>> const& damage) -> std::shared_ptr<Buffer>
 {
     auto const shm_buffer = wl_shm_buffer_get(buffer);
     if (!shm_buffer)
     {
         BOOST_THROW_EXCEPTION((std::logic_error{"Attempt to import a non-SHM buffer as a SHM buffer"}));
     }
+
+    mir::geometry::Size const size{wl_shm_buffer_get_width(shm_buffer), wl_shm_buffer_get_height(shm_buffer)};
+    auto const format = wl_format_to_mir_format(wl_shm_buffer_get_format(shm_buffer));
+
+    std::shared_ptr<mgc::ShmTexture> texture;
+    if (auto const previous_shm = std::dynamic_pointer_cast<WlShmBuffer>(previous))
+        texture = previous_shm->texture_for(size, format);
+
+    if (!texture)
+        texture = std::make_shared<mgc::ShmTexture>(egl_delegate, size, format);
+
     return std::make_shared<WlShmBuffer>(
         SharedWlBuffer{buffer, std::move(executor)},
         std::move(egl_delegate),
-        mir::geometry::Size{
-            wl_shm_buffer_get_width(shm_buffer),
-            wl_shm_buffer_get_height(shm_buffer)
-        },
+        size,
         mir::geometry::Stride{wl_shm_buffer_get_stride(shm_buffer)},
-        wl_format_to_mir_format(wl_shm_buffer_get_format(shm_buffer)),
-        std::move(on_consumed));
+        format,
+        std::move(on_consumed),
+        std::move(texture),
+        damage);
 }
@@ -20,8 +20,12 @@
 #ifndef MIR_GRAPHICS_GL_WAYLAND_SHM_PROVIDER_H_
 #define MIR_GRAPHICS_GL_WAYLAND_SHM_PROVIDER_H_
 
+#include "mir/geometry/rectangle.h"
+
+#include <experimental/optional>
 #include <memory>
 #include <functional>
+#include <vector>
 
 struct wl_resource;
 
@@ -52,13 +56,19 @@ namespace wayland
  * \param executor      [in]    An Executor that will defer work to the Wayland event loop
  * \param egl_delegate  [in]    An EGL-context-thread delegator
  * \param on_consumed   [in]    Closure to call when the compositor has consumed this buffer
+ * \param previous      [in]    The buffer last imported for the same surface (or nullptr), whose
+ *                              texture is taken over if it is compatible
+ * \param damage        [in]    The parts of buffer (in buffer coordinates) that differ from previous,
+ *                              or nullopt if unknown
  * \return                      An mg::Buffer supporting being rendered from in GL and read by the CPU.
  */
 auto buffer_from_wl_shm(
     wl_resource* buffer,
     std::shared_ptr<Executor> executor,
     std::shared_ptr<common::EGLContextExecutor> egl_delegate,
-    std::function<void()>&& on_consumed) -> std::shared_ptr<Buffer>;
+    std::function<void()>&& on_consumed,
+    std::shared_ptr<Buffer> const& previous,
+    std::experimental::optional<std::vector<geometry::Rectangle>> const& damage) -> std::shared_ptr<Buffer>;
 }
 }
 }
@@ -21,8 +21,11 @@
 
 #include <boost/throw_exception.hpp>
 #include <algorithm>
+#include <memory>
 #include <stdexcept>
 
+#include <drm_fourcc.h>
+
 namespace mgk = mir::graphics::kms;
 
 namespace
@@ -205,3 +208,97 @@ auto mgk::find_crtc_with_primary_plane(
 
     BOOST_THROW_EXCEPTION(std::runtime_error{"Could not find primary plane for CRTC"});
 }
+
+auto mgk::find_planes_for_crtc(
+    int drm_fd,
+    uint32_t crtc_id,
+    uint64_t plane_type) -> std::vector<DRMModePlaneUPtr>
+{
+    DRMModeResources resources{drm_fd};
+
+    auto crtcs = resources.crtcs();
+    auto const our_crtc = std::find_if(
+        crtcs.begin(),
+        crtcs.end(),
+        [crtc_id](mgk::DRMModeCrtcUPtr& crtc)
+        {
+            return crtc_id == crtc->crtc_id;
+        });
+    if (our_crtc == crtcs.end())
+    {
+        BOOST_THROW_EXCEPTION(std::runtime_error{"Failed to find index of CRTC?!"});
+    }
+    auto const crtc_index = std::distance(crtcs.begin(), our_crtc);
+
+    std::vector<DRMModePlaneUPtr> planes;
+
+    mgk::PlaneResources plane_res{drm_fd};
+    for (auto& plane : plane_res.planes())
+    {
+        if (plane->possible_crtcs & (1 << crtc_index))
+        {
+            ObjectProperties plane_props{drm_fd, plane->plane_id, DRM_MODE_OBJECT_PLANE};
+            if (plane_props["type"] == plane_type)
+            {
+                planes.push_back(std::move(plane));
+            }
+        }
+    }
+
+    return planes;
+}
+
+bool mgk::plane_supports_format(
+    int drm_fd,
+    DRMModePlaneUPtr const& plane,
+    uint32_t format,
+    std::optional<uint64_t> modifier)
+{
+    auto const formats_end = plane->formats + plane->count_formats;
+    if (std::find(plane->formats, formats_end, format) == formats_end)
+        return false;
+
+    if (!modifier)
+        return true;
+
+    ObjectProperties plane_props{drm_fd, plane->plane_id, DRM_MODE_OBJECT_PLANE};
+    if (!plane_props.has_property("IN_FORMATS"))
+    {
+        // Without IN_FORMATS the plane only scans out implicitly-modified buffers
+        return modifier.value() == DRM_FORMAT_MOD_LINEAR || modifier.value() == DRM_FORMAT_MOD_INVALID;
+    }
+
+    std::unique_ptr<drmModePropertyBlobRes, decltype(&drmModeFreePropertyBlob)> blob{
+        drmModeGetPropertyBlob(drm_fd, plane_props["IN_FORMATS"]),
+        &drmModeFreePropertyBlob};
+    if (!blob)
+        return false;
+
+    auto const header = static_cast<drm_format_modifier_blob const*>(blob->data);
+    auto const blob_bytes = static_cast<char const*>(blob->data);
+    auto const formats = reinterpret_cast<uint32_t const*>(blob_bytes + header->formats_offset);
+    auto const modifiers = reinterpret_cast<drm_format_modifier const*>(blob_bytes + header->modifiers_offset);
+
+    auto const format_index = static_cast<uint32_t>(
+        std::find(formats, formats + header->count_formats, format) - formats);
+    if (format_index == header->count_formats)
+        return false;
+
+    /* Each drm_format_modifier covers a window of 64 formats, starting at offset,
+     * with bit n of the formats mask set if it applies to the (offset + n)th format
+     */
+    for (auto m = modifiers; m != modifiers + header->count_modifiers; ++m)
+    {
+        if (m->modifier != modifier.value())
+            continue;
+
+        if (format_index >= m->offset &&
+            format_index < m->offset + 64 &&
+            (m->formats & (1ull << (format_index - m->offset))))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
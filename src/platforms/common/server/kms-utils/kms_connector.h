@@ -21,6 +21,7 @@
 
 #include "drm_mode_resources.h"
 
+#include <optional>
 #include <string>
 #include <vector>
 #include <xf86drmMode.h>
@@ -53,6 +54,37 @@ DRMModeCrtcUPtr find_crtc_for_connector(
 std::pair<DRMModeCrtcUPtr, DRMModePlaneUPtr> find_crtc_with_primary_plane(
     int drm_fd,
     DRMModeConnectorUPtr const& connector);
+
+/**
+ * Finds the planes of a given type that can be used with a CRTC
+ *
+ * \note    Only planes of type DRM_PLANE_TYPE_OVERLAY are visible unless
+ *          DRM_CLIENT_CAP_UNIVERSAL_PLANES has been set on drm_fd.
+ * \param [in]  drm_fd      File descriptor to DRM node
+ * \param [in]  crtc_id     The CRTC the planes must be able to display on
+ * \param [in]  plane_type  One of DRM_PLANE_TYPE_{PRIMARY,CURSOR,OVERLAY}
+ * \returns     The matching planes, which may be none.
+ */
+std::vector<DRMModePlaneUPtr> find_planes_for_crtc(
+    int drm_fd,
+    uint32_t crtc_id,
+    uint64_t plane_type);
+
+/**
+ * Checks whether a plane can scan out buffers of a given format and modifier
+ *
+ * \param [in]  drm_fd      File descriptor to DRM node
+ * \param [in]  plane       The plane to check
+ * \param [in]  format      A DRM fourcc format code
+ * \param [in]  modifier    The buffer's DRM format modifier, if it has one
+ * \returns     False if the plane's advertised formats rule the buffer out.
+ *              Buffers without a modifier are only checked against the format.
+ */
+bool plane_supports_format(
+    int drm_fd,
+    DRMModePlaneUPtr const& plane,
+    uint32_t format,
+    std::optional<uint64_t> modifier);
 }
 }
 }
@@ -0,0 +1,113 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "plane_assignment.h"
+#include "mir/graphics/buffer.h"
+
+#include <algorithm>
+
+namespace mg = mir::graphics;
+namespace mgc = mir::graphics::common;
+namespace geom = mir::geometry;
+
+namespace
+{
+bool suits_a_plane(mg::Renderable const& renderable, geom::Rectangle const& view_area)
+{
+    glm::mat4 static const identity(1);
+
+    auto const position = renderable.screen_position();
+
+    // Planes can't rotate, clip or fade their content
+    return renderable.transformation() == identity &&
+           renderable.alpha() == 1.0f &&
+           !renderable.clip_area() &&
+           view_area.contains(position) &&
+           position.size.width > geom::Width{} &&
+           position.size.height > geom::Height{};
+}
+}
+
+mgc::PlaneAssignment::PlaneAssignment(
+    RenderableList const& renderables,
+    geometry::Rectangle const& view_area,
+    Predicate const& can_scan_out)
+    : renderables{renderables}
+{
+    std::vector<geom::Rectangle> composited_above;
+
+    for (auto i = renderables.size(); i-- != 0;)
+    {
+        auto const& renderable = *renderables[i];
+        auto const position = renderable.screen_position();
+
+        if (!view_area.overlaps(position))
+            continue;
+
+        bool const covered = std::any_of(
+            composited_above.begin(),
+            composited_above.end(),
+            [&position](geom::Rectangle const& above) { return above.overlaps(position); });
+
+        if (!covered && suits_a_plane(renderable, view_area) && can_scan_out(renderable))
+        {
+            overlay_indices.push_back(i);
+        }
+        else
+        {
+            composited_indices.push_back(i);
+            composited_above.push_back(position);
+        }
+    }
+
+    // We've been working top down
+    std::reverse(overlay_indices.begin(), overlay_indices.end());
+    std::reverse(composited_indices.begin(), composited_indices.end());
+}
+
+auto mgc::PlaneAssignment::overlays() const -> RenderableList
+{
+    RenderableList result;
+    result.reserve(overlay_indices.size());
+    for (auto const i : overlay_indices)
+        result.push_back(renderables[i]);
+    return result;
+}
+
+auto mgc::PlaneAssignment::composited() const -> RenderableList
+{
+    RenderableList result;
+    result.reserve(composited_indices.size());
+    for (auto const i : composited_indices)
+        result.push_back(renderables[i]);
+    return result;
+}
+
+bool mgc::PlaneAssignment::composite_lowest_overlay()
+{
+    if (overlay_indices.empty())
+        return false;
+
+    /* Nothing composited can be above an overlay it overlaps, and the lowest
+     * overlay is below all the others, so this keeps the assignment valid.
+     */
+    auto const lowest = overlay_indices.front();
+    overlay_indices.erase(overlay_indices.begin());
+    composited_indices.insert(
+        std::upper_bound(composited_indices.begin(), composited_indices.end(), lowest),
+        lowest);
+    return true;
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_COMMON_PLANE_ASSIGNMENT_H_
+#define MIR_GRAPHICS_COMMON_PLANE_ASSIGNMENT_H_
+
+#include "mir/graphics/renderable.h"
+
+#include <functional>
+#include <vector>
+
+namespace mir
+{
+namespace graphics
+{
+namespace common
+{
+
+/**
+ * Splits a frame into renderables to scan out on overlay planes and those
+ * to composite onto the primary plane beneath them. (For a nested server
+ * the "planes" are subsurfaces of the host's window.)
+ *
+ * Overlay planes sit above everything composited, so a renderable is only
+ * a candidate for one if nothing composited above it overlaps it. Candidates
+ * are taken from the top of the stack down, which favours the renderables
+ * most likely to change every frame (video, notifications, the focused app).
+ */
+class PlaneAssignment
+{
+public:
+    using Predicate = std::function<bool(Renderable const&)>;
+
+    /**
+     * \param [in] renderables  The frame, in stacking order (bottom to top)
+     * \param [in] view_area    The area of the output
+     * \param [in] can_scan_out Whether the hardware could show a renderable's
+     *                          buffer at all; only asked of renderables that
+     *                          are otherwise suitable
+     */
+    PlaneAssignment(
+        RenderableList const& renderables,
+        geometry::Rectangle const& view_area,
+        Predicate const& can_scan_out);
+
+    /// The renderables to scan out on overlay planes, bottom to top
+    RenderableList overlays() const;
+
+    /// The visible renderables to composite, in stacking order
+    RenderableList composited() const;
+
+    /**
+     * Give up on the lowest overlay and composite it instead, as the
+     * hardware can't do everything we'd like.
+     *
+     * \returns False if there were no overlays left to give up.
+     */
+    bool composite_lowest_overlay();
+
+private:
+    RenderableList const renderables;
+    /// Indices into renderables
+    std::vector<size_t> overlay_indices;
+    std::vector<size_t> composited_indices;
+};
+
+}
+}
+}
+
+#endif /* MIR_GRAPHICS_COMMON_PLANE_ASSIGNMENT_H_ */
@@ -0,0 +1,242 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "shm_texture.h"
+#include "egl_context_executor.h"
+#include "mir/graphics/gl_format.h"
+
+#define MIR_LOG_COMPONENT "wayland-gfx-helpers"
+#include "mir/log.h"
+
+#include <GLES2/gl2ext.h>
+
+namespace mg = mir::graphics;
+namespace mgc = mir::graphics::common;
+namespace geom = mir::geometry;
+
+namespace
+{
+/* A fence from another context may not have been flushed yet; that context
+ * flushes when it swaps, so waiting on the CPU shouldn't take long. Don't
+ * risk hanging the compositor if it never does, though.
+ */
+EGLTimeKHR const client_wait_timeout_ns{100000000};
+}
+
+mgc::ShmTexture::ShmTexture(std::shared_ptr<EGLContextExecutor> egl_delegate, geom::Size size, MirPixelFormat format)
+    : egl_delegate{std::move(egl_delegate)},
+      size{size},
+      format{format}
+{
+}
+
+mgc::ShmTexture::~ShmTexture()
+{
+    std::vector<EGLSyncKHR> fences;
+    if (upload_fence != EGL_NO_SYNC_KHR)
+        fences.push_back(upload_fence);
+    for (auto const& use : use_fences)
+        fences.push_back(use.second);
+
+    if (tex_id != 0 || !fences.empty())
+    {
+        egl_delegate->spawn(
+            [id = tex_id, dpy = dpy, fence_sync = fence_sync, fences = std::move(fences)]()
+            {
+                if (id != 0)
+                    glDeleteTextures(1, &id);
+                for (auto const fence : fences)
+                    fence_sync->eglDestroySyncKHR(dpy, fence);
+            });
+    }
+}
+
+auto mgc::ShmTexture::compatible_with(geom::Size size, MirPixelFormat format) const -> bool
+{
+    return this->size == size && this->format == format;
+}
+
+auto mgc::ShmTexture::add_frame(std::experimental::optional<std::vector<geom::Rectangle>> damage) -> uint64_t
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    pending.push_back({++latest_frame, std::move(damage)});
+    if (pending.size() > max_pending_frames)
+    {
+        // The damage of the dropped frame is unknown from now on
+        pending.pop_front();
+        pending.front().damage = std::experimental::nullopt;
+    }
+    return latest_frame;
+}
+
+void mgc::ShmTexture::update_to(uint64_t frame, unsigned char const* pixels, geom::Stride stride)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    if (frame <= uploaded_frame)
+        return;
+
+    std::experimental::optional<std::vector<geom::Rectangle>> damage{std::vector<geom::Rectangle>{}};
+    while (!pending.empty() && pending.front().frame <= frame)
+    {
+        auto const& frame_damage = pending.front().damage;
+        if (!frame_damage)
+            damage = std::experimental::nullopt;
+        else if (damage)
+            damage->insert(damage->end(), frame_damage->begin(), frame_damage->end());
+        pending.pop_front();
+    }
+
+    auto const fences = fences_locked();
+    auto const current = eglGetCurrentContext();
+
+    // Other contexts may still be drawing with the old content
+    if (fences)
+    {
+        for (auto const& use : use_fences)
+        {
+            wait_for_locked(use.first, use.second);
+            fences->eglDestroySyncKHR(dpy, use.second);
+        }
+        use_fences.clear();
+    }
+
+    upload(pixels, stride, damage);
+    uploaded_frame = frame;
+
+    if (fences)
+    {
+        if (upload_fence != EGL_NO_SYNC_KHR)
+            fences->eglDestroySyncKHR(dpy, upload_fence);
+        upload_fence = fences->eglCreateSyncKHR(dpy, EGL_SYNC_FENCE_KHR, nullptr);
+        upload_context = current;
+        // Other contexts can only wait for the fence once it has been flushed
+        glFlush();
+    }
+    else
+    {
+        // Without fences, the only way to make the upload safe for other contexts is to complete it
+        glFinish();
+    }
+}
+
+void mgc::ShmTexture::bind()
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    if (upload_fence != EGL_NO_SYNC_KHR)
+        wait_for_locked(upload_context, upload_fence);
+    glBindTexture(GL_TEXTURE_2D, tex_id);
+}
+
+void mgc::ShmTexture::add_syncpoint()
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    auto const fences = fences_locked();
+    if (!fences)
+        return;
+
+    // Only the latest use matters; the context's earlier uses complete before it
+    auto& fence = use_fences[eglGetCurrentContext()];
+    if (fence != EGL_NO_SYNC_KHR)
+        fences->eglDestroySyncKHR(dpy, fence);
+    fence = fences->eglCreateSyncKHR(dpy, EGL_SYNC_FENCE_KHR, nullptr);
+}
+
+auto mgc::ShmTexture::fences_locked() -> EGLExtensions::FenceSync const*
+{
+    if (!fences_checked)
+    {
+        dpy = eglGetCurrentDisplay();
+        if (auto const ext = EGLExtensions::FenceSync::maybe_fence_sync(dpy))
+            fence_sync.emplace(*ext);
+        fences_checked = true;
+    }
+    return fence_sync ? &*fence_sync : nullptr;
+}
+
+void mgc::ShmTexture::wait_for_locked(EGLContext issuer, EGLSyncKHR fence)
+{
+    if (fence == EGL_NO_SYNC_KHR || issuer == eglGetCurrentContext())
+        return;
+
+    // Commands within a context are already ordered, so only another context's fence needs waiting for
+    if (fence_sync->eglWaitSyncKHR)
+    {
+        // Have the GPU wait, rather than blocking this thread
+        fence_sync->eglWaitSyncKHR(dpy, fence, 0);
+    }
+    else
+    {
+        fence_sync->eglClientWaitSyncKHR(dpy, fence, EGL_SYNC_FLUSH_COMMANDS_BIT_KHR, client_wait_timeout_ns);
+    }
+}
+
+void mgc::ShmTexture::upload(
+    unsigned char const* pixels,
+    geom::Stride stride,
+    std::experimental::optional<std::vector<geom::Rectangle>> const& damage)
+{
+    GLenum gl_format, gl_type;
+    if (!mg::get_gl_pixel_format(format, gl_format, gl_type))
+    {
+        mir::log_error("Wayland shm buffer has non-GL-compatible pixel format %i; rendering will be incomplete", format);
+        return;
+    }
+
+    auto const bytes_per_pixel = MIR_BYTES_PER_PIXEL(format);
+
+    // We assume (as does Weston) that stride is a multiple of whole pixels
+    glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, stride.as_int() / bytes_per_pixel);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    if (tex_id == 0)
+    {
+        glGenTextures(1, &tex_id);
+        glBindTexture(GL_TEXTURE_2D, tex_id);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        // The only time the storage is (re)allocated; afterwards we update it in place
+        glTexImage2D(
+            GL_TEXTURE_2D, 0, gl_format,
+            size.width.as_int(), size.height.as_int(), 0,
+            gl_format, gl_type, pixels);
+    }
+    else
+    {
+        glBindTexture(GL_TEXTURE_2D, tex_id);
+
+        geom::Rectangle const whole_buffer{{}, size};
+        for (auto const& rect : damage.value_or(std::vector<geom::Rectangle>{whole_buffer}))
+        {
+            auto const area = rect.intersection_with(whole_buffer);
+            if (area.size.width <= geom::Width{0} || area.size.height <= geom::Height{0})
+                continue;
+
+            glTexSubImage2D(
+                GL_TEXTURE_2D, 0,
+                area.left().as_int(), area.top().as_int(),
+                area.size.width.as_int(), area.size.height.as_int(),
+                gl_format, gl_type,
+                pixels + area.top().as_int() * stride.as_int() + area.left().as_int() * bytes_per_pixel);
+        }
+    }
+
+    // Be nice to other users of the GL context by reverting our changes to shared state
+    glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
@@ -0,0 +1,127 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_COMMON_SHM_TEXTURE_H_
+#define MIR_GRAPHICS_COMMON_SHM_TEXTURE_H_
+
+#include "mir/graphics/egl_extensions.h"
+#include "mir/geometry/rectangle.h"
+#include "mir/geometry/dimensions.h"
+#include "mir_toolkit/common.h"
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLES2/gl2.h>
+
+#include <deque>
+#include <experimental/optional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace mir
+{
+namespace graphics
+{
+namespace common
+{
+class EGLContextExecutor;
+
+/**
+ * The GL texture of the successive shm buffers committed to a surface
+ *
+ * Giving each buffer a texture of its own would reallocate the texture storage and copy every pixel
+ * each frame. As successive buffers mostly differ by the client's damage, they share a texture instead
+ * and each frame uploads only what has changed since the texture was last brought up to date.
+ *
+ * A surface shown on several outputs has its texture used from each output's GL context. Each upload
+ * is fenced, and other contexts wait for that fence before sampling the texture; each use is fenced,
+ * and an upload waits for the uses by other contexts to complete before overwriting the texture.
+ */
+class ShmTexture
+{
+public:
+    ShmTexture(std::shared_ptr<EGLContextExecutor> egl_delegate, geometry::Size size, MirPixelFormat format);
+    ~ShmTexture();
+
+    auto compatible_with(geometry::Size size, MirPixelFormat format) const -> bool;
+
+    /// Records the damage of the next frame relative to its predecessor, returning the new frame's number
+    auto add_frame(std::experimental::optional<std::vector<geometry::Rectangle>> damage) -> uint64_t;
+
+    /**
+     * Bring the texture up to date with frame (whose content is pixels), unless it is already newer
+     *
+     * \note This must be called with a current GL context
+     */
+    void update_to(uint64_t frame, unsigned char const* pixels, geometry::Stride stride);
+
+    /// \note This must be called with a current GL context
+    void bind();
+
+    /**
+     * Mark the end of the current context's use of the texture, as issued so far
+     *
+     * \note This must be called with a current GL context
+     */
+    void add_syncpoint();
+
+private:
+    struct Frame
+    {
+        uint64_t frame;
+        std::experimental::optional<std::vector<geometry::Rectangle>> damage;
+    };
+
+    /// Beyond this many frames without an upload, just upload everything next time
+    static size_t constexpr max_pending_frames = 8;
+
+    void upload(
+        unsigned char const* pixels,
+        geometry::Stride stride,
+        std::experimental::optional<std::vector<geometry::Rectangle>> const& damage);
+
+    /// Looks up the fence extension for the current display the first time we need it
+    auto fences_locked() -> EGLExtensions::FenceSync const*;
+    /// Makes the current context wait for fence, if that was issued from another context
+    void wait_for_locked(EGLContext issuer, EGLSyncKHR fence);
+
+    std::shared_ptr<EGLContextExecutor> const egl_delegate;
+    geometry::Size const size;
+    MirPixelFormat const format;
+
+    std::mutex mutex;
+    GLuint tex_id{0};
+    uint64_t latest_frame{0};
+    uint64_t uploaded_frame{0};
+    /// The frames after uploaded_frame, oldest first
+    std::deque<Frame> pending;
+
+    bool fences_checked{false};
+    EGLDisplay dpy{EGL_NO_DISPLAY};
+    std::optional<EGLExtensions::FenceSync> fence_sync;
+    EGLContext upload_context{EGL_NO_CONTEXT};
+    EGLSyncKHR upload_fence{EGL_NO_SYNC_KHR};
+    /// The last use of the texture by each context
+    std::map<EGLContext, EGLSyncKHR> use_fences;
+};
+}
+}
+}
+
+#endif // MIR_GRAPHICS_COMMON_SHM_TEXTURE_H_
@@ -0,0 +1,795 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "atomic_kms_output.h"
+#include "fb_handle.h"
+#include "page_flipper.h"
+#include "kms-utils/kms_connector.h"
+#include "mir/fatal.h"
+#include "mir/log.h"
+
+#include <boost/throw_exception.hpp>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include <xf86drm.h>
+#include <xf86drmMode.h>
+
+namespace mg = mir::graphics;
+namespace mgg = mg::gbm;
+namespace mgk = mg::kms;
+namespace geom = mir::geometry;
+
+namespace
+{
+void add_property(
+    drmModeAtomicReq* request,
+    uint32_t object_id,
+    mgk::ObjectProperties const& props,
+    char const* name,
+    uint64_t value)
+{
+    drmModeAtomicAddProperty(request, object_id, props.id_for(name), value);
+}
+
+/// Plane coordinates are signed, but passed through libdrm as uint64_t
+uint64_t signed_property(int value)
+{
+    return static_cast<uint64_t>(static_cast<int64_t>(value));
+}
+
+void destroy_blob(int drm_fd, uint32_t& blob)
+{
+    if (blob)
+    {
+        drmModeDestroyPropertyBlob(drm_fd, blob);
+        blob = 0;
+    }
+}
+}
+
+mgg::AtomicKMSOutput::AtomicKMSOutput(
+    int drm_fd,
+    kms::DRMModeConnectorUPtr&& connector,
+    std::shared_ptr<PageFlipper> const& page_flipper)
+    : RealKMSOutput{drm_fd, std::move(connector), page_flipper},
+      cursor_thread{[this] { run_cursor_commits(); }}
+{
+}
+
+mgg::AtomicKMSOutput::~AtomicKMSOutput()
+{
+    {
+        std::lock_guard<std::mutex> lock{atomic_mutex};
+        stopping = true;
+    }
+    cursor_cv.notify_all();
+    cursor_thread.join();
+
+    destroy_blob(drm_fd_, mode_blob);
+    destroy_blob(drm_fd_, gamma_blob);
+}
+
+void mgg::AtomicKMSOutput::reset()
+{
+    RealKMSOutput::reset();
+    forget_planes();
+}
+
+void mgg::AtomicKMSOutput::refresh_hardware_state()
+{
+    RealKMSOutput::refresh_hardware_state();
+    forget_planes();
+}
+
+void mgg::AtomicKMSOutput::forget_planes()
+{
+    std::lock_guard<std::mutex> lock{atomic_mutex};
+
+    primary_plane = nullptr;
+    cursor_plane = nullptr;
+    crtc_props = nullptr;
+    primary_props = nullptr;
+    cursor_props = nullptr;
+    overlay_planes.clear();
+    placed_overlays.clear();
+    tested_overlays.clear();
+    overlays_changed = false;
+}
+
+bool mgg::AtomicKMSOutput::ensure_planes()
+{
+    if (!ensure_crtc())
+        return false;
+
+    if (primary_plane && crtc_props)
+        return true;
+
+    auto primary_planes = kms::find_planes_for_crtc(drm_fd_, current_crtc->crtc_id, DRM_PLANE_TYPE_PRIMARY);
+    if (primary_planes.empty())
+    {
+        mir::log_error("Output %s has no primary plane for its CRTC",
+                       mgk::connector_name(connector).c_str());
+        return false;
+    }
+
+    primary_plane = std::move(primary_planes.front());
+    primary_props = std::make_unique<kms::ObjectProperties>(drm_fd_, primary_plane);
+    crtc_props = std::make_unique<kms::ObjectProperties>(drm_fd_, current_crtc);
+    connector_props = std::make_unique<kms::ObjectProperties>(drm_fd_, connector);
+
+    // Not having a cursor plane is fine; the cursor will be drawn in software
+    auto cursor_planes = kms::find_planes_for_crtc(drm_fd_, current_crtc->crtc_id, DRM_PLANE_TYPE_CURSOR);
+    if (!cursor_planes.empty())
+    {
+        cursor_plane = std::move(cursor_planes.front());
+        cursor_props = std::make_unique<kms::ObjectProperties>(drm_fd_, cursor_plane);
+    }
+
+    /* Overlay planes are kept in stacking order. Where the driver exposes
+     * zpos we use it (and skip any planes beneath the primary plane);
+     * otherwise we assume they stack in the order they're enumerated.
+     */
+    auto const zpos_of = [](kms::ObjectProperties const& props) -> uint64_t
+        {
+            return props.has_property("zpos") ? props["zpos"] : 0;
+        };
+    auto const primary_zpos = zpos_of(*primary_props);
+
+    overlay_planes.clear();
+    for (auto& plane : kms::find_planes_for_crtc(drm_fd_, current_crtc->crtc_id, DRM_PLANE_TYPE_OVERLAY))
+    {
+        auto props = std::make_unique<kms::ObjectProperties>(drm_fd_, plane);
+        if (props->has_property("zpos") && primary_props->has_property("zpos") && zpos_of(*props) <= primary_zpos)
+            continue;
+
+        overlay_planes.push_back(OverlayPlane{std::move(plane), std::move(props)});
+    }
+    std::stable_sort(
+        overlay_planes.begin(),
+        overlay_planes.end(),
+        [&zpos_of](OverlayPlane const& a, OverlayPlane const& b)
+        {
+            return zpos_of(*a.props) < zpos_of(*b.props);
+        });
+
+    return true;
+}
+
+void mgg::AtomicKMSOutput::add_primary_plane(drmModeAtomicReq* request, FBHandle const& fb) const
+{
+    auto const plane_id = primary_plane->plane_id;
+    auto const& mode = connector->modes[mode_index];
+
+    add_property(request, plane_id, *primary_props, "FB_ID", fb.get_drm_fb_id());
+    add_property(request, plane_id, *primary_props, "CRTC_ID", current_crtc->crtc_id);
+
+    /* Source viewport. Coordinates are 16.16 fixed point format */
+    add_property(request, plane_id, *primary_props, "SRC_X", uint64_t(fb_offset.dx.as_int()) << 16);
+    add_property(request, plane_id, *primary_props, "SRC_Y", uint64_t(fb_offset.dy.as_int()) << 16);
+    add_property(request, plane_id, *primary_props, "SRC_W", uint64_t(mode.hdisplay) << 16);
+    add_property(request, plane_id, *primary_props, "SRC_H", uint64_t(mode.vdisplay) << 16);
+
+    /* Destination viewport. Coordinates are *not* 16.16 */
+    add_property(request, plane_id, *primary_props, "CRTC_X", 0);
+    add_property(request, plane_id, *primary_props, "CRTC_Y", 0);
+    add_property(request, plane_id, *primary_props, "CRTC_W", mode.hdisplay);
+    add_property(request, plane_id, *primary_props, "CRTC_H", mode.vdisplay);
+}
+
+void mgg::AtomicKMSOutput::add_overlay_planes(
+    drmModeAtomicReq* request,
+    std::vector<PlacedOverlay> const& placement) const
+{
+    auto placed = placement.begin();
+    for (size_t i = 0; i != overlay_planes.size(); ++i)
+    {
+        auto const plane_id = overlay_planes[i].plane->plane_id;
+        auto const& props = *overlay_planes[i].props;
+
+        if (placed == placement.end() || placed->plane_index != i)
+        {
+            add_property(request, plane_id, props, "FB_ID", 0);
+            add_property(request, plane_id, props, "CRTC_ID", 0);
+            continue;
+        }
+
+        auto const& overlay = placed->overlay;
+        auto const& destination = overlay.destination;
+
+        add_property(request, plane_id, props, "FB_ID", overlay.fb->get_drm_fb_id());
+        add_property(request, plane_id, props, "CRTC_ID", current_crtc->crtc_id);
+        add_property(request, plane_id, props, "SRC_X", 0);
+        add_property(request, plane_id, props, "SRC_Y", 0);
+        add_property(request, plane_id, props, "SRC_W", uint64_t(overlay.buffer_size.width.as_uint32_t()) << 16);
+        add_property(request, plane_id, props, "SRC_H", uint64_t(overlay.buffer_size.height.as_uint32_t()) << 16);
+        add_property(request, plane_id, props, "CRTC_X", signed_property(destination.top_left.x.as_int()));
+        add_property(request, plane_id, props, "CRTC_Y", signed_property(destination.top_left.y.as_int()));
+        add_property(request, plane_id, props, "CRTC_W", destination.size.width.as_uint32_t());
+        add_property(request, plane_id, props, "CRTC_H", destination.size.height.as_uint32_t());
+
+        ++placed;
+    }
+}
+
+void mgg::AtomicKMSOutput::add_cursor_plane(drmModeAtomicReq* request) const
+{
+    if (!cursor_plane)
+        return;
+
+    auto const plane_id = cursor_plane->plane_id;
+
+    if (!cursor_fb)
+    {
+        add_property(request, plane_id, *cursor_props, "FB_ID", 0);
+        add_property(request, plane_id, *cursor_props, "CRTC_ID", 0);
+        return;
+    }
+
+    auto const width = uint64_t(cursor_size.width.as_uint32_t());
+    auto const height = uint64_t(cursor_size.height.as_uint32_t());
+
+    add_property(request, plane_id, *cursor_props, "FB_ID", cursor_fb->get_drm_fb_id());
+    add_property(request, plane_id, *cursor_props, "CRTC_ID", current_crtc->crtc_id);
+    add_property(request, plane_id, *cursor_props, "SRC_X", 0);
+    add_property(request, plane_id, *cursor_props, "SRC_Y", 0);
+    add_property(request, plane_id, *cursor_props, "SRC_W", width << 16);
+    add_property(request, plane_id, *cursor_props, "SRC_H", height << 16);
+    add_property(request, plane_id, *cursor_props, "CRTC_X", signed_property(cursor_position.x.as_int()));
+    add_property(request, plane_id, *cursor_props, "CRTC_Y", signed_property(cursor_position.y.as_int()));
+    add_property(request, plane_id, *cursor_props, "CRTC_W", width);
+    add_property(request, plane_id, *cursor_props, "CRTC_H", height);
+}
+
+void mgg::AtomicKMSOutput::add_gamma(drmModeAtomicReq* request) const
+{
+    if (gamma_blob)
+        add_property(request, current_crtc->crtc_id, *crtc_props, "GAMMA_LUT", gamma_blob);
+}
+
+bool mgg::AtomicKMSOutput::set_crtc(FBHandle const& fb)
+{
+    std::lock_guard<std::mutex> lock{atomic_mutex};
+
+    if (!ensure_planes())
+    {
+        mir::log_error("Output %s has no associated CRTC to set a framebuffer on",
+                       mgk::connector_name(connector).c_str());
+        return false;
+    }
+
+    uint32_t new_mode_blob{0};
+    if (auto const ret = drmModeCreatePropertyBlob(
+            drm_fd_,
+            &connector->modes[mode_index],
+            sizeof(connector->modes[mode_index]),
+            &new_mode_blob))
+    {
+        mir::log_error("Failed to create mode property blob for output %s: %s",
+                       mgk::connector_name(connector).c_str(), strerror(-ret));
+        return false;
+    }
+
+    AtomicRequestUPtr request{drmModeAtomicAlloc(), &drmModeAtomicFree};
+    auto const crtc_id = current_crtc->crtc_id;
+
+    add_property(request.get(), crtc_id, *crtc_props, "MODE_ID", new_mode_blob);
+    add_property(request.get(), crtc_id, *crtc_props, "ACTIVE", 1);
+    add_property(request.get(), connector->connector_id, *connector_props, "CRTC_ID", crtc_id);
+    add_primary_plane(request.get(), fb);
+    add_overlay_planes(request.get(), placed_overlays);
+    add_cursor_plane(request.get());
+    add_gamma(request.get());
+
+    // Check the driver can do this before we touch the hardware, so failure leaves the output as it was
+    auto ret = drmModeAtomicCommit(
+        drm_fd_, request.get(), DRM_MODE_ATOMIC_TEST_ONLY | DRM_MODE_ATOMIC_ALLOW_MODESET, nullptr);
+    if (!ret)
+        ret = drmModeAtomicCommit(drm_fd_, request.get(), DRM_MODE_ATOMIC_ALLOW_MODESET, nullptr);
+
+    if (ret)
+    {
+        mir::log_warning("Failed to set mode on output %s: %s",
+                         mgk::connector_name(connector).c_str(), strerror(-ret));
+        drmModeDestroyPropertyBlob(drm_fd_, new_mode_blob);
+        current_crtc = nullptr;
+        primary_plane = nullptr;
+        cursor_plane = nullptr;
+        overlay_planes.clear();
+        placed_overlays.clear();
+        tested_overlays.clear();
+        return false;
+    }
+
+    destroy_blob(drm_fd_, mode_blob);
+    mode_blob = new_mode_blob;
+    cursor_changed = false;
+    gamma_changed = false;
+
+    // The modeset is immediate, so the overlays are already on screen
+    visible_overlay_fbs.clear();
+    for (auto const& placed : placed_overlays)
+        visible_overlay_fbs.push_back(placed.overlay.fb);
+    overlays_changed = false;
+    using_saved_crtc = false;
+    return true;
+}
+
+void mgg::AtomicKMSOutput::clear_crtc()
+{
+    std::lock_guard<std::mutex> lock{atomic_mutex};
+
+    try
+    {
+        if (!ensure_planes())
+            return;
+    }
+    catch (...)
+    {
+        /*
+         * Not being able to get a crtc is OK, since it means that the
+         * output cannot be displaying anything anyway.
+         */
+        return;
+    }
+
+    AtomicRequestUPtr request{drmModeAtomicAlloc(), &drmModeAtomicFree};
+    auto const crtc_id = current_crtc->crtc_id;
+
+    add_property(request.get(), crtc_id, *crtc_props, "MODE_ID", 0);
+    add_property(request.get(), crtc_id, *crtc_props, "ACTIVE", 0);
+    add_property(request.get(), connector->connector_id, *connector_props, "CRTC_ID", 0);
+    add_property(request.get(), primary_plane->plane_id, *primary_props, "FB_ID", 0);
+    add_property(request.get(), primary_plane->plane_id, *primary_props, "CRTC_ID", 0);
+    add_overlay_planes(request.get(), {});
+    if (cursor_plane)
+    {
+        add_property(request.get(), cursor_plane->plane_id, *cursor_props, "FB_ID", 0);
+        add_property(request.get(), cursor_plane->plane_id, *cursor_props, "CRTC_ID", 0);
+    }
+
+    auto const result = drmModeAtomicCommit(drm_fd_, request.get(), DRM_MODE_ATOMIC_ALLOW_MODESET, nullptr);
+    if (result)
+    {
+        if (result == -EACCES || result == -EPERM)
+        {
+            /* We don't have modesetting rights.
+             *
+             * This can happen during session switching if (eg) logind has already
+             * revoked device access before notifying us.
+             *
+             * Whatever we're switching to can handle the CRTCs; this should not be fatal.
+             */
+            mir::log_info("Couldn't clear output %s (drmModeAtomicCommit: %s (%i))",
+                mgk::connector_name(connector).c_str(),
+                strerror(-result),
+                -result);
+        }
+        else
+        {
+            fatal_error("Couldn't clear output %s (drmModeAtomicCommit = %d)",
+                        mgk::connector_name(connector).c_str(), result);
+        }
+    }
+
+    destroy_blob(drm_fd_, mode_blob);
+    current_crtc = nullptr;
+    primary_plane = nullptr;
+    cursor_plane = nullptr;
+    overlay_planes.clear();
+    placed_overlays.clear();
+    tested_overlays.clear();
+    overlays_changed = false;
+}
+
+bool mgg::AtomicKMSOutput::schedule_page_flip(FBHandle const& fb)
+{
+    std::unique_lock<std::mutex> lg(power_mutex);
+    if (power_mode != mir_power_mode_on)
+        return true;
+
+    std::unique_lock<std::mutex> lock{atomic_mutex};
+    if (!current_crtc || !primary_plane)
+    {
+        mir::log_error("Output %s has no associated CRTC to schedule page flips on",
+                       mgk::connector_name(connector).c_str());
+        return false;
+    }
+
+    // Claim the CRTC, so cursor changes from now on are left for this flip to carry
+    flip_pending = true;
+
+    // A cursor commit still in flight would have the flip rejected with EBUSY; it completes by the next vblank
+    cursor_cv.wait(lock, [this] { return !cursor_commit_pending; });
+
+    if (!current_crtc || !primary_plane)
+    {
+        flip_pending = false;
+        return false;
+    }
+
+    AtomicRequestUPtr request{drmModeAtomicAlloc(), &drmModeAtomicFree};
+    add_primary_plane(request.get(), fb);
+    if (overlays_changed)
+        add_overlay_planes(request.get(), placed_overlays);
+    if (cursor_changed)
+        add_cursor_plane(request.get());
+    if (gamma_changed)
+        add_gamma(request.get());
+
+    if (!page_flipper->schedule_atomic_flip(current_crtc->crtc_id, request.get(), connector->connector_id))
+    {
+        // Whatever the hardware objected to, don't trust our earlier tests of the overlays
+        tested_overlays.clear();
+        flip_pending = false;
+        cursor_cv.notify_all();
+        return false;
+    }
+
+    if (overlays_changed)
+    {
+        scheduled_overlay_fbs.clear();
+        for (auto const& placed : placed_overlays)
+            scheduled_overlay_fbs.push_back(placed.overlay.fb);
+        overlay_fbs_scheduled = true;
+    }
+
+    cursor_changed = false;
+    gamma_changed = false;
+    overlays_changed = false;
+    return true;
+}
+
+void mgg::AtomicKMSOutput::wait_for_page_flip()
+{
+    RealKMSOutput::wait_for_page_flip();
+
+    std::lock_guard<std::mutex> lock{atomic_mutex};
+    flip_pending = false;
+
+    if (overlay_fbs_scheduled)
+    {
+        visible_overlay_fbs = std::move(scheduled_overlay_fbs);
+        scheduled_overlay_fbs.clear();
+        overlay_fbs_scheduled = false;
+    }
+
+    /* Anything that arrived too late for the flip shouldn't wait for the next frame
+     * indefinitely, but committing it straight away would take the next vblank
+     * from that frame.
+     */
+    if (cursor_changed)
+    {
+        cursor_commit_not_before = std::chrono::steady_clock::now() + half_a_frame();
+        cursor_cv.notify_all();
+    }
+}
+
+auto mgg::AtomicKMSOutput::half_a_frame() const -> std::chrono::microseconds
+{
+    auto const vrefresh = connector->modes[mode_index].vrefresh;
+    return std::chrono::microseconds{500000 / (vrefresh ? vrefresh : 60)};
+}
+
+auto mgg::AtomicKMSOutput::place_overlays(std::vector<Overlay> const& overlays) const
+    -> std::optional<std::vector<PlacedOverlay>>
+{
+    if (overlays.size() > overlay_planes.size())
+        return std::nullopt;
+
+    std::vector<PlacedOverlay> placement;
+    placement.reserve(overlays.size());
+
+    size_t plane_index = 0;
+    for (auto const& overlay : overlays)
+    {
+        while (plane_index != overlay_planes.size() &&
+               !kms::plane_supports_format(
+                   drm_fd_, overlay_planes[plane_index].plane, overlay.drm_fourcc, overlay.modifier))
+        {
+            ++plane_index;
+        }
+
+        if (plane_index == overlay_planes.size())
+            return std::nullopt;
+
+        placement.push_back(PlacedOverlay{plane_index++, overlay});
+    }
+
+    return placement;
+}
+
+bool mgg::AtomicKMSOutput::needs_test(std::vector<PlacedOverlay> const& placement) const
+{
+    return !std::equal(
+        placement.begin(), placement.end(),
+        tested_overlays.begin(), tested_overlays.end(),
+        [](PlacedOverlay const& a, PlacedOverlay const& b)
+        {
+            return a.plane_index == b.plane_index &&
+                   a.overlay.drm_fourcc == b.overlay.drm_fourcc &&
+                   a.overlay.modifier == b.overlay.modifier &&
+                   a.overlay.buffer_size == b.overlay.buffer_size &&
+                   a.overlay.destination == b.overlay.destination;
+        });
+}
+
+bool mgg::AtomicKMSOutput::set_overlays(FBHandle const& primary, std::vector<Overlay> const& overlays)
+{
+    std::lock_guard<std::mutex> lock{atomic_mutex};
+
+    if (overlays.empty())
+    {
+        if (!placed_overlays.empty())
+        {
+            placed_overlays.clear();
+            overlays_changed = true;
+        }
+        return true;
+    }
+
+    if (!current_crtc || !primary_plane)
+        return false;
+
+    auto placement = place_overlays(overlays);
+    if (!placement)
+        return false;
+
+    // Once a layout has been accepted, new FBs in the same places don't need checking every frame
+    if (needs_test(placement.value()))
+    {
+        AtomicRequestUPtr request{drmModeAtomicAlloc(), &drmModeAtomicFree};
+        add_primary_plane(request.get(), primary);
+        add_overlay_planes(request.get(), placement.value());
+
+        if (drmModeAtomicCommit(drm_fd_, request.get(), DRM_MODE_ATOMIC_TEST_ONLY, nullptr))
+            return false;
+
+        tested_overlays = placement.value();
+        for (auto& tested : tested_overlays)
+            tested.overlay.fb = nullptr;
+    }
+
+    placed_overlays = std::move(placement.value());
+    overlays_changed = true;
+    return true;
+}
+
+bool mgg::AtomicKMSOutput::can_commit_cursor_locked() const
+{
+    return !flip_pending &&
+           !cursor_commit_pending &&
+           crtc_active &&
+           std::chrono::steady_clock::now() >= cursor_commit_not_before;
+}
+
+void mgg::AtomicKMSOutput::commit_cursor_locked()
+{
+    cursor_changed = false;
+
+    if (!current_crtc || !cursor_plane)
+        return;
+
+    AtomicRequestUPtr request{drmModeAtomicAlloc(), &drmModeAtomicFree};
+    add_cursor_plane(request.get());
+
+    // Completing like a flip tells us when the CRTC can take another commit
+    if (!page_flipper->schedule_atomic_flip(current_crtc->crtc_id, request.get(), connector->connector_id))
+    {
+        mir::log_warning("Failed to update cursor on output %s", mgk::connector_name(connector).c_str());
+        return;
+    }
+
+    cursor_commit_pending = true;
+    cursor_commit_crtc_id = current_crtc->crtc_id;
+    cursor_cv.notify_all();
+}
+
+void mgg::AtomicKMSOutput::run_cursor_commits()
+{
+    std::unique_lock<std::mutex> lock{atomic_mutex};
+
+    while (!stopping)
+    {
+        if (cursor_commit_pending)
+        {
+            auto const crtc_id = cursor_commit_crtc_id;
+            lock.unlock();
+            page_flipper->wait_for_flip(crtc_id);
+            lock.lock();
+
+            cursor_commit_pending = false;
+            cursor_cv.notify_all();
+        }
+        else if (cursor_changed && !flip_pending && crtc_active)
+        {
+            // Either a frame takes the change first, or we commit it once it's due
+            if (can_commit_cursor_locked())
+                commit_cursor_locked();
+            else
+                cursor_cv.wait_until(lock, cursor_commit_not_before);
+        }
+        else
+        {
+            cursor_cv.wait(lock);
+        }
+    }
+}
+
+bool mgg::AtomicKMSOutput::set_cursor(gbm_bo* buffer)
+{
+    auto const fb = fb_for(buffer);
+    if (!fb)
+    {
+        mir::log_warning("set_cursor: failed to create framebuffer for cursor image");
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock{atomic_mutex};
+    if (!current_crtc || !cursor_plane)
+    {
+        has_cursor_ = false;
+        return !current_crtc;
+    }
+
+    cursor_fb = fb;
+    cursor_size = geom::Size{gbm_bo_get_width(buffer), gbm_bo_get_height(buffer)};
+    cursor_changed = true;
+    has_cursor_ = true;
+
+    if (can_commit_cursor_locked())
+        commit_cursor_locked();
+    else
+        cursor_cv.notify_all();
+
+    return true;
+}
+
+void mgg::AtomicKMSOutput::move_cursor(geometry::Point destination)
+{
+    std::lock_guard<std::mutex> lock{atomic_mutex};
+
+    if (cursor_position == destination)
+        return;
+
+    cursor_position = destination;
+    cursor_changed = true;
+
+    // Otherwise the move goes with the pending frame, or once the commit in flight completes
+    if (!cursor_fb)
+        return;
+
+    if (can_commit_cursor_locked())
+        commit_cursor_locked();
+    else
+        cursor_cv.notify_all();
+}
+
+bool mgg::AtomicKMSOutput::clear_cursor()
+{
+    std::lock_guard<std::mutex> lock{atomic_mutex};
+
+    if (current_crtc && cursor_fb)
+    {
+        cursor_fb = nullptr;
+        cursor_changed = true;
+
+        if (can_commit_cursor_locked())
+            commit_cursor_locked();
+        else
+            cursor_cv.notify_all();
+    }
+    has_cursor_ = false;
+
+    return true;
+}
+
+void mgg::AtomicKMSOutput::set_power_mode(MirPowerMode mode)
+{
+    std::lock_guard<std::mutex> lg(power_mutex);
+
+    if (power_mode == mode)
+        return;
+
+    power_mode = mode;
+
+    std::lock_guard<std::mutex> lock{atomic_mutex};
+    crtc_active = mode == mir_power_mode_on;
+    if (!current_crtc || !crtc_props)
+        return;
+
+    // Atomic drivers express DPMS as the CRTC being (in)active
+    AtomicRequestUPtr request{drmModeAtomicAlloc(), &drmModeAtomicFree};
+    add_property(request.get(), current_crtc->crtc_id, *crtc_props, "ACTIVE", crtc_active);
+
+    // Cursor changes can't be committed while the CRTC is off, so they go when it's switched on
+    if (crtc_active && cursor_changed)
+    {
+        add_cursor_plane(request.get());
+        cursor_changed = false;
+    }
+
+    if (auto const result = drmModeAtomicCommit(drm_fd_, request.get(), DRM_MODE_ATOMIC_ALLOW_MODESET, nullptr))
+    {
+        mir::log_warning("Failed to set power mode of output %s: %s",
+                         mgk::connector_name(connector).c_str(), strerror(-result));
+    }
+}
+
+void mgg::AtomicKMSOutput::set_gamma(mg::GammaCurves const& gamma)
+{
+    std::unique_lock<std::mutex> lock{atomic_mutex};
+
+    if (!ensure_planes())
+    {
+        mir::log_warning("Output %s has no associated CRTC to set gamma on",
+                         mgk::connector_name(connector).c_str());
+        return;
+    }
+
+    if (!crtc_props->has_property("GAMMA_LUT"))
+    {
+        // The driver only supports the legacy gamma ramp
+        lock.unlock();
+        RealKMSOutput::set_gamma(gamma);
+        return;
+    }
+
+    if (gamma.red.size() != gamma.green.size() ||
+        gamma.green.size() != gamma.blue.size())
+    {
+        BOOST_THROW_EXCEPTION(
+            std::invalid_argument("set_gamma: mismatch gamma LUT sizes"));
+    }
+
+    std::vector<drm_color_lut> lut(gamma.red.size());
+    for (size_t i = 0; i != lut.size(); ++i)
+    {
+        lut[i].red = gamma.red[i];
+        lut[i].green = gamma.green[i];
+        lut[i].blue = gamma.blue[i];
+        lut[i].reserved = 0;
+    }
+
+    uint32_t new_gamma_blob{0};
+    if (auto const ret = drmModeCreatePropertyBlob(
+            drm_fd_, lut.data(), lut.size() * sizeof(lut[0]), &new_gamma_blob))
+    {
+        mir::log_warning("Failed to create gamma LUT blob: %s", strerror(-ret));
+        return;
+    }
+
+    destroy_blob(drm_fd_, gamma_blob);
+    gamma_blob = new_gamma_blob;
+    gamma_changed = true;
+
+    // Let a cursor commit in flight complete first, unless a frame claims the CRTC (and the gamma change) meanwhile
+    cursor_cv.wait(lock, [this] { return !cursor_commit_pending || flip_pending; });
+
+    if (!flip_pending)
+    {
+        AtomicRequestUPtr request{drmModeAtomicAlloc(), &drmModeAtomicFree};
+        add_gamma(request.get());
+
+        if (auto const result = drmModeAtomicCommit(drm_fd_, request.get(), 0, nullptr))
+        {
+            mir::log_warning("Failed to set gamma of output %s: %s",
+                             mgk::connector_name(connector).c_str(), strerror(-result));
+        }
+        gamma_changed = false;
+    }
+}
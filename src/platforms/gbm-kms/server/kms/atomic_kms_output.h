@@ -0,0 +1,157 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_GBM_ATOMIC_KMS_OUTPUT_H_
+#define MIR_GRAPHICS_GBM_ATOMIC_KMS_OUTPUT_H_
+
+#include "real_kms_output.h"
+#include "mir/geometry/point.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace mir
+{
+namespace graphics
+{
+namespace gbm
+{
+
+/**
+ * A KMSOutput driven through atomic modesetting.
+ *
+ * The mode, primary plane, overlay planes, cursor plane and gamma are all
+ * applied through atomic commits. Cursor and gamma changes made while a page
+ * flip is pending are folded into the next commit rather than each taking an
+ * ioctl of their own.
+ *
+ * Only one commit can be in flight on a CRTC, so a cursor change is only
+ * committed on its own when no frame is pending. Such commits complete with
+ * an event, like a page flip, and a frame waits for that event rather than
+ * having its flip rejected.
+ *
+ * Requires DRM_CLIENT_CAP_ATOMIC to have been set on drm_fd.
+ */
+class AtomicKMSOutput : public RealKMSOutput
+{
+public:
+    AtomicKMSOutput(
+        int drm_fd,
+        kms::DRMModeConnectorUPtr&& connector,
+        std::shared_ptr<PageFlipper> const& page_flipper);
+    ~AtomicKMSOutput();
+
+    void reset() override;
+
+    bool set_crtc(FBHandle const& fb) override;
+    void clear_crtc() override;
+    bool schedule_page_flip(FBHandle const& fb) override;
+    void wait_for_page_flip() override;
+    bool set_overlays(FBHandle const& primary, std::vector<Overlay> const& overlays) override;
+
+    bool set_cursor(gbm_bo* buffer) override;
+    void move_cursor(geometry::Point destination) override;
+    bool clear_cursor() override;
+
+    void set_power_mode(MirPowerMode mode) override;
+    void set_gamma(GammaCurves const& gamma) override;
+
+    void refresh_hardware_state() override;
+
+private:
+    using AtomicRequestUPtr = std::unique_ptr<drmModeAtomicReq, void(*)(drmModeAtomicReqPtr)>;
+
+    struct OverlayPlane
+    {
+        kms::DRMModePlaneUPtr plane;
+        std::unique_ptr<kms::ObjectProperties> props;
+    };
+
+    /// An overlay, and the index into overlay_planes of the plane showing it
+    struct PlacedOverlay
+    {
+        size_t plane_index;
+        Overlay overlay;
+    };
+
+    bool ensure_planes();
+    void forget_planes();
+
+    /// Matches overlays to planes that can show them, keeping their stacking order
+    auto place_overlays(std::vector<Overlay> const& overlays) const -> std::optional<std::vector<PlacedOverlay>>;
+    /// Whether placement differs from the last one the hardware accepted in anything but its FBs
+    bool needs_test(std::vector<PlacedOverlay> const& placement) const;
+
+    void add_primary_plane(drmModeAtomicReq* request, FBHandle const& fb) const;
+    void add_overlay_planes(drmModeAtomicReq* request, std::vector<PlacedOverlay> const& placement) const;
+    void add_cursor_plane(drmModeAtomicReq* request) const;
+    void add_gamma(drmModeAtomicReq* request) const;
+    bool can_commit_cursor_locked() const;
+    void commit_cursor_locked();
+    /// Commits the cursor changes no frame has carried, and handles the completion of cursor commits
+    void run_cursor_commits();
+    auto half_a_frame() const -> std::chrono::microseconds;
+
+    std::mutex atomic_mutex;
+    std::condition_variable cursor_cv;
+
+    kms::DRMModePlaneUPtr primary_plane;
+    kms::DRMModePlaneUPtr cursor_plane;
+    std::unique_ptr<kms::ObjectProperties> crtc_props;
+    std::unique_ptr<kms::ObjectProperties> connector_props;
+    std::unique_ptr<kms::ObjectProperties> primary_props;
+    std::unique_ptr<kms::ObjectProperties> cursor_props;
+    std::vector<OverlayPlane> overlay_planes;
+
+    uint32_t mode_blob{0};
+    uint32_t gamma_blob{0};
+    bool gamma_changed{false};
+
+    std::shared_ptr<FBHandle const> cursor_fb;
+    geometry::Size cursor_size;
+    geometry::Point cursor_position;
+    bool cursor_changed{false};
+    /// A cursor-only commit hasn't completed, so nothing else can be committed to the CRTC yet
+    bool cursor_commit_pending{false};
+    uint32_t cursor_commit_crtc_id{0};
+    /// Changes left after a frame give the next frame a chance to carry them before this
+    std::chrono::steady_clock::time_point cursor_commit_not_before;
+    bool crtc_active{true};
+
+    std::vector<PlacedOverlay> placed_overlays;
+    std::vector<PlacedOverlay> tested_overlays;
+    bool overlays_changed{false};
+    /// Keep overlay FBs alive until the flip replacing them has completed
+    std::vector<std::shared_ptr<FBHandle const>> scheduled_overlay_fbs;
+    std::vector<std::shared_ptr<FBHandle const>> visible_overlay_fbs;
+    bool overlay_fbs_scheduled{false};
+
+    bool flip_pending{false};
+
+    bool stopping{false};
+    std::thread cursor_thread;
+};
+
+}
+}
+}
+
+#endif /* MIR_GRAPHICS_GBM_ATOMIC_KMS_OUTPUT_H_ */
@@ -21,6 +21,7 @@
 #include "mir/graphics/display_report.h"
 #include "mir/graphics/transformation.h"
 #include "bypass.h"
+#include "plane_assignment.h"
 #include "gbm_buffer.h"
 #include "mir/fatal.h"
 #include "mir/log.h"
@@ -37,12 +38,15 @@
 #include <GLES2/gl2.h>
 #include <GLES2/gl2ext.h>
 #include <drm_fourcc.h>
+#include <linux/sync_file.h>
+#include <sys/ioctl.h>
 
 #include <sstream>
 #include <stdexcept>
 #include <chrono>
 #include <thread>
 #include <algorithm>
+#include <unordered_map>
 
 namespace mg = mir::graphics;
 namespace mgg = mir::graphics::gbm;
@@ -440,6 +444,8 @@ mgg::DisplayBuffer::DisplayBuffer(
       area(area),
       transform{transformation},
       needs_set_crtc{false},
+      composite_render_time{std::chrono::milliseconds{50}},
+      bypass_render_time{std::chrono::milliseconds{5}},
       page_flips_pending{false}
 {
     listener->report_successful_setup_of_native_resources();
@@ -524,8 +530,28 @@ void mgg::DisplayBuffer::set_transformation(glm::mat2 const& t, geometry::Rectan
     area = a;
 }
 
+auto mgg::DisplayBuffer::bypass_fb_for(Renderable const& renderable) const -> std::shared_ptr<FBHandle const>
+{
+    auto bypass_buffer = renderable.buffer();
+    auto dmabuf_image = dynamic_cast<mg::DMABufBuffer*>(bypass_buffer->native_buffer_base());
+    if (dmabuf_image &&
+        bypass_buffer->size() == surface.size())
+    {
+        return outputs.front()->fb_for(*dmabuf_image);
+    }
+
+    return nullptr;
+}
+
 bool mgg::DisplayBuffer::overlay(RenderableList const& renderable_list)
 {
+    // Trying to overlay is the first thing the compositor does with each frame
+    if (!frame_start)
+        frame_start = time::PosixTimestamp::now(outputs.front()->last_frame().ust.clock_id);
+
+    // This is all or nothing, so any overlays left from a previous frame have to go
+    clear_overlays();
+
     glm::mat2 static const no_transformation(1);
     if (transform == no_transformation &&
        (bypass_option == mgg::BypassOption::allowed))
@@ -534,26 +560,131 @@ bool mgg::DisplayBuffer::overlay(RenderableList const& renderable_list)
         auto bypass_it = std::find_if(renderable_list.rbegin(), renderable_list.rend(), bypass_match);
         if (bypass_it != renderable_list.rend())
         {
-            auto bypass_buffer = (*bypass_it)->buffer();
-            auto dmabuf_image = dynamic_cast<mg::DMABufBuffer*>(bypass_buffer->native_buffer_base());
-            if (dmabuf_image &&
-                bypass_buffer->size() == surface.size())
+            if (auto bufobj = bypass_fb_for(**bypass_it))
             {
-                if (auto bufobj = outputs.front()->fb_for(*dmabuf_image))
+                bypass_buf = (*bypass_it)->buffer();
+                bypass_bufobj = bufobj;
+                return true;
+            }
+        }
+    }
+
+    bypass_buf = nullptr;
+    bypass_bufobj = nullptr;
+    return false;
+}
+
+bool mgg::DisplayBuffer::overlay_partially(RenderableList const& renderable_list, RenderableList& to_render)
+{
+    if (overlay(renderable_list))
+    {
+        to_render.clear();
+        return true;
+    }
+
+    to_render = renderable_list;
+
+    /*
+     * Overlays are only tried on a single, untransformed output: in clone mode
+     * each output would need its own plane assignment. The hardware also needs
+     * a primary plane FB to check the overlays against, so not before the first frame.
+     */
+    glm::mat2 static const no_transformation(1);
+    auto const primary_fb = scheduled_fb ? scheduled_fb : visible_fb;
+    if (outputs.size() != 1 ||
+        transform != no_transformation ||
+        bypass_option != mgg::BypassOption::allowed ||
+        !primary_fb)
+    {
+        return false;
+    }
+
+    auto const& output = outputs.front();
+
+    std::unordered_map<Renderable const*, std::pair<KMSOutput::Overlay, std::shared_ptr<Buffer>>> candidates;
+    mg::common::PlaneAssignment assignment{
+        renderable_list,
+        area,
+        [this, &output, &candidates](Renderable const& renderable)
+        {
+            auto buffer = renderable.buffer();
+            auto const dmabuf = dynamic_cast<mg::DMABufBuffer*>(buffer->native_buffer_base());
+            if (!dmabuf)
+                return false;
+
+            auto fb = output->fb_for(*dmabuf);
+            if (!fb)
+                return false;
+
+            auto const position = renderable.screen_position();
+            KMSOutput::Overlay overlay{
+                std::move(fb),
+                dmabuf->drm_fourcc(),
+                dmabuf->modifier(),
+                dmabuf->size(),
+                {position.top_left - as_displacement(area.top_left), position.size}};
+
+            candidates.emplace(&renderable, std::make_pair(std::move(overlay), std::move(buffer)));
+            return true;
+        }};
+
+    // Keep giving up the lowest overlay until the hardware accepts the rest
+    for (auto overlaid = assignment.overlays(); !overlaid.empty(); overlaid = assignment.overlays())
+    {
+        std::vector<KMSOutput::Overlay> overlays;
+        std::vector<std::shared_ptr<Buffer>> buffers;
+        for (auto const& renderable : overlaid)
+        {
+            auto const& candidate = candidates.at(renderable.get());
+            overlays.push_back(candidate.first);
+            buffers.push_back(candidate.second);
+        }
+
+        auto const composited = assignment.composited();
+
+        // If all that's beneath the overlays is a fullscreen surface we can scan that out too
+        if (composited.size() == 1 && BypassMatch{area}(composited.front()))
+        {
+            if (auto const bufobj = bypass_fb_for(*composited.front()))
+            {
+                if (output->set_overlays(*bufobj, overlays))
                 {
-                    bypass_buf = bypass_buffer;
+                    bypass_buf = composited.front()->buffer();
                     bypass_bufobj = bufobj;
+                    overlay_bufs = std::move(buffers);
+                    overlays_active = true;
+                    to_render.clear();
                     return true;
                 }
             }
         }
+
+        if (output->set_overlays(*primary_fb, overlays))
+        {
+            overlay_bufs = std::move(buffers);
+            overlays_active = true;
+            to_render = composited;
+            return false;
+        }
+
+        assignment.composite_lowest_overlay();
     }
 
-    bypass_buf = nullptr;
-    bypass_bufobj = nullptr;
     return false;
 }
 
+void mgg::DisplayBuffer::clear_overlays()
+{
+    if (overlays_active)
+    {
+        // Clearing overlays doesn't need checking against the primary plane, so any FB will do
+        auto const primary_fb = scheduled_fb ? scheduled_fb : visible_fb;
+        outputs.front()->set_overlays(*primary_fb, {});
+        overlays_active = false;
+    }
+    overlay_bufs.clear();
+}
+
 void mgg::DisplayBuffer::for_each_display_buffer(
     std::function<void(graphics::DisplayBuffer&)> const& f)
 {
@@ -562,11 +693,25 @@ void mgg::DisplayBuffer::for_each_display_buffer(
 
 void mgg::DisplayBuffer::swap_buffers()
 {
+    render_fence = surface.render_fence();
     surface.swap_buffers();
     bypass_buf = nullptr;
     bypass_bufobj = nullptr;
 }
 
+void mgg::DisplayBuffer::swap_buffers_with_damage(std::vector<geometry::Rectangle> const& damage)
+{
+    render_fence = surface.render_fence();
+    surface.swap_buffers_with_damage(damage);
+    bypass_buf = nullptr;
+    bypass_bufobj = nullptr;
+}
+
+int mgg::DisplayBuffer::buffer_age() const
+{
+    return surface.buffer_age();
+}
+
 void mgg::DisplayBuffer::set_crtc(FBHandle const& forced_frame)
 {
     for (auto& output : outputs)
@@ -609,6 +754,8 @@ void mgg::DisplayBuffer::post()
     }
 
     scheduled_fb = std::move(bufobj);
+    scheduled_overlay_frames = std::move(overlay_bufs);
+    overlay_bufs.clear();
     /*
      * Try to schedule a page flip as first preference to avoid tearing.
      * [will complete in a background thread]
@@ -630,10 +777,8 @@ void mgg::DisplayBuffer::post()
         needs_set_crtc = false;
     }
 
-    using namespace std::chrono_literals;  // For operator""ms()
-
-    // Predicted worst case render time for the next frame...
-    auto predicted_render_time = 50ms;
+    auto const submitted = time::PosixTimestamp::now(outputs.front()->last_frame().ust.clock_id);
+    auto const bypassed = static_cast<bool>(bypass_buf);
 
     if (bypass_buf)
     {
@@ -648,10 +793,6 @@ void mgg::DisplayBuffer::post()
          */
         scheduled_bypass_frame = bypass_buf;
         wait_for_page_flip();
-
-        // It's very likely the next frame will be bypassed like this one so
-        // we only need time for kernel page flip scheduling...
-        predicted_render_time = 5ms;
     }
     else
     {
@@ -662,28 +803,95 @@ void mgg::DisplayBuffer::post()
          */
         if (outputs.size() == 1)
             wait_for_page_flip();
-
-        /*
-         * TODO: If you're optimistic about your GPU performance and/or
-         *       measure it carefully you may wish to set predicted_render_time
-         *       to a lower value here for lower latency.
-         *
-         *predicted_render_time = 9ms; // e.g. about the same as Weston
-         */
     }
 
     // Buffer lifetimes are managed exclusively by scheduled*/visible* now
     bypass_buf = nullptr;
     bypass_bufobj = nullptr;
 
+    update_recommended_sleep(submitted, bypassed);
+
+    frame_start = std::nullopt;
+    render_fence = Fd{};
+}
+
+namespace
+{
+/// When the last of the fences in a sync_file signalled, if it has
+auto signal_time(mir::Fd const& fence) -> std::optional<std::chrono::nanoseconds>
+{
+    if (fence == mir::Fd::invalid)
+        return std::nullopt;
+
+    sync_file_info info{};
+    if (ioctl(fence, SYNC_IOC_FILE_INFO, &info) != 0 || info.status != 1 || info.num_fences == 0)
+        return std::nullopt;
+
+    std::vector<sync_fence_info> fences(info.num_fences);
+    info.sync_fence_info = reinterpret_cast<uintptr_t>(fences.data());
+    if (ioctl(fence, SYNC_IOC_FILE_INFO, &info) != 0)
+        return std::nullopt;
+
+    uint64_t last_signalled{0};
+    for (auto const& f : fences)
+        last_signalled = std::max<uint64_t>(last_signalled, f.timestamp_ns);
+
+    return std::chrono::nanoseconds{last_signalled};
+}
+}
+
+void mgg::DisplayBuffer::update_recommended_sleep(time::PosixTimestamp const& submitted, bool bypassed)
+{
+    using namespace std::chrono_literals;  // For operator""ms()
+
     recommend_sleep = 0ms;
-    if (outputs.size() == 1)
+
+    /*
+     * In clone mode we haven't waited for the flip, so there's no vblank to
+     * aim for and no finished frame to learn from.
+     */
+    if (outputs.size() != 1)
+        return;
+
+    auto& predictor = bypassed ? bypass_render_time : composite_render_time;
+    auto const& output = outputs.front();
+    auto const frame_interval = std::chrono::nanoseconds{1s} / output->max_refresh_rate();
+    auto const frame = output->last_frame();
+    auto const vblank_is_new = frame.msc != 0 && (!last_vblank || frame.msc != last_vblank->msc);
+
+    if (vblank_is_new && frame_start && frame.ust.clock_id == frame_start->clock_id)
     {
-        auto const& output = outputs.front();
-        auto const min_frame_interval = 1000ms / output->max_refresh_rate();
-        if (predicted_render_time < min_frame_interval)
-            recommend_sleep = min_frame_interval - predicted_render_time;
+        /*
+         * The frame was ready when it was both submitted and rendered. Fence
+         * timestamps are CLOCK_MONOTONIC, so we can only use them when the
+         * vblank timestamps are too.
+         */
+        auto ready = submitted;
+        if (frame.ust.clock_id == CLOCK_MONOTONIC)
+        {
+            if (auto const rendered = signal_time(render_fence))
+                ready = time::PosixTimestamp{CLOCK_MONOTONIC, std::max(*rendered, submitted.nanoseconds)};
+        }
+
+        std::optional<time::PosixTimestamp> previous_vblank;
+        if (last_vblank && last_vblank->ust.clock_id == frame.ust.clock_id)
+            previous_vblank = last_vblank->ust;
+
+        predictor.record_frame(*frame_start, ready, previous_vblank, frame.ust, frame_interval);
     }
+
+    /*
+     * If the output can't tell us when the flip happened, it has at least
+     * happened by now.
+     */
+    auto const now = time::PosixTimestamp::now(frame.ust.clock_id);
+    auto const vblank = vblank_is_new ? frame.ust : now;
+
+    if (vblank_is_new)
+        last_vblank = frame;
+
+    recommend_sleep = std::chrono::duration_cast<std::chrono::milliseconds>(
+        predictor.delay_before_next_frame(now, vblank, frame_interval));
 }
 
 std::chrono::milliseconds mgg::DisplayBuffer::recommended_sleep() const
@@ -730,6 +938,9 @@ void mgg::DisplayBuffer::wait_for_page_flip()
 
         visible_composite_frame = std::move(scheduled_composite_frame);
         scheduled_composite_frame = nullptr;
+
+        visible_overlay_frames = std::move(scheduled_overlay_frames);
+        scheduled_overlay_frames.clear();
     }
 }
 
@@ -801,11 +1012,27 @@ void mgg::GBMOutputSurface::swap_buffers()
         fatal_error("Failed to perform buffer swap");
 }
 
+void mgg::GBMOutputSurface::swap_buffers_with_damage(std::vector<geometry::Rectangle> const& damage)
+{
+    if (!egl.swap_buffers(damage))
+        fatal_error("Failed to perform buffer swap");
+}
+
+int mgg::GBMOutputSurface::buffer_age() const
+{
+    return egl.buffer_age();
+}
+
 void mgg::GBMOutputSurface::bind()
 {
 
 }
 
+auto mgg::GBMOutputSurface::render_fence() const -> Fd
+{
+    return egl.render_fence();
+}
+
 auto mgg::GBMOutputSurface::lock_front() -> FrontBuffer
 {
     return FrontBuffer{surface.get()};
@@ -25,10 +25,13 @@
 #include "display_helpers.h"
 #include "egl_helper.h"
 #include "platform_common.h"
+#include "render_time_predictor.h"
+#include "mir/graphics/frame.h"
 
 #include <vector>
 #include <memory>
 #include <atomic>
+#include <optional>
 
 namespace mir
 {
@@ -81,8 +84,12 @@ public:
     void make_current() override;
     void release_current() override;
     void swap_buffers() override;
+    void swap_buffers_with_damage(std::vector<geometry::Rectangle> const& damage) override;
+    int buffer_age() const override;
     void bind() override;
 
+    /// \see helpers::EGLHelper::render_fence()
+    auto render_fence() const -> Fd;
     FrontBuffer lock_front();
     void report_egl_configuration(std::function<void(EGLDisplay, EGLConfig)> const& to);
     geometry::Size size() const { return {width, height}; }
@@ -111,7 +118,10 @@ public:
     void make_current() override;
     void release_current() override;
     void swap_buffers() override;
+    void swap_buffers_with_damage(std::vector<geometry::Rectangle> const& damage) override;
+    int buffer_age() const override;
     bool overlay(RenderableList const& renderlist) override;
+    bool overlay_partially(RenderableList const& renderlist, RenderableList& to_render) override;
     void bind() override;
 
     void for_each_display_buffer(
@@ -129,10 +139,17 @@ public:
 private:
     bool schedule_page_flip(FBHandle const& bufobj);
     void set_crtc(FBHandle const&);
+    auto bypass_fb_for(Renderable const& renderable) const -> std::shared_ptr<FBHandle const>;
+    void clear_overlays();
+    /// Learns from how long the frame just posted took, and works out when to start the next
+    void update_recommended_sleep(time::PosixTimestamp const& submitted, bool bypassed);
 
     std::shared_ptr<graphics::Buffer> visible_bypass_frame, scheduled_bypass_frame;
     std::shared_ptr<Buffer> bypass_buf{nullptr};
     std::shared_ptr<FBHandle const> bypass_bufobj{nullptr};
+    /// The client buffers on overlay planes, from when they're picked until they're off screen
+    std::vector<std::shared_ptr<Buffer>> overlay_bufs, scheduled_overlay_frames, visible_overlay_frames;
+    bool overlays_active{false};
     std::shared_ptr<DisplayReport> const listener;
     BypassOption bypass_option;
 
@@ -157,6 +174,13 @@ private:
     glm::mat2 transform;
     std::atomic<bool> needs_set_crtc;
     std::chrono::milliseconds recommend_sleep{0};
+    RenderTimePredictor composite_render_time;
+    RenderTimePredictor bypass_render_time;
+    /// When compositing of the current frame began
+    std::optional<time::PosixTimestamp> frame_start;
+    /// Signals when the GPU has finished rendering the current frame, if the driver can tell us
+    Fd render_fence;
+    std::optional<Frame> last_vblank;
     bool page_flips_pending;
 };
 
@@ -21,6 +21,9 @@
 #include "mir/graphics/egl_error.h"
 #include <boost/exception/errinfo_errno.hpp>
 #include <boost/throw_exception.hpp>
+#include <GLES2/gl2.h>
+
+#include <cstring>
 
 #define MIR_LOG_COMPONENT "EGL"
 #include "mir/log.h"
@@ -34,7 +37,8 @@ mgmh::EGLHelper::EGLHelper(GLConfig const& gl_config)
       stencil_buffer_bits{gl_config.stencil_buffer_bits()},
       egl_display{EGL_NO_DISPLAY}, egl_config{0},
       egl_context{EGL_NO_CONTEXT}, egl_surface{EGL_NO_SURFACE},
-      should_terminate_egl{false}
+      should_terminate_egl{false},
+      has_buffer_age{false}
 {
 }
 
@@ -55,7 +59,10 @@ mgmh::EGLHelper::EGLHelper(EGLHelper&& from)
       egl_config{from.egl_config},
       egl_context{from.egl_context},
       egl_surface{from.egl_surface},
-      should_terminate_egl{from.should_terminate_egl}
+      should_terminate_egl{from.should_terminate_egl},
+      has_buffer_age{from.has_buffer_age},
+      swap_with_damage{from.swap_with_damage},
+      native_fence{from.native_fence}
 {
     from.should_terminate_egl = false;
     from.egl_display = EGL_NO_DISPLAY;
@@ -121,6 +128,13 @@ void mgmh::EGLHelper::setup(
     if(egl_surface == EGL_NO_SURFACE)
         BOOST_THROW_EXCEPTION(mg::egl_error("Failed to create EGL window surface"));
 
+    auto const extensions = eglQueryString(egl_display, EGL_EXTENSIONS);
+    has_buffer_age = extensions && strstr(extensions, "EGL_EXT_buffer_age");
+    if (auto const ext = mg::EGLExtensions::SwapBuffersWithDamage::maybe_swap_buffers_with_damage(egl_display))
+        swap_with_damage.emplace(ext.value());
+    if (auto const ext = mg::EGLExtensions::NativeFenceSync::maybe_native_fence_sync(egl_display))
+        native_fence.emplace(ext.value());
+
     egl_context = eglCreateContext(egl_display, egl_config, shared_context, context_attr);
     if (egl_context == EGL_NO_CONTEXT)
         BOOST_THROW_EXCEPTION(mg::egl_error("Failed to create EGL context"));
@@ -149,6 +163,51 @@ bool mgmh::EGLHelper::swap_buffers()
     return (ret == EGL_TRUE);
 }
 
+bool mgmh::EGLHelper::swap_buffers(std::vector<geometry::Rectangle> const& damage)
+{
+    if (!swap_with_damage)
+        return swap_buffers();
+
+    std::vector<EGLint> rects;
+    rects.reserve(damage.size() * 4);
+    for (auto const& rect : damage)
+    {
+        rects.push_back(rect.top_left.x.as_int());
+        rects.push_back(rect.top_left.y.as_int());
+        rects.push_back(rect.size.width.as_int());
+        rects.push_back(rect.size.height.as_int());
+    }
+
+    auto ret = swap_with_damage->eglSwapBuffersWithDamage(
+        egl_display, egl_surface, rects.data(), static_cast<EGLint>(damage.size()));
+    return (ret == EGL_TRUE);
+}
+
+int mgmh::EGLHelper::buffer_age() const
+{
+    EGLint age{0};
+    if (!has_buffer_age || eglQuerySurface(egl_display, egl_surface, EGL_BUFFER_AGE_EXT, &age) != EGL_TRUE)
+        return 0;
+    return age;
+}
+
+auto mgmh::EGLHelper::render_fence() const -> Fd
+{
+    if (!native_fence)
+        return Fd{};
+
+    auto const sync = native_fence->eglCreateSyncKHR(egl_display, EGL_SYNC_NATIVE_FENCE_ANDROID, nullptr);
+    if (sync == EGL_NO_SYNC_KHR)
+        return Fd{};
+
+    // The fence fd only exists once the fence command has been flushed to the GPU
+    glFlush();
+    Fd fence{native_fence->eglDupNativeFenceFDANDROID(egl_display, sync)};
+    native_fence->eglDestroySyncKHR(egl_display, sync);
+
+    return fence;
+}
+
 bool mgmh::EGLHelper::make_current() const
 {
     auto ret = eglMakeCurrent(egl_display, egl_surface, egl_surface, egl_context);
@@ -21,8 +21,13 @@
 
 #include "display_helpers.h"
 #include "mir/graphics/egl_extensions.h"
+#include "mir/geometry/rectangle.h"
+#include "mir/fd.h"
 #include <EGL/egl.h>
 
+#include <optional>
+#include <vector>
+
 namespace mir
 {
 namespace graphics
@@ -52,6 +57,16 @@ public:
     void setup(GBMHelper const& gbm, gbm_surface* surface_gbm, EGLContext shared_context, bool owns_egl);
 
     bool swap_buffers();
+    /// Damage is in GL window coordinates; falls back to a full swap if unsupported
+    bool swap_buffers(std::vector<geometry::Rectangle> const& damage);
+    /// The age of the back buffer per EGL_EXT_buffer_age, or 0 if unsupported
+    int buffer_age() const;
+    /**
+     * A sync_file that signals once the GL commands issued so far have completed.
+     * Flushes the GL command stream. Invalid if EGL_ANDROID_native_fence_sync is
+     * unsupported.
+     */
+    auto render_fence() const -> Fd;
     bool make_current() const;
     bool release_current() const;
 
@@ -69,6 +84,9 @@ private:
     EGLSurface egl_surface;
     bool should_terminate_egl;
     EGLExtensions::PlatformBaseEXT platform_base;
+    bool has_buffer_age;
+    std::optional<EGLExtensions::SwapBuffersWithDamage> swap_with_damage;
+    std::optional<EGLExtensions::NativeFenceSync> native_fence;
 };
 }
 }
@@ -22,6 +22,7 @@
 #include "mir/geometry/size.h"
 #include "mir/geometry/point.h"
 #include "mir/geometry/displacement.h"
+#include "mir/geometry/rectangle.h"
 #include "mir/graphics/display_configuration.h"
 #include "mir/graphics/frame.h"
 #include "mir/graphics/dmabuf_buffer.h"
@@ -31,6 +32,10 @@
 
 #include <gbm.h>
 
+#include <memory>
+#include <optional>
+#include <vector>
+
 namespace mir
 {
 namespace graphics
@@ -45,6 +50,19 @@ class FBHandle;
 class KMSOutput
 {
 public:
+    /**
+     * A buffer to scan out on a hardware plane above the primary plane
+     */
+    struct Overlay
+    {
+        std::shared_ptr<FBHandle const> fb;
+        uint32_t drm_fourcc;
+        std::optional<uint64_t> modifier;
+        geometry::Size buffer_size;
+        /// Where to show the whole buffer, relative to the output's top left
+        geometry::Rectangle destination;
+    };
+
     virtual ~KMSOutput() = default;
 
     /*
@@ -70,6 +88,19 @@ public:
     virtual bool schedule_page_flip(FBHandle const& fb) = 0;
     virtual void wait_for_page_flip() = 0;
 
+    /**
+     * Show overlays on hardware planes above the primary plane, from the next
+     * schedule_page_flip() or set_crtc() on.
+     *
+     * \param [in] primary     An FB like the ones the primary plane will show,
+     *                          used to check the hardware accepts the combination
+     * \param [in] overlays    The buffers to show, bottom to top
+     * \returns    True if the hardware can show overlays;
+     *              False (leaving the current overlays in place) if it can't.
+     *              Clearing the overlays always succeeds.
+     */
+    virtual bool set_overlays(FBHandle const& primary, std::vector<Overlay> const& overlays) = 0;
+
     virtual bool set_cursor(gbm_bo* buffer) = 0;
     virtual void move_cursor(geometry::Point destination) = 0;
     virtual bool clear_cursor() = 0;
@@ -88,6 +88,27 @@ bool mgg::KMSPageFlipper::schedule_flip(uint32_t crtc_id,
     return (ret == 0);
 }
 
+bool mgg::KMSPageFlipper::schedule_atomic_flip(uint32_t crtc_id,
+                                               drmModeAtomicReq* request,
+                                               uint32_t connector_id)
+{
+    std::unique_lock<std::mutex> lock{pf_mutex};
+
+    if (pending_page_flips.find(crtc_id) != pending_page_flips.end())
+        BOOST_THROW_EXCEPTION(std::logic_error("Page flip for crtc_id is already scheduled"));
+
+    pending_page_flips[crtc_id] = PageFlipEventData{crtc_id, connector_id, this};
+
+    auto ret = drmModeAtomicCommit(drm_fd, request,
+                                   DRM_MODE_ATOMIC_NONBLOCK | DRM_MODE_PAGE_FLIP_EVENT,
+                                   &pending_page_flips[crtc_id]);
+
+    if (ret)
+        pending_page_flips.erase(crtc_id);
+
+    return (ret == 0);
+}
+
 mg::Frame mgg::KMSPageFlipper::wait_for_flip(uint32_t crtc_id)
 {
     drmEventContext evctx;
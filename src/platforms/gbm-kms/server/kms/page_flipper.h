@@ -22,6 +22,8 @@
 #include "mir/graphics/frame.h"
 #include <cstdint>
 
+#include <xf86drmMode.h>
+
 namespace mir
 {
 namespace graphics
@@ -35,6 +37,14 @@ public:
     virtual ~PageFlipper() {}
 
     virtual bool schedule_flip(uint32_t crtc_id, uint32_t fb_id, uint32_t connector_id) = 0;
+    /**
+     * Commit an atomic request, completing like a page flip on crtc_id.
+     *
+     * The request may update any state that can change without a modeset.
+     * Only one request can be in flight on a CRTC: until wait_for_flip()
+     * returns, another is rejected rather than queued.
+     */
+    virtual bool schedule_atomic_flip(uint32_t crtc_id, drmModeAtomicReq* request, uint32_t connector_id) = 0;
     virtual Frame wait_for_flip(uint32_t crtc_id) = 0;
 
 protected:
@@ -17,6 +17,7 @@
  */
 
 #include "real_kms_output.h"
+#include "fb_handle.h"
 #include "mir/graphics/display_configuration.h"
 #include "page_flipper.h"
 #include "kms-utils/kms_connector.h"
@@ -34,31 +35,6 @@ namespace mgg = mg::gbm;
 namespace mgk = mg::kms;
 namespace geom = mir::geometry;
 
-class mgg::FBHandle
-{
-public:
-    FBHandle(int drm_fd, uint32_t fb_id)
-        : drm_fd{drm_fd},
-          fb_id{fb_id}
-    {
-    }
-
-    ~FBHandle()
-    {
-        // TODO: Some sort of logging on failure?
-        drmModeRmFB(drm_fd, fb_id);
-    }
-
-    auto get_drm_fb_id() const -> uint32_t
-    {
-        return fb_id;
-    }
-private:
-    int const drm_fd;
-    uint32_t const fb_id;
-};
-
-
 mgg::RealKMSOutput::RealKMSOutput(
     int drm_fd,
     kms::DRMModeConnectorUPtr&& connector,
@@ -250,6 +226,12 @@ void mgg::RealKMSOutput::wait_for_page_flip()
     last_frame_.store(page_flipper->wait_for_flip(current_crtc->crtc_id));
 }
 
+bool mgg::RealKMSOutput::set_overlays(FBHandle const&, std::vector<Overlay> const& overlays)
+{
+    // Legacy KMS has no way to flip overlay planes in step with the primary plane
+    return overlays.empty();
+}
+
 mg::Frame mgg::RealKMSOutput::last_frame() const
 {
     return last_frame_.load();
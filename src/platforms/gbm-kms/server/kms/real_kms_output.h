@@ -55,6 +55,7 @@ public:
     void clear_crtc() override;
     bool schedule_page_flip(FBHandle const& fb) override;
     void wait_for_page_flip() override;
+    bool set_overlays(FBHandle const& primary, std::vector<Overlay> const& overlays) override;
 
     bool set_cursor(gbm_bo* buffer) override;
     void move_cursor(geometry::Point destination) override;
@@ -75,7 +76,7 @@ public:
     bool buffer_requires_migration(gbm_bo* bo) const override;
     int drm_fd() const override;
 
-private:
+protected:
     bool ensure_crtc();
     void restore_saved_crtc();
 
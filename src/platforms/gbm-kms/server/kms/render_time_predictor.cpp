@@ -0,0 +1,90 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "render_time_predictor.h"
+
+#include <algorithm>
+
+namespace mgg = mir::graphics::gbm;
+namespace mt = mir::time;
+
+using namespace std::chrono_literals;
+
+namespace
+{
+/// Allowance for the compositor thread waking up late from its sleep
+auto constexpr scheduling_slack = 1ms;
+}
+
+mgg::RenderTimePredictor::RenderTimePredictor(std::chrono::nanoseconds initial_prediction)
+    : initial_prediction{initial_prediction}
+{
+}
+
+void mgg::RenderTimePredictor::record_frame(
+    mt::PosixTimestamp const& started,
+    mt::PosixTimestamp const& ready,
+    std::optional<mt::PosixTimestamp> const& previous_vblank,
+    mt::PosixTimestamp const& vblank,
+    std::chrono::nanoseconds frame_interval)
+{
+    auto const render_time = std::max(ready - started, std::chrono::nanoseconds::zero());
+
+    if (previous_vblank && frame_interval > frame_interval.zero() && started > *previous_vblank)
+    {
+        // The vblank we were aiming for is the first one the prediction said we could make
+        auto const earliest_ready = started + prediction();
+        auto const intervals = (earliest_ready - *previous_vblank + frame_interval - 1ns) / frame_interval;
+        auto const target = *previous_vblank + intervals * frame_interval;
+
+        if (vblank > target + frame_interval / 2)
+        {
+            // Whatever held us up wasn't measured, so back off by a chunk of a frame
+            add_sample(std::max(render_time, prediction() + frame_interval / 4));
+            return;
+        }
+    }
+
+    add_sample(render_time);
+}
+
+void mgg::RenderTimePredictor::add_sample(std::chrono::nanoseconds render_time)
+{
+    history[next_sample] = render_time;
+    next_sample = (next_sample + 1) % history_size;
+    samples = std::min(samples + 1, history_size);
+}
+
+auto mgg::RenderTimePredictor::prediction() const -> std::chrono::nanoseconds
+{
+    if (samples == 0)
+        return initial_prediction;
+
+    return *std::max_element(history.begin(), history.begin() + samples) + scheduling_slack;
+}
+
+auto mgg::RenderTimePredictor::delay_before_next_frame(
+    mt::PosixTimestamp const& now,
+    mt::PosixTimestamp const& last_vblank,
+    std::chrono::nanoseconds frame_interval) const -> std::chrono::nanoseconds
+{
+    auto const start_by = last_vblank + frame_interval - prediction();
+
+    if (start_by > now)
+        return start_by - now;
+
+    return std::chrono::nanoseconds::zero();
+}
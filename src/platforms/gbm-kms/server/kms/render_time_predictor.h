@@ -0,0 +1,93 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_GBM_RENDER_TIME_PREDICTOR_H_
+#define MIR_GRAPHICS_GBM_RENDER_TIME_PREDICTOR_H_
+
+#include "mir/time/posix_timestamp.h"
+
+#include <array>
+#include <chrono>
+#include <optional>
+
+namespace mir
+{
+namespace graphics
+{
+namespace gbm
+{
+
+/**
+ * Predicts how long the next frame will take to be ready for scanout, so
+ * that compositing can start as late as possible before the vblank it's
+ * aiming for.
+ *
+ * The prediction is the worst of the recently measured frames plus a little
+ * slack for scheduling jitter. A frame that misses its vblank anyway pushes
+ * the prediction up further, so the cost of a bad guess is only paid once.
+ */
+class RenderTimePredictor
+{
+public:
+    /// \param [in] initial_prediction  What to predict until there are measurements
+    explicit RenderTimePredictor(std::chrono::nanoseconds initial_prediction);
+
+    /**
+     * Record the timing of a frame that has reached the screen.
+     *
+     * \param [in] started          When compositing the frame began
+     * \param [in] ready            When the frame was ready for scanout: both
+     *                              submitted for page flip and finished rendering
+     * \param [in] previous_vblank  When the previous frame reached the screen, if known
+     * \param [in] vblank           When this frame reached the screen
+     * \param [in] frame_interval   The output's refresh interval
+     */
+    void record_frame(
+        time::PosixTimestamp const& started,
+        time::PosixTimestamp const& ready,
+        std::optional<time::PosixTimestamp> const& previous_vblank,
+        time::PosixTimestamp const& vblank,
+        std::chrono::nanoseconds frame_interval);
+
+    /// How long the next frame is expected to take from starting to being ready for scanout
+    auto prediction() const -> std::chrono::nanoseconds;
+
+    /**
+     * How long to wait after now before starting the next frame, so that it
+     * will be ready just before the first vblank after last_vblank.
+     */
+    auto delay_before_next_frame(
+        time::PosixTimestamp const& now,
+        time::PosixTimestamp const& last_vblank,
+        std::chrono::nanoseconds frame_interval) const -> std::chrono::nanoseconds;
+
+private:
+    void add_sample(std::chrono::nanoseconds render_time);
+
+    /// About a second of frames at typical refresh rates
+    static size_t constexpr history_size = 64;
+
+    std::chrono::nanoseconds const initial_prediction;
+    std::array<std::chrono::nanoseconds, history_size> history;
+    size_t samples{0};
+    size_t next_sample{0};
+};
+
+}
+}
+}
+
+#endif /* MIR_GRAPHICS_GBM_RENDER_TIME_PREDICTOR_H_ */
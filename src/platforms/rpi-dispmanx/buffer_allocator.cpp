@@ -495,7 +495,9 @@ private:
 auto mg::rpi::BufferAllocator::buffer_from_shm(
     wl_resource* buffer,
     std::shared_ptr<mir::Executor> /*wayland_executor*/,
-    std::function<void()>&& on_consumed) -> std::shared_ptr<Buffer>
+    std::function<void()>&& on_consumed,
+    std::shared_ptr<Buffer> const& /*previous*/,
+    std::experimental::optional<std::vector<geometry::Rectangle>> const& /*damage*/) -> std::shared_ptr<Buffer>
 {
     auto shm_buffer = wl_shm_buffer_get(buffer);
     if (shm_buffer == nullptr)
@@ -16,12 +16,17 @@
  */
 
 #include "displayclient.h"
+#include "plane_assignment.h"
+#include "linux-dmabuf-unstable-v1-client-protocol.h"
 #include "mir/graphics/egl_error.h"
+#include <mir/graphics/buffer.h>
+#include <mir/graphics/dmabuf_buffer.h>
 #include <mir/graphics/pixel_format_utils.h>
 
 #include <wayland-client.h>
 #include <wayland-egl.h>
 
+#include <drm_fourcc.h>
 #include <fcntl.h>
 #include <sys/mman.h>
 #include <xkbcommon/xkbcommon.h>
@@ -30,6 +35,7 @@
 
 #include <algorithm>
 #include <condition_variable>
+#include <cstdint>
 #include <cstring>
 #include <stdlib.h>
 #include <system_error>
@@ -103,6 +109,7 @@ public:
     // DisplayBuffer implementation
     auto view_area() const -> geometry::Rectangle override;
     bool overlay(RenderableList const& renderlist) override;
+    bool overlay_partially(RenderableList const& renderlist, RenderableList& to_render) override;
     auto transformation() const -> glm::mat2 override;
     auto native_display_buffer() -> NativeDisplayBuffer* override;
 
@@ -110,7 +117,61 @@ public:
     void make_current() override;
     void release_current() override;
     void swap_buffers() override;
+    void swap_buffers_with_damage(std::vector<geometry::Rectangle> const& damage) override;
+    int buffer_age() const override;
     void bind() override;
+
+    /// A client's dmabuf imported into the host, so the host can show it without us compositing it
+    struct HostBuffer;
+    /// A subsurface of our window, showing a client's buffer
+    struct Subsurface;
+
+    bool can_pass_through(Renderable const& renderable) const;
+    auto host_buffer_for(DMABufBuffer const& dmabuf) -> HostBuffer&;
+    void show_on_subsurfaces(RenderableList const& overlays);
+    void forget_unused_host_buffers();
+
+    std::vector<std::unique_ptr<Subsurface>> subsurfaces;
+    std::vector<std::unique_ptr<HostBuffer>> host_buffers;
+    uint64_t frame_count{0};
+    /// The subsurfaces hide our window entirely, so post() commits the frame instead of swap_buffers()
+    bool fully_overlaid{false};
+};
+
+struct mgw::DisplayClient::Output::HostBuffer
+{
+    HostBuffer(zwp_linux_dmabuf_v1* linux_dmabuf, DMABufBuffer const& dmabuf);
+    ~HostBuffer();
+
+    HostBuffer(HostBuffer const&) = delete;
+    HostBuffer& operator=(HostBuffer const&) = delete;
+
+    bool imports(DMABufBuffer const& dmabuf) const;
+
+    /// Keeps the dmabuf open, so its fd can't be reused for another buffer while we recognise it by that
+    Fd const dma_buf;
+    uint32_t const format;
+    geometry::Size const size;
+    wl_buffer* const buffer;
+
+    std::mutex mutex;
+    /// The client's buffer, held until the host releases it so the client doesn't draw into it while it is shown
+    std::shared_ptr<Buffer> busy;
+    uint64_t last_used{0};
+};
+
+struct mgw::DisplayClient::Output::Subsurface
+{
+    Subsurface(DisplayClient const* owner, wl_surface* parent);
+    ~Subsurface();
+
+    Subsurface(Subsurface const&) = delete;
+    Subsurface& operator=(Subsurface const&) = delete;
+
+    wl_surface* const surface;
+    wl_subsurface* const subsurface;
+    /// What is attached, so we only attach (and damage) a new buffer
+    std::optional<BufferID> shown;
 };
 
 namespace
@@ -120,6 +181,51 @@ static EGLint const ctxattribs[] =
         EGL_CONTEXT_CLIENT_VERSION, 2,
         EGL_NONE
     };
+
+/// Host buffers we haven't shown for this many frames are destroyed
+uint64_t const max_idle_frames{60};
+
+/// Waits for the host's frame "done" for the next commit of a surface
+class FrameSync
+{
+public:
+    explicit FrameSync(wl_surface* surface) :
+        callback{wl_surface_frame(surface)}
+    {
+        static struct wl_callback_listener const frame_listener =
+            {
+                [](void* data, auto... args)
+                    { static_cast<FrameSync*>(data)->frame_done(args...); },
+            };
+
+        wl_callback_add_listener(callback, &frame_listener, this);
+    }
+
+    ~FrameSync()
+    {
+        wl_callback_destroy(callback);
+    }
+
+    void wait_for_done()
+    {
+        std::unique_lock<decltype(mutex)> lock{mutex};
+        cv.wait(lock, [this]{ return posted; });
+    }
+
+private:
+    void frame_done(wl_callback*, uint32_t)
+    {
+        std::lock_guard<decltype(mutex)> lock{mutex};
+        posted = true;
+        cv.notify_all();
+    }
+
+    std::mutex mutex;
+    bool posted = false;
+    std::condition_variable cv;
+
+    wl_callback* const callback;
+};
 }
 
 void mgw::DisplayClient::Output::geometry(
@@ -259,6 +365,9 @@ mgw::DisplayClient::Output::Output(
 
 mgw::DisplayClient::Output::~Output()
 {
+    subsurfaces.clear();
+    host_buffers.clear();
+
     if (output)
         wl_output_destroy(output);
 
@@ -316,6 +425,14 @@ void mgw::DisplayClient::Output::for_each_display_buffer(std::function<void(Disp
 
 void mgw::DisplayClient::Output::post()
 {
+    if (!fully_overlaid)
+        return;
+
+    // Nothing was rendered, so there was no eglSwapBuffers() to commit the subsurfaces' new buffers
+    FrameSync frame_sync{surface};
+    wl_surface_commit(surface);
+    wl_display_flush(owner->display);
+    frame_sync.wait_for_done();
 }
 
 auto mgw::DisplayClient::Output::recommended_sleep() const -> std::chrono::milliseconds
@@ -333,6 +450,210 @@ bool mgw::DisplayClient::Output::overlay(mir::graphics::RenderableList const&)
     return false;
 }
 
+bool mgw::DisplayClient::Output::overlay_partially(RenderableList const& renderlist, RenderableList& to_render)
+{
+    ++frame_count;
+    RenderableList overlays;
+
+    // Subsurfaces are positioned in surface coordinates, so we only pass buffers through when that's 1:1
+    if (owner->subcompositor && owner->linux_dmabuf && round(dcout.scale) == 1)
+    {
+        common::PlaneAssignment const assignment{
+            renderlist,
+            view_area(),
+            [this](Renderable const& renderable) { return can_pass_through(renderable); }};
+
+        overlays = assignment.overlays();
+        to_render = assignment.composited();
+    }
+    else
+    {
+        to_render = renderlist;
+    }
+
+    show_on_subsurfaces(overlays);
+    forget_unused_host_buffers();
+
+    // Our window is still shown beneath the subsurfaces, so we can only skip drawing it if they hide it
+    fully_overlaid =
+        to_render.empty() &&
+        !overlays.empty() &&
+        overlays.front()->screen_position().contains(view_area()) &&
+        !overlays.front()->shaped();
+
+    return fully_overlaid;
+}
+
+bool mgw::DisplayClient::Output::can_pass_through(Renderable const& renderable) const
+{
+    auto const buffer = renderable.buffer();
+    auto const dmabuf = dynamic_cast<DMABufBuffer const*>(buffer->native_buffer_base());
+
+    // The host shows a subsurface's buffer unscaled, so it has to be the size it is shown at
+    return dmabuf &&
+        buffer->size() == renderable.screen_position().size &&
+        owner->host_supports_dmabuf(dmabuf->drm_fourcc(), dmabuf->modifier());
+}
+
+void mgw::DisplayClient::Output::show_on_subsurfaces(RenderableList const& overlays)
+{
+    while (subsurfaces.size() < overlays.size())
+        subsurfaces.push_back(std::make_unique<Subsurface>(owner, surface));
+
+    auto below = surface;
+    for (size_t i = 0; i != overlays.size(); ++i)
+    {
+        auto& subsurface = *subsurfaces[i];
+        auto const& renderable = *overlays[i];
+        auto const buffer = renderable.buffer();
+        auto& host_buffer = host_buffer_for(*dynamic_cast<DMABufBuffer const*>(buffer->native_buffer_base()));
+
+        // Position and stacking are applied with our window's next commit, along with the subsurface's own state
+        auto const position = renderable.screen_position().top_left - view_area().top_left;
+        wl_subsurface_set_position(subsurface.subsurface, position.dx.as_int(), position.dy.as_int());
+        wl_subsurface_place_above(subsurface.subsurface, below);
+        below = subsurface.surface;
+
+        if (subsurface.shown == buffer->id())
+            continue;
+
+        {
+            std::lock_guard<decltype(host_buffer.mutex)> lock{host_buffer.mutex};
+            host_buffer.busy = buffer;
+        }
+
+        wl_surface_attach(subsurface.surface, host_buffer.buffer, 0, 0);
+
+        auto const damage_buffer = wl_proxy_get_version(reinterpret_cast<wl_proxy*>(subsurface.surface)) >=
+            WL_SURFACE_DAMAGE_BUFFER_SINCE_VERSION ? &wl_surface_damage_buffer : &wl_surface_damage;
+
+        // Unscaled and untransformed, so buffer coordinates are also surface coordinates
+        auto const damage = subsurface.shown ?
+            renderable.damage_since(subsurface.shown.value()) : std::experimental::nullopt;
+
+        if (damage)
+        {
+            for (auto const& rect : damage.value())
+            {
+                damage_buffer(
+                    subsurface.surface,
+                    rect.top_left.x.as_int(), rect.top_left.y.as_int(),
+                    rect.size.width.as_int(), rect.size.height.as_int());
+            }
+        }
+        else
+        {
+            damage_buffer(subsurface.surface, 0, 0, INT32_MAX, INT32_MAX);
+        }
+
+        wl_surface_commit(subsurface.surface);
+        subsurface.shown = buffer->id();
+    }
+
+    for (auto i = overlays.size(); i != subsurfaces.size(); ++i)
+    {
+        auto& subsurface = *subsurfaces[i];
+        if (subsurface.shown)
+        {
+            wl_surface_attach(subsurface.surface, nullptr, 0, 0);
+            wl_surface_commit(subsurface.surface);
+            subsurface.shown = std::nullopt;
+        }
+    }
+}
+
+auto mgw::DisplayClient::Output::host_buffer_for(DMABufBuffer const& dmabuf) -> HostBuffer&
+{
+    auto found = std::find_if(begin(host_buffers), end(host_buffers), [&](auto const& host_buffer)
+        { return host_buffer->imports(dmabuf); });
+
+    if (found == end(host_buffers))
+    {
+        host_buffers.push_back(std::make_unique<HostBuffer>(owner->linux_dmabuf, dmabuf));
+        found = end(host_buffers) - 1;
+    }
+
+    (*found)->last_used = frame_count;
+    return **found;
+}
+
+void mgw::DisplayClient::Output::forget_unused_host_buffers()
+{
+    host_buffers.erase(
+        std::remove_if(begin(host_buffers), end(host_buffers), [this](auto const& host_buffer)
+            {
+                std::lock_guard<decltype(host_buffer->mutex)> lock{host_buffer->mutex};
+                return !host_buffer->busy && frame_count - host_buffer->last_used > max_idle_frames;
+            }),
+        end(host_buffers));
+}
+
+mgw::DisplayClient::Output::HostBuffer::HostBuffer(zwp_linux_dmabuf_v1* linux_dmabuf, DMABufBuffer const& dmabuf) :
+    dma_buf{dmabuf.planes().front().dma_buf},
+    format{dmabuf.drm_fourcc()},
+    size{dmabuf.size()},
+    buffer{[&]
+        {
+            auto const params = zwp_linux_dmabuf_v1_create_params(linux_dmabuf);
+            auto const modifier = dmabuf.modifier().value_or(DRM_FORMAT_MOD_INVALID);
+
+            uint32_t plane_index{0};
+            for (auto const& plane : dmabuf.planes())
+            {
+                zwp_linux_buffer_params_v1_add(
+                    params, plane.dma_buf, plane_index++, plane.offset, plane.stride, modifier >> 32, modifier & 0xffffffff);
+            }
+
+            // We only import formats the host has advertised, so it has no reason to fail
+            auto const buffer = zwp_linux_buffer_params_v1_create_immed(
+                params, size.width.as_int(), size.height.as_int(), format, 0);
+            zwp_linux_buffer_params_v1_destroy(params);
+            return buffer;
+        }()}
+{
+    static wl_buffer_listener const buffer_listener{
+        [](void* data, wl_buffer*)
+            {
+                auto const self = static_cast<HostBuffer*>(data);
+                std::lock_guard<decltype(self->mutex)> lock{self->mutex};
+                self->busy.reset();
+            }
+    };
+
+    wl_buffer_add_listener(buffer, &buffer_listener, this);
+}
+
+mgw::DisplayClient::Output::HostBuffer::~HostBuffer()
+{
+    wl_buffer_destroy(buffer);
+}
+
+bool mgw::DisplayClient::Output::HostBuffer::imports(DMABufBuffer const& dmabuf) const
+{
+    return static_cast<int>(dmabuf.planes().front().dma_buf) == static_cast<int>(dma_buf) &&
+        dmabuf.drm_fourcc() == format &&
+        dmabuf.size() == size;
+}
+
+mgw::DisplayClient::Output::Subsurface::Subsurface(DisplayClient const* owner, wl_surface* parent) :
+    surface{wl_compositor_create_surface(owner->compositor)},
+    subsurface{wl_subcompositor_get_subsurface(owner->subcompositor, surface, parent)}
+{
+    // Keep the subsurfaces' buffers in step with the frame composited into our window
+    wl_subsurface_set_sync(subsurface);
+
+    // Input goes to our window, as though the subsurfaces weren't there
+    auto const empty = wl_compositor_create_region(owner->compositor);
+    wl_surface_set_input_region(surface, empty);
+    wl_region_destroy(empty);
+}
+
+mgw::DisplayClient::Output::Subsurface::~Subsurface()
+{
+    wl_subsurface_destroy(subsurface);
+    wl_surface_destroy(surface);
+}
+
 auto mgw::DisplayClient::Output::transformation() const -> glm::mat2
 {
     return glm::mat2{1};
@@ -359,55 +680,56 @@ void mgw::DisplayClient::Output::release_current()
 
 void mgw::DisplayClient::Output::swap_buffers()
 {
-    struct FrameSync
-    {
-        explicit FrameSync(wl_surface* surface) :
-            callback{wl_surface_frame(surface)}
-        {
-            static struct wl_callback_listener const frame_listener =
-                {
-                    [](void* data, auto... args)
-                        { static_cast<FrameSync*>(data)->frame_done(args...); },
-                };
+    FrameSync frame_sync{surface};
 
-            wl_callback_add_listener(callback, &frame_listener, this);
-        }
+    // Avoid throttling compositing by blocking in eglSwapBuffers().
+    // Instead we use the frame "done" notification.
+    eglSwapInterval(owner->egldisplay, 0);
 
-        ~FrameSync()
-        {
-            wl_callback_destroy(callback);
-        }
+    if (eglSwapBuffers(owner->egldisplay, eglsurface) != EGL_TRUE)
+        BOOST_THROW_EXCEPTION(egl_error("Failed to perform buffer swap"));
 
-        void frame_done(wl_callback*, uint32_t)
-        {
-            std::lock_guard<decltype(mutex)> lock{mutex};
-            posted = true;
-            cv.notify_all();
-        }
+    frame_sync.wait_for_done();
+}
 
-        void wait_for_done()
-        {
-            std::unique_lock<decltype(mutex)> lock{mutex};
-            cv.wait(lock, [this]{ return posted; });
-        }
+void mgw::DisplayClient::Output::swap_buffers_with_damage(std::vector<geometry::Rectangle> const& damage)
+{
+    if (!owner->swap_with_damage)
+    {
+        swap_buffers();
+        return;
+    }
 
-        std::mutex mutex;
-        bool posted = false;
-        std::condition_variable cv;
+    // Both GL window coordinates, and Mesa passes them on to the host as wl_surface.damage_buffer
+    std::vector<EGLint> rects;
+    rects.reserve(damage.size() * 4);
+    for (auto const& rect : damage)
+    {
+        rects.push_back(rect.top_left.x.as_int());
+        rects.push_back(rect.top_left.y.as_int());
+        rects.push_back(rect.size.width.as_int());
+        rects.push_back(rect.size.height.as_int());
+    }
 
-        wl_callback* const callback;
-    } frame_sync{surface};
+    FrameSync frame_sync{surface};
 
-    // Avoid throttling compositing by blocking in eglSwapBuffers().
-    // Instead we use the frame "done" notification.
     eglSwapInterval(owner->egldisplay, 0);
 
-    if (eglSwapBuffers(owner->egldisplay, eglsurface) != EGL_TRUE)
+    if (owner->swap_with_damage->eglSwapBuffersWithDamage(
+            owner->egldisplay, eglsurface, rects.data(), static_cast<EGLint>(damage.size())) != EGL_TRUE)
         BOOST_THROW_EXCEPTION(egl_error("Failed to perform buffer swap"));
 
     frame_sync.wait_for_done();
 }
 
+int mgw::DisplayClient::Output::buffer_age() const
+{
+    EGLint age{0};
+    if (!owner->has_buffer_age || eglQuerySurface(owner->egldisplay, eglsurface, EGL_BUFFER_AGE_EXT, &age) != EGL_TRUE)
+        return 0;
+    return age;
+}
+
 void mgw::DisplayClient::Output::bind()
 {
 }
@@ -468,7 +790,16 @@ mgw::DisplayClient::DisplayClient(
     if (eglctx == EGL_NO_CONTEXT)
         BOOST_THROW_EXCEPTION(egl_error("eglCreateContext failed"));
 
+    auto const extensions = eglQueryString(egldisplay, EGL_EXTENSIONS);
+    has_buffer_age = extensions && strstr(extensions, "EGL_EXT_buffer_age");
+    if (auto const ext = EGLExtensions::SwapBuffersWithDamage::maybe_swap_buffers_with_damage(egldisplay))
+        swap_with_damage.emplace(ext.value());
+
     wl_display_roundtrip(display);
+
+    // A second roundtrip for the events of the globals we bound in the first, such as the host's dmabuf formats
+    if (linux_dmabuf)
+        wl_display_roundtrip(display);
 }
 
 void mgw::DisplayClient::on_output_changed(Output const* /*output*/)
@@ -510,7 +841,7 @@ void mgw::DisplayClient::new_global(
     if (strcmp(interface, "wl_compositor") == 0)
     {
         self->compositor =
-            static_cast<decltype(self->compositor)>(wl_registry_bind(registry, id, &wl_compositor_interface, std::min(version, 3u)));
+            static_cast<decltype(self->compositor)>(wl_registry_bind(registry, id, &wl_compositor_interface, std::min(version, 4u)));
     }
     else if (strcmp(interface, "wl_shm") == 0)
     {
@@ -544,6 +875,18 @@ void mgw::DisplayClient::new_global(
     {
         self->shell = static_cast<decltype(self->shell)>(wl_registry_bind(registry, id, &wl_shell_interface, std::min(version, 1u)));
     }
+    else if (strcmp(interface, "wl_subcompositor") == 0)
+    {
+        self->subcompositor = static_cast<decltype(self->subcompositor)>(
+            wl_registry_bind(registry, id, &wl_subcompositor_interface, std::min(version, 1u)));
+    }
+    else if (strcmp(interface, "zwp_linux_dmabuf_v1") == 0 && version >= 2)
+    {
+        // Version 2 for create_immed, so we don't wait on the host to import a buffer
+        self->linux_dmabuf = static_cast<decltype(self->linux_dmabuf)>(
+            wl_registry_bind(registry, id, &zwp_linux_dmabuf_v1_interface, std::min(version, 3u)));
+        add_linux_dmabuf_listener(self, self->linux_dmabuf);
+    }
 }
 
 void mgw::DisplayClient::remove_global(
@@ -840,6 +1183,41 @@ void mir::graphics::wayland::DisplayClient::shm_format(wl_shm* /*wl_shm*/, uint3
     }
 }
 
+void mgw::DisplayClient::add_linux_dmabuf_listener(DisplayClient* self, zwp_linux_dmabuf_v1* linux_dmabuf)
+{
+    static struct zwp_linux_dmabuf_v1_listener linux_dmabuf_listener =
+        {
+            [](void* self, zwp_linux_dmabuf_v1* linux_dmabuf, uint32_t format)
+                {
+                    // Version 2 hosts only send formats, which they import with an implicit modifier
+                    static_cast<DisplayClient*>(self)->linux_dmabuf_modifier(
+                        linux_dmabuf, format, DRM_FORMAT_MOD_INVALID);
+                },
+            [](void* self, zwp_linux_dmabuf_v1* linux_dmabuf, uint32_t format, uint32_t hi, uint32_t lo)
+                {
+                    static_cast<DisplayClient*>(self)->linux_dmabuf_modifier(
+                        linux_dmabuf, format, (uint64_t{hi} << 32) | lo);
+                },
+        };
+
+    zwp_linux_dmabuf_v1_add_listener(linux_dmabuf, &linux_dmabuf_listener, self);
+}
+
+void mgw::DisplayClient::linux_dmabuf_modifier(
+    zwp_linux_dmabuf_v1* /*linux_dmabuf*/,
+    uint32_t format,
+    uint64_t modifier)
+{
+    std::lock_guard<decltype(dmabuf_formats_mutex)> lock{dmabuf_formats_mutex};
+    dmabuf_formats.emplace(format, modifier);
+}
+
+bool mgw::DisplayClient::host_supports_dmabuf(uint32_t format, std::optional<uint64_t> modifier) const
+{
+    std::lock_guard<decltype(dmabuf_formats_mutex)> lock{dmabuf_formats_mutex};
+    return dmabuf_formats.count({format, modifier.value_or(DRM_FORMAT_MOD_INVALID)});
+}
+
 namespace mir
 {
 namespace graphics
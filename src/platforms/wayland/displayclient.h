@@ -22,6 +22,7 @@
 #include <mir/graphics/display.h>
 #include <mir/graphics/display_buffer.h>
 #include <mir/graphics/display_configuration.h>
+#include <mir/graphics/egl_extensions.h>
 #include <mir/renderer/gl/render_target.h>
 #include <mir/graphics/gl_config.h>
 
@@ -32,11 +33,15 @@
 #include <unordered_map>
 #include <memory>
 #include <mutex>
+#include <optional>
+#include <set>
+#include <utility>
 #include <mir/geometry/displacement.h>
 
 struct xkb_context;
 struct xkb_keymap;
 struct xkb_state;
+struct zwp_linux_dmabuf_v1;
 
 namespace mir
 {
@@ -132,6 +137,8 @@ protected:
     wl_shell* shell = nullptr;
     wl_seat* seat = nullptr;
     wl_shm* shm = nullptr;
+    wl_subcompositor* subcompositor = nullptr;
+    zwp_linux_dmabuf_v1* linux_dmabuf = nullptr;
 
     static void new_global(
         void* data,
@@ -153,6 +160,13 @@ protected:
     void shm_format(wl_shm *wl_shm, uint32_t format);
     MirPixelFormat shm_pixel_format{mir_pixel_format_invalid};
 
+    static void add_linux_dmabuf_listener(DisplayClient* self, zwp_linux_dmabuf_v1* linux_dmabuf);
+    void linux_dmabuf_modifier(zwp_linux_dmabuf_v1* linux_dmabuf, uint32_t format, uint64_t modifier);
+    /// Whether the host can show a dmabuf with this format and modifier (if any) on a subsurface
+    bool host_supports_dmabuf(uint32_t format, std::optional<uint64_t> modifier) const;
+    std::mutex mutable dmabuf_formats_mutex;
+    std::set<std::pair<uint32_t, uint64_t>> dmabuf_formats;
+
     xkb_context* keyboard_context_;
     xkb_keymap* keyboard_map_ = nullptr;
     xkb_state* keyboard_state_ = nullptr;
@@ -168,6 +182,8 @@ protected:
     EGLDisplay egldisplay;
     EGLConfig eglconfig;
     EGLContext eglctx;
+    std::optional<EGLExtensions::SwapBuffersWithDamage> swap_with_damage;
+    bool has_buffer_age{false};
 };
 }
 }
@@ -108,6 +108,24 @@ void mgx::DisplayBuffer::swap_buffers()
     if (!egl.swap_buffers())
         fatal_error("Failed to perform buffer swap");
 
+    update_last_frame();
+}
+
+void mgx::DisplayBuffer::swap_buffers_with_damage(std::vector<geometry::Rectangle> const& damage)
+{
+    if (!egl.swap_buffers(damage))
+        fatal_error("Failed to perform buffer swap");
+
+    update_last_frame();
+}
+
+int mgx::DisplayBuffer::buffer_age() const
+{
+    return egl.buffer_age();
+}
+
+void mgx::DisplayBuffer::update_last_frame()
+{
     /*
      * It would be nice to call this on demand as required. However the
      * implementation requires an EGL context. So for simplicity we call it here
@@ -61,6 +61,8 @@ public:
     void make_current() override;
     void release_current() override;
     void swap_buffers() override;
+    void swap_buffers_with_damage(std::vector<geometry::Rectangle> const& damage) override;
+    int buffer_age() const override;
     void bind() override;
     bool overlay(RenderableList const& renderlist) override;
     void set_view_area(geometry::Rectangle const& a);
@@ -75,6 +77,8 @@ public:
     NativeDisplayBuffer* native_display_buffer() override;
 
 private:
+    void update_last_frame();
+
     std::shared_ptr<DisplayReport> const report;
     geometry::Rectangle area;
     glm::mat2 transform;
@@ -23,6 +23,8 @@
 
 #include <boost/throw_exception.hpp>
 
+#include <cstring>
+
 namespace mg = mir::graphics;
 namespace mgx = mg::X;
 namespace mgxh = mgx::helpers;
@@ -77,6 +79,11 @@ mgxh::EGLHelper::EGLHelper(GLConfig const& gl_config, ::Display* const x_dpy, Wi
     if(egl_surface == EGL_NO_SURFACE)
         BOOST_THROW_EXCEPTION(mg::egl_error("Failed to create EGL window surface"));
 
+    auto const extensions = eglQueryString(egl_display, EGL_EXTENSIONS);
+    has_buffer_age = extensions && strstr(extensions, "EGL_EXT_buffer_age");
+    if (auto const ext = mg::EGLExtensions::SwapBuffersWithDamage::maybe_swap_buffers_with_damage(egl_display))
+        swap_with_damage.emplace(ext.value());
+
     egl_context = eglCreateContext(egl_display, egl_config, shared_context, context_attr);
     if (egl_context == EGL_NO_CONTEXT)
         BOOST_THROW_EXCEPTION(mg::egl_error("Failed to create EGL context"));
@@ -105,6 +112,34 @@ bool mgxh::EGLHelper::swap_buffers() const
     return (ret == EGL_TRUE);
 }
 
+bool mgxh::EGLHelper::swap_buffers(std::vector<geometry::Rectangle> const& damage) const
+{
+    if (!swap_with_damage)
+        return swap_buffers();
+
+    std::vector<EGLint> rects;
+    rects.reserve(damage.size() * 4);
+    for (auto const& rect : damage)
+    {
+        rects.push_back(rect.top_left.x.as_int());
+        rects.push_back(rect.top_left.y.as_int());
+        rects.push_back(rect.size.width.as_int());
+        rects.push_back(rect.size.height.as_int());
+    }
+
+    auto ret = swap_with_damage->eglSwapBuffersWithDamage(
+        egl_display, egl_surface, rects.data(), static_cast<EGLint>(damage.size()));
+    return (ret == EGL_TRUE);
+}
+
+int mgxh::EGLHelper::buffer_age() const
+{
+    EGLint age{0};
+    if (!has_buffer_age || eglQuerySurface(egl_display, egl_surface, EGL_BUFFER_AGE_EXT, &age) != EGL_TRUE)
+        return 0;
+    return age;
+}
+
 bool mgxh::EGLHelper::make_current() const
 {
     auto ret = eglMakeCurrent(egl_display, egl_surface, egl_surface, egl_context);
@@ -123,7 +158,8 @@ mgxh::EGLHelper::EGLHelper(GLConfig const& gl_config)
       stencil_buffer_bits{gl_config.stencil_buffer_bits()},
       egl_display{EGL_NO_DISPLAY}, egl_config{0},
       egl_context{EGL_NO_CONTEXT}, egl_surface{EGL_NO_SURFACE},
-      should_terminate_egl{false}
+      should_terminate_egl{false},
+      has_buffer_age{false}
 {
 }
 
@@ -19,8 +19,13 @@
 #ifndef MIR_GRAPHICS_X11_EGL_HELPER_H_
 #define MIR_GRAPHICS_X11_EGL_HELPER_H_
 
+#include "mir/geometry/rectangle.h"
+#include "mir/graphics/egl_extensions.h"
+
 #include <memory>
 #include <functional>
+#include <optional>
+#include <vector>
 
 #include <X11/Xlib.h>
 #include <EGL/egl.h>
@@ -49,6 +54,10 @@ public:
     ~EGLHelper() noexcept;
 
     bool swap_buffers() const;
+    /// Damage is in GL window coordinates; falls back to a full swap if unsupported
+    bool swap_buffers(std::vector<geometry::Rectangle> const& damage) const;
+    /// The age of the back buffer per EGL_EXT_buffer_age, or 0 if unsupported
+    int buffer_age() const;
     bool make_current() const;
     bool release_current() const;
 
@@ -69,6 +78,8 @@ private:
     EGLContext egl_context;
     EGLSurface egl_surface;
     bool should_terminate_egl;
+    bool has_buffer_age;
+    std::optional<EGLExtensions::SwapBuffersWithDamage> swap_with_damage;
 };
 
 }
@@ -33,6 +33,7 @@
 #include "mir/graphics/texture.h"
 #include "mir/graphics/program_factory.h"
 #include "mir/graphics/program.h"
+#include "mir/geometry/rectangles.h"
 
 #define GLM_FORCE_RADIANS
 #include <glm/gtc/matrix_transform.hpp>
@@ -49,6 +50,61 @@ namespace mgl = mir::gl;
 namespace mrg = mir::renderer::gl;
 namespace geom = mir::geometry;
 
+namespace
+{
+/// The oldest back buffer we keep enough damage history to repair
+size_t const max_buffer_age{4};
+
+/// Beyond this many rectangles the per-rectangle overhead outweighs what we save
+size_t const max_repaint_rectangles{8};
+
+/// Beyond this many visible parts, drawing a renderable once costs less than drawing each part
+size_t const max_visible_parts{4};
+
+bool is_empty(geom::Rectangle const& rect)
+{
+    return rect.size.width <= geom::Width{0} || rect.size.height <= geom::Height{0};
+}
+
+/// The opaque part of a shaped renderable, if it is simple enough to draw separately
+std::experimental::optional<geom::Rectangle> opaque_part_of(mg::Renderable const& renderable)
+{
+    if (!renderable.shaped() || renderable.alpha() != 1.0f)
+        return {};
+
+    // The interior of a window (inside its shadows and rounded corners) is a single rectangle. Anything
+    // more complex is left to blending.
+    auto const region = renderable.opaque_region();
+    if (region.size() != 1 || is_empty(region.front()))
+        return {};
+
+    return region.front();
+}
+
+/// What is left of area with hole cut out of it: up to four rectangles
+std::vector<geom::Rectangle> subtract(geom::Rectangle const& area, geom::Rectangle const& hole)
+{
+    auto const overlap = area.intersection_with(hole);
+    if (is_empty(overlap))
+        return {area};
+
+    std::vector<geom::Rectangle> result;
+    auto const add = [&result](geom::Point top_left, geom::Point bottom_right)
+        {
+            geom::Rectangle const rect{top_left, as_size(bottom_right - top_left)};
+            if (!is_empty(rect))
+                result.push_back(rect);
+        };
+
+    add(area.top_left, {area.right(), overlap.top()});
+    add({area.left(), overlap.top()}, overlap.bottom_left());
+    add(overlap.top_right(), {area.right(), overlap.bottom()});
+    add({area.left(), overlap.bottom()}, area.bottom_right());
+
+    return result;
+}
+}
+
 mrg::CurrentRenderTarget::CurrentRenderTarget(mg::DisplayBuffer* display_buffer)
     : render_target{
         dynamic_cast<renderer::gl::RenderTarget*>(display_buffer->native_display_buffer())}
@@ -80,6 +136,16 @@ void mrg::CurrentRenderTarget::swap_buffers()
     render_target->swap_buffers();
 }
 
+void mrg::CurrentRenderTarget::swap_buffers_with_damage(std::vector<geom::Rectangle> const& damage)
+{
+    render_target->swap_buffers_with_damage(damage);
+}
+
+int mrg::CurrentRenderTarget::buffer_age() const
+{
+    return render_target->buffer_age();
+}
+
 const GLchar* const mrg::Renderer::vshader =
 {
     "attribute vec3 position;\n"
@@ -428,15 +494,48 @@ void mrg::Renderer::render(mg::RenderableList const& renderables) const
 
     glClearColor(clear_color[0], clear_color[1], clear_color[2], clear_color[3]);
     glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
-    glClear(GL_COLOR_BUFFER_BIT);
 
     ++frameno;
-    for (auto const& r : renderables)
+    if (auto const repaint = repaint_area())
     {
-        draw(*r);
+        // Only the damaged parts of the back buffer are stale, so only redraw those
+        glEnable(GL_SCISSOR_TEST);
+        for (auto const& rect : repaint.value())
+        {
+            auto const gl_rect = to_gl_window_coords(rect);
+            glScissor(
+                gl_rect.top_left.x.as_int(), gl_rect.top_left.y.as_int(),
+                gl_rect.size.width.as_int(), gl_rect.size.height.as_int());
+            glClear(GL_COLOR_BUFFER_BIT);
+
+            repainting = rect;
+            draw_all(renderables);
+        }
+        repainting = std::experimental::nullopt;
+        glDisable(GL_SCISSOR_TEST);
+
+        std::vector<geom::Rectangle> gl_damage;
+        gl_damage.reserve(pending_damage.value().size());
+        for (auto const& rect : pending_damage.value())
+            gl_damage.push_back(to_gl_window_coords(rect));
+
+        render_target.swap_buffers_with_damage(gl_damage);
+        damage_history.push_front(std::move(pending_damage.value()));
+    }
+    else
+    {
+        glClear(GL_COLOR_BUFFER_BIT);
+        draw_all(renderables);
+
+        render_target.swap_buffers();
+        damage_history.push_front({viewport});
+        needs_full_repaint = false;
     }
 
-    render_target.swap_buffers();
+    pending_damage = std::experimental::nullopt;
+    visible_regions.clear();
+    if (damage_history.size() > max_buffer_age)
+        damage_history.resize(max_buffer_age);
 
     // Deleting unused textures only requires the GL context. This clean-up
     // does not affect screen contents so can happen after swap_buffers...
@@ -446,21 +545,78 @@ void mrg::Renderer::render(mg::RenderableList const& renderables) const
         mir::log_debug("GL error: %d", gl_error);
 }
 
+void mrg::Renderer::draw_all(mg::RenderableList const& renderables) const
+{
+    for (auto const& r : renderables)
+    {
+        auto const untransformed = r->transformation() == glm::mat4(1);
+
+        // Skip anything that can't touch the area being repainted
+        if (repainting && untransformed && !r->screen_position().overlaps(repainting.value()))
+            continue;
+
+        // Scissoring to what's visible only saves anything while it takes few draws
+        auto const visible = pixel_aligned && untransformed ? visible_regions.find(r->id()) : visible_regions.end();
+        auto const scissor_visible = visible != visible_regions.end() && visible->second.size() <= max_visible_parts;
+
+        // Drawing the opaque part of a shaped renderable without blending saves fill-rate
+        auto const opaque = pixel_aligned && untransformed ?
+            opaque_part_of(*r) : std::experimental::optional<geom::Rectangle>{};
+
+        if (!scissor_visible && !opaque)
+        {
+            draw(*r);
+            continue;
+        }
+
+        auto const parts = scissor_visible ? visible->second : std::vector<geom::Rectangle>{r->screen_position()};
+        for (auto const& part : parts)
+        {
+            auto const area = repainting ? part.intersection_with(repainting.value()) : part;
+            if (is_empty(area))
+                continue;
+
+            if (!opaque)
+            {
+                drawing_within = area;
+                draw(*r);
+                continue;
+            }
+
+            auto const opaque_area = area.intersection_with(opaque.value());
+            if (!is_empty(opaque_area))
+            {
+                drawing_within = opaque_area;
+                drawing_opaque = true;
+                draw(*r);
+                drawing_opaque = false;
+            }
+
+            for (auto const& translucent_area : subtract(area, opaque.value()))
+            {
+                drawing_within = translucent_area;
+                draw(*r);
+            }
+        }
+        drawing_within = std::experimental::nullopt;
+    }
+}
+
 void mrg::Renderer::draw(mg::Renderable const& renderable) const
 {
-    auto const clip_area = renderable.clip_area();
-    if (clip_area)
+    auto scissor = renderable.clip_area();
+    if (auto const within = drawing_within ? drawing_within : repainting)
+        scissor = scissor ? scissor.value().intersection_with(within.value()) : within.value();
+
+    if (scissor)
     {
+        auto const gl_scissor = to_gl_window_coords(scissor.value());
         glEnable(GL_SCISSOR_TEST);
         glScissor(
-            clip_area.value().top_left.x.as_int() -
-                viewport.top_left.x.as_int(),
-            viewport.top_left.y.as_int() +
-                viewport.size.height.as_int() -
-                clip_area.value().top_left.y.as_int() -
-                clip_area.value().size.height.as_int(),
-            clip_area.value().size.width.as_int(), 
-            clip_area.value().size.height.as_int()
+            gl_scissor.top_left.x.as_int(),
+            gl_scissor.top_left.y.as_int(),
+            gl_scissor.size.width.as_int(),
+            gl_scissor.size.height.as_int()
         );
     }
 
@@ -576,7 +732,7 @@ void mrg::Renderer::draw(mg::Renderable const& renderable) const
         BlendSeparate client_blend;
 
         // These renderable method names could be better (see LP: #1236224)
-        if (renderable.shaped())  // Client is RGBA:
+        if (renderable.shaped() && !drawing_opaque)  // Client is RGBA:
         {
             client_blend = {GL_ONE, GL_ONE_MINUS_SRC_ALPHA,
                             GL_ONE, GL_ONE_MINUS_SRC_ALPHA};
@@ -643,7 +799,7 @@ void mrg::Renderer::draw(mg::Renderable const& renderable) const
 
     glDisableVertexAttribArray(prog.texcoord_attr);
     glDisableVertexAttribArray(prog.position_attr);
-    if (renderable.clip_area())
+    if (scissor && !repainting)
     {
         glDisable(GL_SCISSOR_TEST);
     }
@@ -689,6 +845,7 @@ void mrg::Renderer::set_viewport(geometry::Rectangle const& rect)
                       0.0f});
 
     viewport = rect;
+    forget_damage();
     update_gl_viewport();
 }
 
@@ -700,6 +857,7 @@ void mrg::Renderer::update_gl_viewport()
      * This keeps pixels square. Note "black"-bars are really glClearColor.
      */
     render_target.ensure_current();
+    pixel_aligned = false;
 
     auto transformed_viewport = display_transform *
                                 glm::vec4(viewport.size.width.as_int(),
@@ -725,6 +883,11 @@ void mrg::Renderer::update_gl_viewport()
         GLint offset_y = (buf_height - reduced_height) / 2;
 
         glViewport(offset_x, offset_y, reduced_width, reduced_height);
+
+        pixel_aligned =
+            display_transform == glm::mat4(1) &&
+            offset_x == 0 && offset_y == 0 &&
+            geom::Size{reduced_width, reduced_height} == viewport.size;
     }
 }
 
@@ -734,6 +897,7 @@ void mrg::Renderer::set_output_transform(glm::mat2 const& t)
     if (new_display_transform != display_transform)
     {
         display_transform = new_display_transform;
+        forget_damage();
         update_gl_viewport();
     }
 }
@@ -741,5 +905,60 @@ void mrg::Renderer::set_output_transform(glm::mat2 const& t)
 void mrg::Renderer::suspend()
 {
     texture_cache->invalidate();
+
+    // Whatever was shown instead didn't come from our framebuffers
+    forget_damage();
+}
+
+void mrg::Renderer::set_damage(std::vector<geom::Rectangle> const& damage)
+{
+    pending_damage = damage;
+}
+
+void mrg::Renderer::set_visible_regions(VisibleRegions const& regions)
+{
+    visible_regions = regions;
+}
+
+void mrg::Renderer::forget_damage() const
+{
+    damage_history.clear();
+    needs_full_repaint = true;
+}
+
+auto mrg::Renderer::repaint_area() const -> std::experimental::optional<std::vector<geom::Rectangle>>
+{
+    if (!pending_damage || needs_full_repaint || !pixel_aligned)
+        return {};
+
+    // The back buffer holds the frame from buffer_age swaps ago, so it's
+    // missing the damage of every frame since as well as this one.
+    auto const age = render_target.buffer_age();
+    if (age < 1 || static_cast<size_t>(age - 1) > damage_history.size())
+        return {};
+
+    auto repaint = pending_damage.value();
+    for (auto frame = damage_history.begin(); frame != damage_history.begin() + (age - 1); ++frame)
+        repaint.insert(repaint.end(), frame->begin(), frame->end());
+
+    if (repaint.size() > max_repaint_rectangles)
+    {
+        geom::Rectangles bounds;
+        for (auto const& rect : repaint)
+            bounds.add(rect);
+        repaint = {bounds.bounding_rectangle()};
+    }
+
+    return repaint;
+}
+
+auto mrg::Renderer::to_gl_window_coords(geom::Rectangle const& rect) const -> geom::Rectangle
+{
+    // GL window coordinates have their origin at the bottom left of the viewport
+    return {
+        {rect.top_left.x.as_int() - viewport.top_left.x.as_int(),
+         viewport.top_left.y.as_int() + viewport.size.height.as_int() -
+             rect.top_left.y.as_int() - rect.size.height.as_int()},
+        rect.size};
 }
 
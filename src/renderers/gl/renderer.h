@@ -29,6 +29,8 @@
 #include "mir/renderer/gl/render_target.h"
 
 #include <GLES2/gl2.h>
+#include <deque>
+#include <experimental/optional>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -51,6 +53,8 @@ public:
     void ensure_current();
     void bind();
     void swap_buffers();
+    void swap_buffers_with_damage(std::vector<geometry::Rectangle> const& damage);
+    int buffer_age() const;
 
 private:
     renderer::gl::RenderTarget* const render_target;
@@ -65,6 +69,8 @@ public:
     // These are called with a valid GL context:
     void set_viewport(geometry::Rectangle const& rect) override;
     void set_output_transform(glm::mat2 const&) override;
+    void set_damage(std::vector<geometry::Rectangle> const& damage) override;
+    void set_visible_regions(VisibleRegions const& regions) override;
     void render(graphics::RenderableList const&) const override;
 
     // This is called _without_ a GL context:
@@ -127,6 +133,10 @@ protected:
 
 private:
     void update_gl_viewport();
+    void forget_damage() const;
+    auto repaint_area() const -> std::experimental::optional<std::vector<geometry::Rectangle>>;
+    auto to_gl_window_coords(geometry::Rectangle const& rect) const -> geometry::Rectangle;
+    void draw_all(graphics::RenderableList const& renderables) const;
 
     class ProgramFactory;
     std::unique_ptr<ProgramFactory> const program_factory;
@@ -135,6 +145,23 @@ private:
     glm::mat4 screen_to_gl_coords;
     glm::mat4 display_transform;
     std::vector<mir::gl::Primitive> mutable primitives;
+
+    /// Whether screen coordinates map 1:1 onto framebuffer pixels (a requirement for partial repaint)
+    bool pixel_aligned{false};
+    /// The damage passed to set_damage() for the next render(), if any
+    std::experimental::optional<std::vector<geometry::Rectangle>> mutable pending_damage;
+    /// The damage of recently rendered frames, most recent first
+    std::deque<std::vector<geometry::Rectangle>> mutable damage_history;
+    /// Set when the framebuffers' content can't be relied upon
+    bool mutable needs_full_repaint{true};
+    /// The area currently being repainted, which draw() must stay within
+    std::experimental::optional<geometry::Rectangle> mutable repainting;
+    /// The parts of partly hidden renderables to draw in the next render()
+    VisibleRegions mutable visible_regions;
+    /// The part of the area being repainted that the current draw() is limited to, if narrower
+    std::experimental::optional<geometry::Rectangle> mutable drawing_within;
+    /// Set while draw() is limited to an area the renderable promises is opaque, so needs no blending
+    bool mutable drawing_opaque{false};
 };
 
 }
@@ -0,0 +1,225 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "compositing_screencast.h"
+#include "screencast_display_buffer.h"
+#include "damage_tracker.h"
+
+#include "mir/compositor/frame_clock.h"
+#include "mir/compositor/scene.h"
+#include "mir/compositor/scene_element.h"
+#include "mir/graphics/buffer.h"
+#include "mir/graphics/renderable.h"
+#include "mir/renderer/gl/context.h"
+#include "mir/renderer/renderer.h"
+#include "mir/renderer/renderer_factory.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <cmath>
+#include <future>
+#include <stdexcept>
+
+namespace mc = mir::compositor;
+namespace mf = mir::frontend;
+namespace mg = mir::graphics;
+namespace geom = mir::geometry;
+
+using namespace std::chrono;
+
+struct mc::CompositingScreencast::Session
+{
+    Session(
+        geom::Rectangle const& region,
+        geom::Size const& size,
+        MirMirrorMode mirror_mode,
+        renderer::gl::Context const& context)
+        : region{region},
+          size{size},
+          mirror_mode{mirror_mode},
+          display_buffer{region, size, mirror_mode, context}
+    {
+    }
+
+    /// Maps damage on the screen onto the buffer, rounding outwards when scaled
+    auto to_buffer(geom::Rectangle const& damage) const -> geom::Rectangle
+    {
+        auto const x_scale = double(size.width.as_int()) / region.size.width.as_int();
+        auto const y_scale = double(size.height.as_int()) / region.size.height.as_int();
+
+        int const left = std::floor((damage.left() - region.left()).as_int() * x_scale);
+        int const top = std::floor((damage.top() - region.top()).as_int() * y_scale);
+        int const right = std::ceil((damage.right() - region.left()).as_int() * x_scale);
+        int const bottom = std::ceil((damage.bottom() - region.top()).as_int() * y_scale);
+
+        geom::Rectangle result{{left, top}, {right - left, bottom - top}};
+
+        if (mirror_mode == mir_mirror_mode_horizontal)
+            result.top_left.x = geom::X{size.width.as_int() - right};
+        else if (mirror_mode == mir_mirror_mode_vertical)
+            result.top_left.y = geom::Y{size.height.as_int() - bottom};
+
+        return result;
+    }
+
+    geom::Rectangle const region;
+    geom::Size const size;
+    MirMirrorMode const mirror_mode;
+
+    ScreencastDisplayBuffer display_buffer;
+    std::unique_ptr<renderer::Renderer> renderer;
+    DamageTracker damage_tracker;
+};
+
+milliseconds const mc::CompositingScreencast::max_frame_wait{100};
+
+mc::CompositingScreencast::CompositingScreencast(
+    std::shared_ptr<Scene> const& scene,
+    std::unique_ptr<renderer::gl::Context> context,
+    std::shared_ptr<renderer::RendererFactory> const& renderer_factory,
+    std::shared_ptr<FrameClock> const& frame_clock)
+    : scene{scene},
+      context{std::move(context)},
+      renderer_factory{renderer_factory},
+      frame_clock{frame_clock}
+{
+}
+
+mc::CompositingScreencast::~CompositingScreencast()
+{
+    for (auto const& session : sessions)
+        scene->unregister_compositor(session.second.get());
+}
+
+mf::ScreencastSessionId mc::CompositingScreencast::create_session(
+    geom::Rectangle const& region,
+    geom::Size const& size,
+    MirPixelFormat /*pixel_format*/,
+    int /*nbuffers*/,
+    MirMirrorMode mirror_mode)
+{
+    // The format and number of buffers are the client's choice, as it provides them
+    if (region.size.width <= geom::Width{} || region.size.height <= geom::Height{})
+        BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid screencast region"));
+
+    if (size.width <= geom::Width{} || size.height <= geom::Height{})
+        BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid screencast size"));
+
+    std::lock_guard<std::mutex> lock{mutex};
+
+    auto session = std::make_unique<Session>(region, size, mirror_mode, *context);
+    session->renderer = renderer_factory->create_renderer_for(session->display_buffer);
+
+    mf::ScreencastSessionId const id{next_id++};
+    scene->register_compositor(session.get());
+    sessions.emplace(id, std::move(session));
+
+    return id;
+}
+
+void mc::CompositingScreencast::destroy_session(mf::ScreencastSessionId id)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    auto const found = sessions.find(id);
+    if (found == sessions.end())
+        BOOST_THROW_EXCEPTION(std::logic_error("Invalid screencast session id"));
+
+    scene->unregister_compositor(found->second.get());
+    sessions.erase(found);
+}
+
+std::shared_ptr<mg::Buffer> mc::CompositingScreencast::capture(mf::ScreencastSessionId)
+{
+    BOOST_THROW_EXCEPTION(std::logic_error("Screencasts are only captured into client buffers"));
+}
+
+mf::ScreencastFrame mc::CompositingScreencast::capture(
+    mf::ScreencastSessionId id,
+    std::shared_ptr<mg::Buffer> const& buffer)
+{
+    geom::Rectangle region;
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        region = session(id).region;
+    }
+
+    mf::ScreencastFrame frame;
+    frame.presented = wait_for_frame(region);
+
+    std::lock_guard<std::mutex> lock{mutex};
+    auto& session = this->session(id);
+
+    context->make_current();
+    try
+    {
+        session.display_buffer.set_target(buffer);
+    }
+    catch (...)
+    {
+        context->release_current();
+        throw;
+    }
+
+    mg::RenderableList renderables;
+    for (auto const& element : scene->scene_elements_for(&session))
+        renderables.push_back(element->renderable());
+
+    auto const damage = session.damage_tracker.damage_for(renderables, region);
+
+    // Unless nothing has changed and the buffer already holds the previous capture
+    if (!damage.empty() || session.display_buffer.buffer_age() != 1)
+    {
+        session.renderer->set_output_transform(session.display_buffer.transformation());
+        session.renderer->set_viewport(region);
+        session.renderer->set_damage(damage);
+        session.renderer->render(renderables);
+    }
+
+    context->release_current();
+
+    frame.damage.reserve(damage.size());
+    for (auto const& rect : damage)
+        frame.damage.push_back(session.to_buffer(rect));
+
+    return frame;
+}
+
+auto mc::CompositingScreencast::session(mf::ScreencastSessionId id) -> Session&
+{
+    auto const found = sessions.find(id);
+    if (found == sessions.end())
+        BOOST_THROW_EXCEPTION(std::logic_error("Invalid screencast session id"));
+
+    return *found->second;
+}
+
+auto mc::CompositingScreencast::wait_for_frame(geom::Rectangle const& region) -> steady_clock::time_point
+{
+    // Shared, as the frame may come after we've given up waiting
+    auto const presented = std::make_shared<std::promise<steady_clock::time_point>>();
+    auto next_frame = presented->get_future();
+
+    frame_clock->on_next_frame(
+        region,
+        [presented](steady_clock::time_point when) { presented->set_value(when); });
+
+    // The outputs may be off, so don't wait forever
+    if (next_frame.wait_for(max_frame_wait) != std::future_status::ready)
+        return steady_clock::now();
+
+    return next_frame.get();
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_COMPOSITOR_COMPOSITING_SCREENCAST_H_
+#define MIR_COMPOSITOR_COMPOSITING_SCREENCAST_H_
+
+#include "mir/frontend/screencast.h"
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace mir
+{
+namespace renderer
+{
+class RendererFactory;
+namespace gl { class Context; }
+}
+namespace compositor
+{
+class Scene;
+class FrameClock;
+
+/**
+ * Screencasts by compositing the scene a second time, straight into buffers
+ * the client provides.
+ *
+ * Each capture waits for the next frame of the outputs showing the session's
+ * region, and reports what changed since the session's previous capture.
+ */
+class CompositingScreencast : public frontend::Screencast
+{
+public:
+    CompositingScreencast(
+        std::shared_ptr<Scene> const& scene,
+        std::unique_ptr<renderer::gl::Context> context,
+        std::shared_ptr<renderer::RendererFactory> const& renderer_factory,
+        std::shared_ptr<FrameClock> const& frame_clock);
+    ~CompositingScreencast();
+
+    frontend::ScreencastSessionId create_session(
+        geometry::Rectangle const& region,
+        geometry::Size const& size,
+        MirPixelFormat pixel_format,
+        int nbuffers,
+        MirMirrorMode mirror_mode) override;
+    void destroy_session(frontend::ScreencastSessionId id) override;
+    std::shared_ptr<graphics::Buffer> capture(frontend::ScreencastSessionId id) override;
+    frontend::ScreencastFrame capture(
+        frontend::ScreencastSessionId id,
+        std::shared_ptr<graphics::Buffer> const& buffer) override;
+
+    /// The longest a capture waits for a frame before capturing the scene as it is
+    static std::chrono::milliseconds const max_frame_wait;
+
+private:
+    struct Session;
+
+    auto session(frontend::ScreencastSessionId id) -> Session&;
+    auto wait_for_frame(geometry::Rectangle const& region) -> std::chrono::steady_clock::time_point;
+
+    std::shared_ptr<Scene> const scene;
+    std::unique_ptr<renderer::gl::Context> const context;
+    std::shared_ptr<renderer::RendererFactory> const renderer_factory;
+    std::shared_ptr<FrameClock> const frame_clock;
+
+    std::mutex mutex;
+    std::unordered_map<frontend::ScreencastSessionId, std::unique_ptr<Session>> sessions;
+    uint32_t next_id{1};
+};
+
+}
+}
+
+#endif /* MIR_COMPOSITOR_COMPOSITING_SCREENCAST_H_ */
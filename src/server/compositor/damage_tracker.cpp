@@ -0,0 +1,179 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "damage_tracker.h"
+#include "mir/graphics/buffer.h"
+#include "mir/geometry/displacement.h"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+namespace mc = mir::compositor;
+namespace mg = mir::graphics;
+namespace geom = mir::geometry;
+
+namespace
+{
+glm::mat4 const identity(1);
+
+bool is_empty(geom::Rectangle const& rect)
+{
+    return rect.size.width <= geom::Width{} || rect.size.height <= geom::Height{};
+}
+
+/// Maps damage in buffer coordinates onto the renderable's screen position
+auto to_screen(
+    geom::Rectangle const& damage,
+    geom::Size const& buffer_size,
+    geom::Rectangle const& screen_position) -> geom::Rectangle
+{
+    auto const x_scale = double(screen_position.size.width.as_int()) / buffer_size.width.as_int();
+    auto const y_scale = double(screen_position.size.height.as_int()) / buffer_size.height.as_int();
+
+    // Round outwards so that scaled content is always fully covered
+    auto const left = std::floor(damage.left().as_int() * x_scale);
+    auto const top = std::floor(damage.top().as_int() * y_scale);
+    auto const right = std::ceil(damage.right().as_int() * x_scale);
+    auto const bottom = std::ceil(damage.bottom().as_int() * y_scale);
+
+    return {
+        screen_position.top_left + geom::Displacement{left, top},
+        geom::Size{right - left, bottom - top}};
+}
+}
+
+auto mc::DamageTracker::state_of(mg::Renderable const& renderable, geom::Rectangle const& view_area)
+    -> RenderableState
+{
+    RenderableState state{
+        renderable.id(),
+        renderable.buffer()->id(),
+        renderable.screen_position(),
+        renderable.clip_area(),
+        renderable.alpha(),
+        renderable.transformation(),
+        renderable.shaped(),
+        renderable.opaque_region(),
+        view_area};
+
+    // A transformed renderable could be drawn anywhere, so we only narrow down untransformed ones
+    if (state.transformation == identity)
+    {
+        state.bounds = state.screen_position.intersection_with(view_area);
+        if (state.clip_area)
+            state.bounds = state.bounds.intersection_with(state.clip_area.value());
+    }
+
+    return state;
+}
+
+auto mc::DamageTracker::damage_for(mg::RenderableList const& renderables, geom::Rectangle const& view_area)
+    -> std::vector<geom::Rectangle>
+{
+    std::vector<geom::Rectangle> damage;
+    auto const add_damage = [&damage, &view_area](geom::Rectangle const& rect)
+        {
+            auto const clipped = rect.intersection_with(view_area);
+            if (!is_empty(clipped))
+                damage.push_back(clipped);
+        };
+
+    std::vector<RenderableState> current;
+    current.reserve(renderables.size());
+    for (auto const& renderable : renderables)
+        current.push_back(state_of(*renderable, view_area));
+
+    if (previous_view_area != view_area)
+    {
+        previous_view_area = view_area;
+        previous = std::move(current);
+        add_damage(view_area);
+        return damage;
+    }
+
+    std::unordered_map<mg::Renderable::ID, size_t> previous_index;
+    for (size_t i = 0; i != previous.size(); ++i)
+        previous_index[previous[i].id] = i;
+
+    std::vector<bool> still_present(previous.size(), false);
+    size_t highest_previous_index = 0;
+
+    for (size_t i = 0; i != current.size(); ++i)
+    {
+        auto const& now = current[i];
+        auto const found = previous_index.find(now.id);
+
+        if (found == previous_index.end())
+        {
+            add_damage(now.bounds);
+            continue;
+        }
+
+        auto const& before = previous[found->second];
+        still_present[found->second] = true;
+
+        bool const restacked = found->second < highest_previous_index;
+        highest_previous_index = std::max(highest_previous_index, found->second);
+
+        if (before.screen_position != now.screen_position ||
+            before.clip_area != now.clip_area ||
+            before.alpha != now.alpha ||
+            before.transformation != now.transformation ||
+            before.shaped != now.shaped ||
+            before.opaque_region != now.opaque_region)
+        {
+            add_damage(before.bounds);
+            add_damage(now.bounds);
+        }
+        else if (restacked)
+        {
+            // Only where this overlaps what it was restacked past can change, but that's within its bounds
+            add_damage(now.bounds);
+        }
+        else if (before.buffer_id != now.buffer_id)
+        {
+            auto const& renderable = *renderables[i];
+            auto const buffer_damage = renderable.damage_since(before.buffer_id);
+            auto const buffer_size = renderable.buffer()->size();
+
+            if (!buffer_damage || is_empty({{}, buffer_size}) || now.transformation != identity)
+            {
+                add_damage(now.bounds);
+            }
+            else
+            {
+                for (auto const& rect : buffer_damage.value())
+                    add_damage(to_screen(rect, buffer_size, now.screen_position).intersection_with(now.bounds));
+            }
+        }
+    }
+
+    for (size_t i = 0; i != previous.size(); ++i)
+    {
+        if (!still_present[i])
+            add_damage(previous[i].bounds);
+    }
+
+    previous = std::move(current);
+    return damage;
+}
+
+void mc::DamageTracker::reset()
+{
+    previous_view_area = std::experimental::nullopt;
+    previous.clear();
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_COMPOSITOR_DAMAGE_TRACKER_H_
+#define MIR_COMPOSITOR_DAMAGE_TRACKER_H_
+
+#include "mir/geometry/rectangle.h"
+#include "mir/graphics/buffer_id.h"
+#include "mir/graphics/renderable.h"
+
+#include <experimental/optional>
+#include <vector>
+
+namespace mir
+{
+namespace compositor
+{
+
+/**
+ * Works out which areas of an output have changed between consecutive frames.
+ *
+ * Damage comes from renderables appearing, disappearing, moving, restacking or
+ * changing their presentation, and from their content changing (which is
+ * narrowed down to the client's damage where the renderable knows it).
+ */
+class DamageTracker
+{
+public:
+    DamageTracker() = default;
+
+    /**
+     * The damage (in screen coordinates, and within view_area) between the
+     * previous call and the renderables about to be drawn.
+     *
+     * The first call, and any call following a change of view_area, damages
+     * the whole of view_area.
+     */
+    auto damage_for(graphics::RenderableList const& renderables, geometry::Rectangle const& view_area)
+        -> std::vector<geometry::Rectangle>;
+
+    /// Forget the previous frame, so the next call damages everything
+    void reset();
+
+private:
+    struct RenderableState
+    {
+        graphics::Renderable::ID id;
+        graphics::BufferID buffer_id;
+        geometry::Rectangle screen_position;
+        std::experimental::optional<geometry::Rectangle> clip_area;
+        float alpha;
+        glm::mat4 transformation;
+        bool shaped;
+        std::vector<geometry::Rectangle> opaque_region;
+        /// The area of the screen the renderable may draw to
+        geometry::Rectangle bounds;
+    };
+
+    static auto state_of(graphics::Renderable const& renderable, geometry::Rectangle const& view_area)
+        -> RenderableState;
+
+    std::experimental::optional<geometry::Rectangle> previous_view_area;
+    std::vector<RenderableState> previous;
+};
+
+}
+}
+
+#endif /* MIR_COMPOSITOR_DAMAGE_TRACKER_H_ */
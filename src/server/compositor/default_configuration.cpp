@@ -22,8 +22,13 @@
 #include "buffer_stream_factory.h"
 #include "default_display_buffer_compositor_factory.h"
 #include "multi_threaded_compositor.h"
+#include "frame_clocks.h"
+#include "compositing_screencast.h"
 #include "gl/renderer_factory.h"
 #include "mir/main_loop.h"
+#include "mir/graphics/display.h"
+#include "mir/renderer/gl/context.h"
+#include "mir/renderer/gl/context_source.h"
 
 #include "mir/options/configuration.h"
 
@@ -77,10 +82,25 @@ mir::DefaultServerConfiguration::the_compositor()
                 the_shell(),
                 the_compositor_report(),
                 composite_delay,
-                true);
+                true,
+                the_frame_clocks());
         });
 }
 
+std::shared_ptr<mc::FrameClocks> mir::DefaultServerConfiguration::the_frame_clocks()
+{
+    return frame_clocks(
+        []()
+        {
+            return std::make_shared<mc::FrameClocks>();
+        });
+}
+
+std::shared_ptr<mc::FrameClock> mir::DefaultServerConfiguration::the_frame_clock()
+{
+    return the_frame_clocks();
+}
+
 std::shared_ptr<mir::renderer::RendererFactory> mir::DefaultServerConfiguration::the_renderer_factory()
 {
     return renderer_factory(
@@ -89,3 +109,20 @@ std::shared_ptr<mir::renderer::RendererFactory> mir::DefaultServerConfiguration:
             return std::make_shared<mir::renderer::gl::RendererFactory>();
         });
 }
+
+std::shared_ptr<mf::Screencast> mir::DefaultServerConfiguration::the_screencast()
+{
+    return screencast(
+        [this]() -> std::shared_ptr<mf::Screencast>
+        {
+            auto const context_source = dynamic_cast<renderer::gl::ContextSource*>(the_display().get());
+            if (!context_source)
+                BOOST_THROW_EXCEPTION(std::logic_error("Display does not support GL rendering"));
+
+            return std::make_shared<mc::CompositingScreencast>(
+                the_scene(),
+                context_source->create_gl_context(),
+                the_renderer_factory(),
+                the_frame_clock());
+        });
+}
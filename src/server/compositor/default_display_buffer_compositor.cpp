@@ -49,7 +49,7 @@ void mc::DefaultDisplayBufferCompositor::composite(mc::SceneElementSequence&& sc
     report->began_frame(this);
 
     auto const& view_area = display_buffer.view_area();
-    auto const& occlusions = mc::filter_occlusions_from(scene_elements, view_area);
+    auto const& occlusions = mc::filter_occlusions_from(scene_elements, view_area, visible_regions);
 
     for (auto const& element : occlusions)
         element->occluded();
@@ -72,18 +72,29 @@ void mc::DefaultDisplayBufferCompositor::composite(mc::SceneElementSequence&& sc
      */
     scene_elements.clear();  // Those in use are still in renderable_list
 
-    if (display_buffer.overlay(renderable_list))
+    mg::RenderableList to_render;
+    if (display_buffer.overlay_partially(renderable_list, to_render))
     {
         report->renderables_in_frame(this, renderable_list);
         renderer->suspend();
+
+        // Nothing we render is on screen, so the next rendered frame has to start afresh
+        damage_tracker.reset();
     }
     else
     {
+        // Reported before rendering, so the report can tell gathering the scene apart from rendering it
+        report->renderables_in_frame(this, renderable_list);
+
+        // Only what we render lands in the framebuffer; anything overlaid is on a plane of its own
+        auto const damage = damage_tracker.damage_for(to_render, view_area);
+
         renderer->set_output_transform(display_buffer.transformation());
         renderer->set_viewport(view_area);
-        renderer->render(renderable_list);
+        renderer->set_damage(damage);
+        renderer->set_visible_regions(visible_regions);
+        renderer->render(to_render);
 
-        report->renderables_in_frame(this, renderable_list);
         report->rendered_frame(this);
 
         /*
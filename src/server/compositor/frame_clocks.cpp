@@ -0,0 +1,148 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "frame_clocks.h"
+
+#include <algorithm>
+
+namespace mc = mir::compositor;
+namespace geom = mir::geometry;
+
+namespace
+{
+auto overlap(std::vector<geom::Rectangle> const& areas, geom::Rectangle const& area) -> long
+{
+    long total{0};
+    for (auto const& a : areas)
+    {
+        auto const intersection = a.intersection_with(area);
+        total += static_cast<long>(intersection.size.width.as_int()) * intersection.size.height.as_int();
+    }
+    return total;
+}
+
+void call_all(std::vector<mc::FrameClock::Callback> const& callbacks, std::chrono::steady_clock::time_point when)
+{
+    for (auto const& callback : callbacks)
+        callback(when);
+}
+}
+
+mc::FrameClocks::~FrameClocks()
+{
+    std::vector<std::shared_ptr<Output>> remaining;
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        remaining = outputs;
+    }
+
+    for (auto const& output : remaining)
+        remove_output(output);
+}
+
+auto mc::FrameClocks::add_output(
+    std::vector<geometry::Rectangle> const& areas,
+    std::function<void()> const& schedule_frame) -> std::shared_ptr<Output>
+{
+    auto const output = std::make_shared<Output>(areas, schedule_frame);
+
+    std::lock_guard<std::mutex> lock{mutex};
+    outputs.push_back(output);
+    return output;
+}
+
+void mc::FrameClocks::remove_output(std::shared_ptr<Output> const& output)
+{
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        outputs.erase(std::remove(outputs.begin(), outputs.end(), output), outputs.end());
+    }
+
+    std::vector<Callback> orphaned;
+    {
+        std::lock_guard<std::mutex> lock{output->mutex};
+        orphaned = std::move(output->waiting_for_presentation);
+        orphaned.insert(
+            orphaned.end(),
+            std::make_move_iterator(output->waiting_for_frame.begin()),
+            std::make_move_iterator(output->waiting_for_frame.end()));
+        output->waiting_for_presentation.clear();
+        output->waiting_for_frame.clear();
+    }
+
+    // There will be no frame on this output to wait for, so don't leave anyone waiting
+    call_all(orphaned, std::chrono::steady_clock::now());
+}
+
+void mc::FrameClocks::on_next_frame(geometry::Rectangle const& area, Callback&& callback)
+{
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        Output* best{nullptr};
+        long best_overlap{0};
+        for (auto const& output : outputs)
+        {
+            auto const output_overlap = overlap(output->areas, area);
+            if (output_overlap > best_overlap)
+            {
+                best = output.get();
+                best_overlap = output_overlap;
+            }
+        }
+
+        if (best)
+        {
+            {
+                std::lock_guard<std::mutex> output_lock{best->mutex};
+                best->waiting_for_frame.push_back(std::move(callback));
+            }
+            best->schedule_frame();
+            return;
+        }
+    }
+
+    callback(std::chrono::steady_clock::now());
+}
+
+mc::FrameClocks::Output::Output(
+    std::vector<geometry::Rectangle> const& areas,
+    std::function<void()> const& schedule_frame) :
+    areas{areas},
+    schedule_frame{schedule_frame}
+{
+}
+
+void mc::FrameClocks::Output::frame_started()
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    waiting_for_presentation.insert(
+        waiting_for_presentation.end(),
+        std::make_move_iterator(waiting_for_frame.begin()),
+        std::make_move_iterator(waiting_for_frame.end()));
+    waiting_for_frame.clear();
+}
+
+void mc::FrameClocks::Output::frame_presented(std::chrono::steady_clock::time_point presented)
+{
+    std::vector<Callback> presented_callbacks;
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        presented_callbacks.swap(waiting_for_presentation);
+    }
+
+    call_all(presented_callbacks, presented);
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_COMPOSITOR_FRAME_CLOCKS_H_
+#define MIR_COMPOSITOR_FRAME_CLOCKS_H_
+
+#include "mir/compositor/frame_clock.h"
+#include "mir/geometry/rectangle.h"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace mir
+{
+namespace compositor
+{
+/**
+ * A FrameClock driven by the compositing threads, one clock per display sync
+ * group.
+ */
+class FrameClocks : public FrameClock
+{
+public:
+    class Output;
+
+    FrameClocks() = default;
+    ~FrameClocks();
+
+    /**
+     * Add the clock of a sync group covering areas.
+     * \param [in] areas           The view areas of the group's display buffers
+     * \param [in] schedule_frame  Asks the group's compositor for a frame. Called
+     *                             with an internal lock held, so must not call back
+     *                             into the FrameClocks.
+     */
+    auto add_output(std::vector<geometry::Rectangle> const& areas, std::function<void()> const& schedule_frame)
+        -> std::shared_ptr<Output>;
+    /// Any callbacks still waiting on the output are called immediately
+    void remove_output(std::shared_ptr<Output> const& output);
+
+    void on_next_frame(geometry::Rectangle const& area, Callback&& callback) override;
+
+private:
+    std::mutex mutex;
+    std::vector<std::shared_ptr<Output>> outputs;
+};
+
+class FrameClocks::Output
+{
+public:
+    Output(std::vector<geometry::Rectangle> const& areas, std::function<void()> const& schedule_frame);
+
+    /// The compositor is about to snapshot the scene; callbacks added after this wait for the next frame
+    void frame_started();
+    /// The frame started has reached the screen
+    void frame_presented(std::chrono::steady_clock::time_point presented);
+
+private:
+    friend class FrameClocks;
+
+    std::vector<geometry::Rectangle> const areas;
+    std::function<void()> const schedule_frame;
+
+    std::mutex mutex;
+    std::vector<Callback> waiting_for_frame;
+    std::vector<Callback> waiting_for_presentation;
+};
+}
+}
+
+#endif /* MIR_COMPOSITOR_FRAME_CLOCKS_H_ */
@@ -0,0 +1,118 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/compositor/frame_timings.h"
+
+#include <algorithm>
+#include <sstream>
+
+namespace mc = mir::compositor;
+namespace geom = mir::geometry;
+
+using namespace std::chrono;
+
+void mc::FrameTimings::add_output(OutputId id, geom::Rectangle const& area)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    auto const index = static_cast<unsigned>(outputs_.size());
+    outputs_.try_emplace(id, Output{index, area, {}}).first->second.area = area;
+}
+
+void mc::FrameTimings::record(OutputId id, Stage stage, nanoseconds duration)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    auto& output = outputs_.try_emplace(id, Output{static_cast<unsigned>(outputs_.size()), {}, {}}).first->second;
+    output.stages[static_cast<int>(stage)].record(duration);
+}
+
+auto mc::FrameTimings::outputs() const -> std::vector<OutputId>
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    std::vector<OutputId> result(outputs_.size());
+    for (auto const& output : outputs_)
+        result[output.second.index] = output.first;
+    return result;
+}
+
+auto mc::FrameTimings::summary(OutputId id, Stage stage) const -> Summary
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    auto const output = outputs_.find(id);
+    if (output == outputs_.end())
+        return time::DurationHistogram{}.summary();
+
+    return output->second.stages[static_cast<int>(stage)].summary();
+}
+
+auto mc::FrameTimings::to_json() const -> std::string
+{
+    std::vector<std::pair<OutputId, Output>> ordered;
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        ordered.assign(outputs_.begin(), outputs_.end());
+    }
+    std::sort(
+        ordered.begin(), ordered.end(),
+        [](auto const& lhs, auto const& rhs) { return lhs.second.index < rhs.second.index; });
+
+    std::ostringstream json;
+    json << "{\"outputs\":[";
+    for (auto output = ordered.begin(); output != ordered.end(); ++output)
+    {
+        auto const& area = output->second.area;
+        if (output != ordered.begin())
+            json << ",";
+        json << "{\"index\":" << output->second.index
+             << ",\"area\":{\"x\":" << area.top_left.x.as_int()
+             << ",\"y\":" << area.top_left.y.as_int()
+             << ",\"width\":" << area.size.width.as_int()
+             << ",\"height\":" << area.size.height.as_int()
+             << "},\"stages\":{";
+
+        for (int stage = 0; stage != stage_count; ++stage)
+        {
+            if (stage)
+                json << ",";
+            json << "\"" << name_of(static_cast<Stage>(stage)) << "\":";
+            time::write_json(json, output->second.stages[stage].summary());
+        }
+        json << "}}";
+    }
+    json << "]}";
+
+    return json.str();
+}
+
+void mc::FrameTimings::reset()
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    for (auto& output : outputs_)
+        output.second.stages = {};
+}
+
+auto mc::FrameTimings::name_of(Stage stage) -> char const*
+{
+    switch (stage)
+    {
+    case Stage::acquire: return "acquire";
+    case Stage::render: return "render";
+    case Stage::present: return "present";
+    case Stage::commit_to_present: return "commit_to_present";
+    }
+    return "unknown";
+}
@@ -17,8 +17,10 @@
  */
 
 #include "multi_threaded_compositor.h"
+#include "frame_clocks.h"
 #include "mir/graphics/display.h"
 #include "mir/graphics/display_buffer.h"
+#include "mir/graphics/display_configuration.h"
 #include "mir/compositor/display_buffer_compositor.h"
 #include "mir/compositor/display_buffer_compositor_factory.h"
 #include "mir/compositor/display_listener.h"
@@ -35,6 +37,7 @@
 #include <thread>
 #include <chrono>
 #include <condition_variable>
+#include <experimental/optional>
 #include <boost/throw_exception.hpp>
 
 using namespace std::literals::chrono_literals;
@@ -53,14 +56,20 @@ class CompositingFunctor
 public:
     CompositingFunctor(
         std::shared_ptr<mc::DisplayBufferCompositorFactory> const& db_compositor_factory,
+        std::shared_ptr<mg::Display> const& display,
         mg::DisplaySyncGroup& group,
+        std::experimental::optional<unsigned> output_id,
         std::shared_ptr<mc::Scene> const& scene,
         std::shared_ptr<DisplayListener> const& display_listener,
+        std::shared_ptr<FrameClocks> const& frame_clocks,
         std::chrono::milliseconds fixed_composite_delay,
         std::shared_ptr<CompositorReport> const& report) :
         compositor_factory{db_compositor_factory},
+        display{display},
         group(group),
+        output_id{output_id},
         scene(scene),
+        frame_clocks{frame_clocks},
         running{true},
         frames_scheduled{0},
         force_sleep{fixed_composite_delay},
@@ -108,6 +117,17 @@ public:
                     scene->unregister_compositor(std::get<1>(compositor).get());
             });
 
+        std::shared_ptr<FrameClocks::Output> frame_clock;
+        auto frame_clock_registration = mir::raii::paired_calls(
+            [this, &frame_clock]
+            {
+                std::vector<geometry::Rectangle> areas;
+                group.for_each_display_buffer([&areas](mg::DisplayBuffer& buffer)
+                    { areas.push_back(buffer.view_area()); });
+                frame_clock = frame_clocks->add_output(areas, [this]{ schedule_compositing(1); });
+            },
+            [this, &frame_clock]{ frame_clocks->remove_output(frame_clock); });
+
         started.set_value();
 
         try
@@ -135,6 +155,8 @@ public:
                     not_posted_yet = false;
                     lock.unlock();
 
+                    frame_clock->frame_started();
+
                     for (auto& tuple : compositors)
                     {
                         auto& compositor = std::get<1>(tuple);
@@ -142,6 +164,11 @@ public:
                     }
                     group.post();
 
+                    frame_clock->frame_presented(presentation_time());
+
+                    for (auto& tuple : compositors)
+                        report->presented_frame(std::get<1>(tuple).get());
+
                     /*
                      * "Predictive bypass" optimization: If the last frame was
                      * bypassed/overlayed or you simply have a fast GPU, it is
@@ -231,9 +258,34 @@ public:
     }
 
 private:
+    /// When the frame just posted reached the screen
+    auto presentation_time() const -> std::chrono::steady_clock::time_point
+    {
+        if (output_id)
+        {
+            // The vblank the display reports for the output, if it uses the clock steady_clock is based on
+            auto const ust = display->last_frame_on(output_id.value()).ust;
+            if (ust.clock_id == CLOCK_MONOTONIC && ust.nanoseconds > std::chrono::nanoseconds::zero())
+            {
+                return std::chrono::steady_clock::time_point{
+                    std::chrono::duration_cast<std::chrono::steady_clock::duration>(ust.nanoseconds)};
+            }
+        }
+
+        /*
+         * post() returns once the frame is on screen (or, in clone
+         * mode, queued to be), so this is close to this output's vblank.
+         */
+        return std::chrono::steady_clock::now();
+    }
+
     std::shared_ptr<mc::DisplayBufferCompositorFactory> const compositor_factory;
+    std::shared_ptr<mg::Display> const display;
     mg::DisplaySyncGroup& group;
+    /// An output shown by the group, for its frame timing
+    std::experimental::optional<unsigned> const output_id;
     std::shared_ptr<mc::Scene> const scene;
+    std::shared_ptr<FrameClocks> const frame_clocks;
     bool running;
     int frames_scheduled;
     std::chrono::milliseconds force_sleep{-1};
@@ -257,11 +309,33 @@ mc::MultiThreadedCompositor::MultiThreadedCompositor(
     std::shared_ptr<CompositorReport> const& compositor_report,
     std::chrono::milliseconds fixed_composite_delay,
     bool compose_on_start)
+    : MultiThreadedCompositor(
+          display,
+          scene,
+          db_compositor_factory,
+          display_listener,
+          compositor_report,
+          fixed_composite_delay,
+          compose_on_start,
+          std::make_shared<FrameClocks>())
+{
+}
+
+mc::MultiThreadedCompositor::MultiThreadedCompositor(
+    std::shared_ptr<mg::Display> const& display,
+    std::shared_ptr<mc::Scene> const& scene,
+    std::shared_ptr<DisplayBufferCompositorFactory> const& db_compositor_factory,
+    std::shared_ptr<DisplayListener> const& display_listener,
+    std::shared_ptr<CompositorReport> const& compositor_report,
+    std::chrono::milliseconds fixed_composite_delay,
+    bool compose_on_start,
+    std::shared_ptr<FrameClocks> const& frame_clocks)
     : display{display},
       scene{scene},
       display_buffer_compositor_factory{db_compositor_factory},
       display_listener{display_listener},
       report{compositor_report},
+      frame_clocks{frame_clocks},
       state{CompositorState::stopped},
       fixed_composite_delay{fixed_composite_delay},
       compose_on_start{compose_on_start},
@@ -363,12 +437,25 @@ void mc::MultiThreadedCompositor::stop()
 
 void mc::MultiThreadedCompositor::create_compositing_threads()
 {
+    // Frame timing is per output, so find an output each sync group shows
+    auto const config = display->configuration();
+
     /* Start the display buffer compositing threads */
-    display->for_each_display_sync_group([this](mg::DisplaySyncGroup& group)
+    display->for_each_display_sync_group([this, &config](mg::DisplaySyncGroup& group)
     {
+        std::experimental::optional<unsigned> output_id;
+        group.for_each_display_buffer([&config, &output_id](mg::DisplayBuffer& buffer)
+            {
+                config->for_each_output([&](mg::DisplayConfigurationOutput const& output)
+                    {
+                        if (!output_id && output.used && output.extents() == buffer.view_area())
+                            output_id = output.id.as_value();
+                    });
+            });
+
         auto thread_functor = std::make_unique<mc::CompositingFunctor>(
-            display_buffer_compositor_factory, group, scene, display_listener,
-            fixed_composite_delay, report);
+            display_buffer_compositor_factory, display, group, output_id, scene, display_listener,
+            frame_clocks, fixed_composite_delay, report);
 
         futures.push_back(thread_pool.run(std::ref(*thread_functor), &group));
         thread_functors.push_back(std::move(thread_functor));
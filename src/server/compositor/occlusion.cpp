@@ -20,7 +20,14 @@
 #include "mir/compositor/scene_element.h"
 #include "mir/graphics/renderable.h"
 #include "occlusion.h"
+#include "region.h"
 
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <experimental/optional>
+#include <limits>
 #include <vector>
 
 using namespace mir::geometry;
@@ -29,52 +36,112 @@ using namespace mir::compositor;
 
 namespace
 {
-bool renderable_is_occluded(
-    Renderable const& renderable, 
-    Rectangle const& area,
-    std::vector<Rectangle>& coverage)
-{
-    static glm::mat4 const identity(1);
-    static Rectangle const empty{};
+glm::mat4 const identity(1);
 
-    if (renderable.transformation() != identity)
-        return false;  // Weirdly transformed. Assume never occluded.
+/// The part of the screen the renderable can draw to, if that can be worked out
+std::experimental::optional<Rectangle> footprint_of(Renderable const& renderable)
+{
+    auto footprint = renderable.screen_position();
 
-    auto const& window = renderable.screen_position();
-    auto const& clipped_window = window.intersection_with(area);
+    auto const& transform = renderable.transformation();
+    if (transform != identity)
+    {
+        // With perspective the renderable could end up anywhere
+        if (transform[0][3] != 0.0f || transform[1][3] != 0.0f ||
+            transform[2][3] != 0.0f || transform[3][3] != 1.0f)
+        {
+            return {};
+        }
 
-    if (clipped_window == empty)
-        return true;  // Not in the area; definitely occluded.
+        // The renderer transforms renderables about their centre
+        glm::vec4 const centre{
+            footprint.left().as_int() + footprint.size.width.as_int() / 2.0f,
+            footprint.top().as_int() + footprint.size.height.as_int() / 2.0f,
+            0.0f, 0.0f};
 
-    bool occluded = false;
-    for (auto const& r : coverage)
-    {
-        if (r.contains(clipped_window))
+        auto left = std::numeric_limits<float>::max();
+        auto top = std::numeric_limits<float>::max();
+        auto right = std::numeric_limits<float>::lowest();
+        auto bottom = std::numeric_limits<float>::lowest();
+        for (auto const& corner : {footprint.top_left, footprint.top_right(),
+                                   footprint.bottom_left(), footprint.bottom_right()})
         {
-            occluded = true;
-            break;
+            glm::vec4 const position{corner.x.as_int(), corner.y.as_int(), 0.0f, 1.0f};
+            auto const transformed = transform * (position - centre) + centre;
+            left = std::min(left, transformed.x);
+            top = std::min(top, transformed.y);
+            right = std::max(right, transformed.x);
+            bottom = std::max(bottom, transformed.y);
         }
+
+        footprint = Rectangle{
+            {std::floor(left), std::floor(top)},
+            {std::ceil(right) - std::floor(left), std::ceil(bottom) - std::floor(top)}};
     }
 
-    if (!occluded && renderable.alpha() == 1.0f && !renderable.shaped())
-        coverage.push_back(clipped_window);
+    if (auto const& clip = renderable.clip_area())
+        footprint = footprint.intersection_with(clip.value());
 
-    return occluded;
+    return footprint;
 }
+
+/// The part of on_screen that the renderable hides whatever is behind
+Region opaque_part_of(Renderable const& renderable, Region const& on_screen)
+{
+    // A transformed renderable need not fill its footprint
+    if (renderable.alpha() != 1.0f || renderable.transformation() != identity)
+        return {};
+
+    if (!renderable.shaped())
+        return on_screen;
+
+    Region opaque;
+    for (auto const& rect : renderable.opaque_region())
+        opaque.unite(rect);
+    opaque.intersect(on_screen);
+    return opaque;
 }
 
-SceneElementSequence mir::compositor::filter_occlusions_from(
+bool renderable_is_occluded(
+    Renderable const& renderable,
+    Rectangle const& area,
+    Region& coverage,
+    VisibleRegions* partially_visible)
+{
+    auto const footprint = footprint_of(renderable);
+    if (!footprint)
+        return false;  // Weirdly transformed. Assume never occluded.
+
+    Region const on_screen{footprint.value().intersection_with(area)};
+    if (on_screen.empty())
+        return true;  // Not in the area; definitely occluded.
+
+    auto visible = on_screen;
+    visible.subtract(coverage);
+    if (visible.empty())
+        return true;
+
+    if (partially_visible && visible != on_screen && renderable.transformation() == identity)
+        (*partially_visible)[renderable.id()] = visible.rectangles();
+
+    coverage.unite(opaque_part_of(renderable, on_screen));
+
+    return false;
+}
+
+SceneElementSequence filter_occlusions_from(
     SceneElementSequence& elements,
-    Rectangle const& area)
+    Rectangle const& area,
+    VisibleRegions* partially_visible)
 {
     SceneElementSequence occluded;
-    std::vector<Rectangle> coverage;
+    Region coverage;
 
     auto it = elements.rbegin();
     while (it != elements.rend())
     {
         auto const renderable = (*it)->renderable();
-        if (renderable_is_occluded(*renderable, area, coverage))
+        if (renderable_is_occluded(*renderable, area, coverage, partially_visible))
         {
             occluded.insert(occluded.begin(), *it);
             it = SceneElementSequence::reverse_iterator(elements.erase(std::prev(it.base())));
@@ -87,3 +154,20 @@ SceneElementSequence mir::compositor::filter_occlusions_from(
 
     return occluded;
 }
+}
+
+SceneElementSequence mir::compositor::filter_occlusions_from(
+    SceneElementSequence& elements,
+    Rectangle const& area)
+{
+    return ::filter_occlusions_from(elements, area, nullptr);
+}
+
+SceneElementSequence mir::compositor::filter_occlusions_from(
+    SceneElementSequence& elements,
+    Rectangle const& area,
+    VisibleRegions& partially_visible)
+{
+    partially_visible.clear();
+    return ::filter_occlusions_from(elements, area, &partially_visible);
+}
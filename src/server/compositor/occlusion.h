@@ -20,14 +20,36 @@
 #define MIR_COMPOSITOR_OCCLUSION_H_
 
 #include "mir/compositor/scene.h"
+#include "mir/graphics/renderable.h"
+
+#include <unordered_map>
+#include <vector>
 
 namespace mir
 {
 namespace compositor
 {
 
+/// The on-screen parts of renderables, keyed by renderable ID
+using VisibleRegions = std::unordered_map<graphics::Renderable::ID, std::vector<geometry::Rectangle>>;
+
+/**
+ * Removes, and returns, the elements that cannot be seen within area because
+ * they lie outside it or because the union of the opaque elements stacked
+ * above them covers them.
+ */
 SceneElementSequence filter_occlusions_from(SceneElementSequence& list, geometry::Rectangle const& area);
 
+/**
+ * As above, also filling partially_visible with the parts of the remaining
+ * untransformed elements that are not covered, for those that are partly
+ * covered. Elements that are entirely visible are left out.
+ */
+SceneElementSequence filter_occlusions_from(
+    SceneElementSequence& list,
+    geometry::Rectangle const& area,
+    VisibleRegions& partially_visible);
+
 } // namespace compositor
 } // namespace mir
 
@@ -0,0 +1,189 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "region.h"
+
+#include <algorithm>
+
+namespace mc = mir::compositor;
+namespace geom = mir::geometry;
+
+mc::Region::Region(geom::Rectangle const& rect)
+{
+    if (rect.size.width > geom::Width{0} && rect.size.height > geom::Height{0})
+    {
+        bands.push_back(Band{
+            rect.top().as_int(), rect.bottom().as_int(),
+            {Span{rect.left().as_int(), rect.right().as_int()}}});
+    }
+}
+
+template<typename Op>
+auto mc::Region::combine(std::vector<Span> const& a, std::vector<Span> const& b, Op const& op) -> std::vector<Span>
+{
+    std::vector<int> edges;
+    edges.reserve(2 * (a.size() + b.size()));
+    for (auto const& span : a)
+    {
+        edges.push_back(span.x1);
+        edges.push_back(span.x2);
+    }
+    for (auto const& span : b)
+    {
+        edges.push_back(span.x1);
+        edges.push_back(span.x2);
+    }
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+    std::vector<Span> result;
+    auto next_a = a.begin();
+    auto next_b = b.begin();
+    for (auto edge = edges.begin(); edge != edges.end() && std::next(edge) != edges.end(); ++edge)
+    {
+        auto const x1 = *edge;
+        auto const x2 = *std::next(edge);
+
+        while (next_a != a.end() && next_a->x2 <= x1) ++next_a;
+        while (next_b != b.end() && next_b->x2 <= x1) ++next_b;
+
+        auto const in_a = next_a != a.end() && next_a->x1 <= x1;
+        auto const in_b = next_b != b.end() && next_b->x1 <= x1;
+
+        if (op(in_a, in_b))
+        {
+            if (!result.empty() && result.back().x2 == x1)
+                result.back().x2 = x2;
+            else
+                result.push_back(Span{x1, x2});
+        }
+    }
+
+    return result;
+}
+
+template<typename Op>
+auto mc::Region::combine(Region const& a, Region const& b, Op const& op) -> Region
+{
+    std::vector<int> edges;
+    edges.reserve(2 * (a.bands.size() + b.bands.size()));
+    for (auto const& band : a.bands)
+    {
+        edges.push_back(band.y1);
+        edges.push_back(band.y2);
+    }
+    for (auto const& band : b.bands)
+    {
+        edges.push_back(band.y1);
+        edges.push_back(band.y2);
+    }
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+    static std::vector<Span> const no_spans;
+
+    Region result;
+    auto next_a = a.bands.begin();
+    auto next_b = b.bands.begin();
+    for (auto edge = edges.begin(); edge != edges.end() && std::next(edge) != edges.end(); ++edge)
+    {
+        auto const y1 = *edge;
+        auto const y2 = *std::next(edge);
+
+        while (next_a != a.bands.end() && next_a->y2 <= y1) ++next_a;
+        while (next_b != b.bands.end() && next_b->y2 <= y1) ++next_b;
+
+        auto const& spans_a = next_a != a.bands.end() && next_a->y1 <= y1 ? next_a->spans : no_spans;
+        auto const& spans_b = next_b != b.bands.end() && next_b->y1 <= y1 ? next_b->spans : no_spans;
+
+        auto spans = combine(spans_a, spans_b, op);
+        if (spans.empty())
+            continue;
+
+        auto& bands = result.bands;
+        if (!bands.empty() && bands.back().y2 == y1 && bands.back().spans == spans)
+            bands.back().y2 = y2;
+        else
+            bands.push_back(Band{y1, y2, std::move(spans)});
+    }
+
+    return result;
+}
+
+void mc::Region::unite(Region const& other)
+{
+    *this = combine(*this, other, [](bool in_this, bool in_other) { return in_this || in_other; });
+}
+
+void mc::Region::subtract(Region const& other)
+{
+    *this = combine(*this, other, [](bool in_this, bool in_other) { return in_this && !in_other; });
+}
+
+void mc::Region::intersect(Region const& other)
+{
+    *this = combine(*this, other, [](bool in_this, bool in_other) { return in_this && in_other; });
+}
+
+auto mc::Region::empty() const -> bool
+{
+    return bands.empty();
+}
+
+auto mc::Region::contains(geom::Rectangle const& rect) const -> bool
+{
+    Region uncovered{rect};
+    uncovered.subtract(*this);
+    return uncovered.empty();
+}
+
+auto mc::Region::overlaps(geom::Rectangle const& rect) const -> bool
+{
+    Region overlap{rect};
+    overlap.intersect(*this);
+    return !overlap.empty();
+}
+
+auto mc::Region::rectangles() const -> std::vector<geom::Rectangle>
+{
+    std::vector<geom::Rectangle> result;
+    for (auto const& band : bands)
+    {
+        for (auto const& span : band.spans)
+        {
+            result.push_back({
+                {span.x1, band.y1},
+                {span.x2 - span.x1, band.y2 - band.y1}});
+        }
+    }
+    return result;
+}
+
+auto mc::Region::operator==(Region const& other) const -> bool
+{
+    return std::equal(
+        bands.begin(), bands.end(),
+        other.bands.begin(), other.bands.end(),
+        [](Band const& lhs, Band const& rhs)
+        {
+            return lhs.y1 == rhs.y1 && lhs.y2 == rhs.y2 && lhs.spans == rhs.spans;
+        });
+}
+
+auto mc::Region::operator!=(Region const& other) const -> bool
+{
+    return !(*this == other);
+}
@@ -0,0 +1,81 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_COMPOSITOR_REGION_H_
+#define MIR_COMPOSITOR_REGION_H_
+
+#include "mir/geometry/rectangle.h"
+
+#include <vector>
+
+namespace mir
+{
+namespace compositor
+{
+
+/**
+ * An arbitrary set of pixels, stored as the union of non-overlapping rectangles.
+ *
+ * The rectangles are kept in y-x banded form: the region is cut into horizontal
+ * bands, each holding sorted, disjoint spans, and vertically adjacent bands with
+ * the same spans are merged. This keeps the representation canonical, so equal
+ * regions compare equal and unions of abutting rectangles collapse.
+ */
+class Region
+{
+public:
+    Region() = default;
+    Region(geometry::Rectangle const& rect);
+
+    void unite(Region const& other);
+    void subtract(Region const& other);
+    void intersect(Region const& other);
+
+    auto empty() const -> bool;
+    auto contains(geometry::Rectangle const& rect) const -> bool;
+    auto overlaps(geometry::Rectangle const& rect) const -> bool;
+
+    /// The non-overlapping rectangles making up the region, top to bottom and left to right
+    auto rectangles() const -> std::vector<geometry::Rectangle>;
+
+    auto operator==(Region const& other) const -> bool;
+    auto operator!=(Region const& other) const -> bool;
+
+private:
+    struct Span
+    {
+        int x1, x2;
+        auto operator==(Span const& other) const -> bool { return x1 == other.x1 && x2 == other.x2; }
+    };
+    struct Band
+    {
+        int y1, y2;
+        std::vector<Span> spans;
+    };
+
+    template<typename Op>
+    static auto combine(Region const& a, Region const& b, Op const& op) -> Region;
+
+    template<typename Op>
+    static auto combine(std::vector<Span> const& a, std::vector<Span> const& b, Op const& op) -> std::vector<Span>;
+
+    std::vector<Band> bands;
+};
+
+}
+}
+
+#endif // MIR_COMPOSITOR_REGION_H_
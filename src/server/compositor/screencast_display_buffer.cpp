@@ -0,0 +1,198 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "screencast_display_buffer.h"
+#include "mir/graphics/buffer.h"
+#include "mir/graphics/dmabuf_buffer.h"
+#include "mir/graphics/texture.h"
+#include "mir/renderer/gl/context.h"
+
+#include <boost/throw_exception.hpp>
+#include <stdexcept>
+
+namespace mc = mir::compositor;
+namespace mg = mir::graphics;
+namespace geom = mir::geometry;
+
+namespace
+{
+/*
+ * The renderer draws the top of the screen at the top of the GL window, which
+ * is the last row of a texture. Flipping vertically puts it in the first row.
+ */
+glm::mat2 transform_for(MirMirrorMode mirror_mode)
+{
+    switch (mirror_mode)
+    {
+    case mir_mirror_mode_vertical:
+        return glm::mat2{1};
+    case mir_mirror_mode_horizontal:
+        return glm::mat2{-1, 0, 0, -1};
+    default:
+        return glm::mat2{1, 0, 0, -1};
+    }
+}
+
+/// The name of the GL texture behind the buffer, or zero if it has none we can render to
+GLuint texture_of(mg::gl::Texture& texture)
+{
+    glBindTexture(GL_TEXTURE_2D, 0);
+    texture.bind();
+
+    GLint name{0};
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &name);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    return name;
+}
+}
+
+mc::ScreencastDisplayBuffer::ScreencastDisplayBuffer(
+    geom::Rectangle const& rect,
+    geom::Size const& size,
+    MirMirrorMode mirror_mode,
+    renderer::gl::Context const& context)
+    : rect{rect},
+      size{size},
+      transform{transform_for(mirror_mode)},
+      context{context}
+{
+}
+
+mc::ScreencastDisplayBuffer::~ScreencastDisplayBuffer()
+{
+    if (targets.empty())
+        return;
+
+    context.make_current();
+    for (auto const& target : targets)
+        glDeleteFramebuffers(1, &target.second.framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    context.release_current();
+}
+
+void mc::ScreencastDisplayBuffer::set_target(std::shared_ptr<mg::Buffer> const& buffer)
+{
+    forget_released_buffers();
+    current = nullptr;
+
+    auto const existing = targets.find(buffer->id());
+    if (existing != targets.end())
+    {
+        current = &existing->second;
+        return;
+    }
+
+    if (buffer->size() != size)
+        BOOST_THROW_EXCEPTION(std::invalid_argument("Screencast buffer is not the size of the session"));
+
+    auto const native = buffer->native_buffer_base();
+    if (!dynamic_cast<mg::DMABufBuffer*>(native))
+        BOOST_THROW_EXCEPTION(std::invalid_argument("Screencast buffer is not a dmabuf"));
+
+    auto const texture = dynamic_cast<mg::gl::Texture*>(native);
+    GLuint const texture_name = texture ? texture_of(*texture) : 0;
+    if (!texture_name)
+        BOOST_THROW_EXCEPTION(std::invalid_argument("Screencast buffer cannot be rendered to"));
+
+    GLuint framebuffer{0};
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture_name, 0);
+
+    auto const status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        glDeleteFramebuffers(1, &framebuffer);
+        BOOST_THROW_EXCEPTION(std::invalid_argument("Screencast buffer cannot be rendered to"));
+    }
+
+    current = &targets.emplace(buffer->id(), Target{buffer, framebuffer, 0}).first->second;
+}
+
+void mc::ScreencastDisplayBuffer::forget_released_buffers()
+{
+    for (auto target = targets.begin(); target != targets.end();)
+    {
+        if (target->second.buffer.expired())
+        {
+            glDeleteFramebuffers(1, &target->second.framebuffer);
+            target = targets.erase(target);
+        }
+        else
+        {
+            ++target;
+        }
+    }
+}
+
+geom::Rectangle mc::ScreencastDisplayBuffer::view_area() const
+{
+    return rect;
+}
+
+bool mc::ScreencastDisplayBuffer::overlay(mg::RenderableList const&)
+{
+    return false;
+}
+
+glm::mat2 mc::ScreencastDisplayBuffer::transformation() const
+{
+    return transform;
+}
+
+mg::NativeDisplayBuffer* mc::ScreencastDisplayBuffer::native_display_buffer()
+{
+    return this;
+}
+
+void mc::ScreencastDisplayBuffer::make_current()
+{
+    context.make_current();
+}
+
+void mc::ScreencastDisplayBuffer::release_current()
+{
+    context.release_current();
+}
+
+void mc::ScreencastDisplayBuffer::swap_buffers()
+{
+    // The client may read the buffer as soon as capture returns
+    glFinish();
+
+    if (current)
+        current->frame = ++frame;
+}
+
+int mc::ScreencastDisplayBuffer::buffer_age() const
+{
+    if (!current || !current->frame)
+        return 0;
+
+    return frame - current->frame + 1;
+}
+
+void mc::ScreencastDisplayBuffer::bind()
+{
+    if (!current)
+        BOOST_THROW_EXCEPTION(std::logic_error("Screencast has no buffer to render to"));
+
+    glBindFramebuffer(GL_FRAMEBUFFER, current->framebuffer);
+    glViewport(0, 0, size.width.as_int(), size.height.as_int());
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_COMPOSITOR_SCREENCAST_DISPLAY_BUFFER_H_
+#define MIR_COMPOSITOR_SCREENCAST_DISPLAY_BUFFER_H_
+
+#include "mir/graphics/display_buffer.h"
+#include "mir/graphics/buffer_id.h"
+#include "mir/renderer/gl/render_target.h"
+#include "mir_toolkit/common.h"
+
+#include <GLES2/gl2.h>
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+
+namespace mir
+{
+namespace graphics { class Buffer; }
+namespace renderer { namespace gl { class Context; } }
+namespace compositor
+{
+
+/**
+ * Renders a region of the screen into client buffers, through a framebuffer
+ * object attached to each buffer's texture. The buffers are imported dmabufs,
+ * so the client reads what was rendered without anything being copied.
+ *
+ * Buffers are drawn top row first (as encoders expect) unless mirrored vertically.
+ */
+class ScreencastDisplayBuffer : public graphics::DisplayBuffer,
+                                public graphics::NativeDisplayBuffer,
+                                public renderer::gl::RenderTarget
+{
+public:
+    ScreencastDisplayBuffer(
+        geometry::Rectangle const& rect,
+        geometry::Size const& size,
+        MirMirrorMode mirror_mode,
+        renderer::gl::Context const& context);
+    ~ScreencastDisplayBuffer();
+
+    /**
+     * Direct rendering at buffer, which must be a dmabuf the size of the session.
+     *
+     * \throws std::invalid_argument if buffer can't be rendered to.
+     * \note   The GL context must be current.
+     */
+    void set_target(std::shared_ptr<graphics::Buffer> const& buffer);
+
+    geometry::Rectangle view_area() const override;
+    bool overlay(graphics::RenderableList const& renderlist) override;
+    glm::mat2 transformation() const override;
+    NativeDisplayBuffer* native_display_buffer() override;
+
+    void make_current() override;
+    void release_current() override;
+    void swap_buffers() override;
+    int buffer_age() const override;
+    void bind() override;
+
+private:
+    struct Target
+    {
+        std::weak_ptr<graphics::Buffer> buffer;
+        GLuint framebuffer;
+        /// The frame last drawn to the buffer
+        uint64_t frame;
+    };
+
+    void forget_released_buffers();
+
+    geometry::Rectangle const rect;
+    geometry::Size const size;
+    glm::mat2 const transform;
+    renderer::gl::Context const& context;
+
+    std::unordered_map<graphics::BufferID, Target> targets;
+    Target* current{nullptr};
+    uint64_t frame{0};
+};
+
+}
+}
+
+#endif /* MIR_COMPOSITOR_SCREENCAST_DISPLAY_BUFFER_H_ */
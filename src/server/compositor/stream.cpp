@@ -22,6 +22,7 @@
 #include "dropping_schedule.h"
 #include "mir/graphics/buffer.h"
 #include <boost/throw_exception.hpp>
+#include <algorithm>
 
 namespace mc = mir::compositor;
 namespace geom = mir::geometry;
@@ -29,6 +30,12 @@ namespace mg = mir::graphics;
 namespace ms = mir::scene;
 namespace geom = mir::geometry;
 
+namespace
+{
+// Enough to cover a client submitting at several times the display refresh rate
+size_t const max_damage_history = 8;
+}
+
 enum class mc::Stream::ScheduleMode {
     Queueing,
     Dropping
@@ -49,15 +56,36 @@ mc::Stream::Stream(
 mc::Stream::~Stream() = default;
 
 void mc::Stream::submit_buffer(std::shared_ptr<mg::Buffer> const& buffer)
+{
+    submit(buffer, std::experimental::nullopt);
+}
+
+void mc::Stream::submit_buffer(std::shared_ptr<mg::Buffer> const& buffer, std::vector<geom::Rectangle> const& damage)
+{
+    submit(buffer, damage);
+}
+
+void mc::Stream::submit(
+    std::shared_ptr<mg::Buffer> const& buffer,
+    std::experimental::optional<std::vector<geom::Rectangle>> damage)
 {
     if (!buffer)
         BOOST_THROW_EXCEPTION(std::invalid_argument("cannot submit null buffer"));
 
     {
         std::lock_guard<decltype(mutex)> lk(mutex);
+        // A resized buffer has no meaningful relationship with its predecessor
+        if (!first_frame_posted || buffer->size() != latest_buffer_size)
+            damage = std::experimental::nullopt;
+
         first_frame_posted = true;
         pf = buffer->pixel_format();
         latest_buffer_size = buffer->size();
+
+        damage_history.push_back({buffer->id(), std::move(damage)});
+        if (damage_history.size() > max_damage_history)
+            damage_history.pop_front();
+
         schedule->schedule(buffer);
     }
     {
@@ -85,6 +113,48 @@ void mc::Stream::set_frame_posted_callback(
     frame_callback = callback;
 }
 
+auto mc::Stream::damage_between(mg::BufferID previous, mg::BufferID current) const
+    -> std::experimental::optional<std::vector<geom::Rectangle>>
+{
+    std::lock_guard<decltype(mutex)> lk(mutex);
+
+    auto const is_buffer = [](mg::BufferID id) { return [id](SubmittedDamage const& entry) { return entry.buffer == id; }; };
+
+    auto const last = std::find_if(damage_history.rbegin(), damage_history.rend(), is_buffer(current));
+    if (last == damage_history.rend())
+        return std::experimental::nullopt;
+
+    if (previous == current)
+        return std::vector<geom::Rectangle>{};
+
+    auto const first = std::find_if(last, damage_history.rend(), is_buffer(previous));
+    if (first == damage_history.rend())
+        return std::experimental::nullopt;
+
+    std::vector<geom::Rectangle> damage;
+    for (auto entry = last; entry != first; ++entry)
+    {
+        if (!entry->damage)
+            return std::experimental::nullopt;
+
+        damage.insert(damage.end(), entry->damage->begin(), entry->damage->end());
+    }
+
+    return damage;
+}
+
+void mc::Stream::set_opaque_region(std::vector<geom::Rectangle> const& region)
+{
+    std::lock_guard<decltype(mutex)> lk(mutex);
+    opaque_region_ = region;
+}
+
+auto mc::Stream::opaque_region() const -> std::vector<geom::Rectangle>
+{
+    std::lock_guard<decltype(mutex)> lk(mutex);
+    return opaque_region_;
+}
+
 std::shared_ptr<mg::Buffer> mc::Stream::lock_compositor_buffer(void const* id)
 {
     return arbiter->compositor_acquire(id);
@@ -29,6 +29,7 @@
 #include <mutex>
 #include <memory>
 #include <set>
+#include <deque>
 
 namespace mir
 {
@@ -43,6 +44,13 @@ public:
     ~Stream();
 
     void submit_buffer(std::shared_ptr<graphics::Buffer> const& buffer) override;
+    void submit_buffer(
+        std::shared_ptr<graphics::Buffer> const& buffer,
+        std::vector<geometry::Rectangle> const& damage) override;
+    auto damage_between(graphics::BufferID previous, graphics::BufferID current) const
+        -> std::experimental::optional<std::vector<geometry::Rectangle>> override;
+    void set_opaque_region(std::vector<geometry::Rectangle> const& region) override;
+    auto opaque_region() const -> std::vector<geometry::Rectangle> override;
     void with_most_recent_buffer_do(std::function<void(graphics::Buffer&)> const& exec) override;
     MirPixelFormat pixel_format() const override;
     void set_frame_posted_callback(
@@ -60,6 +68,15 @@ public:
 private:
     enum class ScheduleMode;
     void transition_schedule(std::shared_ptr<Schedule>&& new_schedule, std::lock_guard<std::mutex> const&);
+    void submit(
+        std::shared_ptr<graphics::Buffer> const& buffer,
+        std::experimental::optional<std::vector<geometry::Rectangle>> damage);
+
+    struct SubmittedDamage
+    {
+        graphics::BufferID buffer;
+        std::experimental::optional<std::vector<geometry::Rectangle>> damage;
+    };
 
     std::mutex mutable mutex;
     ScheduleMode schedule_mode;
@@ -69,6 +86,9 @@ private:
     float scale_{1.0f};
     MirPixelFormat pf;
     bool first_frame_posted;
+    /// Damage of the most recently submitted buffers, oldest first
+    std::deque<SubmittedDamage> damage_history;
+    std::vector<geometry::Rectangle> opaque_region_;
 
     std::mutex callback_mutex;
     std::function<void(geometry::Size const&)> frame_callback;
@@ -0,0 +1,107 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/time/duration_histogram.h"
+
+#include <algorithm>
+#include <cmath>
+#include <ostream>
+
+namespace mt = mir::time;
+
+using namespace std::chrono;
+
+namespace
+{
+int constexpr linear_buckets{16};
+int constexpr sub_buckets_log2{3};
+int constexpr sub_buckets{1 << sub_buckets_log2};
+
+// Below 16µs every microsecond has its own bucket; above, each power of two is split into eight
+auto bucket_for(microseconds duration, int bucket_count) -> int
+{
+    auto const us = static_cast<uint64_t>(std::max(duration.count(), microseconds::rep{0}));
+    if (us < linear_buckets)
+        return static_cast<int>(us);
+
+    int const exponent = 63 - __builtin_clzll(us);
+    int const sub_bucket = (us >> (exponent - sub_buckets_log2)) & (sub_buckets - 1);
+    int const bucket = linear_buckets + (exponent - 4) * sub_buckets + sub_bucket;
+    return std::min(bucket, bucket_count - 1);
+}
+
+// The largest duration that falls in the bucket
+auto largest_in(int bucket) -> microseconds
+{
+    auto const next = bucket + 1;
+    if (next < linear_buckets)
+        return microseconds{next - 1};
+
+    int const exponent = (next - linear_buckets) / sub_buckets + 4;
+    int const sub_bucket = (next - linear_buckets) % sub_buckets;
+    return microseconds{(uint64_t{sub_buckets + static_cast<unsigned>(sub_bucket)} << (exponent - sub_buckets_log2)) - 1};
+}
+}
+
+void mt::DurationHistogram::record(nanoseconds duration)
+{
+    auto const us = std::max(duration_cast<microseconds>(duration), microseconds{0});
+
+    ++buckets[bucket_for(us, bucket_count)];
+    ++count;
+    sum += us;
+    max = std::max(max, us);
+}
+
+auto mt::DurationHistogram::percentile(double fraction) const -> microseconds
+{
+    if (!count)
+        return microseconds{0};
+
+    auto const rank = static_cast<uint64_t>(std::ceil(fraction * count));
+    uint64_t seen{0};
+    for (int bucket = 0; bucket != bucket_count; ++bucket)
+    {
+        seen += buckets[bucket];
+        if (seen >= rank)
+            return std::min(largest_in(bucket), max);
+    }
+    return max;
+}
+
+auto mt::DurationHistogram::summary() const -> Summary
+{
+    return Summary{
+        count,
+        count ? sum / static_cast<microseconds::rep>(count) : microseconds{0},
+        percentile(0.5),
+        percentile(0.9),
+        percentile(0.99),
+        percentile(0.999),
+        max};
+}
+
+void mt::write_json(std::ostream& out, DurationHistogram::Summary const& summary)
+{
+    out << "{\"count\":" << summary.count
+        << ",\"mean_us\":" << summary.mean.count()
+        << ",\"p50_us\":" << summary.median.count()
+        << ",\"p90_us\":" << summary.p90.count()
+        << ",\"p99_us\":" << summary.p99.count()
+        << ",\"p999_us\":" << summary.p999.count()
+        << ",\"max_us\":" << summary.max.count()
+        << "}";
+}
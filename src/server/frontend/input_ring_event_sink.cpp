@@ -0,0 +1,99 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "input_ring_event_sink.h"
+
+#include "mir/events/event.h"
+#include "mir/events/event_ring.h"
+
+namespace mf = mir::frontend;
+namespace mg = mir::graphics;
+namespace mev = mir::events;
+
+mf::InputRingEventSink::InputRingEventSink(std::shared_ptr<EventSink> const& wrapped)
+    : wrapped{wrapped}
+{
+}
+
+void mf::InputRingEventSink::use_ring(std::shared_ptr<mev::EventRing> const& ring)
+{
+    std::lock_guard<decltype(mutex)> lock{mutex};
+    this->ring = ring;
+}
+
+void mf::InputRingEventSink::handle_event(EventUPtr&& event)
+{
+    if (event->type() == mir_event_type_input)
+    {
+        std::lock_guard<decltype(mutex)> lock{mutex};
+        if (ring)
+        {
+            auto const ev = event.get();
+            ring->push(MirEvent::serialized_size(ev), [ev](void* data) { MirEvent::serialize_into(ev, data); });
+            return;
+        }
+    }
+
+    wrapped->handle_event(std::move(event));
+}
+
+void mf::InputRingEventSink::handle_lifecycle_event(MirLifecycleState state)
+{
+    wrapped->handle_lifecycle_event(state);
+}
+
+void mf::InputRingEventSink::handle_display_config_change(mg::DisplayConfiguration const& config)
+{
+    wrapped->handle_display_config_change(config);
+}
+
+void mf::InputRingEventSink::send_ping(int32_t serial)
+{
+    wrapped->send_ping(serial);
+}
+
+void mf::InputRingEventSink::handle_input_config_change(MirInputConfig const& config)
+{
+    wrapped->handle_input_config_change(config);
+}
+
+void mf::InputRingEventSink::handle_error(ClientVisibleError const& error)
+{
+    wrapped->handle_error(error);
+}
+
+void mf::InputRingEventSink::send_buffer(BufferStreamId id, mg::Buffer& buffer, mg::BufferIpcMsgType type)
+{
+    wrapped->send_buffer(id, buffer, type);
+}
+
+void mf::InputRingEventSink::add_buffer(mg::Buffer& buffer)
+{
+    wrapped->add_buffer(buffer);
+}
+
+void mf::InputRingEventSink::error_buffer(
+    geometry::Size req_size,
+    MirPixelFormat req_format,
+    std::string const& error_msg)
+{
+    wrapped->error_buffer(req_size, req_format, error_msg);
+}
+
+void mf::InputRingEventSink::update_buffer(mg::Buffer& buffer)
+{
+    wrapped->update_buffer(buffer);
+}
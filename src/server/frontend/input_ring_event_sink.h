@@ -0,0 +1,68 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_FRONTEND_INPUT_RING_EVENT_SINK_H_
+#define MIR_FRONTEND_INPUT_RING_EVENT_SINK_H_
+
+#include "mir/frontend/event_sink.h"
+
+#include <memory>
+#include <mutex>
+
+namespace mir
+{
+namespace events
+{
+class EventRing;
+}
+namespace frontend
+{
+/**
+ * An EventSink for a surface that, once the client has asked for one, writes input events into a shared-memory ring
+ * instead of sending them over the socket. Everything else goes to the wrapped sink.
+ *
+ * An input event that doesn't fit in the ring (because the client isn't reading) is dropped, rather than holding up
+ * the input thread.
+ */
+class InputRingEventSink : public EventSink
+{
+public:
+    explicit InputRingEventSink(std::shared_ptr<EventSink> const& wrapped);
+
+    void use_ring(std::shared_ptr<events::EventRing> const& ring);
+
+    void handle_event(EventUPtr&& event) override;
+    void handle_lifecycle_event(MirLifecycleState state) override;
+    void handle_display_config_change(graphics::DisplayConfiguration const& config) override;
+    void send_ping(int32_t serial) override;
+    void handle_input_config_change(MirInputConfig const& config) override;
+    void handle_error(ClientVisibleError const& error) override;
+
+    void send_buffer(BufferStreamId id, graphics::Buffer& buffer, graphics::BufferIpcMsgType type) override;
+    void add_buffer(graphics::Buffer& buffer) override;
+    void error_buffer(geometry::Size req_size, MirPixelFormat req_format, std::string const& error_msg) override;
+    void update_buffer(graphics::Buffer& buffer) override;
+
+private:
+    std::shared_ptr<EventSink> const wrapped;
+
+    std::mutex mutex;
+    std::shared_ptr<events::EventRing> ring;
+};
+}
+}
+
+#endif /* MIR_FRONTEND_INPUT_RING_EVENT_SINK_H_ */
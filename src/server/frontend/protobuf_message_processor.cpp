@@ -326,6 +326,10 @@ bool mfd::ProtobufMessageProcessor::dispatch(
         {
             invoke(this, display_server.get(), &protobuf::DisplayServer::request_persistent_surface_id, invocation);
         }
+        else if ("request_input_ring" == invocation.method_name())
+        {
+            invoke(this, display_server.get(), &protobuf::DisplayServer::request_input_ring, invocation);
+        }
         else if ("preview_base_display_configuration" == invocation.method_name())
         {
             invoke(this, display_server.get(), &protobuf::DisplayServer::preview_base_display_configuration, invocation);
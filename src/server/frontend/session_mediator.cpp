@@ -18,6 +18,7 @@
 
 #include "session_mediator.h"
 #include "reordering_message_sender.h"
+#include "input_ring_event_sink.h"
 #include "event_sink_factory.h"
 
 #include "mir/frontend/session_mediator_observer.h"
@@ -55,6 +56,7 @@
 #include "mir/input/device.h"
 #include "mir/scene/prompt_session_creation_parameters.h"
 #include "mir/fd.h"
+#include "mir/events/event_ring.h"
 #include "mir/cookie/authority.h"
 #include "mir/module_properties.h"
 #include "mir/graphics/graphic_buffer_allocator.h"
@@ -83,9 +85,13 @@ namespace mfd=mir::frontend::detail;
 namespace mg = mir::graphics;
 namespace mi = mir::input;
 namespace geom = mir::geometry;
+namespace mev = mir::events;
 
 namespace
 {
+// Room for a few hundred input events, which is plenty for a client that reads them as they come
+size_t const input_ring_capacity{64 * 1024};
+
 mg::GammaCurve convert_string_to_gamma_curve(std::string const& str_bytes)
 {
     mg::GammaCurve out(str_bytes.size() / (sizeof(mg::GammaCurve::value_type) / sizeof(char)));
@@ -324,9 +330,10 @@ void mf::SessionMediator::create_surface(
     params.input_shape = extract_input_shape_from(request);
 
     auto buffering_sender = std::make_shared<mf::ReorderingMessageSender>(message_sender);
-    std::shared_ptr<mf::EventSink> sink = sink_factory->create_sink(buffering_sender);
+    auto const sink = std::make_shared<mf::InputRingEventSink>(sink_factory->create_sink(buffering_sender));
 
     auto const surf_id = shell->create_surface(mir_client_session, params, sink);
+    input_ring_sinks[surf_id] = sink;
 
     auto surface = mir_client_session->frontend_surface(surf_id);
     auto const& content_size = surface->content_size();
@@ -591,6 +598,8 @@ void mf::SessionMediator::release_surface(
         legacy_default_stream_map.erase(it);
     }
 
+    input_ring_sinks.erase(id);
+
     // TODO: We rely on this sending responses synchronously.
     done->Run();
 }
@@ -1158,6 +1167,32 @@ void mf::SessionMediator::request_persistent_surface_id(
     done->Run();
 }
 
+void mf::SessionMediator::request_input_ring(
+    mir::protobuf::SurfaceId const* request,
+    mir::protobuf::SocketFD* response,
+    google::protobuf::Closure* done)
+{
+    auto const mir_client_session = weak_mir_client_session.lock();
+
+    if (!mir_client_session)
+        BOOST_THROW_EXCEPTION(std::logic_error("Invalid application session"));
+
+    auto const sink = input_ring_sinks.find(mf::SurfaceId{request->value()});
+    if (sink == input_ring_sinks.end())
+        BOOST_THROW_EXCEPTION(std::logic_error("Invalid surface"));
+
+    auto const ring = std::make_shared<mev::EventRing>(input_ring_capacity);
+    sink->second->use_ring(ring);
+
+    for (auto const& fd : {ring->shm_fd(), ring->notify_fd()})
+    {
+        response->add_fd(fd);
+        resource_cache->save_fd(response, fd);
+    }
+
+    done->Run();
+}
+
 void mf::SessionMediator::configure_buffer_stream(
     mir::protobuf::StreamConfiguration const* request,
     mir::protobuf::Void*,
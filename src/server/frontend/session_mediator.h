@@ -73,6 +73,7 @@ class MessageResourceCache;
 class SessionMediatorObserver;
 class EventSink;
 class EventSinkFactory;
+class InputRingEventSink;
 class MessageSender;
 class DisplayChanger;
 class Screencast;
@@ -240,6 +241,10 @@ public:
         mir::protobuf::SurfaceId const* request,
         mir::protobuf::PersistentSurfaceId* response,
         google::protobuf::Closure* done) override;
+    void request_input_ring(
+        mir::protobuf::SurfaceId const* request,
+        mir::protobuf::SocketFD* response,
+        google::protobuf::Closure* done) override;
     void pong(
         mir::protobuf::PingEvent const* request,
         mir::protobuf::Void* response,
@@ -303,6 +308,7 @@ private:
     detail::PromptSessionStore prompt_sessions;
 
     std::map<frontend::SurfaceId, frontend::BufferStreamId> legacy_default_stream_map;
+    std::map<frontend::SurfaceId, std::shared_ptr<InputRingEventSink>> input_ring_sinks;
 };
 
 }
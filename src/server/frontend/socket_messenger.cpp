@@ -26,23 +26,43 @@
 
 #include <errno.h>
 #include <string.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
 
+#include <algorithm>
 #include <stdexcept>
+#include <system_error>
 
 namespace mf = mir::frontend;
 namespace mfd = mf::detail;
 namespace bs = boost::system;
 namespace ba = boost::asio;
 
+namespace
+{
+size_t const header_size{2};
+
+/// The byte each set of fds is attached to. The client reads them together.
+char const fd_marker{'M'};
+
+/// Enough fds to send without allocating, as in mir::send_fds()
+size_t const builtin_n_fds{5};
+
+/// Enough for a backlog of small messages to go in one call
+size_t const max_iov{64};
+}
+
+size_t const mfd::SocketMessenger::max_queued_bytes{4 * 1024 * 1024};
+size_t const mfd::SocketMessenger::max_queued_fds{256};
+
 mfd::SocketMessenger::SocketMessenger(std::shared_ptr<ba::local::stream_protocol::socket> const& socket)
     : socket(socket),
       socket_fd{IntOwnedFd{socket->native_handle()}}
 {
     // Make the socket non-blocking to avoid hanging the server when a client
     // is unresponsive. Also increase the send buffer size to 64KiB to allow
-    // more leeway for transient client freezes.
+    // more leeway for transient client freezes before messages are queued.
     // See https://bugs.launchpad.net/mir/+bug/1350207
-    // TODO: Rework the messenger to support asynchronous sends
     socket->non_blocking(true);
     boost::asio::socket_base::send_buffer_size option(64*1024);
     socket->set_option(option);
@@ -73,24 +93,190 @@ mf::SessionCredentials mfd::SocketMessenger::client_creds()
 
 void mfd::SocketMessenger::send(char const* data, size_t length, FdSets const& fd_set)
 {
-    static size_t const header_size{2};
-    mir::VariableLengthArray<mf::serialization_buffer_size> whole_message{header_size + length};
+    unsigned char const header[header_size]{
+        static_cast<unsigned char>((length >> 8) & 0xff),
+        static_cast<unsigned char>((length >> 0) & 0xff)};
+
+    iovec const message[]{
+        {const_cast<unsigned char*>(header), header_size},
+        {const_cast<char*>(data), length}};
+    iovec const marker{const_cast<char*>(&fd_marker), 1};
 
-    whole_message.data()[0] = static_cast<unsigned char>((length >> 8) & 0xff);
-    whole_message.data()[1] = static_cast<unsigned char>((length >> 0) & 0xff);
-    std::copy(data, data + length, whole_message.data() + header_size);
+    std::lock_guard<std::mutex> lock{message_lock};
 
-    std::unique_lock<std::mutex> lg(message_lock);
+    if (disconnected)
+        return;
 
-    // TODO: This should be asynchronous, but we are not making sure
-    // that a potential call to send_fds is executed _after_ this
-    // function has completed (if it would be executed asynchronously.
-    // NOTE: we rely on this synchronous behavior as per the comment in
-    // mf::SessionMediator::create_surface
-    ba::write(*socket, ba::buffer(whole_message.data(), whole_message.size()));
+    // Anything already queued has to go first, to keep messages (and fds) in order
+    auto const sent = outbound.empty() ? send_some(message, 2, {}) : 0;
+    if (sent < header_size + length)
+        enqueue(message, 2, sent, {});
 
     for (auto const& fds : fd_set)
-        mir::send_fds(socket_fd, fds);
+    {
+        if (fds.empty())
+            continue;
+
+        if (!outbound.empty() || !send_some(&marker, 1, fds))
+            enqueue(&marker, 1, 0, fds);
+    }
+
+    if (queued_bytes > max_queued_bytes || queued_fds > max_queued_fds)
+        disconnect();
+    else if (!outbound.empty())
+        flush_when_writable();
+}
+
+size_t mfd::SocketMessenger::send_some(iovec const* iov, size_t iov_count, std::vector<Fd> const& fds)
+{
+    msghdr header{};
+    header.msg_iov = const_cast<iovec*>(iov);
+    header.msg_iovlen = iov_count;
+
+    auto const fds_bytes = fds.size() * sizeof(int);
+    mir::VariableLengthArray<CMSG_SPACE(builtin_n_fds * sizeof(int))> control{fds.empty() ? 0 : CMSG_SPACE(fds_bytes)};
+
+    if (!fds.empty())
+    {
+        // Silence valgrind uninitialized memory complaint
+        memset(control.data(), 0, control.size());
+        header.msg_control = control.data();
+        header.msg_controllen = control.size();
+
+        auto const message = CMSG_FIRSTHDR(&header);
+        message->cmsg_len = CMSG_LEN(fds_bytes);
+        message->cmsg_level = SOL_SOCKET;
+        message->cmsg_type = SCM_RIGHTS;
+
+        auto fd_data = reinterpret_cast<int*>(CMSG_DATA(message));
+        for (auto const& fd : fds)
+            *fd_data++ = fd;
+    }
+
+    for (;;)
+    {
+        auto const sent = sendmsg(socket_fd, &header, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (sent >= 0)
+            return sent;
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+            return 0;
+        if (errno != EINTR)
+            BOOST_THROW_EXCEPTION(std::system_error(errno, std::system_category(), "Failed to send message to client"));
+    }
+}
+
+void mfd::SocketMessenger::enqueue(iovec const* iov, size_t iov_count, size_t skip, std::vector<Fd> const& fds)
+{
+    Pending pending{{}, fds, 0};
+
+    for (auto i = 0u; i != iov_count; ++i)
+    {
+        auto const begin = static_cast<char const*>(iov[i].iov_base);
+        auto const skipped = std::min(skip, iov[i].iov_len);
+        pending.data.insert(pending.data.end(), begin + skipped, begin + iov[i].iov_len);
+        skip -= skipped;
+    }
+
+    queued_bytes += pending.data.size();
+    queued_fds += pending.fds.size();
+    outbound.push_back(std::move(pending));
+}
+
+void mfd::SocketMessenger::flush()
+{
+    while (!outbound.empty())
+    {
+        // Gather as much as will go in one call. Fds go on their own, with their marker.
+        iovec iov[max_iov];
+        size_t iov_count{0};
+        size_t bytes{0};
+
+        for (auto pending = outbound.begin(); pending != outbound.end() && iov_count != max_iov; ++pending)
+        {
+            if (!pending->fds.empty() && iov_count)
+                break;
+
+            iov[iov_count++] = {pending->data.data() + pending->sent, pending->data.size() - pending->sent};
+            bytes += pending->data.size() - pending->sent;
+
+            if (!pending->fds.empty())
+                break;
+        }
+
+        auto sent = send_some(iov, iov_count, outbound.front().fds);
+        auto const everything_sent = sent == bytes;
+
+        queued_bytes -= sent;
+        while (sent)
+        {
+            auto& front = outbound.front();
+            auto const taken = std::min(sent, front.data.size() - front.sent);
+            front.sent += taken;
+            sent -= taken;
+
+            if (front.sent == front.data.size())
+            {
+                queued_fds -= front.fds.size();
+                outbound.pop_front();
+            }
+        }
+
+        if (!everything_sent)
+            return;
+    }
+}
+
+void mfd::SocketMessenger::flush_when_writable()
+{
+    if (flush_pending)
+        return;
+
+    flush_pending = true;
+
+    std::weak_ptr<SocketMessenger> const weak_self{shared_from_this()};
+    socket->async_write_some(
+        ba::null_buffers(),
+        [weak_self](bs::error_code const& error, size_t)
+        {
+            auto const self = weak_self.lock();
+            if (!self)
+                return;
+
+            std::lock_guard<std::mutex> lock{self->message_lock};
+            self->flush_pending = false;
+
+            if (self->disconnected)
+                return;
+
+            try
+            {
+                if (error)
+                    BOOST_THROW_EXCEPTION(bs::system_error(error));
+
+                self->flush();
+            }
+            catch (std::exception const&)
+            {
+                // The client has gone, so nothing queued can reach it
+                self->disconnect();
+                return;
+            }
+
+            if (!self->outbound.empty())
+                self->flush_when_writable();
+        });
+}
+
+void mfd::SocketMessenger::disconnect()
+{
+    outbound.clear();
+    queued_bytes = 0;
+    queued_fds = 0;
+    disconnected = true;
+
+    // Our pending read then fails, which tears down the connection
+    bs::error_code ignored;
+    socket->shutdown(ba::local::stream_protocol::socket::shutdown_both, ignored);
 }
 
 void mfd::SocketMessenger::async_receive_msg(
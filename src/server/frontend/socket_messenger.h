@@ -21,7 +21,13 @@
 #include "message_sender.h"
 #include "message_receiver.h"
 #include "mir/frontend/session_credentials.h"
+
+#include <deque>
+#include <memory>
 #include <mutex>
+#include <vector>
+
+struct iovec;
 
 namespace mir
 {
@@ -29,12 +35,21 @@ namespace frontend
 {
 namespace detail
 {
+/**
+ * Sends without ever blocking: whatever the socket won't take yet is queued,
+ * in order, and written as the client reads. A client that lets more than
+ * max_queued_bytes (or max_queued_fds) pile up is disconnected.
+ */
 class SocketMessenger : public MessageSender,
-                        public MessageReceiver
+                        public MessageReceiver,
+                        public std::enable_shared_from_this<SocketMessenger>
 {
 public:
     SocketMessenger(std::shared_ptr<boost::asio::local::stream_protocol::socket> const& socket);
 
+    static size_t const max_queued_bytes;
+    static size_t const max_queued_fds;
+
     void send(char const* data, size_t length, FdSets const& fds) override;
 
     void async_receive_msg(MirReadHandler const& handler, boost::asio::mutable_buffers_1 const& buffer) override;
@@ -44,6 +59,21 @@ public:
     void receive_fds(std::vector<Fd>& fds) override;
 
 private:
+    /// Part of a message that the socket hasn't taken yet
+    struct Pending
+    {
+        std::vector<char> data;
+        std::vector<Fd> fds;
+        size_t sent;
+    };
+
+    /// Returns the number of bytes sent, which is zero if the socket is full
+    size_t send_some(iovec const* iov, size_t iov_count, std::vector<Fd> const& fds);
+    void enqueue(iovec const* iov, size_t iov_count, size_t skip, std::vector<Fd> const& fds);
+    void flush();
+    void flush_when_writable();
+    void disconnect();
+
     void set_passcred(int opt);
     void update_session_creds();
     SessionCredentials creator_creds() const;
@@ -52,6 +82,12 @@ private:
     mir::Fd socket_fd;
 
     std::mutex message_lock;
+    std::deque<Pending> outbound;
+    size_t queued_bytes{0};
+    size_t queued_fds{0};
+    bool flush_pending{false};
+    bool disconnected{false};
+
     SessionCredentials session_creds{0, 0, 0};
 };
 }
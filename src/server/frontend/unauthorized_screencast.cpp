@@ -45,7 +45,8 @@ std::shared_ptr<mir::graphics::Buffer> mf::UnauthorizedScreencast::capture(
         std::runtime_error("Process is not authorized to capture screencasts"));
 }
 
-void mf::UnauthorizedScreencast::capture(mf::ScreencastSessionId, std::shared_ptr<mir::graphics::Buffer> const&)
+auto mf::UnauthorizedScreencast::capture(mf::ScreencastSessionId, std::shared_ptr<mir::graphics::Buffer> const&)
+    -> ScreencastFrame
 {
     BOOST_THROW_EXCEPTION(
         std::runtime_error("Process is not authorized to capture screencasts"));
@@ -105,10 +105,12 @@ public:
     WlCompositor(
         struct wl_display* display,
         std::shared_ptr<mir::Executor> const& executor,
-        std::shared_ptr<mg::GraphicBufferAllocator> const& allocator)
+        std::shared_ptr<mg::GraphicBufferAllocator> const& allocator,
+        std::shared_ptr<mc::FrameClock> const& frame_clock)
         : Global(display, Version<4>()),
           allocator{allocator},
-          executor{executor}
+          executor{executor},
+          frame_clock{frame_clock}
     {
     }
 
@@ -117,6 +119,7 @@ public:
 private:
     std::shared_ptr<mg::GraphicBufferAllocator> const allocator;
     std::shared_ptr<mir::Executor> const executor;
+    std::shared_ptr<mc::FrameClock> const frame_clock;
     std::map<std::pair<wl_client*, uint32_t>, std::vector<std::function<void(WlSurface*)>>> surface_callbacks;
 
     class Instance : wayland::Compositor
@@ -156,7 +159,7 @@ void WlCompositor::on_surface_created(wl_client* client, uint32_t id, std::funct
 
 void WlCompositor::Instance::create_surface(wl_resource* new_surface)
 {
-    auto const surface = new WlSurface{new_surface, compositor->executor, compositor->allocator};
+    auto const surface = new WlSurface{new_surface, compositor->executor, compositor->allocator, compositor->frame_clock};
     auto const key = std::make_pair(wl_resource_get_client(new_surface), wl_resource_get_id(new_surface));
     auto const callbacks = compositor->surface_callbacks.find(key);
     if (callbacks != compositor->surface_callbacks.end())
@@ -489,7 +492,9 @@ mf::WaylandConnector::WaylandConnector(
     std::shared_ptr<MirDisplay> const& display_config,
     std::shared_ptr<mi::InputDeviceHub> const& input_hub,
     std::shared_ptr<mi::Seat> const& seat,
+    std::shared_ptr<mi::InputLatencies> const& input_latencies,
     std::shared_ptr<mg::GraphicBufferAllocator> const& allocator,
+    std::shared_ptr<mc::FrameClock> const& frame_clock,
     std::shared_ptr<mf::SessionAuthorizer> const& session_authorizer,
     std::shared_ptr<SurfaceStack> const& surface_stack,
     std::shared_ptr<ms::Clipboard> const& clipboard,
@@ -542,9 +547,10 @@ mf::WaylandConnector::WaylandConnector(
     compositor_global = std::make_unique<mf::WlCompositor>(
         display.get(),
         executor,
-        this->allocator);
+        this->allocator,
+        frame_clock);
     subcompositor_global = std::make_unique<mf::WlSubcompositor>(display.get());
-    seat_global = std::make_unique<mf::WlSeat>(display.get(), input_hub, seat);
+    seat_global = std::make_unique<mf::WlSeat>(display.get(), input_hub, seat, input_latencies);
     output_manager = std::make_unique<mf::OutputManager>(
         display.get(),
         display_config,
@@ -37,11 +37,16 @@ namespace input
 {
 class InputDeviceHub;
 class Seat;
+class InputLatencies;
 }
 namespace graphics
 {
 class GraphicBufferAllocator;
 }
+namespace compositor
+{
+class FrameClock;
+}
 namespace geometry
 {
 struct Size;
@@ -112,7 +117,9 @@ public:
         std::shared_ptr<MirDisplay> const& display_config,
         std::shared_ptr<input::InputDeviceHub> const& input_hub,
         std::shared_ptr<input::Seat> const& seat,
+        std::shared_ptr<input::InputLatencies> const& input_latencies,
         std::shared_ptr<graphics::GraphicBufferAllocator> const& allocator,
+        std::shared_ptr<compositor::FrameClock> const& frame_clock,
         std::shared_ptr<SessionAuthorizer> const& session_authorizer,
         std::shared_ptr<SurfaceStack> const& surface_stack,
         std::shared_ptr<scene::Clipboard> const& clipboard,
@@ -252,7 +252,9 @@ std::shared_ptr<mf::Connector>
                 display_config,
                 the_input_device_hub(),
                 the_seat(),
+                the_input_latencies(),
                 the_buffer_allocator(),
+                the_frame_clock(),
                 the_session_authorizer(),
                 the_frontend_surface_stack(),
                 the_clipboard(),
@@ -20,13 +20,14 @@
 
 #include "mir/fd.h"
 #include "mir/log.h"
+#include "mir/thread/mpsc_queue.h"
 
 #include <sys/eventfd.h>
 
 #include <boost/throw_exception.hpp>
 
+#include <atomic>
 #include <cstring>
-#include <deque>
 #include <functional>
 #include <mutex>
 #include <system_error>
@@ -44,6 +45,10 @@ namespace mf = mir::frontend;
  * wl_event_source and the WaylandExecutor. WaylandExecutor can then always
  * enqueue new work, even if no more work is going to be processed, and the work
  * processing function always has a reference to the workqueue state.
+ *
+ * Work is enqueued from compositor, input and IPC threads, so the workqueue
+ * itself is lock-free. Only termination, which needs to jump the queue, takes
+ * the mutex.
  */
 
 class mf::WaylandExecutor::State
@@ -74,34 +79,43 @@ public:
             return;
         }
 
-        std::lock_guard<std::mutex> lock{mutex};
-        if (state == ExecutionState::Running)
+        if (state.load(std::memory_order_acquire) == ExecutionState::Running)
         {
-            workqueue.emplace_back(std::move(work));
+            workqueue.push(std::move(work));
         }
         // If we've been terminated then drop the work on the floor, letting the
-        // std::function destructor clean up any necessary state.
+        // std::function destructor clean up any necessary state. Work that races
+        // with termination is dropped when the queue is drained.
     }
 
     void enqueue_termination(std::function<void()>&& terminator)
     {
         std::lock_guard<std::mutex> lock{mutex};
-        if (state == ExecutionState::Running)
+        if (state.load(std::memory_order_relaxed) == ExecutionState::Running)
         {
-            workqueue.emplace_front(std::move(terminator));
+            this->terminator = std::move(terminator);
             on_wayland_thread = false;
-            state = ExecutionState::TerminationRequested;
+            state.store(ExecutionState::TerminationRequested, std::memory_order_release);
         }
     }
 
     std::function<void()> get_work()
     {
-        std::lock_guard<std::mutex> lock{mutex};
-        if (!workqueue.empty())
+        // A termination request jumps the queue
+        if (state.load(std::memory_order_acquire) == ExecutionState::TerminationRequested)
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            if (terminator)
+            {
+                auto work = std::move(terminator);
+                terminator = nullptr;
+                return work;
+            }
+        }
+
+        if (auto work = workqueue.pop())
         {
-            auto const work = std::move(workqueue.front());
-            workqueue.pop_front();
-            return work;
+            return std::move(work.value());
         }
         return {};
     }
@@ -110,22 +124,22 @@ public:
     {
         std::unique_lock<std::mutex> lock{mutex};
 
-        if (state == ExecutionState::TerminationRequested)
+        if (terminator)
         {
-            // If we've been asked to terminate then the front of the workqueue
-            // will contain the termination request.
-            {
-                std::function<void()> const work = std::move(workqueue.front());
-                lock.unlock();
+            std::function<void()> const work = std::move(terminator);
+            terminator = nullptr;
+            lock.unlock();
+
+            work();
 
-                work();
-            }
             lock.lock();
         }
 
         on_wayland_thread = false;
-        state = ExecutionState::Stopped;
-        workqueue.clear();
+        state.store(ExecutionState::Stopped, std::memory_order_release);
+        while (workqueue.pop())
+        {
+        }
 
         return lock;
     }
@@ -134,9 +148,11 @@ public:
 private:
     static thread_local bool on_wayland_thread;
     std::mutex mutex;
-    ExecutionState state{ExecutionState::Running};
+    std::atomic<ExecutionState> state{ExecutionState::Running};
     wl_event_loop* const loop;
-    std::deque<std::function<void()>> workqueue;
+    std::function<void()> terminator; ///< Guarded by mutex
+    /// Pushed to from any thread, popped from only on the Wayland thread
+    mir::thread::MpscQueue<std::function<void()>> workqueue;
 };
 
 thread_local bool mf::WaylandExecutor::State::on_wayland_thread{false};
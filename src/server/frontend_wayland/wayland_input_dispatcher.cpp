@@ -118,4 +118,6 @@ void mf::WaylandInputDispatcher::handle_event(MirInputEvent const* event)
     default:
         break;
     }
+
+    seat->event_sent(event);
 }
@@ -33,6 +33,7 @@
 #include "mir/input/seat.h"
 #include "mir/input/device.h"
 #include "mir/input/keymap.h"
+#include "mir/input/input_latencies.h"
 #include "mir/input/mir_keyboard_config.h"
 
 #include <mutex>
@@ -151,7 +152,8 @@ private:
 mf::WlSeat::WlSeat(
     wl_display* display,
     std::shared_ptr<mi::InputDeviceHub> const& input_hub,
-    std::shared_ptr<mi::Seat> const& seat)
+    std::shared_ptr<mi::Seat> const& seat,
+    std::shared_ptr<mi::InputLatencies> const& input_latencies)
     :   Global(display, Version<6>()),
         keymap{std::make_unique<input::Keymap>()},
         config_observer{
@@ -165,7 +167,8 @@ mf::WlSeat::WlSeat(
         keyboard_listeners{std::make_shared<ListenerList<WlKeyboard>>()},
         touch_listeners{std::make_shared<ListenerList<WlTouch>>()},
         input_hub{input_hub},
-        seat{seat}
+        seat{seat},
+        input_latencies{input_latencies}
 {
     input_hub->add_observer(config_observer);
     add_focus_listener(&focus);
@@ -196,6 +199,11 @@ void mf::WlSeat::for_each_listener(wl_client* client, std::function<void(WlTouch
     touch_listeners->for_each(client, func);
 }
 
+void mf::WlSeat::event_sent(MirInputEvent const* event)
+{
+    input_latencies->record(event, mi::InputLatencies::Stage::sent);
+}
+
 void mf::WlSeat::notify_focus(wl_client *focus)
 {
     if (focus != focused_client)
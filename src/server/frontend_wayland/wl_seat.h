@@ -41,6 +41,7 @@ namespace input
 class InputDeviceHub;
 class Seat;
 class Keymap;
+class InputLatencies;
 }
 namespace frontend
 {
@@ -54,7 +55,8 @@ public:
     WlSeat(
         wl_display* display,
         std::shared_ptr<mir::input::InputDeviceHub> const& input_hub,
-        std::shared_ptr<mir::input::Seat> const& seat);
+        std::shared_ptr<mir::input::Seat> const& seat,
+        std::shared_ptr<mir::input::InputLatencies> const& input_latencies);
 
     ~WlSeat();
 
@@ -64,6 +66,9 @@ public:
     void for_each_listener(wl_client* client, std::function<void(WlKeyboard*)> func);
     void for_each_listener(wl_client* client, std::function<void(WlTouch*)> func);
 
+    /// Records how long the event took to be sent to a client
+    void event_sent(MirInputEvent const* event);
+
     class ListenerTracker
     {
     public:
@@ -112,6 +117,7 @@ private:
 
     std::shared_ptr<input::InputDeviceHub> const input_hub;
     std::shared_ptr<input::Seat> const seat;
+    std::shared_ptr<input::InputLatencies> const input_latencies;
 
     void bind(wl_resource* new_wl_seat) override;
 };
@@ -32,6 +32,8 @@
 #include "mir/scene/session.h"
 #include "mir/frontend/wayland.h"
 #include "mir/compositor/buffer_stream.h"
+#include "mir/compositor/frame_clock.h"
+#include "mir/scene/surface.h"
 #include "mir/executor.h"
 #include "mir/graphics/graphic_buffer_allocator.h"
 #include "mir/shell/surface_specification.h"
@@ -46,6 +48,25 @@ namespace geom = mir::geometry;
 namespace mw = mir::wayland;
 namespace msh = mir::shell;
 
+namespace
+{
+void send_frame_callbacks(
+    std::vector<std::shared_ptr<mf::WlSurfaceState::Callback>> const& callbacks,
+    std::chrono::steady_clock::time_point presented)
+{
+    auto const timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(presented.time_since_epoch());
+
+    for (auto const& frame : callbacks)
+    {
+        if (!*frame->destroyed)
+        {
+            frame->send_done_event(timestamp.count());
+            frame->destroy_wayland_object();
+        }
+    }
+}
+}
+
 mf::WlSurfaceState::Callback::Callback(wl_resource* new_resource)
     : mw::Callback{new_resource, Version<1>()},
       destroyed{deleted_flag_for_resource(resource)}
@@ -66,10 +87,16 @@ void mf::WlSurfaceState::update_from(WlSurfaceState const& source)
     if (source.input_shape)
         input_shape = source.input_shape;
 
+    if (source.opaque_region)
+        opaque_region = source.opaque_region;
+
     frame_callbacks.insert(end(frame_callbacks),
                            begin(source.frame_callbacks),
                            end(source.frame_callbacks));
 
+    surface_damage.insert(end(surface_damage), begin(source.surface_damage), end(source.surface_damage));
+    buffer_damage.insert(end(buffer_damage), begin(source.buffer_damage), end(source.buffer_damage));
+
     if (source.surface_data_invalidated)
         surface_data_invalidated = true;
 }
@@ -84,12 +111,14 @@ bool mf::WlSurfaceState::surface_data_needs_refresh() const
 mf::WlSurface::WlSurface(
     wl_resource* new_resource,
     std::shared_ptr<Executor> const& executor,
-    std::shared_ptr<graphics::GraphicBufferAllocator> const& allocator)
+    std::shared_ptr<graphics::GraphicBufferAllocator> const& allocator,
+    std::shared_ptr<compositor::FrameClock> const& frame_clock)
     : Surface(new_resource, Version<4>()),
         session{get_session(client)},
         stream{session->create_buffer_stream({{}, mir_pixel_format_invalid, graphics::BufferUsage::undefined})},
         allocator{allocator},
         executor{executor},
+        frame_clock{frame_clock},
         null_role{this},
         role{&null_role}
 {
@@ -222,18 +251,30 @@ mf::WlSurface* mf::WlSurface::from(wl_resource* resource)
     return static_cast<WlSurface*>(static_cast<wayland::Surface*>(raw_surface));
 }
 
-void mf::WlSurface::send_frame_callbacks()
+void mf::WlSurface::request_frame_callbacks()
 {
-    for (auto const& frame : frame_callbacks)
-    {
-        if (!*frame->destroyed)
+    if (frame_callbacks.empty())
+        return;
+
+    // A surface that isn't on screen (yet) has no area, and gets its callbacks straight away
+    geom::Rectangle area;
+    auto const surface = scene_surface();
+    if (surface && surface.value() && buffer_size_)
+        area = {surface.value()->top_left() + total_offset(), buffer_size_.value()};
+
+    // Only the callbacks committed so far are due after the next frame; later ones make their own request
+    decltype(frame_callbacks) due;
+    due.swap(frame_callbacks);
+
+    frame_clock->on_next_frame(
+        area,
+        [executor = executor, due = std::move(due)](auto presented) mutable
         {
-            // TODO: argument should be a timestamp
-            frame->send_done_event(0);
-            frame->destroy_wayland_object();
-        }
-    }
-    frame_callbacks.clear();
+            executor->spawn([due = std::move(due), presented]()
+                {
+                    send_frame_callbacks(due, presented);
+                });
+        });
 }
 
 void mf::WlSurface::destroy()
@@ -253,20 +294,12 @@ void mf::WlSurface::attach(std::experimental::optional<wl_resource*> const& buff
 
 void mf::WlSurface::damage(int32_t x, int32_t y, int32_t width, int32_t height)
 {
-    (void)x;
-    (void)y;
-    (void)width;
-    (void)height;
-    // This isn't essential, but could enable optimizations
+    pending.surface_damage.push_back({{x, y}, {width, height}});
 }
 
 void mf::WlSurface::damage_buffer(int32_t x, int32_t y, int32_t width, int32_t height)
 {
-    (void)x;
-    (void)y;
-    (void)width;
-    (void)height;
-    // This isn't essential, but could enable optimizations
+    pending.buffer_damage.push_back({{x, y}, {width, height}});
 }
 
 void mf::WlSurface::frame(wl_resource* new_callback)
@@ -276,8 +309,11 @@ void mf::WlSurface::frame(wl_resource* new_callback)
 
 void mf::WlSurface::set_opaque_region(std::experimental::optional<wl_resource*> const& region)
 {
-    (void)region;
-    // This isn't essential, but could enable optimizations
+    // This isn't essential, but lets the compositor skip blending and drawing what is hidden behind the surface
+    if (region)
+        pending.opaque_region = WlRegion::from(region.value())->rectangle_vector();
+    else
+        pending.opaque_region = std::vector<geom::Rectangle>{};
 }
 
 void mf::WlSurface::set_input_region(std::experimental::optional<wl_resource*> const& region)
@@ -338,8 +374,15 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
     if (state.input_shape)
         input_shape = state.input_shape.value();
 
+    // Applied before any new buffer is submitted, so the compositor doesn't see the buffer with a stale region
+    if (state.opaque_region)
+        stream->set_opaque_region(state.opaque_region.value());
+
     if (state.scale)
+    {
+        buffer_scale = state.scale.value();
         stream->set_scale(state.scale.value());
+    }
 
     if (state.buffer)
     {
@@ -349,22 +392,14 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
         {
             // TODO: unmap surface, and unmap all subsurfaces
             buffer_size_ = std::experimental::nullopt;
-            send_frame_callbacks();
+            previous_shm_buffer.reset();
+            send_frame_callbacks(frame_callbacks, std::chrono::steady_clock::now());
+            frame_callbacks.clear();
         }
         else
         {
-            auto const executor_send_frame_callbacks = [executor = executor, weak_self = mw::make_weak(this)]()
-                {
-                    executor->spawn([weak_self]()
-                        {
-                            if (weak_self)
-                            {
-                                weak_self.value().send_frame_callbacks();
-                            }
-                        });
-                };
-
             std::shared_ptr<graphics::Buffer> mir_buffer;
+            std::experimental::optional<std::vector<geom::Rectangle>> damage;
 
             if (auto const shm_buffer = wl_shm_buffer_get(buffer))
             {
@@ -382,10 +417,15 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
                     BOOST_THROW_EXCEPTION((
                                               std::runtime_error{"Buffer has invalid stride"}));
                 }
+                // Damage is relative to the previous buffer, which lets the new one update its texture in place
+                damage = damage_in_buffer_coordinates(state, {width, wl_shm_buffer_get_height(shm_buffer)});
                 mir_buffer = allocator->buffer_from_shm(
                     buffer,
                     executor,
-                    std::move(executor_send_frame_callbacks));
+                    []{},
+                    previous_shm_buffer.lock(),
+                    damage);
+                previous_shm_buffer = mir_buffer;
                 tracepoint(
                     mir_server_wayland,
                     sw_buffer_committed,
@@ -405,8 +445,10 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
 
                 mir_buffer = allocator->buffer_from_resource(
                     buffer,
-                    std::move(executor_send_frame_callbacks),
+                    []{},
                     std::move(release_buffer));
+                damage = damage_in_buffer_coordinates(state, mir_buffer->size());
+                previous_shm_buffer.reset();
                 tracepoint(
                     mir_server_wayland,
                     hw_buffer_committed,
@@ -414,7 +456,14 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
                     mir_buffer->id().as_value());
             }
 
-            stream->submit_buffer(mir_buffer);
+            if (damage)
+            {
+                stream->submit_buffer(mir_buffer, damage.value());
+            }
+            else
+            {
+                stream->submit_buffer(mir_buffer);
+            }
             auto const new_buffer_size = stream->stream_size();
 
             if (!input_shape && std::experimental::make_optional(new_buffer_size) != buffer_size_)
@@ -425,10 +474,9 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
             buffer_size_ = new_buffer_size;
         }
     }
-    else
-    {
-        send_frame_callbacks();
-    }
+
+    // Frame callbacks are paced by the output the surface is shown on, not by its buffers being consumed
+    request_frame_callbacks();
 
     for (WlSubsurface* child: children)
     {
@@ -436,6 +484,50 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
     }
 }
 
+auto mf::WlSurface::damage_in_buffer_coordinates(WlSurfaceState const& state, geom::Size const& buffer_size) const
+    -> std::experimental::optional<std::vector<geom::Rectangle>>
+{
+    // Clients that don't report damage get the whole buffer treated as damaged. (The protocol would permit us to
+    // assume nothing has changed, but not all clients are careful to damage their surfaces.)
+    if (state.surface_damage.empty() && state.buffer_damage.empty())
+        return std::experimental::nullopt;
+
+    std::vector<geom::Rectangle> damage;
+    damage.reserve(state.surface_damage.size() + state.buffer_damage.size());
+
+    // Clients commonly damage INT32_MAX sized areas, so clip to the buffer using 64 bit arithmetic
+    auto const add_clipped = [&](int64_t x, int64_t y, int64_t width, int64_t height)
+        {
+            auto const left = std::max<int64_t>(x, 0);
+            auto const top = std::max<int64_t>(y, 0);
+            auto const right = std::min<int64_t>(x + width, buffer_size.width.as_int());
+            auto const bottom = std::min<int64_t>(y + height, buffer_size.height.as_int());
+
+            if (left < right && top < bottom)
+                damage.push_back({{left, top}, {right - left, bottom - top}});
+        };
+
+    for (auto const& rect : state.surface_damage)
+    {
+        add_clipped(
+            int64_t{rect.top_left.x.as_int()} * buffer_scale,
+            int64_t{rect.top_left.y.as_int()} * buffer_scale,
+            int64_t{rect.size.width.as_int()} * buffer_scale,
+            int64_t{rect.size.height.as_int()} * buffer_scale);
+    }
+
+    for (auto const& rect : state.buffer_damage)
+    {
+        add_clipped(
+            rect.top_left.x.as_int(),
+            rect.top_left.y.as_int(),
+            rect.size.width.as_int(),
+            rect.size.height.as_int());
+    }
+
+    return damage;
+}
+
 void mf::WlSurface::commit()
 {
     if (pending.offset && *pending.offset == offset_)
@@ -26,7 +26,9 @@
 #include "mir/geometry/displacement.h"
 #include "mir/geometry/size.h"
 #include "mir/geometry/point.h"
+#include "mir/geometry/rectangle.h"
 
+#include <chrono>
 #include <vector>
 #include <map>
 
@@ -37,6 +39,7 @@ class Executor;
 namespace graphics
 {
 class GraphicBufferAllocator;
+class Buffer;
 }
 namespace scene
 {
@@ -53,6 +56,7 @@ class Rectangle;
 namespace compositor
 {
 class BufferStream;
+class FrameClock;
 }
 namespace frontend
 {
@@ -83,7 +87,12 @@ struct WlSurfaceState
     std::experimental::optional<int> scale;
     std::experimental::optional<geometry::Displacement> offset;
     std::experimental::optional<std::experimental::optional<std::vector<geometry::Rectangle>>> input_shape;
+    // an empty opaque region (which is what a null region means) promises nothing
+    std::experimental::optional<std::vector<geometry::Rectangle>> opaque_region;
     std::vector<std::shared_ptr<Callback>> frame_callbacks;
+    // damage is accumulated in surface (wl_surface.damage) and buffer (wl_surface.damage_buffer) coordinates
+    std::vector<geometry::Rectangle> surface_damage;
+    std::vector<geometry::Rectangle> buffer_damage;
 
 private:
     // only set to true if invalidate_surface_data() is called
@@ -111,7 +120,8 @@ class WlSurface : public wayland::Surface
 public:
     WlSurface(wl_resource* new_resource,
               std::shared_ptr<mir::Executor> const& executor,
-              std::shared_ptr<graphics::GraphicBufferAllocator> const& allocator);
+              std::shared_ptr<graphics::GraphicBufferAllocator> const& allocator,
+              std::shared_ptr<compositor::FrameClock> const& frame_clock);
 
     ~WlSurface();
 
@@ -143,6 +153,7 @@ public:
 private:
     std::shared_ptr<mir::graphics::GraphicBufferAllocator> const allocator;
     std::shared_ptr<mir::Executor> const executor;
+    std::shared_ptr<compositor::FrameClock> const frame_clock;
 
     NullWlSurfaceRole null_role;
     WlSurfaceRole* role;
@@ -153,8 +164,14 @@ private:
     std::experimental::optional<geometry::Size> buffer_size_;
     std::vector<std::shared_ptr<WlSurfaceState::Callback>> frame_callbacks;
     std::experimental::optional<std::vector<mir::geometry::Rectangle>> input_shape;
-
-    void send_frame_callbacks();
+    int buffer_scale{1};
+    /// Not owned, so as not to delay the release of the client's buffer
+    std::weak_ptr<graphics::Buffer> previous_shm_buffer;
+
+    /// Asks the frame clock to send the callbacks in frame_callbacks after the next frame this surface could be in
+    void request_frame_callbacks();
+    auto damage_in_buffer_coordinates(WlSurfaceState const& state, geometry::Size const& buffer_size) const
+        -> std::experimental::optional<std::vector<geometry::Rectangle>>;
 
     void destroy() override;
     void attach(std::experimental::optional<wl_resource*> const& buffer, int32_t x, int32_t y) override;
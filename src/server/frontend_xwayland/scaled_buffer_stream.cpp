@@ -19,6 +19,9 @@
 #include "scaled_buffer_stream.h"
 #include "mir/log.h"
 
+#include <algorithm>
+#include <cmath>
+
 namespace mf = mir::frontend;
 
 mf::ScaledBufferStream::ScaledBufferStream(std::shared_ptr<compositor::BufferStream>&& inner, float scale)
@@ -59,6 +62,41 @@ void mf::ScaledBufferStream::set_scale(float scale)
     inner->set_scale(scale);
 }
 
+void mf::ScaledBufferStream::submit_buffer(
+    std::shared_ptr<graphics::Buffer> const& buffer,
+    std::vector<geometry::Rectangle> const& damage)
+{
+    // Damage is in buffer coordinates, so is unaffected by our scale
+    inner->submit_buffer(buffer, damage);
+}
+
+auto mf::ScaledBufferStream::damage_between(graphics::BufferID previous, graphics::BufferID current) const
+    -> std::experimental::optional<std::vector<geometry::Rectangle>>
+{
+    return inner->damage_between(previous, current);
+}
+
+void mf::ScaledBufferStream::set_opaque_region(std::vector<geometry::Rectangle> const& region)
+{
+    inner->set_opaque_region(region);
+}
+
+auto mf::ScaledBufferStream::opaque_region() const -> std::vector<geometry::Rectangle>
+{
+    // Like the size, the opaque region is in our scaled coordinates. Round inwards, so partly covered pixels
+    // aren't claimed to be opaque.
+    auto region = inner->opaque_region();
+    for (auto& rect : region)
+    {
+        int const left = std::ceil(rect.left().as_int() * inv_scale);
+        int const top = std::ceil(rect.top().as_int() * inv_scale);
+        int const right = std::floor(rect.right().as_int() * inv_scale);
+        int const bottom = std::floor(rect.bottom().as_int() * inv_scale);
+        rect = {{left, top}, {std::max(right - left, 0), std::max(bottom - top, 0)}};
+    }
+    return region;
+}
+
 auto mf::ScaledBufferStream::lock_compositor_buffer(void const* user_id) -> std::shared_ptr<graphics::Buffer>
 {
     return inner->lock_compositor_buffer(user_id);
@@ -47,6 +47,13 @@ public:
 
     /// Overrides from compositor::BufferStream
     /// @{
+    void submit_buffer(
+        std::shared_ptr<graphics::Buffer> const& buffer,
+        std::vector<geometry::Rectangle> const& damage);
+    auto damage_between(graphics::BufferID previous, graphics::BufferID current) const
+        -> std::experimental::optional<std::vector<geometry::Rectangle>>;
+    void set_opaque_region(std::vector<geometry::Rectangle> const& region);
+    auto opaque_region() const -> std::vector<geometry::Rectangle>;
     auto lock_compositor_buffer(void const* user_id) -> std::shared_ptr<graphics::Buffer>;
     auto stream_size() -> geometry::Size;
     auto buffers_ready_for_compositor(void const* user_id) const -> int;
@@ -292,6 +292,27 @@ auto mf::XCBConnection::read_property(
     uint32_t max_length,
     Handler<xcb_get_property_reply_t*>&& handler) const -> std::function<void()>
 {
+    // Deleting the property changes it, so those reads are neither answered from nor added to the cache
+    std::experimental::optional<uint64_t> cache_generation;
+    if (!delete_after_read)
+    {
+        std::lock_guard<std::mutex> lock{property_cache_mutex};
+        auto const cached_window = property_cache.find(window);
+        if (cached_window != property_cache.end())
+        {
+            auto const cached = cached_window->second.replies.find(prop);
+            if (cached != cached_window->second.replies.end() && cached->second.max_length == max_length)
+            {
+                return [this, reply=cached->second.reply, handler=std::move(handler), window, prop]()
+                    {
+                        handle_property_reply(window, prop, reply.get(), nullptr, handler);
+                    };
+            }
+
+            cache_generation = cached_window->second.generation;
+        }
+    }
+
     xcb_get_property_cookie_t cookie = xcb_get_property(
         xcb_connection,
         delete_after_read ? 1 : 0,
@@ -301,44 +322,103 @@ auto mf::XCBConnection::read_property(
         0, // no offset
         max_length);
 
-    return [this, cookie, handler=std::move(handler), window, prop]()
+    return [this, cookie, handler=std::move(handler), window, prop, max_length, cache_generation]()
         {
-            try
+            Error error;
+            std::shared_ptr<xcb_get_property_reply_t> const reply{
+                xcb_get_property_reply(xcb_connection, cookie, &error.ptr),
+                DeleteCPtr{}};
+
+            if (reply && cache_generation)
             {
-                Error error;
-                auto const reply = make_unique_cptr(xcb_get_property_reply(xcb_connection, cookie, &error.ptr));
-                if (reply && reply->type != XCB_ATOM_NONE)
-                {
-                    handler.on_success(reply.get());
-                }
-                else if (reply)
-                {
-                    std::string message = "no reply data";
-                    if (verbose_xwayland_logging_enabled())
-                    {
-                        message +=  " for " + window_debug_string(window) + "." + query_name(prop);
-                    }
-                    handler.on_error(message);
-                }
-                else
-                {
-                    std::string message = "error reading property: ";
-                    if (verbose_xwayland_logging_enabled())
-                    {
-                        message = "error reading " + window_debug_string(window) + "." + query_name(prop) + ": ";
-                    }
-                    handler.on_error(message + error_debug_string(error.ptr));
-                }
+                cache_property_reply(window, prop, max_length, cache_generation.value(), reply);
             }
-            catch (...)
+
+            handle_property_reply(window, prop, reply.get(), error.ptr, handler);
+        };
+}
+
+void mf::XCBConnection::handle_property_reply(
+    xcb_window_t window,
+    xcb_atom_t prop,
+    xcb_get_property_reply_t* reply,
+    xcb_generic_error_t* error,
+    Handler<xcb_get_property_reply_t*> const& handler) const
+{
+    try
+    {
+        if (reply && reply->type != XCB_ATOM_NONE)
+        {
+            handler.on_success(reply);
+        }
+        else if (reply)
+        {
+            std::string message = "no reply data";
+            if (verbose_xwayland_logging_enabled())
             {
-                log(
-                    logging::Severity::warning,
-                    MIR_LOG_COMPONENT,
-                    "Exception thrown processing reply for property " +
-                    window_debug_string(window) + "." + query_name(prop));
+                message +=  " for " + window_debug_string(window) + "." + query_name(prop);
             }
-        };
+            handler.on_error(message);
+        }
+        else
+        {
+            std::string message = "error reading property: ";
+            if (verbose_xwayland_logging_enabled())
+            {
+                message = "error reading " + window_debug_string(window) + "." + query_name(prop) + ": ";
+            }
+            handler.on_error(message + error_debug_string(error));
+        }
+    }
+    catch (...)
+    {
+        log(
+            logging::Severity::warning,
+            MIR_LOG_COMPONENT,
+            "Exception thrown processing reply for property " +
+            window_debug_string(window) + "." + query_name(prop));
+    }
+}
+
+void mf::XCBConnection::cache_property_reply(
+    xcb_window_t window,
+    xcb_atom_t prop,
+    uint32_t max_length,
+    uint64_t generation,
+    std::shared_ptr<xcb_get_property_reply_t> const& reply) const
+{
+    std::lock_guard<std::mutex> lock{property_cache_mutex};
+
+    // Unless the window has been forgotten, or a property changed, since the request was sent
+    auto const cached_window = property_cache.find(window);
+    if (cached_window != property_cache.end() && cached_window->second.generation == generation)
+    {
+        cached_window->second.replies[prop] = CachedReply{max_length, reply};
+    }
+}
+
+void mf::XCBConnection::cache_properties_of(xcb_window_t window) const
+{
+    std::lock_guard<std::mutex> lock{property_cache_mutex};
+    property_cache[window] = CachedProperties{++property_cache_generation, {}};
+}
+
+void mf::XCBConnection::forget_properties_of(xcb_window_t window) const
+{
+    std::lock_guard<std::mutex> lock{property_cache_mutex};
+    property_cache.erase(window);
+}
+
+void mf::XCBConnection::property_changed(xcb_window_t window, xcb_atom_t property) const
+{
+    std::lock_guard<std::mutex> lock{property_cache_mutex};
+
+    auto const cached_window = property_cache.find(window);
+    if (cached_window != property_cache.end())
+    {
+        cached_window->second.generation = ++property_cache_generation;
+        cached_window->second.replies.erase(property);
+    }
 }
 
 auto mf::XCBConnection::read_property(
@@ -30,6 +30,7 @@
 #include <vector>
 #include <unordered_map>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <atomic>
 #include <experimental/optional>
@@ -71,6 +72,23 @@ private:
     std::mutex mutable atom_name_cache_mutex;
     std::unordered_map<xcb_atom_t, std::string> mutable atom_name_cache;
 
+    struct CachedReply
+    {
+        uint32_t max_length;
+        std::shared_ptr<xcb_get_property_reply_t> reply;
+    };
+
+    struct CachedProperties
+    {
+        /// Changes whenever a property changes, so replies to requests sent before then are not cached
+        uint64_t generation;
+        std::unordered_map<xcb_atom_t, CachedReply> replies;
+    };
+
+    std::mutex mutable property_cache_mutex;
+    std::unordered_map<xcb_window_t, CachedProperties> mutable property_cache;
+    uint64_t mutable property_cache_generation{0};
+
 public:
     class Atom
     {
@@ -193,6 +211,14 @@ public:
         Handler<std::vector<int32_t>> handler) const -> std::function<void()>;
     /// @}
 
+    /// Remember the properties read from the window until they change, so reading them again needs no round trip
+    /// The window must select XCB_EVENT_MASK_PROPERTY_CHANGE, and property_changed() be called for each PropertyNotify
+    /// @{
+    void cache_properties_of(xcb_window_t window) const;
+    void forget_properties_of(xcb_window_t window) const;
+    void property_changed(xcb_window_t window, xcb_atom_t property) const;
+    /// @}
+
     /// Set X11 window properties
     /// Safer and more fun than the C-style function provided by XCB
     /// @{
@@ -228,6 +254,7 @@ public:
     inline void delete_property(xcb_window_t window, xcb_atom_t property) const
     {
         xcb_delete_property(xcb_connection, window, property);
+        property_changed(window, property);
     }
 
     /// Wrapper around xcb_configure_window
@@ -320,6 +347,20 @@ private:
 
     auto xcb_type_atom(XCBType type) const -> xcb_atom_t;
 
+    void handle_property_reply(
+        xcb_window_t window,
+        xcb_atom_t prop,
+        xcb_get_property_reply_t* reply,
+        xcb_generic_error_t* error,
+        Handler<xcb_get_property_reply_t*> const& handler) const;
+
+    void cache_property_reply(
+        xcb_window_t window,
+        xcb_atom_t prop,
+        uint32_t max_length,
+        uint64_t generation,
+        std::shared_ptr<xcb_get_property_reply_t> const& reply) const;
+
     template<XCBType type>
     static inline constexpr uint8_t xcb_type_format()
     {
@@ -355,6 +396,7 @@ private:
             xcb_type_format<type>(),
             length,
             data);
+        property_changed(window, property);
     }
 
     template<typename T, size_t dest_len>
@@ -291,6 +291,9 @@ mf::XWaylandSurface::XWaylandSurface(
 
     uint32_t const value = XCB_EVENT_MASK_PROPERTY_CHANGE | XCB_EVENT_MASK_FOCUS_CHANGE;
     xcb_change_window_attributes(*connection, window, XCB_CW_EVENT_MASK, &value);
+
+    // Now we'll be told of changes, property reads can be answered from the cache until then
+    connection->cache_properties_of(window);
 }
 
 mf::XWaylandSurface::~XWaylandSurface()
@@ -580,16 +583,19 @@ void mf::XWaylandSurface::wm_change_state_client_message(uint32_t const (&data)[
     request_scene_surface_state(new_window_state.mir_window_state());
 }
 
-void mf::XWaylandSurface::property_notify(xcb_atom_t property)
+auto mf::XWaylandSurface::property_notify(xcb_atom_t property) -> std::function<void()>
 {
     auto const handler = property_handlers.find(property);
-    if (handler != property_handlers.end())
+    if (handler == property_handlers.end())
     {
-        auto completion = handler->second();
-        completion();
-
-        apply_any_mods_to_scene_surface();
+        return []{};
     }
+
+    return [this, completion = handler->second()]()
+        {
+            completion();
+            apply_any_mods_to_scene_surface();
+        };
 }
 
 void mf::XWaylandSurface::attach_wl_surface(WlSurface* wl_surface)
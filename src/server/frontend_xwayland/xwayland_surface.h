@@ -67,7 +67,8 @@ public:
     void configure_notify(xcb_configure_notify_event_t* event);
     void net_wm_state_client_message(uint32_t const (&data)[5]);
     void wm_change_state_client_message(uint32_t const (&data)[5]);
-    void property_notify(xcb_atom_t property);
+    /// Starts reading the changed property, returning the function that waits for and applies the new value
+    auto property_notify(xcb_atom_t property) -> std::function<void()>;
     void attach_wl_surface(WlSurface* wl_surface); ///< Should only be called on the Wayland thread
     void move_resize(uint32_t detail);
 
@@ -291,6 +291,19 @@ void mf::XWaylandWM::handle_events()
         got_events = true;
     }
 
+    try
+    {
+        read_changed_properties();
+    }
+    catch (...)
+    {
+        log(
+            logging::Severity::warning,
+            MIR_LOG_COMPONENT,
+            std::current_exception(),
+            "Error reading changed XCB properties");
+    }
+
     if (got_events)
     {
         connection->flush();
@@ -522,6 +535,11 @@ void mf::XWaylandWM::handle_event(xcb_generic_event_t* event)
     int const xcb_error_type = 0;
 
     auto const type = event->response_type & ~0x80;
+
+    // Other events may depend on the changed properties, so apply them first
+    if (type != XCB_PROPERTY_NOTIFY)
+        read_changed_properties();
+
     switch (type)
     {
     case XCB_BUTTON_PRESS:
@@ -618,6 +636,8 @@ void mf::XWaylandWM::handle_event(xcb_generic_event_t* event)
 
 void mf::XWaylandWM::handle_property_notify(xcb_property_notify_event_t *event)
 {
+    connection->property_changed(event->window, event->atom);
+
     if (verbose_xwayland_logging_enabled())
     {
         if (event->state == XCB_PROPERTY_DELETE)
@@ -658,9 +678,34 @@ void mf::XWaylandWM::handle_property_notify(xcb_property_notify_event_t *event)
         }
     }
 
-    if (auto const surface = get_wm_surface(event->window))
+    // Apps can change a property many times in a row, so only read it once they're done
+    auto const change = std::make_pair(event->window, event->atom);
+    if (changed_properties_seen.insert(change).second)
+        changed_properties.push_back(change);
+}
+
+void mf::XWaylandWM::read_changed_properties()
+{
+    if (changed_properties.empty())
+        return;
+
+    // Send all the requests before waiting on any reply, so this takes one round trip rather than one each
+    std::vector<std::shared_ptr<XWaylandSurface>> keep_alive;
+    std::vector<std::function<void()>> completions;
+    for (auto const& change : changed_properties)
+    {
+        if (auto const surface = get_wm_surface(change.first))
+        {
+            keep_alive.push_back(surface.value());
+            completions.push_back(surface.value()->property_notify(change.second));
+        }
+    }
+    changed_properties.clear();
+    changed_properties_seen.clear();
+
+    for (auto const& completion : completions)
     {
-        surface.value()->property_notify(event->atom);
+        completion();
     }
 }
 
@@ -709,6 +754,8 @@ void mf::XWaylandWM::handle_destroy_notify(xcb_destroy_notify_event_t *event)
             connection->window_debug_string(event->event).c_str());
     }
 
+    connection->forget_properties_of(event->window);
+
     std::shared_ptr<XWaylandSurface> surface{nullptr};
 
     {
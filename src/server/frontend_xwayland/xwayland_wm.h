@@ -27,6 +27,7 @@
 #include <map>
 #include <set>
 #include <thread>
+#include <vector>
 #include <experimental/optional>
 #include <mutex>
 
@@ -95,6 +96,8 @@ private:
     void handle_create_notify(xcb_create_notify_event_t *event);
     void handle_motion_notify(xcb_motion_notify_event_t *event);
     void handle_property_notify(xcb_property_notify_event_t *event);
+    /// Reads all properties changed since it was last called, and applies their new values
+    void read_changed_properties();
     void handle_map_request(xcb_map_request_event_t *event);
     void handle_surface_id(std::weak_ptr<XWaylandSurface> const& weak_surface, xcb_client_message_event_t *event);
     void handle_move_resize(std::shared_ptr<XWaylandSurface> surface, xcb_client_message_event_t *event);
@@ -131,6 +134,11 @@ private:
     /// Could be regenerated from scene_surfaces at any time, but more efficient to keep this up to date
     std::set<std::weak_ptr<scene::Surface>, std::owner_less<std::weak_ptr<scene::Surface>>> scene_surface_set;
     std::experimental::optional<xcb_window_t> focused_window;
+
+    /// Only accessed from handle_events(). In the order they first changed, so they are applied in that order
+    std::vector<std::pair<xcb_window_t, xcb_atom_t>> changed_properties;
+    /// The same properties as changed_properties, to drop repeated changes
+    std::set<std::pair<xcb_window_t, xcb_atom_t>> changed_properties_seen;
 };
 } /* frontend */
 } /* mir */
@@ -150,6 +150,12 @@ void mgo::DisplayBuffer::swap_buffers()
     glFinish();
 }
 
+int mgo::DisplayBuffer::buffer_age() const
+{
+    // We always draw to the same framebuffer object, so it holds the previous frame
+    return 1;
+}
+
 bool mgo::DisplayBuffer::overlay(RenderableList const&)
 {
     return false;
@@ -73,6 +73,7 @@ public:
     void bind() override;
     void release_current() override;
     void swap_buffers() override;
+    int buffer_age() const override;
 private:
     SurfacelessEGLContext const egl_context;
     detail::GLFramebufferObject const fbo;
@@ -108,6 +108,19 @@ public:
         return true;
     }
 
+    std::vector<geom::Rectangle> opaque_region() const override
+    {
+        return {};
+    }
+
+    std::experimental::optional<std::vector<geom::Rectangle>> damage_since(mg::BufferID previous) const override
+    {
+        // A new image comes with a new CursorRenderable, so the buffer content never changes
+        if (previous == buffer_->id())
+            return std::vector<geom::Rectangle>{};
+        return {};
+    }
+
     void move_to(geom::Point new_position)
     {
         std::lock_guard<std::mutex> lock{position_mutex};
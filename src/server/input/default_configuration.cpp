@@ -30,11 +30,13 @@
 #include "default_input_device_hub.h"
 #include "default_input_manager.h"
 #include "surface_input_dispatcher.h"
+#include "motion_coalescing_dispatcher.h"
 #include "basic_seat.h"
 #include "seat_observer_multiplexer.h"
 
 #include "mir/input/touch_visualizer.h"
 #include "mir/input/input_probe.h"
+#include "mir/input/input_latencies.h"
 #include "mir/input/platform.h"
 #include "mir/input/xkb_mapper.h"
 #include "mir/input/vt_filter.h"
@@ -97,9 +99,27 @@ mir::DefaultServerConfiguration::the_event_filter_chain_dispatcher()
                     }
                     return {default_filter};
                 };
+            auto const make_surface_dispatcher =
+                [this]() -> std::shared_ptr<mi::InputDispatcher>
+                {
+                    auto const coalescing = the_options()->get<std::string>(options::coalesce_pointer_motion_opt);
+                    if (coalescing == options::off_opt_value)
+                        return the_surface_input_dispatcher();
+
+                    if (coalescing != "frame" && coalescing != "resample")
+                        throw AbnormalExit(std::string("Invalid ") + options::coalesce_pointer_motion_opt +
+                                           " option: " + coalescing +
+                                           " (valid options are: \"off\", \"frame\" and \"resample\")");
+
+                    return std::make_shared<mi::MotionCoalescingDispatcher>(
+                        the_surface_input_dispatcher(),
+                        the_frame_clock(),
+                        the_input_reading_multiplexer(),
+                        coalescing == "resample");
+                };
             return std::make_shared<mi::EventFilterChainDispatcher>(
                 make_default_filter_list(),
-                the_surface_input_dispatcher());
+                make_surface_dispatcher());
         });
 }
 
@@ -123,7 +143,7 @@ mir::DefaultServerConfiguration::the_surface_input_dispatcher()
     return surface_input_dispatcher(
         [this]()
         {
-            return std::make_shared<mi::SurfaceInputDispatcher>(the_input_scene());
+            return std::make_shared<mi::SurfaceInputDispatcher>(the_input_scene(), the_input_latencies());
         });
 }
 
@@ -261,7 +281,10 @@ mir::DefaultServerConfiguration::the_input_reading_multiplexer()
     return input_reading_multiplexer(
         []() -> std::shared_ptr<mir::dispatch::MultiplexingDispatchable>
         {
-            return std::make_shared<mir::dispatch::MultiplexingDispatchable>();
+            // Only the input thread dispatches this, so it may as well handle every
+            // ready source per wakeup rather than one at a time
+            int const max_events_per_dispatch{16};
+            return std::make_shared<mir::dispatch::MultiplexingDispatchable>(max_events_per_dispatch);
         }
     );
 }
@@ -309,7 +332,8 @@ std::shared_ptr<mi::DefaultInputDeviceHub> mir::DefaultServerConfiguration::the_
                the_input_reading_multiplexer(),
                the_cookie_authority(),
                the_key_mapper(),
-               the_server_status_listener());
+               the_server_status_listener(),
+               the_input_latencies());
 
            // lp:1675357: KeyRepeatDispatcher must be informed about removed input devices, otherwise
            // pressed keys get repeated indefinitely
@@ -328,6 +352,15 @@ std::shared_ptr<mi::KeyMapper> mir::DefaultServerConfiguration::the_key_mapper()
        });
 }
 
+std::shared_ptr<mi::InputLatencies> mir::DefaultServerConfiguration::the_input_latencies()
+{
+    return input_latencies(
+        [this]()
+        {
+            return std::make_shared<mi::InputLatencies>(the_clock());
+        });
+}
+
 std::shared_ptr<mi::SeatObserver> mir::DefaultServerConfiguration::the_seat_observer()
 {
     return seat_observer_multiplexer(
@@ -21,6 +21,7 @@
 
 #include "mir/input/input_device.h"
 #include "mir/input/input_device_observer.h"
+#include "mir/input/input_latencies.h"
 #include "mir/input/mir_pointer_config.h"
 #include "mir/input/mir_touchpad_config.h"
 #include "mir/input/mir_keyboard_config.h"
@@ -174,13 +175,15 @@ mi::DefaultInputDeviceHub::DefaultInputDeviceHub(
     std::shared_ptr<dispatch::MultiplexingDispatchable> const& input_multiplexer,
     std::shared_ptr<mir::cookie::Authority> const& cookie_authority,
     std::shared_ptr<mi::KeyMapper> const& key_mapper,
-    std::shared_ptr<mir::ServerStatusListener> const& server_status_listener)
+    std::shared_ptr<mir::ServerStatusListener> const& server_status_listener,
+    std::shared_ptr<mi::InputLatencies> const& latencies)
     : seat{seat},
       input_dispatchable{input_multiplexer},
       device_queue(std::make_shared<dispatch::ActionQueue>()),
       cookie_authority(cookie_authority),
       key_mapper(key_mapper),
       server_status_listener(server_status_listener),
+      latencies(latencies),
       device_id_generator{0}
 {
     input_dispatchable->add_watch(device_queue);
@@ -202,9 +205,10 @@ void mi::DefaultInputDeviceHub::add_device(std::shared_ptr<InputDevice> const& d
     {
         auto queue = std::make_shared<dispatch::ActionQueue>();
         auto handle = restore_or_create_device(*device, queue);
+        latencies->add_device(handle->id(), handle->name());
         // send input device info to observer loop..
         devices.push_back(std::make_unique<RegisteredDevice>(
-            device, handle->id(), queue, cookie_authority, handle));
+            device, handle->id(), queue, cookie_authority, handle, latencies));
 
         auto const& dev = devices.back();
         add_device_handle(handle);
@@ -258,12 +262,14 @@ mi::DefaultInputDeviceHub::RegisteredDevice::RegisteredDevice(
     MirInputDeviceId device_id,
     std::shared_ptr<dispatch::ActionQueue> const& queue,
     std::shared_ptr<mir::cookie::Authority> const& cookie_authority,
-    std::shared_ptr<mi::DefaultDevice> const& handle)
+    std::shared_ptr<mi::DefaultDevice> const& handle,
+    std::shared_ptr<mi::InputLatencies> const& latencies)
     : handle(handle),
       device_id(device_id),
       cookie_authority(cookie_authority),
       device(dev),
-      queue(queue)
+      queue(queue),
+      latencies(latencies)
 {
 }
 
@@ -288,6 +294,9 @@ void mi::DefaultInputDeviceHub::RegisteredDevice::handle_input(std::shared_ptr<M
     if (!seat)
         return;
 
+    if (type == mir_event_type_input)
+        latencies->record(mir_event_get_input_event(event.get()), InputLatencies::Stage::received);
+
     seat->dispatch_event(event);
 }
 
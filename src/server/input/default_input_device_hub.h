@@ -60,6 +60,7 @@ class DefaultDevice;
 class Seat;
 class KeyMapper;
 class DefaultInputDeviceHub;
+class InputLatencies;
 
 struct ExternalInputDeviceHub : InputDeviceHub
 {
@@ -87,7 +88,8 @@ public:
                           std::shared_ptr<dispatch::MultiplexingDispatchable> const& input_multiplexer,
                           std::shared_ptr<cookie::Authority> const& cookie_authority,
                           std::shared_ptr<KeyMapper> const& key_mapper,
-                          std::shared_ptr<ServerStatusListener> const& server_status_listener);
+                          std::shared_ptr<ServerStatusListener> const& server_status_listener,
+                          std::shared_ptr<InputLatencies> const& latencies);
 
     // InputDeviceRegistry - calls from mi::Platform
     void add_device(std::shared_ptr<InputDevice> const& device) override;
@@ -116,6 +118,7 @@ private:
     std::shared_ptr<cookie::Authority> const cookie_authority;
     std::shared_ptr<KeyMapper> const key_mapper;
     std::shared_ptr<ServerStatusListener> const server_status_listener;
+    std::shared_ptr<InputLatencies> const latencies;
 
     struct RegisteredDevice : public InputSink
     {
@@ -124,7 +127,8 @@ private:
                          MirInputDeviceId dev_id,
                          std::shared_ptr<dispatch::ActionQueue> const& multiplexer,
                          std::shared_ptr<cookie::Authority> const& cookie_authority,
-                         std::shared_ptr<DefaultDevice> const& handle);
+                         std::shared_ptr<DefaultDevice> const& handle,
+                         std::shared_ptr<InputLatencies> const& latencies);
         void handle_input(std::shared_ptr<MirEvent> const& event) override;
         geometry::Rectangle bounding_rectangle() const override;
         input::OutputInfo output_info(uint32_t output_id) const override;
@@ -143,6 +147,7 @@ private:
         std::shared_ptr<cookie::Authority> cookie_authority;
         std::shared_ptr<InputDevice> const device;
         std::shared_ptr<dispatch::ActionQueue> queue;
+        std::shared_ptr<InputLatencies> const latencies;
     };
 
     std::vector<std::shared_ptr<Device>> handles;
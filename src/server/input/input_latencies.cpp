@@ -0,0 +1,149 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/input/input_latencies.h"
+#include "mir/time/clock.h"
+
+#include <algorithm>
+#include <sstream>
+
+namespace mi = mir::input;
+
+using namespace std::chrono;
+
+mi::InputLatencies::InputLatencies(std::shared_ptr<time::Clock> const& clock)
+    : clock{clock}
+{
+}
+
+void mi::InputLatencies::add_device(MirInputDeviceId id, std::string const& name)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    auto const index = static_cast<unsigned>(devices_.size());
+    devices_.try_emplace(id, Device{index, name, {}}).first->second.name = name;
+}
+
+void mi::InputLatencies::record(MirInputEvent const* event, Stage stage)
+{
+    // Event timestamps are taken from CLOCK_MONOTONIC, as is the clock's epoch
+    nanoseconds const event_time{mir_input_event_get_event_time(event)};
+    auto const now = duration_cast<nanoseconds>(clock->now().time_since_epoch());
+
+    record(mir_input_event_get_device_id(event), stage, now - event_time);
+}
+
+void mi::InputLatencies::record(MirInputDeviceId id, Stage stage, nanoseconds latency)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    auto& device = devices_.try_emplace(id, Device{static_cast<unsigned>(devices_.size()), {}, {}}).first->second;
+    device.stages[static_cast<int>(stage)].record(latency);
+}
+
+auto mi::InputLatencies::devices() const -> std::vector<MirInputDeviceId>
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    std::vector<MirInputDeviceId> result(devices_.size());
+    for (auto const& device : devices_)
+        result[device.second.index] = device.first;
+    return result;
+}
+
+auto mi::InputLatencies::summary(MirInputDeviceId id, Stage stage) const -> Summary
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    auto const device = devices_.find(id);
+    if (device == devices_.end())
+        return time::DurationHistogram{}.summary();
+
+    return device->second.stages[static_cast<int>(stage)].summary();
+}
+
+namespace
+{
+void write_json_string(std::ostream& out, std::string const& string)
+{
+    out << "\"";
+    for (auto const c : string)
+    {
+        switch (c)
+        {
+        case '"': out << "\\\""; break;
+        case '\\': out << "\\\\"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20)
+                out << "\\u00" << "0123456789abcdef"[c >> 4] << "0123456789abcdef"[c & 0xf];
+            else
+                out << c;
+        }
+    }
+    out << "\"";
+}
+}
+
+auto mi::InputLatencies::to_json() const -> std::string
+{
+    std::vector<std::pair<MirInputDeviceId, Device>> ordered;
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        ordered.assign(devices_.begin(), devices_.end());
+    }
+    std::sort(
+        ordered.begin(), ordered.end(),
+        [](auto const& lhs, auto const& rhs) { return lhs.second.index < rhs.second.index; });
+
+    std::ostringstream json;
+    json << "{\"devices\":[";
+    for (auto device = ordered.begin(); device != ordered.end(); ++device)
+    {
+        if (device != ordered.begin())
+            json << ",";
+        json << "{\"id\":" << device->first << ",\"name\":";
+        write_json_string(json, device->second.name);
+        json << ",\"stages\":{";
+
+        for (int stage = 0; stage != stage_count; ++stage)
+        {
+            if (stage)
+                json << ",";
+            json << "\"" << name_of(static_cast<Stage>(stage)) << "\":";
+            time::write_json(json, device->second.stages[stage].summary());
+        }
+        json << "}}";
+    }
+    json << "]}";
+
+    return json.str();
+}
+
+void mi::InputLatencies::reset()
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    for (auto& device : devices_)
+        device.second.stages = {};
+}
+
+auto mi::InputLatencies::name_of(Stage stage) -> char const*
+{
+    switch (stage)
+    {
+    case Stage::received: return "received";
+    case Stage::dispatched: return "dispatched";
+    case Stage::sent: return "sent";
+    }
+    return "unknown";
+}
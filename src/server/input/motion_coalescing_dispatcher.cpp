@@ -0,0 +1,241 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "motion_coalescing_dispatcher.h"
+
+#include "mir/compositor/frame_clock.h"
+#include "mir/dispatch/action_queue.h"
+#include "mir/dispatch/multiplexing_dispatchable.h"
+#include "mir/events/event_builders.h"
+#include "mir/geometry/rectangle.h"
+
+#include <algorithm>
+
+namespace mi = mir::input;
+namespace md = mir::dispatch;
+namespace mev = mir::events;
+namespace geom = mir::geometry;
+
+using namespace std::chrono;
+
+namespace
+{
+// Motion older than this says nothing about the pointer's current velocity
+milliseconds constexpr max_sample_gap{20};
+// Longer than this between frames and the outputs are idle rather than running at some rate
+milliseconds constexpr max_frame_period{50};
+
+auto pointer_motion(MirEvent const* event) -> MirPointerEvent const*
+{
+    if (mir_event_get_type(event) != mir_event_type_input)
+        return nullptr;
+
+    auto const iev = mir_event_get_input_event(event);
+    if (mir_input_event_get_type(iev) != mir_input_event_type_pointer || mir_input_event_has_cookie(iev))
+        return nullptr;
+
+    auto const pev = mir_input_event_get_pointer_event(iev);
+    if (mir_pointer_event_action(pev) != mir_pointer_action_motion ||
+        mir_pointer_event_axis_value(pev, mir_pointer_axis_vscroll) != 0 ||
+        mir_pointer_event_axis_value(pev, mir_pointer_axis_hscroll) != 0)
+        return nullptr;
+
+    return pev;
+}
+}
+
+mi::MotionCoalescingDispatcher::MotionCoalescingDispatcher(
+    std::shared_ptr<InputDispatcher> const& next_dispatcher,
+    std::shared_ptr<compositor::FrameClock> const& frame_clock,
+    std::shared_ptr<md::MultiplexingDispatchable> const& input_thread,
+    bool resample)
+    : next_dispatcher{next_dispatcher},
+      frame_clock{frame_clock},
+      input_thread{input_thread},
+      presented_frames{std::make_shared<md::ActionQueue>()},
+      resample{resample}
+{
+    input_thread->add_watch(presented_frames);
+}
+
+mi::MotionCoalescingDispatcher::~MotionCoalescingDispatcher()
+{
+    input_thread->remove_watch(presented_frames);
+}
+
+bool mi::MotionCoalescingDispatcher::dispatch(std::shared_ptr<MirEvent const> const& event)
+{
+    auto const pev = pointer_motion(event.get());
+    if (!pev)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        send_held_motion(nanoseconds{0});
+        return next_dispatcher->dispatch(event);
+    }
+
+    auto const iev = mir_pointer_event_input_event(pev);
+    auto const id = mir_input_event_get_device_id(iev);
+    Sample const sample{
+        nanoseconds{mir_input_event_get_event_time(iev)},
+        mir_pointer_event_axis_value(pev, mir_pointer_axis_x),
+        mir_pointer_event_axis_value(pev, mir_pointer_axis_y)};
+    auto const relative_x = mir_pointer_event_axis_value(pev, mir_pointer_axis_relative_x);
+    auto const relative_y = mir_pointer_event_axis_value(pev, mir_pointer_axis_relative_y);
+
+    bool request_frame;
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        auto held = held_motion.find(id);
+        if (held != held_motion.end())
+        {
+            auto const held_pev = mir_input_event_get_pointer_event(mir_event_get_input_event(held->second.event.get()));
+            if (mir_pointer_event_buttons(held_pev) != mir_pointer_event_buttons(pev) ||
+                mir_pointer_event_modifiers(held_pev) != mir_pointer_event_modifiers(pev))
+            {
+                send_held_motion(nanoseconds{0});
+                held = held_motion.end();
+            }
+        }
+
+        if (held == held_motion.end())
+        {
+            auto earliest = sample;
+            auto const sent = sent_motion.find(id);
+            if (sent != sent_motion.end() && sample.time - sent->second.time < max_sample_gap)
+                earliest = sent->second;
+
+            held_motion.emplace(id, Motion{event, 1, relative_x, relative_y, earliest, sample});
+        }
+        else
+        {
+            auto& motion = held->second;
+            motion.event = event;
+            ++motion.events;
+            motion.relative_x += relative_x;
+            motion.relative_y += relative_y;
+            motion.latest = sample;
+        }
+
+        request_frame = !frame_requested;
+        frame_requested = true;
+    }
+
+    // Not under the lock: with nothing on screen the callback is called immediately
+    if (request_frame)
+    {
+        frame_clock->on_next_frame(
+            geom::Rectangle{{static_cast<int>(sample.x), static_cast<int>(sample.y)}, {1, 1}},
+            [weak_self = weak_from_this()](steady_clock::time_point presented)
+            {
+                if (auto const self = weak_self.lock())
+                    self->frame_presented(presented);
+            });
+    }
+
+    return true;
+}
+
+void mi::MotionCoalescingDispatcher::start()
+{
+    next_dispatcher->start();
+}
+
+void mi::MotionCoalescingDispatcher::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        held_motion.clear();
+        sent_motion.clear();
+    }
+    next_dispatcher->stop();
+}
+
+void mi::MotionCoalescingDispatcher::frame_presented(steady_clock::time_point presented)
+{
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        auto const since_last = presented - last_presented;
+        if (since_last > nanoseconds{0} && since_last < max_frame_period)
+            frame_period = since_last;
+        last_presented = presented;
+        frame_requested = false;
+
+        auto const next_presentation = presented.time_since_epoch() + frame_period;
+        predict_to = resample ? duration_cast<nanoseconds>(next_presentation) : nanoseconds{0};
+
+        if (send_queued)
+            return;
+        send_queued = true;
+    }
+
+    // Dispatching to surfaces takes scene locks and writes to clients, which the compositor mustn't wait on
+    presented_frames->enqueue(
+        [weak_self = weak_from_this()]
+        {
+            if (auto const self = weak_self.lock())
+                self->send_presented_motion();
+        });
+}
+
+void mi::MotionCoalescingDispatcher::send_presented_motion()
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    send_queued = false;
+    send_held_motion(predict_to);
+}
+
+void mi::MotionCoalescingDispatcher::send_held_motion(nanoseconds predict_to)
+{
+    for (auto const& held : held_motion)
+    {
+        auto const id = held.first;
+        auto const& motion = held.second;
+        sent_motion[id] = motion.latest;
+
+        auto const span = motion.latest.time - motion.earliest.time;
+        bool const predict = predict_to > motion.latest.time && span > nanoseconds{0};
+        if (!predict && motion.events == 1)
+        {
+            next_dispatcher->dispatch(motion.event);
+            continue;
+        }
+
+        auto x = motion.latest.x;
+        auto y = motion.latest.y;
+        if (predict)
+        {
+            auto const ahead = std::min<nanoseconds>(predict_to - motion.latest.time, max_prediction);
+            auto const scale = static_cast<float>(ahead.count()) / span.count();
+            x += (motion.latest.x - motion.earliest.x) * scale;
+            y += (motion.latest.y - motion.earliest.y) * scale;
+        }
+
+        auto const pev = mir_input_event_get_pointer_event(mir_event_get_input_event(motion.event.get()));
+        next_dispatcher->dispatch(mev::make_event(
+            id,
+            motion.latest.time,
+            std::vector<uint8_t>{},
+            mir_pointer_event_modifiers(pev),
+            mir_pointer_action_motion,
+            mir_pointer_event_buttons(pev),
+            x, y,
+            0, 0,
+            motion.relative_x, motion.relative_y));
+    }
+    held_motion.clear();
+}
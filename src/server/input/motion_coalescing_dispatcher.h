@@ -0,0 +1,117 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_INPUT_MOTION_COALESCING_DISPATCHER_H_
+#define MIR_INPUT_MOTION_COALESCING_DISPATCHER_H_
+
+#include "mir/input/input_dispatcher.h"
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace mir
+{
+namespace compositor
+{
+class FrameClock;
+}
+namespace dispatch
+{
+class ActionQueue;
+class MultiplexingDispatchable;
+}
+namespace input
+{
+/**
+ * Holds back pointer motion until the next frame is presented, merging the motion of each device into one event.
+ *
+ * A 1000Hz mouse would otherwise wake clients a thousand times a second for a display that shows sixty frames.
+ * Relative motion is summed, so clients that need raw deltas (such as those using relative pointer) see all of it.
+ * Anything other than plain motion (buttons, scrolling, keys, touch) first sends the motion held back, so the order
+ * of events is kept. Optionally, the merged position is predicted forward to when the client's next frame is
+ * expected to be presented.
+ *
+ * Held motion is sent from the input thread: the frame clock's callback only notes that a frame was presented and
+ * queues the sending on \p input_thread. Each batch of motion asks the frame clock for a frame, so while the pointer
+ * moves the compositor draws every frame, even when a hardware cursor would otherwise have needed none.
+ */
+class MotionCoalescingDispatcher : public InputDispatcher, public std::enable_shared_from_this<MotionCoalescingDispatcher>
+{
+public:
+    MotionCoalescingDispatcher(
+        std::shared_ptr<InputDispatcher> const& next_dispatcher,
+        std::shared_ptr<compositor::FrameClock> const& frame_clock,
+        std::shared_ptr<dispatch::MultiplexingDispatchable> const& input_thread,
+        bool resample);
+    ~MotionCoalescingDispatcher();
+
+    // InputDispatcher
+    bool dispatch(std::shared_ptr<MirEvent const> const& event) override;
+    void start() override;
+    void stop() override;
+
+    /// The furthest the position is predicted beyond the latest motion
+    static std::chrono::milliseconds constexpr max_prediction{8};
+
+private:
+    struct Sample
+    {
+        std::chrono::nanoseconds time;
+        float x;
+        float y;
+    };
+
+    struct Motion
+    {
+        std::shared_ptr<MirEvent const> event; ///< The latest
+        unsigned events;
+        float relative_x;
+        float relative_y;
+        Sample earliest;
+        Sample latest;
+    };
+
+    /// Called with the mutex held
+    void send_held_motion(std::chrono::nanoseconds predict_to);
+
+    /// Called on a compositor thread, so only queues the sending
+    void frame_presented(std::chrono::steady_clock::time_point presented);
+    /// Called on the input thread once a frame has been presented
+    void send_presented_motion();
+
+    std::shared_ptr<InputDispatcher> const next_dispatcher;
+    std::shared_ptr<compositor::FrameClock> const frame_clock;
+    std::shared_ptr<dispatch::MultiplexingDispatchable> const input_thread;
+    std::shared_ptr<dispatch::ActionQueue> const presented_frames;
+    bool const resample;
+
+    std::mutex mutex;
+    std::map<MirInputDeviceId, Motion> held_motion;
+    /// The latest motion sent for each device, to estimate velocity when few samples have been held
+    std::map<MirInputDeviceId, Sample> sent_motion;
+    bool frame_requested{false};
+    bool send_queued{false};
+    /// Where to predict the motion sent for the latest frame presented
+    std::chrono::nanoseconds predict_to{0};
+    std::chrono::steady_clock::time_point last_presented;
+    std::chrono::nanoseconds frame_period{0};
+};
+}
+}
+
+#endif // MIR_INPUT_MOTION_COALESCING_DISPATCHER_H_
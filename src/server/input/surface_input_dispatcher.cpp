@@ -20,6 +20,7 @@
 
 #include "mir/input/scene.h"
 #include "mir/input/surface.h"
+#include "mir/input/input_latencies.h"
 #include "mir/scene/null_observer.h"
 #include "mir/scene/surface.h"
 #include "mir/scene/null_surface_observer.h"
@@ -47,16 +48,24 @@ struct InputDispatcherSceneObserver :
     InputDispatcherSceneObserver(
         std::function<void(std::shared_ptr<ms::Surface>)> const& on_removed,
         std::function<void(ms::Surface const*)> const& on_surface_moved,
-        std::function<void()> const& on_surface_resized)
+        std::function<void(ms::Surface const*)> const& on_surface_resized,
+        std::function<void()> const& on_stacking_changed)
         : on_removed(on_removed),
           on_surface_moved{on_surface_moved},
-          on_surface_resized{on_surface_resized}
+          on_surface_resized{on_surface_resized},
+          on_stacking_changed{on_stacking_changed}
     {
     }
 
     void surface_added(std::shared_ptr<ms::Surface> const& surface) override
     {
         surface->add_observer(shared_from_this());
+        on_stacking_changed();
+    }
+
+    void surfaces_reordered(ms::SurfaceSet const& /*affected_surfaces*/) override
+    {
+        on_stacking_changed();
     }
 
     void surface_removed(std::shared_ptr<ms::Surface> const& surface) override
@@ -67,6 +76,7 @@ struct InputDispatcherSceneObserver :
     void surface_exists(std::shared_ptr<ms::Surface> const& surface) override
     {
         surface->add_observer(shared_from_this());
+        on_stacking_changed();
     }
 
     void attrib_changed(ms::Surface const*, MirWindowAttrib /*attrib*/, int /*value*/) override
@@ -74,9 +84,9 @@ struct InputDispatcherSceneObserver :
         // TODO: Do we need to listen to visibility events?
     }
 
-    void content_resized_to(ms::Surface const*, mir::geometry::Size const& /*size*/) override
+    void content_resized_to(ms::Surface const* surf, mir::geometry::Size const& /*size*/) override
     {
-        on_surface_resized();
+        on_surface_resized(surf);
     }
 
     void moved_to(ms::Surface const* surf, mir::geometry::Point const& /*top_left*/) override
@@ -89,9 +99,21 @@ struct InputDispatcherSceneObserver :
         // TODO: Do we need to listen to this?
     }
 
+    void depth_layer_set_to(ms::Surface const*, MirDepthLayer /*depth_layer*/) override
+    {
+        on_stacking_changed();
+    }
+
+    void input_region_set_to(ms::Surface const* surf, std::vector<mir::geometry::Rectangle> const& /*region*/) override
+    {
+        // The pointer may now be over a different surface, just as for a resize
+        on_surface_resized(surf);
+    }
+
     std::function<void(std::shared_ptr<ms::Surface>)> const on_removed;
     std::function<void(ms::Surface const*)> const on_surface_moved;
-    std::function<void()> const on_surface_resized;
+    std::function<void(ms::Surface const*)> const on_surface_resized;
+    std::function<void()> const on_stacking_changed;
 };
 
 void deliver_without_relative_motion(
@@ -135,26 +157,39 @@ void deliver(
     MirEvent const* ev,
     std::vector<uint8_t> const& drag_and_drop_handle)
 {
+    auto const& bounds = surface->input_bounds();
+
+    // A surface at the origin (such as a fullscreen game) needs nothing rewritten, so skip the copy
+    if (drag_and_drop_handle.empty() && bounds.top_left == geom::Point{})
+    {
+        surface->consume(ev);
+        return;
+    }
+
     auto to_deliver = mev::clone_event(*ev);
 
     if (!drag_and_drop_handle.empty())
         mev::set_drag_and_drop_handle(*to_deliver, drag_and_drop_handle);
 
-    auto const& bounds = surface->input_bounds();
     mev::transform_positions(*to_deliver, geom::Displacement{bounds.top_left.x.as_int(), bounds.top_left.y.as_int()});
     surface->consume(to_deliver.get());
 }
 
 }
 
-mi::SurfaceInputDispatcher::SurfaceInputDispatcher(std::shared_ptr<mi::Scene> const& scene)
+mi::SurfaceInputDispatcher::SurfaceInputDispatcher(
+    std::shared_ptr<mi::Scene> const& scene,
+    std::shared_ptr<mi::InputLatencies> const& latencies)
     : scene(scene),
+      latencies(latencies),
+      surface_index_stale{true},
       started(false)
 {
     scene_observer = std::make_shared<InputDispatcherSceneObserver>(
         [this](std::shared_ptr<ms::Surface> const& s) { surface_removed(s); },
         [this](scene::Surface const* s) { surface_moved(s); },
-        [this] { surface_resized(); });
+        [this](scene::Surface const* s) { surface_resized(s); },
+        [this] { surface_index_stale = true; });
     scene->add_observer(scene_observer);
 }
 
@@ -186,6 +221,8 @@ void mi::SurfaceInputDispatcher::surface_removed(std::shared_ptr<ms::Surface> su
 {
     std::lock_guard<std::mutex> lg(dispatcher_mutex);
 
+    surface_index.remove(surface.get());
+
     auto strong_focus = focus_surface.lock();
     if (strong_focus && compare_surfaces(strong_focus, surface.get()))
     {
@@ -336,6 +373,8 @@ void mi::SurfaceInputDispatcher::surface_moved(ms::Surface const* moved_surface)
 {
     std::lock_guard<std::mutex> lock{dispatcher_mutex};
 
+    surface_index.update(moved_surface);
+
     if (!last_pointer_event)
         return;
 
@@ -363,10 +402,12 @@ void mi::SurfaceInputDispatcher::surface_moved(ms::Surface const* moved_surface)
     }
 }
 
-void mi::SurfaceInputDispatcher::surface_resized()
+void mi::SurfaceInputDispatcher::surface_resized(ms::Surface const* resized_surface)
 {
     std::lock_guard<std::mutex> lock{dispatcher_mutex};
 
+    surface_index.update(resized_surface);
+
     if (!last_pointer_event)
         return;
 
@@ -442,12 +483,19 @@ bool is_gesture_terminator(MirPointerEvent const* pev)
 
 std::shared_ptr<mi::Surface> mi::SurfaceInputDispatcher::find_target_surface(geom::Point const& point)
 {
-    std::shared_ptr<mi::Surface> top_target = nullptr;
-    scene->for_each([&top_target, &point](std::shared_ptr<mi::Surface> const& target) {
-            if (target->input_area_contains(point))
-                top_target = target;
-    });
-    return top_target;
+    // Surfaces being added or restacked only flag the index: walking the scene from within
+    // its own notifications would be unsafe, and several changes often arrive together.
+    if (surface_index_stale.exchange(false))
+    {
+        std::vector<std::shared_ptr<mi::Surface>> stacking_order;
+        scene->for_each([&stacking_order](std::shared_ptr<mi::Surface> const& surface)
+            {
+                stacking_order.push_back(surface);
+            });
+        surface_index.rebuild(stacking_order);
+    }
+
+    return surface_index.surface_at(point);
 }
 
 void mi::SurfaceInputDispatcher::send_enter_exit_event(std::shared_ptr<mi::Surface> const& surface,
@@ -639,19 +687,26 @@ bool mi::SurfaceInputDispatcher::dispatch(std::shared_ptr<MirEvent const> const&
     
     auto iev = mir_event_get_input_event(event.get());
     auto id = mir_input_event_get_device_id(iev);
+    bool delivered;
     switch (mir_input_event_get_type(iev))
     {
     case mir_input_event_type_key:
-        return dispatch_key(event.get());
+        delivered = dispatch_key(event.get());
+        break;
     case mir_input_event_type_touch:
-        return dispatch_touch(id, event.get());
+        delivered = dispatch_touch(id, event.get());
+        break;
     case mir_input_event_type_pointer:
-        return dispatch_pointer(id, event);
+        delivered = dispatch_pointer(id, event);
+        break;
     default:
         BOOST_THROW_EXCEPTION(std::logic_error("InputDispatcher got an input event of unknown type"));
     }
-    
-    return true;
+
+    if (delivered)
+        latencies->record(iev, InputLatencies::Stage::dispatched);
+
+    return delivered;
 }
 
 void mi::SurfaceInputDispatcher::start()
@@ -22,7 +22,9 @@
 #include "mir/input/input_dispatcher.h"
 #include "mir/shell/input_targeter.h"
 #include "mir/geometry/point.h"
+#include "surface_spatial_index.h"
 
+#include <atomic>
 #include <memory>
 #include <mutex>
 #include <unordered_map>
@@ -39,11 +41,14 @@ namespace input
 {
 class Surface;
 class Scene;
+class InputLatencies;
 
 class SurfaceInputDispatcher : public mir::input::InputDispatcher, public shell::InputTargeter
 {
 public:
-    SurfaceInputDispatcher(std::shared_ptr<input::Scene> const& scene);
+    SurfaceInputDispatcher(
+        std::shared_ptr<input::Scene> const& scene,
+        std::shared_ptr<InputLatencies> const& latencies);
     ~SurfaceInputDispatcher();
 
     // mir::input::InputDispatcher
@@ -74,7 +79,7 @@ private:
     void surface_removed(std::shared_ptr<scene::Surface> surface);
 
     void surface_moved(scene::Surface const* moved_surface);
-    void surface_resized();
+    void surface_resized(scene::Surface const* resized_surface);
 
     // Look in to homognizing index on KeyInputState and PointerInputState (wrt to device id)
     struct PointerInputState
@@ -93,9 +98,13 @@ private:
     TouchInputState& ensure_touch_state(MirInputDeviceId id);
     
     std::shared_ptr<input::Scene> const scene;
+    std::shared_ptr<InputLatencies> const latencies;
 
     std::shared_ptr<scene::Observer> scene_observer;
 
+    SurfaceSpatialIndex surface_index;
+    std::atomic<bool> surface_index_stale;
+
     std::mutex dispatcher_mutex;
     std::shared_ptr<MirEvent const> last_pointer_event;
     std::weak_ptr<input::Surface> focus_surface;
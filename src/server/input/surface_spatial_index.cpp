@@ -0,0 +1,219 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "surface_spatial_index.h"
+
+#include "mir/input/surface.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace mi = mir::input;
+namespace geom = mir::geometry;
+
+namespace
+{
+// Beyond this a surface is cheaper to test on every lookup than to file in every cell
+int64_t const max_cells_per_surface = 1024;
+
+int floor_div(int value, int divisor)
+{
+    return value / divisor - (value % divisor < 0 ? 1 : 0);
+}
+
+uint64_t key_for(int cell_x, int cell_y)
+{
+    return (uint64_t{static_cast<uint32_t>(cell_x)} << 32) | static_cast<uint32_t>(cell_y);
+}
+
+bool is_empty(geom::Rectangle const& bounds)
+{
+    return bounds.size.width <= geom::Width{0} || bounds.size.height <= geom::Height{0};
+}
+}
+
+mi::SurfaceSpatialIndex::SurfaceSpatialIndex(int cell_size)
+    : cell_size{cell_size}
+{
+    if (cell_size <= 0)
+        BOOST_THROW_EXCEPTION(std::invalid_argument("Spatial index cell size must be positive"));
+}
+
+template<typename F>
+void mi::SurfaceSpatialIndex::for_each_cell_of(geom::Rectangle const& bounds, F const& f) const
+{
+    if (is_empty(bounds))
+        return;
+
+    auto const first_x = floor_div(bounds.left().as_int(), cell_size);
+    auto const last_x = floor_div(bounds.right().as_int() - 1, cell_size);
+    auto const first_y = floor_div(bounds.top().as_int(), cell_size);
+    auto const last_y = floor_div(bounds.bottom().as_int() - 1, cell_size);
+
+    for (auto x = first_x; x <= last_x; ++x)
+        for (auto y = first_y; y <= last_y; ++y)
+            f(key_for(x, y));
+}
+
+auto mi::SurfaceSpatialIndex::is_oversized(geom::Rectangle const& bounds) const -> bool
+{
+    if (is_empty(bounds))
+        return false;
+
+    int64_t const columns =
+        floor_div(bounds.right().as_int() - 1, cell_size) - floor_div(bounds.left().as_int(), cell_size) + 1;
+    int64_t const rows =
+        floor_div(bounds.bottom().as_int() - 1, cell_size) - floor_div(bounds.top().as_int(), cell_size) + 1;
+
+    return columns * rows > max_cells_per_surface;
+}
+
+void mi::SurfaceSpatialIndex::insert(Entry const& entry)
+{
+    auto const add_to = [&entry](Cell& cell)
+        {
+            // Cells are kept top-most first so that a lookup can stop at the first hit
+            auto const position = std::upper_bound(
+                cell.begin(), cell.end(), &entry,
+                [](Entry const* lhs, Entry const* rhs)
+                {
+                    return lhs->stacking_position > rhs->stacking_position;
+                });
+            cell.insert(position, &entry);
+        };
+
+    if (is_oversized(entry.bounds))
+    {
+        add_to(oversized);
+    }
+    else
+    {
+        for_each_cell_of(entry.bounds, [&](CellKey key) { add_to(cells[key]); });
+    }
+}
+
+void mi::SurfaceSpatialIndex::erase(Entry const& entry)
+{
+    auto const remove_from = [&entry](Cell& cell)
+        {
+            cell.erase(std::remove(cell.begin(), cell.end(), &entry), cell.end());
+        };
+
+    if (is_oversized(entry.bounds))
+    {
+        remove_from(oversized);
+    }
+    else
+    {
+        for_each_cell_of(entry.bounds, [&](CellKey key)
+            {
+                auto const cell = cells.find(key);
+                if (cell != cells.end())
+                {
+                    remove_from(cell->second);
+                    if (cell->second.empty())
+                        cells.erase(cell);
+                }
+            });
+    }
+}
+
+void mi::SurfaceSpatialIndex::rebuild(std::vector<std::shared_ptr<Surface>> const& surfaces)
+{
+    clear();
+
+    unsigned stacking_position = 0;
+    for (auto const& surface : surfaces)
+    {
+        auto const inserted = entries.emplace(
+            surface.get(),
+            Entry{surface, stacking_position++, surface->input_area_bounds()});
+
+        if (inserted.second)
+            insert(inserted.first->second);
+    }
+}
+
+void mi::SurfaceSpatialIndex::update(Surface const* surface)
+{
+    auto const found = entries.find(surface);
+    if (found == entries.end())
+        return;
+
+    auto& entry = found->second;
+    auto const bounds = surface->input_area_bounds();
+    if (bounds == entry.bounds)
+        return;
+
+    erase(entry);
+    entry.bounds = bounds;
+    insert(entry);
+}
+
+void mi::SurfaceSpatialIndex::remove(Surface const* surface)
+{
+    auto const found = entries.find(surface);
+    if (found == entries.end())
+        return;
+
+    erase(found->second);
+    entries.erase(found);
+}
+
+void mi::SurfaceSpatialIndex::clear()
+{
+    cells.clear();
+    oversized.clear();
+    entries.clear();
+}
+
+auto mi::SurfaceSpatialIndex::surface_at(geom::Point const& point) const -> std::shared_ptr<Surface>
+{
+    Entry const* top_target = nullptr;
+
+    auto const search = [&](Cell const& cell)
+        {
+            for (auto const entry : cell)
+            {
+                if (top_target && entry->stacking_position < top_target->stacking_position)
+                    return;
+
+                if (entry->bounds.contains(point) && entry->surface->input_area_contains(point))
+                {
+                    top_target = entry;
+                    return;
+                }
+            }
+        };
+
+    auto const cell = cells.find(key_for(
+        floor_div(point.x.as_int(), cell_size),
+        floor_div(point.y.as_int(), cell_size)));
+
+    if (cell != cells.end())
+        search(cell->second);
+
+    search(oversized);
+
+    return top_target ? top_target->surface : nullptr;
+}
+
+auto mi::SurfaceSpatialIndex::size() const -> size_t
+{
+    return entries.size();
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_INPUT_SURFACE_SPATIAL_INDEX_H_
+#define MIR_INPUT_SURFACE_SPATIAL_INDEX_H_
+
+#include "mir/geometry/point.h"
+#include "mir/geometry/rectangle.h"
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace mir
+{
+namespace input
+{
+class Surface;
+
+/**
+ * Finds the top-most surface accepting input at a point without testing every surface.
+ *
+ * Surfaces are bucketed by their input_area_bounds() into a grid of square cells, each
+ * cell listing its surfaces top-most first. A lookup only tests the surfaces that share
+ * the point's cell, so its cost depends on how many windows overlap there rather than on
+ * how many windows there are.
+ *
+ * The index does not observe the scene itself: the owner calls rebuild() when the
+ * stacking order changes and update() when a surface's input area does.
+ */
+class SurfaceSpatialIndex
+{
+public:
+    explicit SurfaceSpatialIndex(int cell_size = 256);
+
+    /// Replaces the indexed surfaces; \a surfaces is in stacking order, bottom-most first
+    void rebuild(std::vector<std::shared_ptr<Surface>> const& surfaces);
+
+    /// Re-reads the input area bounds of an indexed surface. Unknown surfaces are ignored.
+    void update(Surface const* surface);
+
+    void remove(Surface const* surface);
+
+    void clear();
+
+    /// The top-most surface for which input_area_contains(point) is true, or null
+    auto surface_at(geometry::Point const& point) const -> std::shared_ptr<Surface>;
+
+    auto size() const -> size_t;
+
+private:
+    struct Entry
+    {
+        std::shared_ptr<Surface> surface;
+        unsigned stacking_position;
+        geometry::Rectangle bounds;
+    };
+    using CellKey = uint64_t;
+    using Cell = std::vector<Entry const*>;
+
+    void insert(Entry const& entry);
+    void erase(Entry const& entry);
+
+    template<typename F>
+    void for_each_cell_of(geometry::Rectangle const& bounds, F const& f) const;
+
+    auto is_oversized(geometry::Rectangle const& bounds) const -> bool;
+
+    int const cell_size;
+    std::unordered_map<Surface const*, Entry> entries;
+    std::unordered_map<CellKey, Cell> cells;
+
+    /// Surfaces covering too many cells to be worth bucketing; tested on every lookup
+    Cell oversized;
+};
+}
+}
+
+#endif // MIR_INPUT_SURFACE_SPATIAL_INDEX_H_
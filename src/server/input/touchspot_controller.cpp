@@ -94,6 +94,19 @@ public:
         return true;
     }
 
+    std::vector<geom::Rectangle> opaque_region() const override
+    {
+        return {};
+    }
+
+    std::experimental::optional<std::vector<geom::Rectangle>> damage_since(mg::BufferID previous) const override
+    {
+        // The touchspot image never changes
+        if (previous == buffer_->id())
+            return std::vector<geom::Rectangle>{};
+        return {};
+    }
+
 // TouchspotRenderable    
     void move_center_to(geom::Point pos)
     {
@@ -20,11 +20,13 @@
 #include "mir/options/configuration.h"
 
 #include "reports.h"
+#include "frame_timing_compositor_report.h"
 #include "lttng_report_factory.h"
 #include "logging_report_factory.h"
 #include "null_report_factory.h"
 
 #include "mir/abnormal_exit.h"
+#include "mir/compositor/frame_timings.h"
 
 namespace mg = mir::graphics;
 namespace mf = mir::frontend;
@@ -66,10 +68,18 @@ auto mir::DefaultServerConfiguration::the_compositor_report() -> std::shared_ptr
     return compositor_report(
         [this]()->std::shared_ptr<mc::CompositorReport>
         {
-            return report_factory(options::compositor_report_opt)->create_compositor_report();
+            return std::make_shared<report::FrameTimingCompositorReport>(
+                report_factory(options::compositor_report_opt)->create_compositor_report(),
+                the_frame_timings(),
+                the_clock());
         });
 }
 
+auto mir::DefaultServerConfiguration::the_frame_timings() -> std::shared_ptr<mc::FrameTimings>
+{
+    return frame_timings([]{ return std::make_shared<mc::FrameTimings>(); });
+}
+
 auto mir::DefaultServerConfiguration::the_connector_report() -> std::shared_ptr<mf::ConnectorReport>
 {
     return connector_report(
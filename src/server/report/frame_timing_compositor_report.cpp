@@ -0,0 +1,130 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "frame_timing_compositor_report.h"
+
+#include "mir/compositor/frame_timings.h"
+
+namespace mc = mir::compositor;
+namespace mr = mir::report;
+namespace geom = mir::geometry;
+
+using Stage = mc::FrameTimings::Stage;
+
+mr::FrameTimingCompositorReport::FrameTimingCompositorReport(
+    std::shared_ptr<mc::CompositorReport> const& next,
+    std::shared_ptr<mc::FrameTimings> const& timings,
+    std::shared_ptr<time::Clock> const& clock)
+    : next{next},
+      timings{timings},
+      clock{clock}
+{
+}
+
+void mr::FrameTimingCompositorReport::added_display(int width, int height, int x, int y, SubCompositorId id)
+{
+    timings->add_output(id, geom::Rectangle{{x, y}, {width, height}});
+    next->added_display(width, height, x, y, id);
+}
+
+void mr::FrameTimingCompositorReport::began_frame(SubCompositorId id)
+{
+    {
+        auto const now = clock->now();
+        std::lock_guard<std::mutex> lock{mutex};
+        auto& frame = frames[id];
+        frame.scheduled = last_scheduled;
+        frame.began = now;
+        frame.acquired = now;
+    }
+    next->began_frame(id);
+}
+
+void mr::FrameTimingCompositorReport::renderables_in_frame(
+    SubCompositorId id,
+    graphics::RenderableList const& renderables)
+{
+    {
+        auto const now = clock->now();
+        std::lock_guard<std::mutex> lock{mutex};
+        auto& frame = frames[id];
+        frame.acquired = now;
+        timings->record(id, Stage::acquire, now - frame.began);
+    }
+    next->renderables_in_frame(id, renderables);
+}
+
+void mr::FrameTimingCompositorReport::rendered_frame(SubCompositorId id)
+{
+    {
+        auto const now = clock->now();
+        std::lock_guard<std::mutex> lock{mutex};
+        timings->record(id, Stage::render, now - frames[id].acquired);
+    }
+    next->rendered_frame(id);
+}
+
+void mr::FrameTimingCompositorReport::finished_frame(SubCompositorId id)
+{
+    {
+        auto const now = clock->now();
+        std::lock_guard<std::mutex> lock{mutex};
+        frames[id].finished = now;
+    }
+    next->finished_frame(id);
+}
+
+void mr::FrameTimingCompositorReport::presented_frame(SubCompositorId id)
+{
+    {
+        auto const now = clock->now();
+        std::lock_guard<std::mutex> lock{mutex};
+        auto& frame = frames[id];
+        timings->record(id, Stage::present, now - frame.finished);
+
+        // Only the first frame to show a scene change counts; later frames may just be draining queued buffers
+        if (frame.scheduled != time::Timestamp{} && frame.scheduled != frame.presented_scheduled)
+        {
+            timings->record(id, Stage::commit_to_present, now - frame.scheduled);
+            frame.presented_scheduled = frame.scheduled;
+        }
+    }
+    next->presented_frame(id);
+}
+
+void mr::FrameTimingCompositorReport::started()
+{
+    next->started();
+}
+
+void mr::FrameTimingCompositorReport::stopped()
+{
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        frames.clear();
+    }
+    next->stopped();
+}
+
+void mr::FrameTimingCompositorReport::scheduled()
+{
+    {
+        auto const now = clock->now();
+        std::lock_guard<std::mutex> lock{mutex};
+        last_scheduled = now;
+    }
+    next->scheduled();
+}
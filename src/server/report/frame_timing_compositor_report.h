@@ -0,0 +1,75 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_REPORT_FRAME_TIMING_COMPOSITOR_REPORT_H_
+#define MIR_REPORT_FRAME_TIMING_COMPOSITOR_REPORT_H_
+
+#include "mir/compositor/compositor_report.h"
+#include "mir/time/clock.h"
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace mir
+{
+namespace compositor
+{
+class FrameTimings;
+}
+namespace report
+{
+/// Records each frame's stages in FrameTimings, and passes every report on to another compositor report
+class FrameTimingCompositorReport : public compositor::CompositorReport
+{
+public:
+    FrameTimingCompositorReport(
+        std::shared_ptr<compositor::CompositorReport> const& next,
+        std::shared_ptr<compositor::FrameTimings> const& timings,
+        std::shared_ptr<time::Clock> const& clock);
+
+    void added_display(int width, int height, int x, int y, SubCompositorId id) override;
+    void began_frame(SubCompositorId id) override;
+    void renderables_in_frame(SubCompositorId id, graphics::RenderableList const& renderables) override;
+    void rendered_frame(SubCompositorId id) override;
+    void finished_frame(SubCompositorId id) override;
+    void presented_frame(SubCompositorId id) override;
+    void started() override;
+    void stopped() override;
+    void scheduled() override;
+
+private:
+    std::shared_ptr<compositor::CompositorReport> const next;
+    std::shared_ptr<compositor::FrameTimings> const timings;
+    std::shared_ptr<time::Clock> const clock;
+
+    struct Frame
+    {
+        time::Timestamp scheduled;  ///< When the frame was scheduled, as of when it began
+        time::Timestamp began;
+        time::Timestamp acquired;
+        time::Timestamp finished;
+        time::Timestamp presented_scheduled; ///< The scheduling last counted towards commit to present
+    };
+
+    std::mutex mutex; // Protects the following...
+    std::unordered_map<SubCompositorId, Frame> frames;
+    time::Timestamp last_scheduled;
+};
+}
+}
+
+#endif // MIR_REPORT_FRAME_TIMING_COMPOSITOR_REPORT_H_
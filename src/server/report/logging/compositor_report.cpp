@@ -166,6 +166,10 @@ void mrl::CompositorReport::finished_frame(SubCompositorId id)
     inst.prev_bypassed = inst.bypassed;
 }
 
+void mrl::CompositorReport::presented_frame(SubCompositorId)
+{
+}
+
 void mrl::CompositorReport::started()
 {
     logger->log(ml::Severity::informational, "Started", component);
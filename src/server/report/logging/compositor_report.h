@@ -47,6 +47,7 @@ public:
     void renderables_in_frame(SubCompositorId id, graphics::RenderableList const& renderables) override;
     void rendered_frame(SubCompositorId id) override;
     void finished_frame(SubCompositorId id) override;
+    void presented_frame(SubCompositorId id) override;
     void started() override;
     void stopped() override;
     void scheduled() override;
@@ -62,3 +62,8 @@ void mir::report::lttng::CompositorReport::finished_frame(SubCompositorId id)
 {
     mir_tracepoint(mir_server_compositor, finished_frame, id);
 }
+
+void mir::report::lttng::CompositorReport::presented_frame(SubCompositorId id)
+{
+    mir_tracepoint(mir_server_compositor, presented_frame, id);
+}
@@ -80,6 +80,13 @@ TRACEPOINT_EVENT_INSTANCE(
     TP_ARGS(void const*, id)
 )
 
+TRACEPOINT_EVENT_INSTANCE(
+    mir_server_compositor,
+    subcompositor_event,
+    presented_frame,
+    TP_ARGS(void const*, id)
+)
+
 TRACEPOINT_EVENT(
     mir_server_compositor,
     buffers_in_frame,
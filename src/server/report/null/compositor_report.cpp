@@ -40,6 +40,10 @@ void mrn::CompositorReport::finished_frame(SubCompositorId)
 {
 }
 
+void mrn::CompositorReport::presented_frame(SubCompositorId)
+{
+}
+
 void mrn::CompositorReport::started()
 {
 }
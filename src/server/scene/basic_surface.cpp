@@ -26,6 +26,7 @@
 #include "mir/graphics/cursor_image.h"
 #include "mir/graphics/pixel_format_utils.h"
 #include "mir/geometry/displacement.h"
+#include "mir/geometry/rectangles.h"
 #include "mir/renderer/sw/pixel_source.h"
 
 #include "mir/scene/scene_report.h"
@@ -171,6 +172,12 @@ void ms::SurfaceObservers::application_id_set_to(Surface const* surf, std::strin
                  { observer->application_id_set_to(surf, application_id); });
 }
 
+void ms::SurfaceObservers::input_region_set_to(Surface const* surf, std::vector<geometry::Rectangle> const& region)
+{
+    for_each([&](std::shared_ptr<SurfaceObserver> const& observer)
+                 { observer->input_region_set_to(surf, region); });
+}
+
 ms::BasicSurface::ProofOfMutexLock::ProofOfMutexLock(std::unique_lock<std::mutex> const& lock)
 {
     if (!lock.owns_lock())
@@ -366,8 +373,11 @@ std::shared_ptr<mf::BufferStream> ms::BasicSurface::primary_buffer_stream() cons
 
 void ms::BasicSurface::set_input_region(std::vector<geom::Rectangle> const& input_rectangles)
 {
-    std::lock_guard<std::mutex> lock(guard);
-    custom_input_rectangles = input_rectangles;
+    {
+        std::lock_guard<std::mutex> lock(guard);
+        custom_input_rectangles = input_rectangles;
+    }
+    observers->input_region_set_to(this, input_rectangles);
 }
 
 void ms::BasicSurface::resize(geom::Size const& desired_size)
@@ -400,6 +410,23 @@ geom::Rectangle ms::BasicSurface::input_bounds() const
     return geom::Rectangle{content_top_left(lock), content_size(lock)};
 }
 
+geom::Rectangle ms::BasicSurface::input_area_bounds() const
+{
+    std::lock_guard<std::mutex> lock(guard);
+
+    if (custom_input_rectangles.empty())
+        return geom::Rectangle{content_top_left(lock), content_size(lock)};
+
+    geom::Rectangles local_area;
+    for (auto const& rectangle : custom_input_rectangles)
+        local_area.add(rectangle);
+
+    auto const local_bounds = local_area.bounding_rectangle();
+    return geom::Rectangle{
+        content_top_left(lock) + as_displacement(local_bounds.top_left),
+        local_bounds.size};
+}
+
 // TODO: Does not account for transformation().
 bool ms::BasicSurface::input_area_contains(geom::Point const& point) const
 {
@@ -808,6 +835,7 @@ public:
         std::experimental::optional<geom::Rectangle> const& clip_area,
         glm::mat4 const& transform,
         float alpha,
+        std::vector<geom::Rectangle> opaque_region,
         mg::Renderable::ID id)
     : underlying_buffer_stream{stream},
       compositor_id{compositor_id},
@@ -815,6 +843,7 @@ public:
       screen_position_(position),
       clip_area_(clip_area),
       transformation_(transform),
+      opaque_region_(std::move(opaque_region)),
       id_(id)
     {
     }
@@ -850,8 +879,14 @@ public:
     bool shaped() const override
     { return mg::contains_alpha(underlying_buffer_stream->pixel_format()); }
 
+    std::vector<geom::Rectangle> opaque_region() const override
+    { return opaque_region_; }
+
     mg::Renderable::ID id() const override
     { return id_; }
+
+    std::experimental::optional<std::vector<geom::Rectangle>> damage_since(mg::BufferID previous) const override
+    { return underlying_buffer_stream->damage_between(previous, buffer()->id()); }
 private:
     std::shared_ptr<mc::BufferStream> const underlying_buffer_stream;
     std::shared_ptr<mg::Buffer> mutable compositor_buffer;
@@ -860,6 +895,7 @@ private:
     geom::Rectangle const screen_position_;
     std::experimental::optional<geom::Rectangle> const clip_area_;
     glm::mat4 const transformation_;
+    std::vector<geom::Rectangle> const opaque_region_;
     mg::Renderable::ID const id_;
 };
 }
@@ -935,17 +971,29 @@ mg::RenderableList ms::BasicSurface::generate_renderables(mc::CompositorID id) c
     {
         if (info.stream->has_submitted_buffer())
         {
-            geom::Size size;
-            if (info.size.is_set())
-                size = info.size.value();
-            else
-                size = info.stream->stream_size();
+            auto const stream_size = info.stream->stream_size();
+            geom::Rectangle const position{
+                content_top_left_ + info.displacement,
+                info.size.is_set() ? info.size.value() : stream_size};
+
+            // The opaque region doesn't survive the stream being stretched
+            std::vector<geom::Rectangle> opaque_region;
+            if (position.size == stream_size)
+            {
+                for (auto rect : info.stream->opaque_region())
+                {
+                    rect.top_left = position.top_left + as_displacement(rect.top_left);
+                    rect = rect.intersection_with(position);
+                    if (rect.size.width > geom::Width{0} && rect.size.height > geom::Height{0})
+                        opaque_region.push_back(rect);
+                }
+            }
 
             list.emplace_back(std::make_shared<SurfaceSnapshot>(
                 info.stream, id,
-                geom::Rectangle{content_top_left_ + info.displacement, std::move(size)},
+                position,
                 clip_area_,
-                transformation_matrix, surface_alpha, info.stream.get()));
+                transformation_matrix, surface_alpha, std::move(opaque_region), info.stream.get()));
         }
     }
     return list;
@@ -100,6 +100,7 @@ public:
     void resize(geometry::Size const& size) override;
     geometry::Point top_left() const override;
     geometry::Rectangle input_bounds() const override;
+    geometry::Rectangle input_area_bounds() const override;
     bool input_area_contains(geometry::Point const& point) const override;
     void consume(MirEvent const* event) override;
     void set_alpha(float alpha) override;
@@ -21,11 +21,18 @@
 #include "mir/renderer/gl/context.h"
 #include "mir/renderer/gl/texture_source.h"
 
+#include <algorithm>
 #include <stdexcept>
 #include <boost/throw_exception.hpp>
 #include <GLES2/gl2.h>
 #include <GLES2/gl2ext.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 namespace mg = mir::graphics;
 namespace ms = mir::scene;
 namespace geom = mir::geometry;
@@ -47,6 +54,52 @@ inline uint32_t abgr_to_argb(uint32_t p)
            ((p) & 0xff000000);        /* A remains at same position */
 }
 
+/*
+ * Exchanges two lines, converting from abgr_8888 to argb_8888 as it goes.
+ * Both lines are read before either is written, so top and bottom may be
+ * the same (middle) line.
+ */
+void swap_and_convert_lines(uint32_t* top, uint32_t* bottom, uint32_t width)
+{
+    uint32_t n = 0;
+
+#if defined(__SSE2__)
+    auto const green_alpha = _mm_set1_epi32(0xff00ff00);
+    auto const convert = [&](__m128i p)
+        {
+            auto const red_blue = _mm_andnot_si128(green_alpha, p);
+            return _mm_or_si128(
+                _mm_and_si128(p, green_alpha),
+                _mm_or_si128(_mm_slli_epi32(red_blue, 16), _mm_srli_epi32(red_blue, 16)));
+        };
+
+    for (; n + 4 <= width; n += 4)
+    {
+        auto const t = _mm_loadu_si128(reinterpret_cast<__m128i const*>(top + n));
+        auto const b = _mm_loadu_si128(reinterpret_cast<__m128i const*>(bottom + n));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(top + n), convert(b));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(bottom + n), convert(t));
+    }
+#elif defined(__ARM_NEON)
+    for (; n + 16 <= width; n += 16)
+    {
+        auto t = vld4q_u8(reinterpret_cast<uint8_t const*>(top + n));
+        auto b = vld4q_u8(reinterpret_cast<uint8_t const*>(bottom + n));
+        std::swap(t.val[0], t.val[2]);
+        std::swap(b.val[0], b.val[2]);
+        vst4q_u8(reinterpret_cast<uint8_t*>(top + n), b);
+        vst4q_u8(reinterpret_cast<uint8_t*>(bottom + n), t);
+    }
+#endif
+
+    for (; n < width; n++)
+    {
+        auto const t = top[n];
+        top[n] = abgr_to_argb(bottom[n]);
+        bottom[n] = abgr_to_argb(t);
+    }
+}
+
 }
 
 ms::GLPixelBuffer::GLPixelBuffer(std::unique_ptr<renderer::gl::Context> gl_context)
@@ -133,30 +186,20 @@ void const* ms::GLPixelBuffer::as_argb_8888()
 {
     if (pixels_need_y_flip)
     {
-        auto const stride_val = stride().as_uint32_t();
+        auto const width = size_.width.as_uint32_t();
         auto const height = size_.height.as_uint32_t();
+        auto const lines = reinterpret_cast<uint32_t*>(pixels.data());
 
-        std::vector<char> tmp(stride_val);
-
-        for (unsigned int i = 0; i < height / 2; i++)
+        /* Flip (and, if needed, convert) in place, a pair of lines at a time */
+        for (unsigned int i = 0; i < (height + 1) / 2; i++)
         {
-            /* Store line i */
-            tmp.assign(&pixels[i * stride_val], &pixels[(i + 1) * stride_val]);
-
-            /* Copy line height - i - 1 to line i */
-            copy_and_convert_pixel_line(&pixels[(height - i - 1) * stride_val],
-                                        &pixels[i * stride_val]);
-
-            /* Copy stored line (i) to height - i - 1 */
-            copy_and_convert_pixel_line(tmp.data(),
-                                        &pixels[(height - i - 1) * stride_val]);
-        }
+            auto const top = lines + i * width;
+            auto const bottom = lines + (height - i - 1) * width;
 
-        /* Process middle line if there is one */
-        if (height % 2 == 1)
-        {
-            copy_and_convert_pixel_line(&pixels[(height / 2) * stride_val],
-                                        &pixels[(height / 2) * stride_val]);
+            if (gl_pixel_format == GL_RGBA)
+                swap_and_convert_lines(top, bottom, width);
+            else
+                std::swap_ranges(top, top + width, bottom);
         }
 
         pixels_need_y_flip = false;
@@ -174,21 +217,3 @@ geom::Stride ms::GLPixelBuffer::stride() const
 {
     return geom::Stride{size_.width.as_uint32_t() * sizeof(uint32_t)};
 }
-
-void ms::GLPixelBuffer::copy_and_convert_pixel_line(char* src, char* dst)
-{
-    if (gl_pixel_format == GL_RGBA)
-    {
-        /* Convert from abgr_8888 to argb_8888 while copying */
-        auto pixels_src = reinterpret_cast<uint32_t*>(src);
-        auto pixels_dst = reinterpret_cast<uint32_t*>(dst);
-        auto const width = size_.width.as_uint32_t();
-
-        for (uint32_t n = 0; n < width; n++)
-            pixels_dst[n] = abgr_to_argb(pixels_src[n]);
-    }
-    else if (src != dst)
-    {
-        std::copy(src, src + stride().as_uint32_t(), dst);
-    }
-}
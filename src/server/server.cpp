@@ -112,6 +112,8 @@ struct TemporaryCompositeEventFilter : public mi::CompositeEventFilter
     MACRO(the_buffer_stream_factory)\
     MACRO(the_compositor)\
     MACRO(the_compositor_report)\
+    MACRO(the_frame_timings)\
+    MACRO(the_screencast)\
     MACRO(the_cursor_listener)\
     MACRO(the_cursor)\
     MACRO(the_display)\
@@ -133,6 +135,7 @@ struct TemporaryCompositeEventFilter : public mi::CompositeEventFilter
     MACRO(the_surface_stack)\
     MACRO(the_touch_visualizer)\
     MACRO(the_input_device_hub)\
+    MACRO(the_input_latencies)\
     MACRO(the_application_not_responding_detector)\
     MACRO(the_persistent_surface_store)\
     MACRO(the_display_configuration_observer_registrar)\
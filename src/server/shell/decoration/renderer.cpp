@@ -31,8 +31,10 @@
 #include <ft2build.h>
 #include FT_FREETYPE_H
 
+#include <algorithm>
 #include <locale>
 #include <codecvt>
+#include <unordered_map>
 
 namespace ms = mir::scene;
 namespace mg = mir::graphics;
@@ -88,6 +90,12 @@ char const* const font_path_search_paths[]{
     "/usr/share/fonts",             // Fedora/Arch
 };
 
+// Titles share most of their glyphs, so this is plenty for every window and a few font sizes
+size_t const max_cached_glyphs = 1024;
+
+// A titlebar buffer for each theme and hover state the titlebar goes through
+size_t const max_cached_titlebars = 8;
+
 inline auto area(geom::Size size) -> size_t
 {
     return (size.width > geom::Width{} && size.height > geom::Height{})
@@ -106,10 +114,10 @@ inline void render_row(
         return;
     geom::X const right = std::min(left.x + as_delta(length), as_x(buf_size.width));
     left.x = std::max(left.x, geom::X{});
+    if (right <= left.x)
+        return;
     uint32_t* const start = data + (left.y.as_int() * buf_size.width.as_int()) + left.x.as_int();
-    uint32_t* const end = start + right.as_int() - left.x.as_int();
-    for (uint32_t* i = start; i < end; i++)
-        *i = color;
+    std::fill_n(start, right.as_int() - left.x.as_int(), color);
 }
 
 inline void render_close_icon(
@@ -185,16 +193,29 @@ public:
         Pixel color) override;
 
 private:
+    /// A glyph as rasterized by FreeType, kept so redrawing a title doesn't rasterize it again
+    struct Glyph
+    {
+        geom::Displacement offset;  ///< From the top left of the line to the top left of the bitmap
+        geom::Displacement advance;
+        geom::Size size;
+        std::vector<unsigned char> coverage; ///< One byte per pixel, rows packed together
+    };
+
     std::mutex mutex;
     FT_Library library;
     FT_Face face;
+    geom::Height char_size{};
+    /// Keyed by pixel height and codepoint (there is only ever the one face)
+    std::unordered_map<uint64_t, Glyph> glyph_cache;
 
+    auto glyph(char32_t codepoint, geom::Height height) -> Glyph const&;
     void set_char_size(geom::Height height);
     void rasterize_glyph(char32_t glyph);
     void render_glyph(
         Pixel* buf,
         geom::Size buf_size,
-        FT_Bitmap const* glyph,
+        Glyph const& glyph,
         geom::Point top_left,
         Pixel color);
 
@@ -290,34 +311,15 @@ void msd::Renderer::Text::Impl::render(
         return;
     }
 
-    try
-    {
-        set_char_size(height_pixels);
-    }
-    catch (std::runtime_error const& error)
-    {
-        log_warning("%s", error.what());
-        return;
-    }
-
     auto const utf32 = utf8_to_utf32(text);
 
-    for (char32_t const glyph : utf32)
+    for (char32_t const codepoint : utf32)
     {
         try
         {
-            rasterize_glyph(glyph);
-
-            geom::Point glyph_top_left =
-                top_left +
-                geom::Displacement{
-                    face->glyph->bitmap_left,
-                    height_pixels.as_int() - face->glyph->bitmap_top};
-            render_glyph(buf, buf_size, &face->glyph->bitmap, glyph_top_left, color);
-
-            top_left += geom::Displacement{
-                face->glyph->advance.x / 64,
-                face->glyph->advance.y / 64};
+            auto const& glyph = this->glyph(codepoint, height_pixels);
+            render_glyph(buf, buf_size, glyph, top_left + glyph.offset, color);
+            top_left += glyph.advance;
         }
         catch (std::runtime_error const& error)
         {
@@ -326,11 +328,49 @@ void msd::Renderer::Text::Impl::render(
     }
 }
 
+auto msd::Renderer::Text::Impl::glyph(char32_t codepoint, geom::Height height) -> Glyph const&
+{
+    auto const key = (uint64_t{static_cast<uint32_t>(height.as_int())} << 32) | codepoint;
+
+    auto const cached = glyph_cache.find(key);
+    if (cached != glyph_cache.end())
+        return cached->second;
+
+    set_char_size(height);
+    rasterize_glyph(codepoint);
+
+    auto const& slot = *face->glyph;
+    Glyph glyph{
+        {slot.bitmap_left, height.as_int() - slot.bitmap_top},
+        {slot.advance.x / 64, slot.advance.y / 64},
+        {static_cast<int>(slot.bitmap.width), static_cast<int>(slot.bitmap.rows)},
+        {}};
+
+    glyph.coverage.resize(area(glyph.size));
+    for (unsigned row = 0; row < slot.bitmap.rows; row++)
+    {
+        std::copy_n(
+            slot.bitmap.buffer + row * slot.bitmap.pitch,
+            slot.bitmap.width,
+            glyph.coverage.begin() + row * slot.bitmap.width);
+    }
+
+    if (glyph_cache.size() >= max_cached_glyphs)
+        glyph_cache.clear();
+
+    return glyph_cache.emplace(key, std::move(glyph)).first->second;
+}
+
 void msd::Renderer::Text::Impl::set_char_size(geom::Height height)
 {
+    if (height == char_size)
+        return;
+
     if (auto const error = FT_Set_Pixel_Sizes(face, 0, height.as_int()))
         BOOST_THROW_EXCEPTION(std::runtime_error(
             "Setting char size failed with error " + std::to_string(error)));
+
+    char_size = height;
 }
 
 void msd::Renderer::Text::Impl::rasterize_glyph(char32_t glyph)
@@ -349,39 +389,33 @@ void msd::Renderer::Text::Impl::rasterize_glyph(char32_t glyph)
 void msd::Renderer::Text::Impl::render_glyph(
     Pixel* buf,
     geom::Size buf_size,
-    FT_Bitmap const* glyph,
+    Glyph const& glyph,
     geom::Point top_left,
     Pixel color)
 {
-    geom::X const buffer_left = std::max(top_left.x, geom::X{});
-    geom::X const buffer_right = std::min(top_left.x + geom::DeltaX{glyph->width}, as_x(buf_size.width));
-
-    geom::Y const buffer_top = std::max(top_left.y, geom::Y{});
-    geom::Y const buffer_bottom = std::min(top_left.y + geom::DeltaY{glyph->rows}, as_y(buf_size.height));
-
-    geom::Displacement const glyph_offset = as_displacement(top_left);
+    int const left = std::max(top_left.x.as_int(), 0);
+    int const right = std::min(top_left.x.as_int() + glyph.size.width.as_int(), buf_size.width.as_int());
+    int const top = std::max(top_left.y.as_int(), 0);
+    int const bottom = std::min(top_left.y.as_int() + glyph.size.height.as_int(), buf_size.height.as_int());
 
-    unsigned char* const color_pixels = (unsigned char *)&color;
-    unsigned char const color_alpha = color_pixels[3];
+    unsigned const color_alpha = color >> 24;
 
-    for (geom::Y buffer_y = buffer_top; buffer_y < buffer_bottom; buffer_y += geom::DeltaY{1})
+    for (int y = top; y < bottom; y++)
     {
-        geom::Y const glyph_y = buffer_y - glyph_offset.dy;
-        unsigned char* const glyph_row = glyph->buffer + glyph_y.as_int() * glyph->pitch;
-        Pixel* const buffer_row = buf + buffer_y.as_int() * buf_size.width.as_int();
+        unsigned char const* const glyph_row =
+            glyph.coverage.data() + (y - top_left.y.as_int()) * glyph.size.width.as_int();
+        Pixel* const buffer_row = buf + y * buf_size.width.as_int();
 
-        for (geom::X buffer_x = buffer_left; buffer_x < buffer_right; buffer_x += geom::DeltaX{1})
+        for (int x = left; x < right; x++)
         {
-            geom::X const glyph_x = buffer_x - glyph_offset.dx;
-            unsigned char const glyph_alpha = ((int)glyph_row[glyph_x.as_int()] * color_alpha) / 255;
-            unsigned char* const buffer_pixels = (unsigned char *)(buffer_row + buffer_x.as_int());
-            for (int i = 0; i < 3; i++)
-            {
-                // Blend color with the previous buffer color based on the glyph's alpha
-                buffer_pixels[i] =
-                    ((int)buffer_pixels[i] * (255 - glyph_alpha)) / 255 +
-                    ((int)color_pixels[i] * glyph_alpha) / 255;
-            }
+            // Most of a glyph's bitmap is either empty or solid, which needs no blending
+            unsigned const glyph_alpha = (glyph_row[x - top_left.x.as_int()] * color_alpha) / 255;
+            if (glyph_alpha == 0)
+                continue;
+            else if (glyph_alpha == 255)
+                buffer_row[x] = (buffer_row[x] & 0xFF000000) | (color & 0x00FFFFFF);
+            else
+                buffer_row[x] = blend(buffer_row[x], color, glyph_alpha);
         }
     }
 }
@@ -486,7 +520,8 @@ void msd::Renderer::update_state(WindowState const& window_state, InputState con
     if (window_state.titlebar_rect().size != titlebar_size)
     {
         titlebar_size = window_state.titlebar_rect().size;
-        titlebar_pixels.reset(); // force a reallocation next time it's needed
+        needs_titlebar_redraw = true;
+        cached_titlebars.clear();
     }
 
     Theme const* const new_theme = (window_state.focused_state() == mir_window_focus_state_focused) ?
@@ -495,8 +530,8 @@ void msd::Renderer::update_state(WindowState const& window_state, InputState con
 
     if (new_theme != current_theme)
     {
+        // The titlebar is redrawn if the pixels were last drawn with another theme (see render_titlebar())
         current_theme = new_theme;
-        needs_titlebar_redraw = true;
         needs_solid_color_redraw = true;
     }
 
@@ -504,6 +539,7 @@ void msd::Renderer::update_state(WindowState const& window_state, InputState con
     {
         name = window_state.window_name();
         needs_titlebar_redraw = true;
+        cached_titlebars.clear();
     }
 
     if (input_state.buttons() != buttons)
@@ -522,6 +558,8 @@ void msd::Renderer::update_state(WindowState const& window_state, InputState con
                     needs_titlebar_redraw = true;
             }
         }
+        if (needs_titlebar_redraw)
+            cached_titlebars.clear();
         buttons = input_state.buttons();
         needs_titlebar_buttons_redraw = true;
     }
@@ -532,24 +570,30 @@ auto msd::Renderer::render_titlebar() -> std::experimental::optional<std::shared
     if (!area(titlebar_size))
         return std::experimental::nullopt;
 
-    if (!titlebar_pixels)
+    for (auto cached = cached_titlebars.begin(); cached != cached_titlebars.end(); ++cached)
     {
-        titlebar_pixels = alloc_pixels(titlebar_size);
+        if (cached->theme == current_theme && cached->buttons == buttons)
+        {
+            std::rotate(cached_titlebars.begin(), cached, std::next(cached));
+            return cached_titlebars.front().buffer;
+        }
+    }
+
+    if (titlebar_pixels.size() < area(titlebar_size))
+        titlebar_pixels.resize(area(titlebar_size));
+
+    if (titlebar_pixels_theme != current_theme)
+    {
+        titlebar_pixels_theme = current_theme;
         needs_titlebar_redraw = true;
     }
 
     if (needs_titlebar_redraw)
     {
-        for (geom::Y y{0}; y < as_y(titlebar_size.height); y += geom::DeltaY{1})
-        {
-            render_row(
-                titlebar_pixels.get(), titlebar_size,
-                {0, y}, titlebar_size.width,
-                current_theme->background_color);
-        }
+        std::fill_n(titlebar_pixels.begin(), area(titlebar_size), current_theme->background_color);
 
         text->render(
-            titlebar_pixels.get(),
+            titlebar_pixels.data(),
             titlebar_size,
             name,
             static_geometry->title_font_top_left,
@@ -570,7 +614,7 @@ auto msd::Renderer::render_titlebar() -> std::experimental::optional<std::shared
                 for (geom::Y y{button.rect.top()}; y < button.rect.bottom(); y += geom::DeltaY{1})
                 {
                     render_row(
-                        titlebar_pixels.get(),
+                        titlebar_pixels.data(),
                         titlebar_size,
                         {button.rect.left(), y},
                         button.rect.size.width,
@@ -581,7 +625,7 @@ auto msd::Renderer::render_titlebar() -> std::experimental::optional<std::shared
                     button.rect.size.width - static_geometry->icon_padding.dx * 2,
                     button.rect.size.height - static_geometry->icon_padding.dy * 2}};
                 icon->second.render_icon(
-                    titlebar_pixels.get(),
+                    titlebar_pixels.data(),
                     titlebar_size,
                     icon_rect,
                     static_geometry->icon_line_width,
@@ -597,7 +641,14 @@ auto msd::Renderer::render_titlebar() -> std::experimental::optional<std::shared
     needs_titlebar_redraw = false;
     needs_titlebar_buttons_redraw = false;
 
-    return make_buffer(titlebar_pixels.get(), titlebar_size);
+    auto const buffer = make_buffer(titlebar_pixels.data(), titlebar_size);
+    if (buffer)
+    {
+        if (cached_titlebars.size() >= max_cached_titlebars)
+            cached_titlebars.pop_back();
+        cached_titlebars.insert(cached_titlebars.begin(), {current_theme, buttons, buffer.value()});
+    }
+    return buffer;
 }
 
 auto msd::Renderer::render_left_border() -> std::experimental::optional<std::shared_ptr<mg::Buffer>>
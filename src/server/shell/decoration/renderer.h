@@ -25,6 +25,7 @@
 
 #include <memory>
 #include <map>
+#include <vector>
 
 namespace mir
 {
@@ -44,6 +45,21 @@ struct StaticGeometry;
 auto const buffer_format = mir_pixel_format_argb_8888;
 auto const bytes_per_pixel = 4;
 
+/// Blends color over dest with the given alpha (0-255), keeping dest's own alpha
+inline auto blend(uint32_t dest, uint32_t color, unsigned alpha) -> uint32_t
+{
+    // Red and blue are blended together in one word and green in another, each channel in a 16 bit lane that
+    // holds its products. x / 255 == (x + 1 + (x >> 8)) >> 8 for the lanes' range, so the result is exact.
+    auto const divide_by_255 = [](uint32_t x)
+        {
+            return ((x + 0x00010001 + ((x >> 8) & 0x00FF00FF)) >> 8) & 0x00FF00FF;
+        };
+    unsigned const inverse = 255 - alpha;
+    uint32_t const rb = (dest & 0x00FF00FF) * inverse + (color & 0x00FF00FF) * alpha;
+    uint32_t const g = ((dest >> 8) & 0xFF) * inverse + ((color >> 8) & 0xFF) * alpha;
+    return (dest & 0xFF000000) | divide_by_255(rb) | (divide_by_255(g) << 8);
+}
+
 class Renderer
 {
 public:
@@ -120,7 +136,18 @@ private:
     std::unique_ptr<Pixel[]> solid_color_pixels; // can be nullptr
 
     geometry::Size titlebar_size{};
-    std::unique_ptr<Pixel[]> titlebar_pixels; // can be nullptr
+    std::vector<Pixel> titlebar_pixels; ///< Only grows, so resizing the window doesn't reallocate it
+    Theme const* titlebar_pixels_theme{nullptr}; ///< The theme titlebar_pixels was last drawn with
+
+    /// A titlebar buffer drawn earlier, which can be reused while the size and title stay the same
+    struct CachedTitlebar
+    {
+        Theme const* theme;
+        std::vector<ButtonInfo> buttons;
+        std::shared_ptr<graphics::Buffer> buffer;
+    };
+    /// Most recently drawn first, so focus and hover changes back and forth don't redraw
+    std::vector<CachedTitlebar> cached_titlebars;
 
     bool needs_titlebar_redraw{true};
     bool needs_titlebar_buttons_redraw{true};
@@ -17,11 +17,13 @@
  */
 
 #include "mir/thread/basic_thread_pool.h"
+#include "mir/thread/mpsc_queue.h"
 #include "mir/terminate_with_current_exception.h"
 
-#include <deque>
 #include <algorithm>
+#include <atomic>
 #include <condition_variable>
+#include <thread>
 
 namespace mt = mir::thread;
 
@@ -64,6 +66,10 @@ private:
     std::exception_ptr task_exception;
 };
 
+/*
+ * Tasks are queued without taking a lock; the mutex and condition variable are
+ * only used to put the worker to sleep when it runs out of tasks, and to wake it.
+ */
 class Worker
 {
 public:
@@ -79,20 +85,12 @@ public:
     void operator()() noexcept
     try
     {
-       std::unique_lock<std::mutex> lock{state_mutex};
-       while (!exiting)
+       while (wait_for_task())
        {
-           task_available_cv.wait(lock, [&]{ return exiting || !tasks.empty(); });
-
-           if (!exiting)
-           {
-               auto task = std::move(tasks.front());
-               lock.unlock();
-               task.execute();
-               lock.lock();
-               tasks.pop_front();
-               task.notify_done();
-           }
+           auto task = pop_task();
+           task->execute();
+           pending.fetch_sub(1);
+           task->notify_done();
        }
     }
     catch(...)
@@ -102,28 +100,68 @@ public:
 
     void queue_task(Task task)
     {
-        std::lock_guard<std::mutex> lock{state_mutex};
-        tasks.push_back(std::move(task));
-        task_available_cv.notify_one();
+        tasks.push(std::move(task));
+        pending.fetch_add(1);
+        wake();
     }
 
     void exit()
     {
-        std::lock_guard<std::mutex> lock{state_mutex};
         exiting = true;
-        task_available_cv.notify_one();
+        wake();
     }
 
     bool is_idle() const
     {
-        std::lock_guard<std::mutex> lock{state_mutex};
-        return tasks.empty();
+        return pending == 0;
     }
 
 private:
-    std::deque<Task> tasks;
-    bool exiting;
-    std::mutex mutable state_mutex;
+    /// Returns false once the worker should exit
+    bool wait_for_task()
+    {
+        if (pending > 0 && !exiting)
+            return true;
+
+        std::unique_lock<std::mutex> lock{state_mutex};
+        sleeping = true;
+        // sleeping is set before pending is checked, and wake() sets pending (or exiting) before checking
+        // sleeping, so one of us always sees the other (both are sequentially consistent)
+        task_available_cv.wait(lock, [&]{ return exiting || pending > 0; });
+        sleeping = false;
+        return !exiting;
+    }
+
+    /**
+     * Pops a counted task
+     *
+     * The counted task has been fully pushed, but a push racing with it may not have linked its node into
+     * the queue yet, leaving everything behind that node out of reach until it does.
+     */
+    auto pop_task() -> std::experimental::optional<Task>
+    {
+        for (;;)
+        {
+            if (auto task = tasks.pop())
+                return task;
+            std::this_thread::yield();
+        }
+    }
+
+    void wake()
+    {
+        if (sleeping)
+        {
+            std::lock_guard<std::mutex> lock{state_mutex};
+            task_available_cv.notify_one();
+        }
+    }
+
+    mir::thread::MpscQueue<Task> tasks;
+    std::atomic<int> pending{0};    ///< Tasks queued or being executed
+    std::atomic<bool> exiting;
+    std::atomic<bool> sleeping{false};
+    std::mutex state_mutex;
     std::condition_variable task_available_cv;
 };
 
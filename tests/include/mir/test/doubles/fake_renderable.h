@@ -80,6 +80,16 @@ public:
         return !rectangular;
     }
 
+    std::vector<geometry::Rectangle> opaque_region() const override
+    {
+        return opaque;
+    }
+
+    void set_opaque_region(std::vector<geometry::Rectangle> const& region)
+    {
+        opaque = region;
+    }
+
     void set_buffer(std::shared_ptr<graphics::Buffer> b)
     {
         buf = b;
@@ -105,11 +115,17 @@ public:
         return 1u;
     }
 
+    std::experimental::optional<std::vector<geometry::Rectangle>> damage_since(graphics::BufferID) const override
+    {
+        return {};
+    }
+
 private:
     std::shared_ptr<graphics::Buffer> buf;
     mir::geometry::Rectangle rect;
     float opacity;
     bool rectangular;
+    std::vector<geometry::Rectangle> opaque;
 };
 
 } // namespace doubles
@@ -72,6 +72,11 @@ struct MockBufferStream : public compositor::BufferStream
     MOCK_METHOD0(drop_client_requests, void());
 
     MOCK_METHOD1(submit_buffer, void(std::shared_ptr<graphics::Buffer> const&));
+    MOCK_METHOD2(submit_buffer, void(std::shared_ptr<graphics::Buffer> const&, std::vector<geometry::Rectangle> const&));
+    MOCK_CONST_METHOD2(damage_between,
+                       std::experimental::optional<std::vector<geometry::Rectangle>>(graphics::BufferID, graphics::BufferID));
+    MOCK_METHOD1(set_opaque_region, void(std::vector<geometry::Rectangle> const&));
+    MOCK_CONST_METHOD0(opaque_region, std::vector<geometry::Rectangle>());
     MOCK_METHOD1(with_most_recent_buffer_do, void(std::function<void(graphics::Buffer&)> const&));
     MOCK_CONST_METHOD0(pixel_format, MirPixelFormat());
     MOCK_CONST_METHOD0(has_submitted_buffer, bool());
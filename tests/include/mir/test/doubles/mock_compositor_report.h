@@ -43,6 +43,8 @@ public:
                  void(compositor::CompositorReport::SubCompositorId));
     MOCK_METHOD1(finished_frame,
                  void(compositor::CompositorReport::SubCompositorId));
+    MOCK_METHOD1(presented_frame,
+                 void(compositor::CompositorReport::SubCompositorId));
     MOCK_METHOD0(started, void());
     MOCK_METHOD0(stopped, void());
     MOCK_METHOD0(scheduled, void());
@@ -55,7 +55,9 @@ struct MockRenderable : public graphics::Renderable
     MOCK_CONST_METHOD0(transformation, glm::mat4());
     MOCK_CONST_METHOD0(visible, bool());
     MOCK_CONST_METHOD0(shaped, bool());
+    MOCK_CONST_METHOD0(opaque_region, std::vector<geometry::Rectangle>());
     MOCK_CONST_METHOD0(swap_interval, unsigned int());
+    MOCK_CONST_METHOD1(damage_since, std::experimental::optional<std::vector<geometry::Rectangle>>(graphics::BufferID));
 };
 }
 }
@@ -65,6 +65,23 @@ public:
     {
         if (b) ++nready;
     }
+    void submit_buffer(std::shared_ptr<graphics::Buffer> const& b, std::vector<geometry::Rectangle> const&) override
+    {
+        submit_buffer(b);
+    }
+    std::experimental::optional<std::vector<geometry::Rectangle>>
+        damage_between(graphics::BufferID, graphics::BufferID) const override
+    {
+        return {};
+    }
+    void set_opaque_region(std::vector<geometry::Rectangle> const& region) override
+    {
+        opaque_region_ = region;
+    }
+    std::vector<geometry::Rectangle> opaque_region() const override
+    {
+        return opaque_region_;
+    }
     void with_most_recent_buffer_do(std::function<void(graphics::Buffer&)> const& fn) override
     {
         fn(*stub_compositor_buffer);
@@ -76,6 +93,7 @@ public:
 
     std::shared_ptr<graphics::Buffer> stub_compositor_buffer;
     int nready = 0;
+    std::vector<geometry::Rectangle> opaque_region_;
 };
 
 }
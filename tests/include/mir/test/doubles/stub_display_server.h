@@ -138,6 +138,10 @@ struct StubDisplayServer : public mir::frontend::detail::DisplayServer
         mir::protobuf::SurfaceId const* /*request*/,
         mir::protobuf::PersistentSurfaceId* /*response*/,
         google::protobuf::Closure* /*done*/) override {}
+    void request_input_ring(
+        mir::protobuf::SurfaceId const* /*request*/,
+        mir::protobuf::SocketFD* /*response*/,
+        google::protobuf::Closure* /*done*/) override {}
     void pong(
         mir::protobuf::PingEvent const* /*request*/,
         mir::protobuf::Void* /*response*/,
@@ -90,10 +90,18 @@ public:
     {
         return false;
     }
+    std::vector<geometry::Rectangle> opaque_region() const override
+    {
+        return {};
+    }
     unsigned int swap_interval() const override
     {
         return 1;
     }
+    std::experimental::optional<std::vector<geometry::Rectangle>> damage_since(graphics::BufferID) const override
+    {
+        return {};
+    }
 
 private:
     std::shared_ptr<graphics::Buffer> make_stub_buffer(geometry::Rectangle const& rect)
@@ -0,0 +1,345 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/server.h"
+#include "mir/frontend/screencast.h"
+#include "mir/graphics/buffer_basic.h"
+#include "mir/graphics/dmabuf_buffer.h"
+#include "mir/graphics/egl_extensions.h"
+#include "mir/graphics/texture.h"
+#include "mir/fd.h"
+
+#include "mir_test_framework/temporary_environment_value.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <gbm.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <algorithm>
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace mf = mir::frontend;
+namespace mg = mir::graphics;
+namespace geom = mir::geometry;
+namespace mtf = mir_test_framework;
+
+using namespace std::chrono_literals;
+using namespace testing;
+
+/*
+ * These tests need a real EGL platform, and a render node to allocate dmabufs
+ * on. Where there is neither (as on most build machines) they are skipped.
+ */
+
+namespace
+{
+/// A linear dmabuf on a render node, which the test can also read and write
+class LinearDMABuf
+{
+public:
+    LinearDMABuf(gbm_device* device, geom::Size size)
+        : size{size},
+          bo{gbm_bo_create(
+              device,
+              size.width.as_uint32_t(), size.height.as_uint32_t(),
+              GBM_FORMAT_ARGB8888,
+              GBM_BO_USE_RENDERING | GBM_BO_USE_LINEAR)}
+    {
+        if (!bo)
+            BOOST_THROW_EXCEPTION(std::runtime_error("Failed to allocate a linear dmabuf"));
+    }
+
+    ~LinearDMABuf()
+    {
+        gbm_bo_destroy(bo);
+    }
+
+    auto export_fd() const -> mir::Fd
+    {
+        return mir::Fd{gbm_bo_get_fd(bo)};
+    }
+
+    auto stride() const -> uint32_t
+    {
+        return gbm_bo_get_stride(bo);
+    }
+
+    void fill(uint32_t pixel)
+    {
+        with_mapping(
+            GBM_BO_TRANSFER_WRITE,
+            [&](char* row)
+            {
+                auto const pixels = reinterpret_cast<uint32_t*>(row);
+                std::fill(pixels, pixels + size.width.as_int(), pixel);
+            });
+    }
+
+    auto pixels() -> std::vector<uint32_t>
+    {
+        std::vector<uint32_t> result;
+        with_mapping(
+            GBM_BO_TRANSFER_READ,
+            [&](char* row)
+            {
+                auto const pixels = reinterpret_cast<uint32_t*>(row);
+                result.insert(result.end(), pixels, pixels + size.width.as_int());
+            });
+        return result;
+    }
+
+    geom::Size const size;
+
+private:
+    template<typename RowFunction>
+    void with_mapping(uint32_t flags, RowFunction const& per_row)
+    {
+        uint32_t stride{0};
+        void* map_data{nullptr};
+        auto const mapped = static_cast<char*>(gbm_bo_map(
+            bo, 0, 0, size.width.as_uint32_t(), size.height.as_uint32_t(), flags, &stride, &map_data));
+        if (!mapped)
+            BOOST_THROW_EXCEPTION(std::runtime_error("Failed to map dmabuf"));
+
+        for (int y = 0; y != size.height.as_int(); ++y)
+            per_row(mapped + y * stride);
+
+        gbm_bo_unmap(bo, map_data);
+    }
+
+    gbm_bo* const bo;
+};
+
+/// What a client's linux-dmabuf buffer looks like to the screencast: imported into EGL when first bound
+class ImportedDMABuf : public mg::BufferBasic, public mg::DMABufBuffer, public mg::gl::Texture
+{
+public:
+    ImportedDMABuf(LinearDMABuf const& dmabuf)
+        : size_{dmabuf.size},
+          planes_{{dmabuf.export_fd(), dmabuf.stride(), 0}}
+    {
+    }
+
+    ~ImportedDMABuf()
+    {
+        // The texture goes with the server's GL context; the image can go now
+        if (image != EGL_NO_IMAGE_KHR)
+            extensions.base(dpy).eglDestroyImageKHR(dpy, image);
+    }
+
+    std::shared_ptr<mg::NativeBuffer> native_buffer_handle() const override { return nullptr; }
+    auto size() const -> geom::Size override { return size_; }
+    MirPixelFormat pixel_format() const override { return mir_pixel_format_argb_8888; }
+    mg::NativeBufferBase* native_buffer_base() override { return this; }
+
+    auto drm_fourcc() const -> uint32_t override { return GBM_FORMAT_ARGB8888; }
+    auto modifier() const -> std::optional<uint64_t> override { return {}; }
+    auto planes() const -> std::vector<PlaneDescriptor> const& override { return planes_; }
+
+    mg::gl::Program const& shader(mg::gl::ProgramFactory&) const override
+    {
+        BOOST_THROW_EXCEPTION(std::logic_error("Screencasts shouldn't sample their own buffers"));
+    }
+    Layout layout() const override { return Layout::GL; }
+
+    void bind() override
+    {
+        if (!texture)
+        {
+            dpy = eglGetCurrentDisplay();
+
+            EGLint const attribs[] = {
+                EGL_WIDTH, size_.width.as_int(),
+                EGL_HEIGHT, size_.height.as_int(),
+                EGL_LINUX_DRM_FOURCC_EXT, static_cast<EGLint>(drm_fourcc()),
+                EGL_DMA_BUF_PLANE0_FD_EXT, planes_[0].dma_buf,
+                EGL_DMA_BUF_PLANE0_OFFSET_EXT, static_cast<EGLint>(planes_[0].offset),
+                EGL_DMA_BUF_PLANE0_PITCH_EXT, static_cast<EGLint>(planes_[0].stride),
+                EGL_NONE};
+
+            image = extensions.base(dpy).eglCreateImageKHR(
+                dpy, EGL_NO_CONTEXT, EGL_LINUX_DMA_BUF_EXT, nullptr, attribs);
+            if (image == EGL_NO_IMAGE_KHR)
+                BOOST_THROW_EXCEPTION(std::runtime_error("Failed to import dmabuf"));
+
+            glGenTextures(1, &texture);
+            glBindTexture(GL_TEXTURE_2D, texture);
+            extensions.base(dpy).glEGLImageTargetTexture2DOES(GL_TEXTURE_2D, image);
+            return;
+        }
+
+        glBindTexture(GL_TEXTURE_2D, texture);
+    }
+
+    void add_syncpoint() override {}
+
+private:
+    geom::Size const size_;
+    std::vector<PlaneDescriptor> const planes_;
+
+    mg::EGLExtensions const extensions;
+    EGLDisplay dpy{EGL_NO_DISPLAY};
+    EGLImageKHR image{EGL_NO_IMAGE_KHR};
+    GLuint texture{0};
+};
+
+/// The first render node we can open, if any
+auto open_render_node() -> mir::Fd
+{
+    for (int minor = 128; minor != 192; ++minor)
+    {
+        auto const path = "/dev/dri/renderD" + std::to_string(minor);
+        mir::Fd fd{open(path.c_str(), O_RDWR | O_CLOEXEC)};
+        if (fd != mir::Fd::invalid)
+            return fd;
+    }
+    return mir::Fd{};
+}
+
+struct OffscreenScreencast : Test
+{
+    void SetUp() override
+    {
+        render_node = open_render_node();
+        if (render_node != mir::Fd::invalid)
+            device = gbm_create_device(render_node);
+        if (!device)
+            GTEST_SKIP() << "No render node to allocate dmabufs on";
+
+        server.set_command_line(server_args.size(), server_args.data());
+        server.add_init_callback([this] { started.set_value(true); });
+        server.apply_settings();
+
+        auto is_running = started.get_future();
+        server_thread = std::thread{[this]
+            {
+                server.run();
+                try
+                {
+                    // The server stopped before initialising, so no platform could run it offscreen
+                    started.set_value(false);
+                }
+                catch (std::future_error const&)
+                {
+                }
+            }};
+
+        if (is_running.wait_for(30s) != std::future_status::ready || !is_running.get())
+            GTEST_SKIP() << "No graphics platform could run the server with --offscreen";
+    }
+
+    void TearDown() override
+    {
+        if (server_thread.joinable())
+        {
+            server.stop();
+            server_thread.join();
+        }
+
+        if (device)
+            gbm_device_destroy(device);
+    }
+
+    auto create_session() -> mf::ScreencastSessionId
+    {
+        return server.the_screencast()->create_session(
+            region, size, mir_pixel_format_argb_8888, 2, mir_mirror_mode_none);
+    }
+
+    // Away from where the cursor would be, so there's nothing on screen there
+    geom::Rectangle const region{{960, 736}, {64, 32}};
+    geom::Size const size{64, 32};
+
+    /// What the renderer clears to, where no surface is drawn
+    uint32_t const cleared{0x00000000};
+    uint32_t const untouched{0xff00ff00};
+
+    mir::Fd render_node;
+    gbm_device* device{nullptr};
+
+    // So the server neither nests in a Wayland session running the tests nor takes its socket
+    mtf::TemporaryEnvironmentValue const wayland_display{"WAYLAND_DISPLAY", nullptr};
+
+    std::vector<char const*> server_args{"mir_integration_tests", "--offscreen", "--no-file"};
+    mir::Server server;
+    std::promise<bool> started;
+    std::thread server_thread;
+};
+}
+
+TEST_F(OffscreenScreencast, captures_into_imported_dmabuf)
+{
+    auto const screencast = server.the_screencast();
+    auto const session = create_session();
+
+    LinearDMABuf dmabuf{device, size};
+    dmabuf.fill(untouched);
+
+    auto const frame = screencast->capture(session, std::make_shared<ImportedDMABuf>(dmabuf));
+
+    EXPECT_THAT(frame.damage, ElementsAre(geom::Rectangle{{0, 0}, size}));
+    EXPECT_THAT(dmabuf.pixels(), Each(Eq(cleared)));
+
+    screencast->destroy_session(session);
+}
+
+TEST_F(OffscreenScreencast, unchanged_screen_is_not_captured_again_into_the_same_buffer)
+{
+    auto const screencast = server.the_screencast();
+    auto const session = create_session();
+
+    LinearDMABuf dmabuf{device, size};
+    auto const buffer = std::make_shared<ImportedDMABuf>(dmabuf);
+    auto const first = screencast->capture(session, buffer);
+
+    dmabuf.fill(untouched);
+    auto const second = screencast->capture(session, buffer);
+
+    EXPECT_THAT(second.damage, IsEmpty());
+    EXPECT_THAT(second.presented, Ge(first.presented));
+    // The buffer holds the previous capture, which is still current
+    EXPECT_THAT(dmabuf.pixels(), Each(Eq(untouched)));
+
+    screencast->destroy_session(session);
+}
+
+TEST_F(OffscreenScreencast, unchanged_screen_is_captured_into_a_new_buffer)
+{
+    auto const screencast = server.the_screencast();
+    auto const session = create_session();
+
+    LinearDMABuf first_dmabuf{device, size};
+    auto const first_buffer = std::make_shared<ImportedDMABuf>(first_dmabuf);
+    screencast->capture(session, first_buffer);
+
+    LinearDMABuf second_dmabuf{device, size};
+    second_dmabuf.fill(untouched);
+    auto const frame = screencast->capture(session, std::make_shared<ImportedDMABuf>(second_dmabuf));
+
+    // Nothing changed on screen, but the new buffer still has to be filled
+    EXPECT_THAT(frame.damage, IsEmpty());
+    EXPECT_THAT(second_dmabuf.pixels(), Each(Eq(cleared)));
+
+    screencast->destroy_session(session);
+}
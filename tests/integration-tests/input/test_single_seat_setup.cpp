@@ -17,6 +17,7 @@
  */
 
 #include "src/server/input/default_input_device_hub.h"
+#include "mir/input/input_latencies.h"
 #include "src/server/input/basic_seat.h"
 #include "src/server/input/config_changer.h"
 #include "src/server/scene/broadcasting_session_event_sink.h"
@@ -134,7 +135,8 @@ struct SingleSeatInputDeviceHubSetup : ::testing::Test
                        mt::fake_shared(mock_seat_observer)};
     mi::DefaultInputDeviceHub hub{mt::fake_shared(seat), mt::fake_shared(multiplexer),
                                   cookie_authority,      mt::fake_shared(key_mapper),
-                                  mt::fake_shared(mock_status_listener)};
+                                  mt::fake_shared(mock_status_listener),
+                                  std::make_shared<mi::InputLatencies>(mt::fake_shared(clock))};
     NiceMock<mtd::MockInputDeviceObserver> mock_observer;
     mi::ConfigChanger changer{
         mt::fake_shared(mock_input_manager),
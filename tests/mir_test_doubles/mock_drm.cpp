@@ -359,6 +359,24 @@ mtd::MockDRM::MockDRM()
         .WillByDefault(Return(0));
     ON_CALL(*this, drmCheckModesettingSupported(IsNull()))
         .WillByDefault(Return(-EINVAL));
+
+    // Drive the legacy KMS paths unless a test opts in to atomic modesetting
+    ON_CALL(*this, drmSetClientCap(_, DRM_CLIENT_CAP_ATOMIC, _))
+        .WillByDefault(Return(-EINVAL));
+
+    // drmModeAtomicAddProperty() returns the number of properties in the request
+    ON_CALL(*this, drmModeAtomicAddProperty(_, _, _, _))
+        .WillByDefault(Return(1));
+
+    ON_CALL(*this, drmModeCreatePropertyBlob(_, _, _, _))
+        .WillByDefault(
+            Invoke(
+                [](auto, auto, auto, uint32_t* id)
+                {
+                    static uint32_t next_blob_id{1000};
+                    *id = next_blob_id++;
+                    return 0;
+                }));
 }
 
 mtd::MockDRM::~MockDRM() noexcept
@@ -580,6 +598,26 @@ void drmFreeVersion(drmVersionPtr version)
     return global_mock->drmFreeVersion(version);
 }
 
+int drmModeAtomicCommit(int fd, drmModeAtomicReqPtr req, uint32_t flags, void* user_data)
+{
+    return global_mock->drmModeAtomicCommit(fd, req, flags, user_data);
+}
+
+int drmModeAtomicAddProperty(drmModeAtomicReqPtr req, uint32_t object_id, uint32_t property_id, uint64_t value)
+{
+    return global_mock->drmModeAtomicAddProperty(req, object_id, property_id, value);
+}
+
+int drmModeCreatePropertyBlob(int fd, void const* data, size_t size, uint32_t* id)
+{
+    return global_mock->drmModeCreatePropertyBlob(fd, data, size, id);
+}
+
+int drmModeDestroyPropertyBlob(int fd, uint32_t id)
+{
+    return global_mock->drmModeDestroyPropertyBlob(fd, id);
+}
+
 int drmSetClientCap(int fd, uint64_t capability, uint64_t value)
 {
     return global_mock->drmSetClientCap(fd, capability, value);
@@ -482,6 +482,11 @@ void basic_software_buffer_drawing(
             return mg::contains_alpha(buffer_->pixel_format());
         }
 
+        auto opaque_region() const -> std::vector<mir::geometry::Rectangle> override
+        {
+            return {};
+        }
+
         auto clip_area() const -> std::experimental::optional<mir::geometry::Rectangle> override
         {
             return std::experimental::optional<mir::geometry::Rectangle>{};
@@ -492,6 +497,12 @@ void basic_software_buffer_drawing(
             return 0;
         }
 
+        auto damage_since(mg::BufferID) const
+            -> std::experimental::optional<std::vector<mir::geometry::Rectangle>> override
+        {
+            return {};
+        }
+
         void set_position(mir::geometry::Point top_left)
         {
             this->top_left = top_left;
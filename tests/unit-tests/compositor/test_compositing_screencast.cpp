@@ -0,0 +1,298 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/compositor/compositing_screencast.h"
+
+#include "mir/compositor/frame_clock.h"
+#include "mir/graphics/buffer_basic.h"
+#include "mir/graphics/display_buffer.h"
+#include "mir/graphics/dmabuf_buffer.h"
+#include "mir/graphics/texture.h"
+#include "mir/renderer/gl/context.h"
+#include "mir/renderer/gl/render_target.h"
+#include "mir/renderer/renderer_factory.h"
+
+#include "mir/test/doubles/mock_gl.h"
+#include "mir/test/doubles/mock_renderer.h"
+#include "mir/test/doubles/mock_scene.h"
+#include "mir/test/doubles/stub_buffer.h"
+#include "mir/test/doubles/stub_scene_element.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <stdexcept>
+
+namespace mc = mir::compositor;
+namespace mf = mir::frontend;
+namespace mg = mir::graphics;
+namespace mrgl = mir::renderer::gl;
+namespace mtd = mir::test::doubles;
+namespace geom = mir::geometry;
+
+using namespace std::chrono;
+using namespace testing;
+
+namespace
+{
+GLuint const texture_name{7};
+GLuint const framebuffer_name{11};
+
+struct StubContext : mrgl::Context
+{
+    void make_current() const override {}
+    void release_current() const override {}
+};
+
+/// Makes renderers that swap buffers after rendering, as the GL renderer does
+struct StubRendererFactory : mir::renderer::RendererFactory
+{
+    auto create_renderer_for(mg::DisplayBuffer& display_buffer) -> std::unique_ptr<mir::renderer::Renderer> override
+    {
+        auto const target = dynamic_cast<mrgl::RenderTarget*>(display_buffer.native_display_buffer());
+        auto renderer = std::make_unique<NiceMock<mtd::MockRenderer>>();
+        ON_CALL(*renderer, render(_))
+            .WillByDefault(InvokeWithoutArgs([target] { target->swap_buffers(); }));
+        last_renderer = renderer.get();
+        return renderer;
+    }
+
+    mtd::MockRenderer* last_renderer{nullptr};
+};
+
+struct StubFrameClock : mc::FrameClock
+{
+    void on_next_frame(geom::Rectangle const&, Callback&& callback) override
+    {
+        if (presenting)
+            callback(presented);
+    }
+
+    bool presenting{true};
+    steady_clock::time_point presented{seconds{42}};
+};
+
+struct StubDMABufTexture : mg::BufferBasic, mg::DMABufBuffer, mg::gl::Texture
+{
+    StubDMABufTexture(geom::Size const& size)
+        : size_{size}
+    {
+    }
+
+    std::shared_ptr<mg::NativeBuffer> native_buffer_handle() const override { return nullptr; }
+    auto size() const -> geom::Size override { return size_; }
+    MirPixelFormat pixel_format() const override { return mir_pixel_format_argb_8888; }
+    mg::NativeBufferBase* native_buffer_base() override { return this; }
+
+    auto drm_fourcc() const -> uint32_t override { return 0; }
+    auto modifier() const -> std::optional<uint64_t> override { return {}; }
+    auto planes() const -> std::vector<PlaneDescriptor> const& override { return planes_; }
+
+    mg::gl::Program const& shader(mg::gl::ProgramFactory&) const override
+    {
+        throw std::logic_error{"Screencasts shouldn't sample their own buffers"};
+    }
+    Layout layout() const override { return Layout::GL; }
+    void bind() override {}
+    void add_syncpoint() override {}
+
+    geom::Size const size_;
+    std::vector<PlaneDescriptor> const planes_;
+};
+
+struct CompositingScreencast : Test
+{
+    CompositingScreencast()
+    {
+        ON_CALL(mock_gl, glGetIntegerv(GL_TEXTURE_BINDING_2D, _))
+            .WillByDefault(SetArgPointee<1>(texture_name));
+        ON_CALL(mock_gl, glGenFramebuffers(1, _))
+            .WillByDefault(SetArgPointee<1>(framebuffer_name));
+        ON_CALL(mock_gl, glCheckFramebufferStatus(GL_FRAMEBUFFER))
+            .WillByDefault(Return(GL_FRAMEBUFFER_COMPLETE));
+    }
+
+    auto create_session(MirMirrorMode mirror_mode = mir_mirror_mode_none) -> mf::ScreencastSessionId
+    {
+        return screencast.create_session(region, size, mir_pixel_format_argb_8888, 2, mirror_mode);
+    }
+
+    auto renderer() -> mtd::MockRenderer& { return *renderer_factory->last_renderer; }
+
+    NiceMock<mtd::MockGL> mock_gl;
+    geom::Rectangle const region{{1920, 0}, {1920, 1080}};
+    geom::Size const size{960, 540};
+    std::shared_ptr<NiceMock<mtd::MockScene>> const scene{std::make_shared<NiceMock<mtd::MockScene>>()};
+    std::shared_ptr<StubRendererFactory> const renderer_factory{std::make_shared<StubRendererFactory>()};
+    std::shared_ptr<StubFrameClock> const frame_clock{std::make_shared<StubFrameClock>()};
+    mc::CompositingScreencast screencast{
+        scene, std::make_unique<StubContext>(), renderer_factory, frame_clock};
+    std::shared_ptr<StubDMABufTexture> const buffer{std::make_shared<StubDMABufTexture>(size)};
+};
+}
+
+TEST_F(CompositingScreencast, session_composites_the_scene_for_as_long_as_it_lasts)
+{
+    EXPECT_CALL(*scene, register_compositor(_));
+    auto const id = create_session();
+
+    Mock::VerifyAndClearExpectations(scene.get());
+
+    EXPECT_CALL(*scene, unregister_compositor(_));
+    screencast.destroy_session(id);
+}
+
+TEST_F(CompositingScreencast, rejects_empty_regions_and_sizes)
+{
+    EXPECT_THROW(
+        screencast.create_session({{0, 0}, {0, 1080}}, size, mir_pixel_format_argb_8888, 2, mir_mirror_mode_none),
+        std::invalid_argument);
+    EXPECT_THROW(
+        screencast.create_session(region, {960, 0}, mir_pixel_format_argb_8888, 2, mir_mirror_mode_none),
+        std::invalid_argument);
+}
+
+TEST_F(CompositingScreencast, captures_only_into_client_buffers)
+{
+    auto const id = create_session();
+
+    EXPECT_THROW(screencast.capture(id), std::logic_error);
+}
+
+TEST_F(CompositingScreencast, rejects_buffers_that_are_not_dmabufs)
+{
+    auto const id = create_session();
+
+    EXPECT_THROW(screencast.capture(id, std::make_shared<mtd::StubBuffer>(size)), std::invalid_argument);
+}
+
+TEST_F(CompositingScreencast, rejects_buffers_of_the_wrong_size)
+{
+    auto const id = create_session();
+
+    EXPECT_THROW(
+        screencast.capture(id, std::make_shared<StubDMABufTexture>(geom::Size{1920, 1080})),
+        std::invalid_argument);
+}
+
+TEST_F(CompositingScreencast, renders_the_region_straight_into_the_buffer)
+{
+    auto const id = create_session();
+
+    InSequence seq;
+    EXPECT_CALL(mock_gl, glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture_name, 0));
+    EXPECT_CALL(renderer(), set_viewport(region));
+    EXPECT_CALL(renderer(), render(_));
+
+    screencast.capture(id, buffer);
+}
+
+TEST_F(CompositingScreencast, draws_the_top_row_first)
+{
+    auto const id = create_session();
+
+    EXPECT_CALL(renderer(), set_output_transform(glm::mat2{1, 0, 0, -1}));
+
+    screencast.capture(id, buffer);
+}
+
+TEST_F(CompositingScreencast, reports_when_the_frame_captured_was_presented)
+{
+    auto const id = create_session();
+
+    EXPECT_THAT(screencast.capture(id, buffer).presented, Eq(frame_clock->presented));
+}
+
+TEST_F(CompositingScreencast, captures_the_scene_as_it_is_when_no_frame_comes)
+{
+    auto const id = create_session();
+    frame_clock->presenting = false;
+
+    auto const before = steady_clock::now();
+    auto const frame = screencast.capture(id, buffer);
+
+    EXPECT_THAT(frame.presented, Ge(before + mc::CompositingScreencast::max_frame_wait));
+}
+
+TEST_F(CompositingScreencast, first_capture_damages_the_whole_buffer)
+{
+    auto const id = create_session();
+
+    EXPECT_THAT(screencast.capture(id, buffer).damage, ElementsAre(geom::Rectangle{{0, 0}, size}));
+}
+
+TEST_F(CompositingScreencast, unchanged_scene_is_not_rendered_again_into_the_same_buffer)
+{
+    auto const id = create_session();
+    screencast.capture(id, buffer);
+
+    EXPECT_CALL(renderer(), render(_)).Times(0);
+
+    EXPECT_THAT(screencast.capture(id, buffer).damage, IsEmpty());
+}
+
+TEST_F(CompositingScreencast, unchanged_scene_is_rendered_into_a_buffer_that_does_not_hold_it)
+{
+    auto const id = create_session();
+    screencast.capture(id, buffer);
+
+    EXPECT_CALL(renderer(), render(_));
+
+    EXPECT_THAT(screencast.capture(id, std::make_shared<StubDMABufTexture>(size)).damage, IsEmpty());
+}
+
+TEST_F(CompositingScreencast, damage_is_scaled_into_buffer_coordinates)
+{
+    auto const id = create_session();
+    screencast.capture(id, buffer);
+
+    auto const element = std::make_shared<mtd::StubSceneElement>(
+        std::make_shared<mtd::StubRenderable>(geom::Rectangle{{1920 + 100, 200}, {300, 400}}));
+    ON_CALL(*scene, scene_elements_for(_))
+        .WillByDefault(Return(mc::SceneElementSequence{element}));
+
+    EXPECT_THAT(
+        screencast.capture(id, buffer).damage,
+        ElementsAre(geom::Rectangle{{50, 100}, {150, 200}}));
+}
+
+TEST_F(CompositingScreencast, damage_is_mirrored_with_the_buffer)
+{
+    auto const id = create_session(mir_mirror_mode_horizontal);
+    screencast.capture(id, buffer);
+
+    auto const element = std::make_shared<mtd::StubSceneElement>(
+        std::make_shared<mtd::StubRenderable>(geom::Rectangle{{1920 + 100, 200}, {300, 400}}));
+    ON_CALL(*scene, scene_elements_for(_))
+        .WillByDefault(Return(mc::SceneElementSequence{element}));
+
+    EXPECT_THAT(
+        screencast.capture(id, buffer).damage,
+        ElementsAre(geom::Rectangle{{960 - 200, 100}, {150, 200}}));
+}
+
+TEST_F(CompositingScreencast, forgets_buffers_the_client_has_released)
+{
+    auto const id = create_session();
+    auto released = std::make_shared<StubDMABufTexture>(size);
+    screencast.capture(id, released);
+    released.reset();
+
+    EXPECT_CALL(mock_gl, glDeleteFramebuffers(1, Pointee(framebuffer_name)));
+
+    screencast.capture(id, buffer);
+    Mock::VerifyAndClearExpectations(&mock_gl);
+}
@@ -0,0 +1,174 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/compositor/damage_tracker.h"
+#include "mir/test/doubles/fake_renderable.h"
+#include "mir/test/doubles/stub_buffer.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+using namespace testing;
+using namespace mir::geometry;
+namespace mc = mir::compositor;
+namespace mg = mir::graphics;
+namespace mtd = mir::test::doubles;
+
+namespace
+{
+struct DamagedRenderable : mtd::FakeRenderable
+{
+    using mtd::FakeRenderable::FakeRenderable;
+
+    std::experimental::optional<std::vector<Rectangle>> damage_since(mg::BufferID) const override
+    {
+        return damage;
+    }
+
+    std::experimental::optional<std::vector<Rectangle>> damage;
+};
+
+struct DamageTracker : Test
+{
+    Rectangle const view_area{{0, 0}, {1920, 1080}};
+    mc::DamageTracker tracker;
+};
+}
+
+TEST_F(DamageTracker, first_frame_damages_whole_view_area)
+{
+    auto const window = std::make_shared<mtd::FakeRenderable>(10, 10, 100, 100);
+
+    EXPECT_THAT(tracker.damage_for({window}, view_area), ElementsAre(view_area));
+}
+
+TEST_F(DamageTracker, unchanged_frame_has_no_damage)
+{
+    auto const window = std::make_shared<mtd::FakeRenderable>(10, 10, 100, 100);
+    tracker.damage_for({window}, view_area);
+
+    EXPECT_THAT(tracker.damage_for({window}, view_area), IsEmpty());
+}
+
+TEST_F(DamageTracker, new_renderable_damages_its_area)
+{
+    auto const background = std::make_shared<mtd::FakeRenderable>(view_area);
+    auto const window = std::make_shared<mtd::FakeRenderable>(10, 10, 100, 100);
+    tracker.damage_for({background}, view_area);
+
+    EXPECT_THAT(tracker.damage_for({background, window}, view_area),
+        ElementsAre(Rectangle{{10, 10}, {100, 100}}));
+}
+
+TEST_F(DamageTracker, removed_renderable_damages_its_old_area)
+{
+    auto const background = std::make_shared<mtd::FakeRenderable>(view_area);
+    auto const window = std::make_shared<mtd::FakeRenderable>(10, 10, 100, 100);
+    tracker.damage_for({background, window}, view_area);
+
+    EXPECT_THAT(tracker.damage_for({background}, view_area),
+        ElementsAre(Rectangle{{10, 10}, {100, 100}}));
+}
+
+TEST_F(DamageTracker, damage_is_clipped_to_view_area)
+{
+    auto const window = std::make_shared<mtd::FakeRenderable>(1900, 1000, 100, 100);
+    tracker.damage_for({}, view_area);
+
+    EXPECT_THAT(tracker.damage_for({window}, view_area),
+        ElementsAre(Rectangle{{1900, 1000}, {20, 80}}));
+}
+
+TEST_F(DamageTracker, restacking_damages_raised_renderable)
+{
+    auto const lower = std::make_shared<mtd::FakeRenderable>(0, 0, 100, 100);
+    auto const upper = std::make_shared<mtd::FakeRenderable>(50, 50, 100, 100);
+    tracker.damage_for({lower, upper}, view_area);
+
+    EXPECT_THAT(tracker.damage_for({upper, lower}, view_area),
+        ElementsAre(Rectangle{{0, 0}, {100, 100}}));
+}
+
+TEST_F(DamageTracker, new_buffer_with_client_damage_damages_only_that)
+{
+    auto const window = std::make_shared<DamagedRenderable>(Rectangle{{100, 100}, {200, 200}});
+    window->set_buffer(std::make_shared<mtd::StubBuffer>(Size{200, 200}));
+    tracker.damage_for({window}, view_area);
+
+    window->set_buffer(std::make_shared<mtd::StubBuffer>(Size{200, 200}));
+    window->damage = std::vector<Rectangle>{{{10, 20}, {30, 40}}};
+
+    EXPECT_THAT(tracker.damage_for({window}, view_area),
+        ElementsAre(Rectangle{{110, 120}, {30, 40}}));
+}
+
+TEST_F(DamageTracker, client_damage_is_scaled_to_screen_position)
+{
+    auto const window = std::make_shared<DamagedRenderable>(Rectangle{{0, 0}, {100, 100}});
+    window->set_buffer(std::make_shared<mtd::StubBuffer>(Size{200, 200}));
+    tracker.damage_for({window}, view_area);
+
+    window->set_buffer(std::make_shared<mtd::StubBuffer>(Size{200, 200}));
+    window->damage = std::vector<Rectangle>{{{11, 11}, {20, 20}}};
+
+    EXPECT_THAT(tracker.damage_for({window}, view_area),
+        ElementsAre(Rectangle{{5, 5}, {11, 11}}));
+}
+
+TEST_F(DamageTracker, new_buffer_without_client_damage_damages_whole_renderable)
+{
+    auto const window = std::make_shared<DamagedRenderable>(Rectangle{{100, 100}, {200, 200}});
+    window->set_buffer(std::make_shared<mtd::StubBuffer>(Size{200, 200}));
+    tracker.damage_for({window}, view_area);
+
+    window->set_buffer(std::make_shared<mtd::StubBuffer>(Size{200, 200}));
+    window->damage = std::experimental::nullopt;
+
+    EXPECT_THAT(tracker.damage_for({window}, view_area),
+        ElementsAre(Rectangle{{100, 100}, {200, 200}}));
+}
+
+TEST_F(DamageTracker, opaque_region_change_damages_whole_renderable)
+{
+    auto const background = std::make_shared<mtd::FakeRenderable>(view_area);
+    auto const window = std::make_shared<mtd::FakeRenderable>(Rectangle{{100, 100}, {200, 200}}, 1.0f, false);
+    window->set_opaque_region({Rectangle{{110, 110}, {180, 180}}});
+    tracker.damage_for({background, window}, view_area);
+
+    window->set_opaque_region({});
+
+    EXPECT_THAT(tracker.damage_for({background, window}, view_area),
+        AllOf(Not(IsEmpty()), Each(Rectangle{{100, 100}, {200, 200}})));
+}
+
+TEST_F(DamageTracker, view_area_change_damages_whole_view_area)
+{
+    auto const window = std::make_shared<mtd::FakeRenderable>(10, 10, 100, 100);
+    Rectangle const new_view_area{{0, 0}, {1280, 720}};
+    tracker.damage_for({window}, view_area);
+
+    EXPECT_THAT(tracker.damage_for({window}, new_view_area), ElementsAre(new_view_area));
+}
+
+TEST_F(DamageTracker, reset_damages_whole_view_area)
+{
+    auto const window = std::make_shared<mtd::FakeRenderable>(10, 10, 100, 100);
+    tracker.damage_for({window}, view_area);
+
+    tracker.reset();
+
+    EXPECT_THAT(tracker.damage_for({window}, view_area), ElementsAre(view_area));
+}
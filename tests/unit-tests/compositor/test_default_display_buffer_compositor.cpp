@@ -126,6 +126,77 @@ TEST_F(DefaultDisplayBufferCompositor, render)
     compositor.composite(make_scene_elements({}));
 }
 
+TEST_F(DefaultDisplayBufferCompositor, passes_only_changed_areas_to_renderer)
+{
+    using namespace testing;
+    Sequence render_seq;
+    EXPECT_CALL(mock_renderer, set_damage(ElementsAre(screen)))
+        .InSequence(render_seq);
+    EXPECT_CALL(mock_renderer, render(_))
+        .InSequence(render_seq);
+    EXPECT_CALL(mock_renderer, set_damage(ElementsAre(small->screen_position())))
+        .InSequence(render_seq);
+    EXPECT_CALL(mock_renderer, render(_))
+        .InSequence(render_seq);
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_buffer,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report());
+
+    compositor.composite(make_scene_elements({big}));
+    compositor.composite(make_scene_elements({big, small}));
+}
+
+TEST_F(DefaultDisplayBufferCompositor, passes_visible_parts_of_partly_covered_renderables_to_renderer)
+{
+    using namespace testing;
+    auto const covering = std::make_shared<mtd::FakeRenderable>(geom::Rectangle{{5, 10}, {50, 200}});
+
+    Sequence render_seq;
+    EXPECT_CALL(mock_renderer, set_visible_regions(ElementsAre(
+            Pair(big->id(), ElementsAre(geom::Rectangle{{55, 10}, {50, 200}})))))
+        .InSequence(render_seq);
+    EXPECT_CALL(mock_renderer, render(ElementsAre(big, covering)))
+        .InSequence(render_seq);
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_buffer,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report());
+
+    compositor.composite(make_scene_elements({big, small, covering}));
+}
+
+TEST_F(DefaultDisplayBufferCompositor, renders_only_what_the_display_buffer_does_not_overlay)
+{
+    using namespace testing;
+
+    struct PartiallyOverlayingDisplayBuffer : NiceMock<mtd::MockDisplayBuffer>
+    {
+        bool overlay_partially(mg::RenderableList const& renderlist, mg::RenderableList& to_render) override
+        {
+            // Take the topmost renderable
+            to_render.assign(renderlist.begin(), renderlist.end() - 1);
+            return false;
+        }
+    } partial_display_buffer;
+
+    ON_CALL(partial_display_buffer, transformation())
+        .WillByDefault(Return(no_transformation));
+    ON_CALL(partial_display_buffer, view_area())
+        .WillByDefault(Return(screen));
+
+    EXPECT_CALL(mock_renderer, render(ElementsAre(big)));
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        partial_display_buffer,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report());
+
+    compositor.composite(make_scene_elements({big, small}));
+}
+
 TEST_F(DefaultDisplayBufferCompositor, optimization_skips_composition)
 {
     using namespace testing;
@@ -169,14 +240,13 @@ TEST_F(DefaultDisplayBufferCompositor, rendering_reports_everything)
         .WillOnce(Return(false));
     EXPECT_CALL(*report, renderables_in_frame(_,_))
         .InSequence(seq);
+    EXPECT_CALL(mock_renderer, render(_))
+        .InSequence(seq);
     EXPECT_CALL(*report, rendered_frame(_))
         .InSequence(seq);
     EXPECT_CALL(*report, finished_frame(_))
         .InSequence(seq);
 
-    EXPECT_CALL(mock_renderer, render(_))
-        .Times(1);
-
     mc::DefaultDisplayBufferCompositor compositor(
         display_buffer,
         mt::fake_shared(mock_renderer),
@@ -0,0 +1,125 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/compositor/frame_clocks.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+using namespace testing;
+using namespace std::chrono_literals;
+namespace mc = mir::compositor;
+namespace geom = mir::geometry;
+
+namespace
+{
+struct FrameClocks : Test
+{
+    using time_point = std::chrono::steady_clock::time_point;
+
+    mc::FrameClocks clocks;
+    geom::Rectangle const left_area{{0, 0}, {1920, 1080}};
+    geom::Rectangle const right_area{{1920, 0}, {2560, 1440}};
+
+    int left_frames_scheduled{0};
+    int right_frames_scheduled{0};
+    std::shared_ptr<mc::FrameClocks::Output> const left{
+        clocks.add_output({left_area}, [this]{ ++left_frames_scheduled; })};
+    std::shared_ptr<mc::FrameClocks::Output> const right{
+        clocks.add_output({right_area}, [this]{ ++right_frames_scheduled; })};
+
+    std::vector<time_point> presented;
+
+    auto record_presentation() -> mc::FrameClock::Callback
+    {
+        return [this](time_point when) { presented.push_back(when); };
+    }
+};
+}
+
+TEST_F(FrameClocks, callback_waits_for_next_frame_to_be_presented)
+{
+    time_point const vblank{16ms};
+
+    clocks.on_next_frame({{10, 10}, {100, 100}}, record_presentation());
+    EXPECT_THAT(presented, IsEmpty());
+
+    left->frame_started();
+    EXPECT_THAT(presented, IsEmpty());
+
+    left->frame_presented(vblank);
+    EXPECT_THAT(presented, ElementsAre(vblank));
+}
+
+TEST_F(FrameClocks, callback_added_during_a_frame_waits_for_the_one_after)
+{
+    left->frame_started();
+    clocks.on_next_frame({{10, 10}, {100, 100}}, record_presentation());
+    left->frame_presented(time_point{16ms});
+
+    EXPECT_THAT(presented, IsEmpty());
+
+    left->frame_started();
+    left->frame_presented(time_point{32ms});
+
+    EXPECT_THAT(presented, ElementsAre(time_point{32ms}));
+}
+
+TEST_F(FrameClocks, only_the_output_showing_the_area_is_asked_for_a_frame)
+{
+    clocks.on_next_frame({{2000, 100}, {100, 100}}, record_presentation());
+
+    EXPECT_THAT(right_frames_scheduled, Eq(1));
+    EXPECT_THAT(left_frames_scheduled, Eq(0));
+
+    left->frame_started();
+    left->frame_presented(time_point{16ms});
+    EXPECT_THAT(presented, IsEmpty());
+
+    right->frame_started();
+    right->frame_presented(time_point{7ms});
+    EXPECT_THAT(presented, ElementsAre(time_point{7ms}));
+}
+
+TEST_F(FrameClocks, area_spanning_outputs_is_paced_by_the_one_showing_most_of_it)
+{
+    clocks.on_next_frame({{1800, 100}, {400, 100}}, record_presentation());
+
+    EXPECT_THAT(right_frames_scheduled, Eq(1));
+    EXPECT_THAT(left_frames_scheduled, Eq(0));
+}
+
+TEST_F(FrameClocks, area_on_no_output_is_called_back_immediately)
+{
+    clocks.on_next_frame({{-500, -500}, {100, 100}}, record_presentation());
+
+    EXPECT_THAT(presented, SizeIs(1));
+    EXPECT_THAT(left_frames_scheduled + right_frames_scheduled, Eq(0));
+}
+
+TEST_F(FrameClocks, removing_an_output_releases_its_callbacks)
+{
+    clocks.on_next_frame({{10, 10}, {100, 100}}, record_presentation());
+    left->frame_started();
+    clocks.on_next_frame({{10, 10}, {100, 100}}, record_presentation());
+
+    clocks.remove_output(left);
+
+    EXPECT_THAT(presented, SizeIs(2));
+
+    clocks.on_next_frame({{10, 10}, {100, 100}}, record_presentation());
+    EXPECT_THAT(presented, SizeIs(3));
+}
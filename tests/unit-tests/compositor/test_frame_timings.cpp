@@ -0,0 +1,190 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/compositor/frame_timings.h"
+#include "src/server/report/frame_timing_compositor_report.h"
+#include "src/server/report/null/compositor_report.h"
+
+#include "mir/test/doubles/advanceable_clock.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace mc = mir::compositor;
+namespace mr = mir::report;
+namespace mtd = mir::test::doubles;
+
+using namespace std::chrono;
+using namespace testing;
+using Stage = mc::FrameTimings::Stage;
+
+namespace
+{
+int const output_a{0};
+int const output_b{1};
+mc::FrameTimings::OutputId const id_a{&output_a};
+mc::FrameTimings::OutputId const id_b{&output_b};
+
+struct FrameTimings : Test
+{
+    mc::FrameTimings timings;
+};
+
+struct FrameTimingCompositorReport : Test
+{
+    void composite_frame(microseconds acquire, microseconds render, microseconds present)
+    {
+        report.began_frame(id_a);
+        clock->advance_by(acquire);
+        report.renderables_in_frame(id_a, {});
+        clock->advance_by(render);
+        report.rendered_frame(id_a);
+        report.finished_frame(id_a);
+        clock->advance_by(present);
+        report.presented_frame(id_a);
+    }
+
+    std::shared_ptr<mc::FrameTimings> const timings{std::make_shared<mc::FrameTimings>()};
+    std::shared_ptr<mtd::AdvanceableClock> const clock{std::make_shared<mtd::AdvanceableClock>()};
+    mr::FrameTimingCompositorReport report{
+        std::make_shared<mr::null::CompositorReport>(),
+        timings,
+        clock};
+};
+}
+
+TEST_F(FrameTimings, summary_of_unknown_output_is_empty)
+{
+    auto const summary = timings.summary(id_a, Stage::render);
+
+    EXPECT_THAT(summary.count, Eq(0u));
+    EXPECT_THAT(summary.max, Eq(microseconds{0}));
+}
+
+TEST_F(FrameTimings, small_durations_are_exact)
+{
+    timings.record(id_a, Stage::render, microseconds{3});
+    timings.record(id_a, Stage::render, microseconds{5});
+    timings.record(id_a, Stage::render, microseconds{7});
+
+    auto const summary = timings.summary(id_a, Stage::render);
+
+    EXPECT_THAT(summary.count, Eq(3u));
+    EXPECT_THAT(summary.mean, Eq(microseconds{5}));
+    EXPECT_THAT(summary.median, Eq(microseconds{5}));
+    EXPECT_THAT(summary.max, Eq(microseconds{7}));
+}
+
+TEST_F(FrameTimings, percentiles_are_within_an_eighth)
+{
+    for (int i = 1; i <= 1000; ++i)
+        timings.record(id_a, Stage::present, microseconds{i * 20});
+
+    auto const summary = timings.summary(id_a, Stage::present);
+
+    auto const near = [](microseconds expected)
+        {
+            return AllOf(Ge(expected), Le(expected + expected / 8));
+        };
+
+    EXPECT_THAT(summary.median, near(microseconds{10000}));
+    EXPECT_THAT(summary.p90, near(microseconds{18000}));
+    EXPECT_THAT(summary.p99, near(microseconds{19800}));
+    EXPECT_THAT(summary.max, Eq(microseconds{20000}));
+}
+
+TEST_F(FrameTimings, a_stall_shows_in_the_tail_but_not_the_median)
+{
+    for (int i = 0; i != 995; ++i)
+        timings.record(id_a, Stage::render, milliseconds{2});
+    for (int i = 0; i != 5; ++i)
+        timings.record(id_a, Stage::render, milliseconds{50});
+
+    auto const summary = timings.summary(id_a, Stage::render);
+
+    EXPECT_THAT(summary.median, Le(milliseconds{3}));
+    EXPECT_THAT(summary.p99, Le(milliseconds{3}));
+    EXPECT_THAT(summary.p999, Ge(milliseconds{50}));
+}
+
+TEST_F(FrameTimings, keeps_outputs_and_stages_apart)
+{
+    timings.add_output(id_a, {{0, 0}, {1920, 1080}});
+    timings.add_output(id_b, {{1920, 0}, {1280, 1024}});
+    timings.record(id_a, Stage::acquire, microseconds{10});
+    timings.record(id_b, Stage::render, microseconds{20});
+
+    EXPECT_THAT(timings.outputs(), ElementsAre(id_a, id_b));
+    EXPECT_THAT(timings.summary(id_a, Stage::acquire).count, Eq(1u));
+    EXPECT_THAT(timings.summary(id_a, Stage::render).count, Eq(0u));
+    EXPECT_THAT(timings.summary(id_b, Stage::render).max, Eq(microseconds{20}));
+}
+
+TEST_F(FrameTimings, reset_forgets_samples_but_not_outputs)
+{
+    timings.add_output(id_a, {{0, 0}, {640, 480}});
+    timings.record(id_a, Stage::acquire, microseconds{10});
+
+    timings.reset();
+
+    EXPECT_THAT(timings.outputs(), ElementsAre(id_a));
+    EXPECT_THAT(timings.summary(id_a, Stage::acquire).count, Eq(0u));
+}
+
+TEST_F(FrameTimings, json_has_each_outputs_area_and_stages)
+{
+    timings.add_output(id_a, {{10, 20}, {640, 480}});
+    timings.record(id_a, Stage::commit_to_present, microseconds{7});
+
+    auto const json = timings.to_json();
+
+    EXPECT_THAT(json, StartsWith("{\"outputs\":[{\"index\":0,"));
+    EXPECT_THAT(json, HasSubstr("\"area\":{\"x\":10,\"y\":20,\"width\":640,\"height\":480}"));
+    EXPECT_THAT(json, HasSubstr("\"acquire\":{\"count\":0,"));
+    EXPECT_THAT(json, HasSubstr("\"commit_to_present\":{\"count\":1,\"mean_us\":7,\"p50_us\":7,"));
+    EXPECT_THAT(json, EndsWith("}}]}"));
+}
+
+TEST_F(FrameTimingCompositorReport, records_each_stage_of_a_frame)
+{
+    report.added_display(640, 480, 0, 0, id_a);
+
+    composite_frame(microseconds{5}, microseconds{10}, microseconds{15});
+
+    EXPECT_THAT(timings->summary(id_a, Stage::acquire).max, Eq(microseconds{5}));
+    EXPECT_THAT(timings->summary(id_a, Stage::render).max, Eq(microseconds{10}));
+    EXPECT_THAT(timings->summary(id_a, Stage::present).max, Eq(microseconds{15}));
+}
+
+TEST_F(FrameTimingCompositorReport, counts_a_scene_change_towards_the_first_frame_presenting_it)
+{
+    report.scheduled();
+    clock->advance_by(microseconds{100});
+
+    composite_frame(microseconds{1}, microseconds{2}, microseconds{3});
+    composite_frame(microseconds{1}, microseconds{2}, microseconds{3});
+
+    auto const summary = timings->summary(id_a, Stage::commit_to_present);
+    EXPECT_THAT(summary.count, Eq(1u));
+    EXPECT_THAT(summary.max, Eq(microseconds{106}));
+}
+
+TEST_F(FrameTimingCompositorReport, frames_before_any_scene_change_have_no_commit_to_present)
+{
+    composite_frame(microseconds{1}, microseconds{2}, microseconds{3});
+
+    EXPECT_THAT(timings->summary(id_a, Stage::commit_to_present).count, Eq(0u));
+}
@@ -17,6 +17,7 @@
  */
 
 #include "src/server/compositor/multi_threaded_compositor.h"
+#include "src/server/compositor/frame_clocks.h"
 #include "src/server/report/null_report_factory.h"
 
 #include "mir/compositor/display_listener.h"
@@ -27,6 +28,7 @@
 #include "mir/raii.h"
 
 #include "mir/test/current_thread_name.h"
+#include "mir/test/signal.h"
 #include "mir/test/doubles/null_display.h"
 #include "mir/test/doubles/null_display_buffer.h"
 #include "mir/test/doubles/mock_display_buffer.h"
@@ -264,6 +266,14 @@ public:
         return true;
     }
 
+    unsigned int record_count_for(mg::DisplayBuffer& display_buffer)
+    {
+        std::lock_guard<std::mutex> lk{m};
+
+        auto const record = records.find(&display_buffer);
+        return record == records.end() ? 0 : record->second.first;
+    }
+
 private:
     std::mutex m;
     typedef std::pair<unsigned int, std::unordered_set<std::thread::id>> Record;
@@ -457,6 +467,8 @@ TEST(MultiThreadedCompositor, reports_in_the_right_places)
         .Times(1);
     EXPECT_CALL(*mock_report, scheduled())
         .Times(2);
+    EXPECT_CALL(*mock_report, presented_frame(_))
+        .Times(AtLeast(1));
 
     EXPECT_CALL(*mock_report, stopped())
         .Times(AtLeast(1));
@@ -948,3 +960,87 @@ TEST(MultiThreadedCompositor, can_schedule_from_display_observer_when_removing_d
         display, stub_scene, db_compositor_factory, mock_display_listener, mock_report, default_delay, true};
     compositor.start();
 }
+
+TEST(MultiThreadedCompositor, frame_clock_is_driven_by_the_output_showing_the_area)
+{
+    using namespace testing;
+
+    geom::Rectangle const left{{0, 0}, {100, 100}};
+    geom::Rectangle const right{{100, 0}, {100, 100}};
+
+    auto display = std::make_shared<mtd::StubDisplay>(std::vector<geom::Rectangle>{left, right});
+    auto scene = std::make_shared<StubScene>();
+    auto db_compositor_factory = std::make_shared<RecordingDisplayBufferCompositorFactory>();
+    auto frame_clocks = std::make_shared<mc::FrameClocks>();
+    mc::MultiThreadedCompositor compositor{
+        display, scene, db_compositor_factory, null_display_listener, null_report, default_delay, false, frame_clocks};
+
+    compositor.start();
+
+    mt::Signal presented;
+    frame_clocks->on_next_frame({{150, 50}, {10, 10}}, [&presented](auto) { presented.raise(); });
+
+    EXPECT_TRUE(presented.wait_for(10s));
+
+    compositor.stop();
+
+    std::vector<mg::DisplayBuffer*> display_buffers;
+    display->for_each_display_sync_group([&](mg::DisplaySyncGroup& group)
+        {
+            group.for_each_display_buffer([&](mg::DisplayBuffer& buffer) { display_buffers.push_back(&buffer); });
+        });
+
+    ASSERT_THAT(display_buffers, SizeIs(2));
+    EXPECT_THAT(db_compositor_factory->record_count_for(*display_buffers[0]), Eq(0u));
+    EXPECT_THAT(db_compositor_factory->record_count_for(*display_buffers[1]), Ge(1u));
+}
+
+namespace
+{
+struct StubDisplayReportingVblanks : mtd::StubDisplay
+{
+    using mtd::StubDisplay::StubDisplay;
+
+    mg::Frame last_frame_on(unsigned output_id) const override
+    {
+        mg::Frame frame;
+        frame.msc = 1;
+        frame.ust = {CLOCK_MONOTONIC, std::chrono::seconds{output_id}};
+        return frame;
+    }
+};
+}
+
+TEST(MultiThreadedCompositor, frame_clock_reports_the_vblank_of_the_output_showing_the_area)
+{
+    using namespace testing;
+
+    geom::Rectangle const left{{0, 0}, {100, 100}};
+    geom::Rectangle const right{{100, 0}, {100, 100}};
+
+    auto display = std::make_shared<StubDisplayReportingVblanks>(std::vector<geom::Rectangle>{left, right});
+    auto scene = std::make_shared<StubScene>();
+    auto db_compositor_factory = std::make_shared<mtd::NullDisplayBufferCompositorFactory>();
+    auto frame_clocks = std::make_shared<mc::FrameClocks>();
+    mc::MultiThreadedCompositor compositor{
+        display, scene, db_compositor_factory, null_display_listener, null_report, default_delay, false, frame_clocks};
+
+    compositor.start();
+
+    mt::Signal presented;
+    std::chrono::steady_clock::time_point presented_at;
+    frame_clocks->on_next_frame(
+        {{150, 50}, {10, 10}},
+        [&](auto when)
+        {
+            presented_at = when;
+            presented.raise();
+        });
+
+    ASSERT_TRUE(presented.wait_for(10s));
+
+    compositor.stop();
+
+    // The right output is the display configuration's second
+    EXPECT_THAT(presented_at, Eq(std::chrono::steady_clock::time_point{2s}));
+}
@@ -21,7 +21,9 @@
 #include "mir/test/doubles/fake_renderable.h"
 #include "mir/test/doubles/stub_scene_element.h"
 
+#include <glm/gtc/matrix_transform.hpp>
 #include <gtest/gtest.h>
+#include <gmock/gmock.h>
 #include <memory>
 
 using namespace testing;
@@ -32,6 +34,38 @@ namespace mtd = mir::test::doubles;
 
 namespace
 {
+struct TransformedRenderable : mtd::FakeRenderable
+{
+    TransformedRenderable(Rectangle const& position, glm::mat4 const& transform)
+        : FakeRenderable{position},
+          transform{transform}
+    {
+    }
+
+    glm::mat4 transformation() const override
+    {
+        return transform;
+    }
+
+    glm::mat4 const transform;
+};
+
+struct ClippedRenderable : mtd::FakeRenderable
+{
+    ClippedRenderable(Rectangle const& position, Rectangle const& clip)
+        : FakeRenderable{position},
+          clip{clip}
+    {
+    }
+
+    std::experimental::optional<Rectangle> clip_area() const override
+    {
+        return clip;
+    }
+
+    Rectangle const clip;
+};
+
 struct OcclusionFilterTest : public Test
 {
     OcclusionFilterTest()
@@ -202,3 +236,147 @@ TEST_F(OcclusionFilterTest,
     EXPECT_THAT(renderables_from(occlusions), ElementsAre(partially_onscreen));
     EXPECT_THAT(renderables_from(elements), ElementsAre(covering));
 }
+
+TEST_F(OcclusionFilterTest, window_covered_by_several_windows_is_occluded)
+{
+    auto const bottom = std::make_shared<mtd::FakeRenderable>(0, 0, 200, 100);
+    auto const left = std::make_shared<mtd::FakeRenderable>(0, 0, 100, 100);
+    auto const right = std::make_shared<mtd::FakeRenderable>(100, 0, 100, 100);
+    auto elements = scene_elements_from({bottom, left, right});
+
+    auto const& occlusions = filter_occlusions_from(elements, monitor_rect);
+
+    EXPECT_THAT(renderables_from(occlusions), ElementsAre(bottom));
+    EXPECT_THAT(renderables_from(elements), ElementsAre(left, right));
+}
+
+TEST_F(OcclusionFilterTest, tiled_windows_occlude_a_window_beneath_them)
+{
+    auto const desktop = std::make_shared<mtd::FakeRenderable>(monitor_rect);
+    std::vector<std::shared_ptr<mg::Renderable>> renderables{desktop};
+    for (auto x = 0; x < 4; ++x)
+        for (auto y = 0; y < 3; ++y)
+            renderables.push_back(std::make_shared<mtd::FakeRenderable>(x * 480, y * 400, 480, 400));
+
+    auto elements = scene_elements_from(renderables);
+
+    auto const& occlusions = filter_occlusions_from(elements, monitor_rect);
+
+    EXPECT_THAT(renderables_from(occlusions), ElementsAre(desktop));
+    EXPECT_THAT(elements.size(), Eq(12u));
+}
+
+TEST_F(OcclusionFilterTest, reports_visible_part_of_partially_covered_window)
+{
+    auto const bottom = std::make_shared<mtd::FakeRenderable>(0, 0, 200, 100);
+    auto const top = std::make_shared<mtd::FakeRenderable>(0, 0, 150, 100);
+    auto elements = scene_elements_from({bottom, top});
+    VisibleRegions partially_visible;
+
+    filter_occlusions_from(elements, monitor_rect, partially_visible);
+
+    EXPECT_THAT(partially_visible.size(), Eq(1u));
+    EXPECT_THAT(partially_visible[bottom->id()], ElementsAre(Rectangle{{150, 0}, {50, 100}}));
+}
+
+TEST_F(OcclusionFilterTest, reports_offscreen_part_of_window_as_not_visible)
+{
+    auto const partially_onscreen = std::make_shared<mtd::FakeRenderable>(-50, 0, 100, 100);
+    auto elements = scene_elements_from({partially_onscreen});
+    VisibleRegions partially_visible;
+
+    filter_occlusions_from(elements, monitor_rect, partially_visible);
+
+    EXPECT_THAT(partially_visible, IsEmpty());
+}
+
+TEST_F(OcclusionFilterTest, translucent_window_partially_covering_leaves_window_fully_visible)
+{
+    auto const bottom = std::make_shared<mtd::FakeRenderable>(0, 0, 200, 100);
+    auto const top = std::make_shared<mtd::FakeRenderable>(Rectangle{{0, 0}, {150, 100}}, 0.5f);
+    auto elements = scene_elements_from({bottom, top});
+    VisibleRegions partially_visible;
+
+    filter_occlusions_from(elements, monitor_rect, partially_visible);
+
+    EXPECT_THAT(partially_visible, IsEmpty());
+}
+
+TEST_F(OcclusionFilterTest, transformed_window_within_opaque_window_is_occluded)
+{
+    auto const shrunk = std::make_shared<TransformedRenderable>(
+        Rectangle{{0, 0}, {200, 200}},
+        glm::scale(glm::mat4(1), glm::vec3{0.5f, 0.5f, 1.0f}));
+    auto const top = std::make_shared<mtd::FakeRenderable>(40, 40, 120, 120);
+    auto elements = scene_elements_from({shrunk, top});
+
+    auto const& occlusions = filter_occlusions_from(elements, monitor_rect);
+
+    EXPECT_THAT(renderables_from(occlusions), ElementsAre(shrunk));
+}
+
+TEST_F(OcclusionFilterTest, transformed_window_occludes_nothing)
+{
+    auto const bottom = std::make_shared<mtd::FakeRenderable>(50, 50, 100, 100);
+    auto const rotated = std::make_shared<TransformedRenderable>(
+        Rectangle{{0, 0}, {200, 200}},
+        glm::rotate(glm::mat4(1), 0.1f, glm::vec3{0.0f, 0.0f, 1.0f}));
+    auto elements = scene_elements_from({bottom, rotated});
+
+    auto const& occlusions = filter_occlusions_from(elements, monitor_rect);
+
+    EXPECT_THAT(renderables_from(occlusions), IsEmpty());
+}
+
+TEST_F(OcclusionFilterTest, clipped_window_only_occludes_within_its_clip_area)
+{
+    auto const bottom = std::make_shared<mtd::FakeRenderable>(0, 0, 100, 100);
+    auto const clipped = std::make_shared<ClippedRenderable>(
+        Rectangle{{0, 0}, {100, 100}},
+        Rectangle{{0, 0}, {100, 50}});
+    auto elements = scene_elements_from({bottom, clipped});
+
+    auto const& occlusions = filter_occlusions_from(elements, monitor_rect);
+
+    EXPECT_THAT(renderables_from(occlusions), IsEmpty());
+}
+
+TEST_F(OcclusionFilterTest, shaped_window_occludes_within_its_opaque_region)
+{
+    auto const top = std::make_shared<mtd::FakeRenderable>(Rectangle{{0, 0}, {200, 200}}, 1.0f, false);
+    top->set_opaque_region({Rectangle{{20, 20}, {160, 160}}});
+    auto const inside = std::make_shared<mtd::FakeRenderable>(50, 50, 100, 100);
+    auto const overlapping_shadow = std::make_shared<mtd::FakeRenderable>(10, 50, 100, 100);
+    auto elements = scene_elements_from({inside, overlapping_shadow, top});
+    VisibleRegions partially_visible;
+
+    auto const& occlusions = filter_occlusions_from(elements, monitor_rect, partially_visible);
+
+    EXPECT_THAT(renderables_from(occlusions), ElementsAre(inside));
+    EXPECT_THAT(renderables_from(elements), ElementsAre(overlapping_shadow, top));
+    EXPECT_THAT(partially_visible[overlapping_shadow->id()], ElementsAre(Rectangle{{10, 50}, {10, 100}}));
+}
+
+TEST_F(OcclusionFilterTest, translucent_window_with_opaque_region_occludes_nothing)
+{
+    auto const top = std::make_shared<mtd::FakeRenderable>(Rectangle{{0, 0}, {200, 200}}, 0.5f, false);
+    top->set_opaque_region({Rectangle{{0, 0}, {200, 200}}});
+    auto const bottom = std::make_shared<mtd::FakeRenderable>(50, 50, 100, 100);
+    auto elements = scene_elements_from({bottom, top});
+
+    auto const& occlusions = filter_occlusions_from(elements, monitor_rect);
+
+    EXPECT_THAT(renderables_from(occlusions), IsEmpty());
+}
+
+TEST_F(OcclusionFilterTest, opaque_region_does_not_reach_beyond_the_window)
+{
+    auto const top = std::make_shared<mtd::FakeRenderable>(Rectangle{{0, 0}, {100, 100}}, 1.0f, false);
+    top->set_opaque_region({Rectangle{{0, 0}, {500, 500}}});
+    auto const beside = std::make_shared<mtd::FakeRenderable>(200, 0, 100, 100);
+    auto elements = scene_elements_from({beside, top});
+
+    auto const& occlusions = filter_occlusions_from(elements, monitor_rect);
+
+    EXPECT_THAT(renderables_from(occlusions), IsEmpty());
+}
@@ -0,0 +1,118 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/compositor/region.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace mc = mir::compositor;
+namespace geom = mir::geometry;
+
+using namespace testing;
+
+TEST(Region, default_is_empty)
+{
+    EXPECT_TRUE(mc::Region{}.empty());
+    EXPECT_THAT(mc::Region{}.rectangles(), IsEmpty());
+}
+
+TEST(Region, empty_rectangle_gives_empty_region)
+{
+    mc::Region const region{geom::Rectangle{{10, 10}, {0, 10}}};
+
+    EXPECT_TRUE(region.empty());
+}
+
+TEST(Region, holds_a_rectangle)
+{
+    geom::Rectangle const rect{{10, 20}, {30, 40}};
+
+    EXPECT_THAT(mc::Region{rect}.rectangles(), ElementsAre(rect));
+}
+
+TEST(Region, union_of_abutting_rectangles_is_a_rectangle)
+{
+    mc::Region region{geom::Rectangle{{0, 0}, {50, 100}}};
+    region.unite(geom::Rectangle{{50, 0}, {50, 100}});
+    region.unite(geom::Rectangle{{0, 100}, {100, 20}});
+
+    EXPECT_THAT(region.rectangles(), ElementsAre(geom::Rectangle{{0, 0}, {100, 120}}));
+}
+
+TEST(Region, union_of_overlapping_rectangles_has_no_overlaps)
+{
+    mc::Region region{geom::Rectangle{{0, 0}, {100, 100}}};
+    region.unite(geom::Rectangle{{50, 50}, {100, 100}});
+
+    EXPECT_THAT(region.rectangles(), ElementsAre(
+        geom::Rectangle{{0, 0}, {100, 50}},
+        geom::Rectangle{{0, 50}, {150, 50}},
+        geom::Rectangle{{50, 100}, {100, 50}}));
+}
+
+TEST(Region, subtracting_punches_a_hole)
+{
+    mc::Region region{geom::Rectangle{{0, 0}, {30, 30}}};
+    region.subtract(geom::Rectangle{{10, 10}, {10, 10}});
+
+    EXPECT_THAT(region.rectangles(), ElementsAre(
+        geom::Rectangle{{0, 0}, {30, 10}},
+        geom::Rectangle{{0, 10}, {10, 10}},
+        geom::Rectangle{{20, 10}, {10, 10}},
+        geom::Rectangle{{0, 20}, {30, 10}}));
+    EXPECT_FALSE(region.contains({{5, 5}, {10, 10}}));
+    EXPECT_TRUE(region.contains({{0, 0}, {30, 10}}));
+}
+
+TEST(Region, subtracting_everything_leaves_nothing)
+{
+    mc::Region region{geom::Rectangle{{0, 0}, {30, 30}}};
+    region.subtract(geom::Rectangle{{-10, -10}, {50, 50}});
+
+    EXPECT_TRUE(region.empty());
+}
+
+TEST(Region, intersection_keeps_the_common_part)
+{
+    mc::Region region{geom::Rectangle{{0, 0}, {30, 30}}};
+    region.intersect(geom::Rectangle{{20, 20}, {30, 30}});
+
+    EXPECT_THAT(region.rectangles(), ElementsAre(geom::Rectangle{{20, 20}, {10, 10}}));
+}
+
+TEST(Region, contains_a_rectangle_covered_only_by_the_union)
+{
+    mc::Region region{geom::Rectangle{{0, 0}, {50, 100}}};
+    region.unite(geom::Rectangle{{50, 0}, {50, 50}});
+    region.unite(geom::Rectangle{{50, 50}, {50, 50}});
+
+    EXPECT_TRUE(region.contains({{25, 25}, {50, 50}}));
+    EXPECT_FALSE(region.contains({{25, 25}, {100, 50}}));
+    EXPECT_TRUE(region.overlaps({{25, 25}, {100, 50}}));
+    EXPECT_FALSE(region.overlaps({{100, 0}, {10, 10}}));
+}
+
+TEST(Region, equal_areas_compare_equal_however_they_were_built)
+{
+    mc::Region by_columns{geom::Rectangle{{0, 0}, {10, 20}}};
+    by_columns.unite(geom::Rectangle{{10, 0}, {10, 20}});
+    mc::Region by_rows{geom::Rectangle{{0, 0}, {20, 10}}};
+    by_rows.unite(geom::Rectangle{{0, 10}, {20, 10}});
+
+    EXPECT_THAT(by_columns, Eq(by_rows));
+    EXPECT_THAT(by_columns, Ne(mc::Region{geom::Rectangle{{0, 0}, {20, 21}}}));
+}
@@ -241,3 +241,35 @@ TEST_F(Stream, stream_remembers_scale_when_buffer_added)
     stream.submit_buffer(buffers[0]);
     ASSERT_THAT(stream.stream_size(), Eq(initial_size / 2));
 }
+
+TEST_F(Stream, reports_submitted_damage_between_buffers)
+{
+    std::vector<geom::Rectangle> const damage1{{{0, 0}, {10, 1}}};
+    std::vector<geom::Rectangle> const damage2{{{20, 1}, {4, 1}}};
+
+    stream.submit_buffer(buffers[0]);
+    stream.submit_buffer(buffers[1], damage1);
+    stream.submit_buffer(buffers[2], damage2);
+
+    EXPECT_THAT(stream.damage_between(buffers[1]->id(), buffers[2]->id()).value(), ElementsAre(damage2[0]));
+    EXPECT_THAT(stream.damage_between(buffers[0]->id(), buffers[2]->id()).value(),
+        ElementsAre(damage1[0], damage2[0]));
+    EXPECT_THAT(stream.damage_between(buffers[2]->id(), buffers[2]->id()).value(), IsEmpty());
+}
+
+TEST_F(Stream, damage_is_unknown_across_a_buffer_submitted_without_damage)
+{
+    stream.submit_buffer(buffers[0], {{{0, 0}, {1, 1}}});
+    stream.submit_buffer(buffers[1]);
+    stream.submit_buffer(buffers[2], {{{0, 0}, {1, 1}}});
+
+    EXPECT_FALSE(stream.damage_between(buffers[0]->id(), buffers[2]->id()));
+}
+
+TEST_F(Stream, damage_is_unknown_from_an_unknown_buffer)
+{
+    mtd::StubBuffer other_buffer{initial_size};
+    stream.submit_buffer(buffers[0], {{{0, 0}, {1, 1}}});
+
+    EXPECT_FALSE(stream.damage_between(other_buffer.id(), buffers[0]->id()));
+}
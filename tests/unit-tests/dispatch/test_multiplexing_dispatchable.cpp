@@ -28,7 +28,9 @@
 #include <fcntl.h>
 
 #include <atomic>
+#include <stdexcept>
 #include <thread>
+#include <vector>
 
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
@@ -490,3 +492,98 @@ TEST(MultiplexingDispatchableTest, automatic_removals_are_threadsafe)
     
     dispatchee->trigger();
 }
+
+TEST(MultiplexingDispatchableTest, batched_dispatch_handles_all_ready_dispatchees_at_once)
+{
+    int dispatch_count{0};
+    md::MultiplexingDispatchable dispatcher{4};
+
+    std::vector<std::shared_ptr<mt::TestDispatchable>> dispatchees;
+    for (int i = 0; i != 3; ++i)
+    {
+        dispatchees.push_back(std::make_shared<mt::TestDispatchable>([&dispatch_count]() { ++dispatch_count; }));
+        dispatcher.add_watch(dispatchees.back());
+        dispatchees.back()->trigger();
+    }
+
+    ASSERT_TRUE(mt::fd_is_readable(dispatcher.watch_fd()));
+    dispatcher.dispatch(md::FdEvent::readable);
+
+    EXPECT_THAT(dispatch_count, testing::Eq(3));
+    EXPECT_FALSE(mt::fd_is_readable(dispatcher.watch_fd()));
+}
+
+TEST(MultiplexingDispatchableTest, batched_dispatch_rearms_sequential_dispatchees)
+{
+    int dispatch_count{0};
+    auto dispatchee = std::make_shared<mt::TestDispatchable>([&dispatch_count]() { ++dispatch_count; });
+    md::MultiplexingDispatchable dispatcher{4};
+    dispatcher.add_watch(dispatchee);
+
+    for (int i = 0; i != 3; ++i)
+    {
+        dispatchee->trigger();
+        ASSERT_TRUE(mt::fd_is_readable(dispatcher.watch_fd()));
+        dispatcher.dispatch(md::FdEvent::readable);
+    }
+
+    EXPECT_THAT(dispatch_count, testing::Eq(3));
+}
+
+TEST(MultiplexingDispatchableTest, batched_dispatch_skips_dispatchees_removed_earlier_in_the_batch)
+{
+    md::MultiplexingDispatchable dispatcher{2};
+    int dispatch_count{0};
+
+    std::shared_ptr<mt::TestDispatchable> first, second;
+    first = std::make_shared<mt::TestDispatchable>(
+        [&]() { ++dispatch_count; dispatcher.remove_watch(second); });
+    second = std::make_shared<mt::TestDispatchable>(
+        [&]() { ++dispatch_count; dispatcher.remove_watch(first); });
+
+    dispatcher.add_watch(first);
+    dispatcher.add_watch(second);
+    first->trigger();
+    second->trigger();
+
+    dispatcher.dispatch(md::FdEvent::readable);
+
+    EXPECT_THAT(dispatch_count, testing::Eq(1));
+}
+
+TEST(MultiplexingDispatchableTest, batched_dispatch_rearms_rest_of_batch_when_a_dispatchee_throws)
+{
+    md::MultiplexingDispatchable dispatcher{2};
+    int dispatch_count{0};
+    auto const throw_once = [&dispatch_count](md::FdEvents)
+        {
+            if (dispatch_count++ == 0)
+                throw std::runtime_error{"Boom"};
+            return true;
+        };
+
+    auto const first = std::make_shared<mt::TestDispatchable>(throw_once);
+    auto const second = std::make_shared<mt::TestDispatchable>(throw_once);
+    dispatcher.add_watch(first);
+    dispatcher.add_watch(second);
+    first->trigger();
+    second->trigger();
+
+    EXPECT_THROW(dispatcher.dispatch(md::FdEvent::readable), std::runtime_error);
+
+    ASSERT_TRUE(mt::fd_is_readable(dispatcher.watch_fd()));
+    dispatcher.dispatch(md::FdEvent::readable);
+
+    EXPECT_THAT(dispatch_count, testing::Eq(2));
+}
+
+TEST(MultiplexingDispatchableTest, batch_size_must_be_positive)
+{
+    EXPECT_THROW(md::MultiplexingDispatchable(0), std::invalid_argument);
+}
+
+TEST(MultiplexingDispatchableTest, batch_size_is_limited)
+{
+    EXPECT_NO_THROW(md::MultiplexingDispatchable(md::MultiplexingDispatchable::max_batch_size));
+    EXPECT_THROW(md::MultiplexingDispatchable(md::MultiplexingDispatchable::max_batch_size + 1), std::invalid_argument);
+}
@@ -0,0 +1,189 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/frontend/socket_messenger.h"
+#include "mir/fd_socket_transmission.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <boost/asio.hpp>
+
+#include <thread>
+#include <unistd.h>
+
+namespace mf = mir::frontend;
+namespace mfd = mf::detail;
+namespace ba = boost::asio;
+
+using namespace testing;
+
+namespace
+{
+/// Nearly the largest message the two byte header allows
+size_t const big_message{60000};
+
+struct SocketMessenger : Test
+{
+    SocketMessenger()
+    {
+        ba::local::connect_pair(*server_socket, client_socket);
+        messenger = std::make_shared<mfd::SocketMessenger>(server_socket);
+    }
+
+    ~SocketMessenger()
+    {
+        io.stop();
+        if (io_thread.joinable())
+            io_thread.join();
+    }
+
+    /// Lets the messenger flush its queue as the client reads
+    void run_io()
+    {
+        io_thread = std::thread{[this] { ba::io_service::work work{io}; io.run(); }};
+    }
+
+    auto receive(size_t length) -> std::string
+    {
+        std::string message(length, '\0');
+        ba::read(client_socket, ba::buffer(&message[0], length));
+        return message;
+    }
+
+    auto receive_message() -> std::string
+    {
+        auto const header = receive(2);
+        auto const length =
+            static_cast<unsigned char>(header[0]) << 8 | static_cast<unsigned char>(header[1]);
+        return receive(length);
+    }
+
+    auto receive_fd() -> mir::Fd
+    {
+        std::vector<mir::Fd> fds(1);
+        char marker;
+        mir::receive_data(mir::Fd{mir::IntOwnedFd{client_socket.native_handle()}}, &marker, 1, fds);
+        return fds[0];
+    }
+
+    void send(std::string const& message, mf::FdSets const& fds = {})
+    {
+        messenger->send(message.data(), message.size(), fds);
+    }
+
+    ba::io_service io;
+    std::thread io_thread;
+    std::shared_ptr<ba::local::stream_protocol::socket> const server_socket{
+        std::make_shared<ba::local::stream_protocol::socket>(io)};
+    ba::local::stream_protocol::socket client_socket{io};
+    std::shared_ptr<mfd::SocketMessenger> messenger;
+};
+
+auto numbered_message(int i) -> std::string
+{
+    auto message = std::to_string(i);
+    message.resize(big_message, '.');
+    return message;
+}
+
+auto pipe_read_end() -> mir::Fd
+{
+    int fds[2];
+    if (pipe(fds))
+        throw std::system_error{errno, std::system_category(), "Failed to create pipe"};
+
+    ::close(fds[1]);
+    return mir::Fd{fds[0]};
+}
+}
+
+TEST_F(SocketMessenger, sends_a_message_after_its_length)
+{
+    send("Hello");
+
+    EXPECT_THAT(receive(2), Eq(std::string{'\0', '\5'}));
+    EXPECT_THAT(receive(5), Eq("Hello"));
+}
+
+TEST_F(SocketMessenger, sends_fds_after_their_message)
+{
+    send("buffer", {{pipe_read_end()}});
+
+    EXPECT_THAT(receive_message(), Eq("buffer"));
+    EXPECT_THAT(fcntl(receive_fd(), F_GETFD), Ne(-1));
+}
+
+TEST_F(SocketMessenger, does_not_block_when_the_client_is_not_reading)
+{
+    int const messages = 20;
+
+    // Much more than the socket holds, so most are queued
+    for (int i = 0; i != messages; ++i)
+        send(numbered_message(i));
+
+    run_io();
+
+    for (int i = 0; i != messages; ++i)
+        EXPECT_THAT(receive_message(), Eq(numbered_message(i)));
+}
+
+TEST_F(SocketMessenger, queued_fds_stay_with_their_message)
+{
+    send(numbered_message(0));
+    send(numbered_message(1));
+    send("buffer", {{pipe_read_end()}});
+    send("after");
+
+    run_io();
+
+    receive_message();
+    receive_message();
+    EXPECT_THAT(receive_message(), Eq("buffer"));
+    EXPECT_THAT(fcntl(receive_fd(), F_GETFD), Ne(-1));
+    EXPECT_THAT(receive_message(), Eq("after"));
+}
+
+TEST_F(SocketMessenger, disconnects_a_client_that_lets_too_much_queue_up)
+{
+    auto const messages = mfd::SocketMessenger::max_queued_bytes / big_message + 10;
+
+    for (auto i = 0u; i != messages; ++i)
+        send(numbered_message(i));
+
+    std::vector<char> everything(messages * (big_message + 2));
+    boost::system::error_code error;
+    auto const received = ba::read(client_socket, ba::buffer(everything), error);
+
+    EXPECT_THAT(error, Eq(ba::error::eof));
+    EXPECT_THAT(received, Lt(everything.size()));
+}
+
+TEST_F(SocketMessenger, disconnects_a_client_that_lets_too_many_fds_queue_up)
+{
+    for (int i = 0; i != 3; ++i)
+        send(numbered_message(i));
+
+    auto const fd = pipe_read_end();
+    for (auto i = 0u; i != mfd::SocketMessenger::max_queued_fds + 1; ++i)
+        send("buffer", {{fd}});
+
+    std::vector<char> everything(4 * big_message);
+    boost::system::error_code error;
+    ba::read(client_socket, ba::buffer(everything), error);
+
+    EXPECT_THAT(error, Eq(ba::error::eof));
+}
@@ -0,0 +1,215 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/gl/recently_used_cache.h"
+
+#include "mir/test/doubles/mock_gl.h"
+#include "mir/test/doubles/mock_gl_buffer.h"
+#include "mir/test/doubles/mock_renderable.h"
+#include "mir/test/doubles/stub_buffer.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace mg = mir::graphics;
+namespace mgl = mir::gl;
+namespace geom = mir::geometry;
+namespace mtd = mir::test::doubles;
+
+using namespace ::testing;
+
+namespace
+{
+// 10×10 ARGB
+size_t const texture_bytes{400};
+
+struct RecentlyUsedCache : Test
+{
+    RecentlyUsedCache()
+    {
+        for (auto const& renderable : {first, second})
+        {
+            ON_CALL(*renderable, id()).WillByDefault(Return(renderable.get()));
+        }
+    }
+
+    void show(
+        std::shared_ptr<mtd::MockRenderable> const& renderable,
+        std::shared_ptr<mtd::MockGLBuffer> const& buffer)
+    {
+        ON_CALL(*renderable, buffer()).WillByDefault(Return(buffer));
+    }
+
+    std::shared_ptr<mtd::MockGLBuffer> new_buffer()
+    {
+        auto const buffer = std::make_shared<NiceMock<mtd::MockGLBuffer>>(
+            geom::Size{10, 10}, geom::Stride{40}, mir_pixel_format_argb_8888);
+        ON_CALL(*buffer, id()).WillByDefault(Return(mg::BufferID{++buffer_count}));
+        return buffer;
+    }
+
+    uint32_t buffer_count{0};
+    NiceMock<mtd::MockGL> mock_gl;
+    std::shared_ptr<mtd::MockRenderable> const first{std::make_shared<NiceMock<mtd::MockRenderable>>()};
+    std::shared_ptr<mtd::MockRenderable> const second{std::make_shared<NiceMock<mtd::MockRenderable>>()};
+};
+}
+
+TEST_F(RecentlyUsedCache, binds_buffer_only_when_it_changes)
+{
+    mgl::RecentlyUsedCache cache;
+    auto const buffer = new_buffer();
+    show(first, buffer);
+
+    EXPECT_CALL(*buffer, bind()).Times(1);
+
+    cache.load(*first);
+    cache.drop_unused();
+    cache.load(*first);
+
+    auto const stats = cache.statistics();
+    EXPECT_THAT(stats.rebinds, Eq(1u));
+    EXPECT_THAT(stats.hits, Eq(1u));
+    EXPECT_THAT(stats.resident_bytes, Eq(texture_bytes));
+}
+
+TEST_F(RecentlyUsedCache, rebinds_new_buffer_into_same_texture)
+{
+    mgl::RecentlyUsedCache cache;
+    auto const buffer = new_buffer();
+    auto const next_buffer = new_buffer();
+
+    show(first, buffer);
+    auto const texture = cache.load(*first);
+    cache.drop_unused();
+
+    show(first, next_buffer);
+    EXPECT_CALL(*next_buffer, bind()).Times(1);
+
+    EXPECT_THAT(cache.load(*first), Eq(texture));
+}
+
+TEST_F(RecentlyUsedCache, keeps_textures_of_renderables_not_drawn_while_within_budget)
+{
+    mgl::RecentlyUsedCache cache{2 * texture_bytes};
+    auto const buffer = new_buffer();
+    show(first, buffer);
+
+    auto const texture = cache.load(*first);
+    cache.drop_unused();
+    cache.drop_unused();    // A frame where first was occluded
+    cache.drop_unused();
+
+    EXPECT_CALL(*buffer, bind()).Times(0);
+
+    EXPECT_THAT(cache.load(*first), Eq(texture));
+    EXPECT_THAT(cache.statistics().evictions, Eq(0u));
+}
+
+TEST_F(RecentlyUsedCache, evicts_least_recently_used_textures_beyond_budget)
+{
+    mgl::RecentlyUsedCache cache{texture_bytes};
+    auto const first_buffer = new_buffer();
+    auto const second_buffer = new_buffer();
+    show(first, first_buffer);
+    show(second, second_buffer);
+
+    cache.load(*first);
+    cache.load(*second);
+    cache.drop_unused();
+    cache.drop_unused();
+
+    EXPECT_THAT(cache.statistics().evictions, Eq(1u));
+    EXPECT_THAT(cache.statistics().resident_bytes, Eq(texture_bytes));
+
+    EXPECT_CALL(*second_buffer, bind()).Times(0);
+    EXPECT_CALL(*first_buffer, bind()).Times(1);
+
+    cache.load(*second);
+    cache.load(*first);
+}
+
+TEST_F(RecentlyUsedCache, frees_texture_not_drawn_once_its_buffer_is_gone_even_within_budget)
+{
+    mgl::RecentlyUsedCache cache;
+    show(first, new_buffer());
+
+    cache.load(*first);
+    cache.drop_unused();
+
+    // The renderable, and with it the last reference to its buffer, goes away
+    Mock::VerifyAndClear(first.get());
+    cache.drop_unused();
+
+    EXPECT_THAT(cache.statistics().expiries, Eq(1u));
+    EXPECT_THAT(cache.statistics().evictions, Eq(0u));
+    EXPECT_THAT(cache.statistics().resident_bytes, Eq(0u));
+}
+
+TEST_F(RecentlyUsedCache, keeps_texture_drawn_in_the_last_frame_even_if_its_buffer_is_gone)
+{
+    mgl::RecentlyUsedCache cache;
+    show(first, new_buffer());
+
+    cache.load(*first);
+    Mock::VerifyAndClear(first.get());
+    cache.drop_unused();
+
+    EXPECT_THAT(cache.statistics().expiries, Eq(0u));
+    EXPECT_THAT(cache.statistics().resident_bytes, Eq(texture_bytes));
+
+    cache.drop_unused();
+
+    EXPECT_THAT(cache.statistics().expiries, Eq(1u));
+}
+
+TEST_F(RecentlyUsedCache, never_evicts_textures_drawn_in_the_last_frame)
+{
+    mgl::RecentlyUsedCache cache{0};
+    auto const first_buffer = new_buffer();
+    auto const second_buffer = new_buffer();
+    show(first, first_buffer);
+    show(second, second_buffer);
+
+    cache.load(*first);
+    cache.load(*second);
+    cache.drop_unused();
+
+    EXPECT_THAT(cache.statistics().evictions, Eq(0u));
+    EXPECT_THAT(cache.statistics().resident_bytes, Eq(2 * texture_bytes));
+}
+
+TEST_F(RecentlyUsedCache, invalidate_forces_rebind)
+{
+    mgl::RecentlyUsedCache cache;
+    auto const buffer = new_buffer();
+    show(first, buffer);
+
+    EXPECT_CALL(*buffer, bind()).Times(2);
+
+    cache.load(*first);
+    cache.drop_unused();
+    cache.invalidate();
+    cache.load(*first);
+}
+
+TEST_F(RecentlyUsedCache, throws_for_buffer_not_supporting_gl)
+{
+    mgl::RecentlyUsedCache cache;
+    ON_CALL(*first, buffer()).WillByDefault(Return(std::make_shared<mtd::StubBuffer>()));
+
+    EXPECT_THROW(cache.load(*first), std::logic_error);
+}
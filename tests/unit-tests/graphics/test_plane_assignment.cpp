@@ -0,0 +1,100 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/platforms/common/server/plane_assignment.h"
+#include "mir/test/doubles/fake_renderable.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+using namespace testing;
+namespace mg = mir::graphics;
+namespace mgc = mir::graphics::common;
+namespace geom = mir::geometry;
+namespace mtd = mir::test::doubles;
+
+namespace
+{
+struct PlaneAssignment : Test
+{
+    geom::Rectangle const view_area{{0, 0}, {1920, 1080}};
+
+    std::shared_ptr<mtd::FakeRenderable> const background{
+        std::make_shared<mtd::FakeRenderable>(geom::Rectangle{{0, 0}, {1920, 1080}})};
+    std::shared_ptr<mtd::FakeRenderable> const video{
+        std::make_shared<mtd::FakeRenderable>(geom::Rectangle{{100, 100}, {1280, 720}})};
+    std::shared_ptr<mtd::FakeRenderable> const notification{
+        std::make_shared<mtd::FakeRenderable>(geom::Rectangle{{1500, 50}, {400, 100}})};
+
+    mgc::PlaneAssignment::Predicate const anything_can_scan_out{[](mg::Renderable const&) { return true; }};
+};
+}
+
+TEST_F(PlaneAssignment, top_of_stack_renderables_become_overlays)
+{
+    mgc::PlaneAssignment assignment{{background, video, notification}, view_area, anything_can_scan_out};
+
+    EXPECT_THAT(assignment.overlays(), ElementsAre(background, video, notification));
+    EXPECT_THAT(assignment.composited(), IsEmpty());
+}
+
+TEST_F(PlaneAssignment, renderables_the_hardware_cant_scan_out_are_composited)
+{
+    mgc::PlaneAssignment assignment{
+        {background, video, notification},
+        view_area,
+        [this](mg::Renderable const& renderable) { return &renderable != notification.get(); }};
+
+    // The background is beneath the composited notification, but the video doesn't overlap it
+    EXPECT_THAT(assignment.overlays(), ElementsAre(video));
+    EXPECT_THAT(assignment.composited(), ElementsAre(background, notification));
+}
+
+TEST_F(PlaneAssignment, renderables_under_composited_ones_are_composited)
+{
+    auto const dialog = std::make_shared<mtd::FakeRenderable>(
+        geom::Rectangle{{200, 200}, {300, 300}}, 0.5f);
+
+    mgc::PlaneAssignment assignment{{background, video, dialog, notification}, view_area, anything_can_scan_out};
+
+    EXPECT_THAT(assignment.overlays(), ElementsAre(notification));
+    EXPECT_THAT(assignment.composited(), ElementsAre(background, video, dialog));
+}
+
+TEST_F(PlaneAssignment, offscreen_and_partially_visible_renderables_are_not_overlays)
+{
+    auto const offscreen = std::make_shared<mtd::FakeRenderable>(geom::Rectangle{{3000, 0}, {100, 100}});
+    auto const straddling = std::make_shared<mtd::FakeRenderable>(geom::Rectangle{{1900, 0}, {100, 100}});
+
+    mgc::PlaneAssignment assignment{{straddling, offscreen}, view_area, anything_can_scan_out};
+
+    EXPECT_THAT(assignment.overlays(), IsEmpty());
+    EXPECT_THAT(assignment.composited(), ElementsAre(straddling));
+}
+
+TEST_F(PlaneAssignment, compositing_lowest_overlay_keeps_stacking_order)
+{
+    mgc::PlaneAssignment assignment{{background, video, notification}, view_area, anything_can_scan_out};
+
+    ASSERT_TRUE(assignment.composite_lowest_overlay());
+    EXPECT_THAT(assignment.overlays(), ElementsAre(video, notification));
+    EXPECT_THAT(assignment.composited(), ElementsAre(background));
+
+    ASSERT_TRUE(assignment.composite_lowest_overlay());
+    ASSERT_TRUE(assignment.composite_lowest_overlay());
+    EXPECT_FALSE(assignment.composite_lowest_overlay());
+    EXPECT_THAT(assignment.composited(), ElementsAre(background, video, notification));
+}
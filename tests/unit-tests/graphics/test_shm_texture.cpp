@@ -0,0 +1,248 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/platforms/common/server/shm_texture.h"
+#include "src/platforms/common/server/egl_context_executor.h"
+#include "mir/renderer/gl/context.h"
+
+#include "mir/test/doubles/mock_gl.h"
+#include "mir/test/doubles/mock_egl.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <GLES2/gl2ext.h>
+#include <EGL/egl.h>
+
+namespace mgc = mir::graphics::common;
+namespace mtd = mir::test::doubles;
+namespace geom = mir::geometry;
+using namespace testing;
+
+namespace
+{
+class DumbGLContext : public mir::renderer::gl::Context
+{
+public:
+    void make_current() const override
+    {
+    }
+
+    void release_current() const override
+    {
+    }
+};
+
+struct ShmTextureTest : public Test
+{
+    ShmTextureTest()
+        : pixels(stride.as_int() * size.height.as_int())
+    {
+        ON_CALL(mock_gl, glGenTextures(1, _))
+            .WillByDefault(SetArgPointee<1>(tex_id));
+        make_current(context_a);
+    }
+
+    void make_current(EGLContext context)
+    {
+        eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, context);
+    }
+
+    void enable_fences()
+    {
+        ON_CALL(mock_egl, eglQueryString(_, EGL_EXTENSIONS))
+            .WillByDefault(Return("EGL_KHR_fence_sync EGL_KHR_wait_sync"));
+        ON_CALL(mock_egl, eglCreateSyncKHR(_, EGL_SYNC_FENCE_KHR, _))
+            .WillByDefault(InvokeWithoutArgs(
+                [this]() { return reinterpret_cast<EGLSyncKHR>(++next_fence); }));
+    }
+
+    auto pixels_at(int x, int y) const -> unsigned char const*
+    {
+        return pixels.data() + y * stride.as_int() + x * bytes_per_pixel;
+    }
+
+    NiceMock<mtd::MockEGL> mock_egl;
+    NiceMock<mtd::MockGL> mock_gl;
+
+    EGLDisplay const dpy{reinterpret_cast<void*>(0xdeebbeed)};
+    EGLContext const context_a{reinterpret_cast<void*>(0xa)};
+    EGLContext const context_b{reinterpret_cast<void*>(0xb)};
+    uintptr_t next_fence{0x1000};
+    GLuint const tex_id{7};
+
+    geom::Size const size{64, 32};
+    int const bytes_per_pixel{4};
+    // Wider than the buffer, so uploads need to address rows by stride
+    geom::Stride const stride{80 * bytes_per_pixel};
+    std::vector<unsigned char> const pixels;
+
+    mgc::ShmTexture texture{
+        std::make_shared<mgc::EGLContextExecutor>(std::make_unique<DumbGLContext>()),
+        size,
+        mir_pixel_format_argb_8888};
+};
+}
+
+TEST_F(ShmTextureTest, first_update_uploads_whole_buffer)
+{
+    EXPECT_CALL(mock_gl, glPixelStorei(_, _))
+        .Times(AnyNumber());
+    EXPECT_CALL(mock_gl, glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, 80));
+    EXPECT_CALL(mock_gl, glTexImage2D(
+        GL_TEXTURE_2D, 0, _, size.width.as_int(), size.height.as_int(), 0, _, _, pixels.data()));
+    EXPECT_CALL(mock_gl, glTexSubImage2D(_, _, _, _, _, _, _, _, _))
+        .Times(0);
+
+    auto const frame = texture.add_frame(std::vector<geom::Rectangle>{{{1, 1}, {2, 2}}});
+    texture.update_to(frame, pixels.data(), stride);
+}
+
+TEST_F(ShmTextureTest, later_updates_upload_only_damage)
+{
+    texture.update_to(texture.add_frame({}), pixels.data(), stride);
+
+    EXPECT_CALL(mock_gl, glTexImage2D(_, _, _, _, _, _, _, _, _))
+        .Times(0);
+    EXPECT_CALL(mock_gl, glTexSubImage2D(GL_TEXTURE_2D, 0, 10, 20, 30, 5, _, _, pixels_at(10, 20)));
+
+    auto const frame = texture.add_frame(std::vector<geom::Rectangle>{{{10, 20}, {30, 5}}});
+    texture.update_to(frame, pixels.data(), stride);
+}
+
+TEST_F(ShmTextureTest, damage_outside_buffer_is_clipped)
+{
+    texture.update_to(texture.add_frame({}), pixels.data(), stride);
+
+    EXPECT_CALL(mock_gl, glTexSubImage2D(GL_TEXTURE_2D, 0, 60, 30, 4, 2, _, _, pixels_at(60, 30)));
+
+    auto const frame = texture.add_frame(std::vector<geom::Rectangle>{{{60, 30}, {100, 100}}});
+    texture.update_to(frame, pixels.data(), stride);
+}
+
+TEST_F(ShmTextureTest, damage_of_skipped_frames_is_accumulated)
+{
+    texture.update_to(texture.add_frame({}), pixels.data(), stride);
+
+    EXPECT_CALL(mock_gl, glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 8, 8, _, _, pixels_at(0, 0)));
+    EXPECT_CALL(mock_gl, glTexSubImage2D(GL_TEXTURE_2D, 0, 16, 4, 8, 8, _, _, pixels_at(16, 4)));
+
+    // The second frame is never bound, so the third must carry its damage too
+    texture.add_frame(std::vector<geom::Rectangle>{{{0, 0}, {8, 8}}});
+    auto const third = texture.add_frame(std::vector<geom::Rectangle>{{{16, 4}, {8, 8}}});
+    texture.update_to(third, pixels.data(), stride);
+}
+
+TEST_F(ShmTextureTest, skipped_frame_with_unknown_damage_uploads_whole_buffer)
+{
+    texture.update_to(texture.add_frame({}), pixels.data(), stride);
+
+    EXPECT_CALL(mock_gl, glTexSubImage2D(
+        GL_TEXTURE_2D, 0, 0, 0, size.width.as_int(), size.height.as_int(), _, _, pixels.data()));
+
+    texture.add_frame(std::experimental::nullopt);
+    auto const third = texture.add_frame(std::vector<geom::Rectangle>{{{16, 4}, {8, 8}}});
+    texture.update_to(third, pixels.data(), stride);
+}
+
+TEST_F(ShmTextureTest, rebinding_older_buffer_keeps_newer_contents)
+{
+    auto const first = texture.add_frame({});
+    auto const second = texture.add_frame(std::vector<geom::Rectangle>{{{0, 0}, {8, 8}}});
+    texture.update_to(second, pixels.data(), stride);
+
+    // The older frame's pixels must not overwrite what the texture already shows of the newer
+    EXPECT_CALL(mock_gl, glTexImage2D(_, _, _, _, _, _, _, _, _))
+        .Times(0);
+    EXPECT_CALL(mock_gl, glTexSubImage2D(_, _, _, _, _, _, _, _, _))
+        .Times(0);
+    EXPECT_CALL(mock_gl, glBindTexture(GL_TEXTURE_2D, tex_id));
+
+    std::vector<unsigned char> const older_pixels(pixels.size());
+    texture.update_to(first, older_pixels.data(), stride);
+    texture.bind();
+}
+
+TEST_F(ShmTextureTest, other_context_waits_for_upload_before_sampling)
+{
+    enable_fences();
+
+    EGLSyncKHR upload_fence{EGL_NO_SYNC_KHR};
+    EXPECT_CALL(mock_egl, eglCreateSyncKHR(_, EGL_SYNC_FENCE_KHR, _))
+        .WillOnce(InvokeWithoutArgs(
+            [&]()
+            {
+                upload_fence = reinterpret_cast<EGLSyncKHR>(++next_fence);
+                return upload_fence;
+            }));
+    EXPECT_CALL(mock_gl, glFlush());
+
+    texture.update_to(texture.add_frame({}), pixels.data(), stride);
+
+    // The uploading context's own commands are already in order
+    EXPECT_CALL(mock_egl, eglWaitSyncKHR(_, _, _))
+        .Times(0);
+    texture.bind();
+    Mock::VerifyAndClearExpectations(&mock_egl);
+
+    make_current(context_b);
+    {
+        InSequence seq;
+        EXPECT_CALL(mock_egl, eglWaitSyncKHR(_, upload_fence, 0));
+        EXPECT_CALL(mock_gl, glBindTexture(GL_TEXTURE_2D, _));
+    }
+    texture.bind();
+}
+
+TEST_F(ShmTextureTest, upload_waits_for_other_contexts_to_finish_sampling)
+{
+    enable_fences();
+    texture.update_to(texture.add_frame({}), pixels.data(), stride);
+
+    make_current(context_b);
+    texture.bind();
+
+    EGLSyncKHR use_fence{EGL_NO_SYNC_KHR};
+    EXPECT_CALL(mock_egl, eglCreateSyncKHR(_, EGL_SYNC_FENCE_KHR, _))
+        .WillOnce(InvokeWithoutArgs(
+            [&]()
+            {
+                use_fence = reinterpret_cast<EGLSyncKHR>(++next_fence);
+                return use_fence;
+            }));
+    texture.add_syncpoint();
+    Mock::VerifyAndClearExpectations(&mock_egl);
+
+    make_current(context_a);
+    {
+        InSequence seq;
+        EXPECT_CALL(mock_egl, eglWaitSyncKHR(_, use_fence, 0));
+        EXPECT_CALL(mock_gl, glTexSubImage2D(_, _, _, _, _, _, _, _, _));
+    }
+    auto const frame = texture.add_frame(std::vector<geom::Rectangle>{{{0, 0}, {8, 8}}});
+    texture.update_to(frame, pixels.data(), stride);
+}
+
+TEST_F(ShmTextureTest, without_fences_upload_is_completed_before_other_contexts_sample)
+{
+    ON_CALL(mock_egl, eglQueryString(_, EGL_EXTENSIONS))
+        .WillByDefault(Return(""));
+
+    Expectation upload = EXPECT_CALL(mock_gl, glTexImage2D(_, _, _, _, _, _, _, _, _));
+    EXPECT_CALL(mock_gl, glFinish())
+        .After(upload);
+
+    texture.update_to(texture.add_frame({}), pixels.data(), stride);
+}
@@ -17,6 +17,7 @@
  */
 
 #include "src/server/input/default_input_device_hub.h"
+#include "mir/input/input_latencies.h"
 
 #include "mir/test/doubles/mock_input_device.h"
 #include "mir/test/doubles/mock_input_device_observer.h"
@@ -28,6 +29,7 @@
 #include "mir/test/doubles/stub_cursor_listener.h"
 #include "mir/test/doubles/stub_touch_visualizer.h"
 #include "mir/test/doubles/triggered_main_loop.h"
+#include "mir/test/doubles/advanceable_clock.h"
 #include "mir/test/event_matchers.h"
 #include "mir/test/fake_shared.h"
 #include "mir/test/fd_utils.h"
@@ -83,9 +85,11 @@ struct InputDeviceHubTest : ::testing::Test
     NiceMock<mtd::MockInputSeat> mock_seat;
     NiceMock<mtd::MockKeyMapper> mock_key_mapper;
     NiceMock<mtd::MockServerStatusListener> mock_server_status_listener;
+    std::shared_ptr<mtd::AdvanceableClock> clock = std::make_shared<mtd::AdvanceableClock>();
+    std::shared_ptr<mi::InputLatencies> latencies = std::make_shared<mi::InputLatencies>(clock);
     mi::DefaultInputDeviceHub hub{mt::fake_shared(mock_seat), mt::fake_shared(multiplexer),
                                   cookie_authority, mt::fake_shared(mock_key_mapper),
-                                  mt::fake_shared(mock_server_status_listener)};
+                                  mt::fake_shared(mock_server_status_listener), latencies};
     NiceMock<mtd::MockInputDeviceObserver> mock_observer;
     NiceMock<mtd::MockInputDevice> device{"device","dev-1", mi::DeviceCapability::unknown};
     NiceMock<mtd::MockInputDevice> another_device{"another_device","dev-2", mi::DeviceCapability::keyboard};
@@ -155,6 +159,26 @@ TEST_F(InputDeviceHubTest, input_device_hub_start_stop_happens_in_order)
     hub.remove_device(mt::fake_shared(third_device));
 }
 
+TEST_F(InputDeviceHubTest, records_latency_of_received_events_for_each_device)
+{
+    using Stage = mi::InputLatencies::Stage;
+    mi::InputSink* sink;
+    mi::EventBuilder* builder;
+    capture_input_sink(another_device, sink, builder);
+
+    hub.add_device(mt::fake_shared(another_device));
+    auto const id = latencies->devices().at(0);
+
+    auto const timestamp = clock->now().time_since_epoch();
+    clock->advance_by(300us);
+    sink->handle_input(builder->key_event(timestamp, mir_keyboard_action_down, 0, KEY_A));
+
+    auto const summary = latencies->summary(id, Stage::received);
+    EXPECT_THAT(summary.count, Eq(1u));
+    EXPECT_THAT(summary.max, Eq(300us));
+    EXPECT_THAT(latencies->to_json(), HasSubstr("\"name\":\"another_device\""));
+}
+
 TEST_F(InputDeviceHubTest, observers_receive_devices_on_add)
 {
     std::shared_ptr<mi::Device> handle_1, handle_2;
@@ -18,6 +18,7 @@
 
 #include "mir/events/event_builders.h"
 #include "mir/events/event_private.h" // only needed to validate motion_up/down mapping
+#include "mir_toolkit/mir_blob.h"
 
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
@@ -283,3 +284,36 @@ TEST_F(InputEventBuilder, when_deserialized_input_device_state_event_has_supplie
         EXPECT_THAT(mir_input_device_state_event_device_pressed_keys_for_index(ids_event, 2, i), Eq(pressed_keys[i]));
     }
 }
+
+TEST_F(InputEventBuilder, storage_of_a_destroyed_event_is_reused)
+{
+    // Holding an event makes sure there is room to keep the next one destroyed
+    auto const held = mev::make_event(device_id, timestamp, cookie, mir_keyboard_action_down, 34, 17, modifiers);
+
+    void const* address;
+    {
+        auto const ev = mev::make_event(device_id, timestamp, cookie, modifiers, mir_pointer_action_motion, 0,
+            1.0f, 2.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+        address = ev.get();
+    }
+
+    auto const ev = mev::make_event(device_id, timestamp, cookie, mir_keyboard_action_down, 34, 17, modifiers);
+
+    EXPECT_THAT(static_cast<void const*>(ev.get()), Eq(address));
+}
+
+TEST_F(InputEventBuilder, clone_of_an_event_larger_than_its_inline_storage_is_complete)
+{
+    std::vector<uint8_t> const handle(4096, 0x5a);
+    auto const ev = mev::make_event(device_id, timestamp, cookie, modifiers, mir_pointer_action_motion, 0,
+        1.0f, 2.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+    mev::set_drag_and_drop_handle(*ev, handle);
+
+    auto const clone = mev::clone_event(*ev);
+
+    auto const blob = mir_event_get_input_event(clone.get())->to_pointer()->dnd_handle();
+    ASSERT_THAT(blob, NotNull());
+    auto const data = static_cast<uint8_t const*>(mir_blob_data(blob));
+    EXPECT_THAT(std::vector<uint8_t>(data, data + mir_blob_size(blob)), Eq(handle));
+    mir_blob_release(blob);
+}
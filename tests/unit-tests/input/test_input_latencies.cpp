@@ -0,0 +1,112 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/input/input_latencies.h"
+#include "mir/events/event_builders.h"
+
+#include "mir/test/doubles/advanceable_clock.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace mi = mir::input;
+namespace mev = mir::events;
+namespace mtd = mir::test::doubles;
+
+using namespace std::chrono;
+using namespace testing;
+using Stage = mi::InputLatencies::Stage;
+
+namespace
+{
+MirInputDeviceId const keyboard{3};
+MirInputDeviceId const mouse{7};
+
+struct InputLatencies : Test
+{
+    auto key_event_at(nanoseconds timestamp) -> mir::EventUPtr
+    {
+        return mev::make_event(
+            keyboard, timestamp, std::vector<uint8_t>{}, mir_keyboard_action_down, 0, 30, mir_input_event_modifier_none);
+    }
+
+    std::shared_ptr<mtd::AdvanceableClock> const clock{std::make_shared<mtd::AdvanceableClock>()};
+    mi::InputLatencies latencies{clock};
+};
+}
+
+TEST_F(InputLatencies, summary_of_unknown_device_is_empty)
+{
+    EXPECT_THAT(latencies.summary(keyboard, Stage::received).count, Eq(0u));
+}
+
+TEST_F(InputLatencies, measures_from_the_event_timestamp)
+{
+    auto const event = key_event_at(clock->now().time_since_epoch());
+    clock->advance_by(microseconds{250});
+
+    latencies.record(mir_event_get_input_event(event.get()), Stage::sent);
+
+    auto const summary = latencies.summary(keyboard, Stage::sent);
+    EXPECT_THAT(summary.count, Eq(1u));
+    EXPECT_THAT(summary.max, Eq(microseconds{250}));
+}
+
+TEST_F(InputLatencies, events_from_the_future_count_as_no_latency)
+{
+    auto const event = key_event_at(clock->now().time_since_epoch() + milliseconds{5});
+
+    latencies.record(mir_event_get_input_event(event.get()), Stage::received);
+
+    EXPECT_THAT(latencies.summary(keyboard, Stage::received).max, Eq(microseconds{0}));
+}
+
+TEST_F(InputLatencies, keeps_devices_and_stages_apart)
+{
+    latencies.add_device(keyboard, "keyboard");
+    latencies.add_device(mouse, "mouse");
+    latencies.record(keyboard, Stage::received, microseconds{10});
+    latencies.record(mouse, Stage::dispatched, microseconds{20});
+
+    EXPECT_THAT(latencies.devices(), ElementsAre(keyboard, mouse));
+    EXPECT_THAT(latencies.summary(keyboard, Stage::received).count, Eq(1u));
+    EXPECT_THAT(latencies.summary(keyboard, Stage::dispatched).count, Eq(0u));
+    EXPECT_THAT(latencies.summary(mouse, Stage::dispatched).max, Eq(microseconds{20}));
+}
+
+TEST_F(InputLatencies, reset_forgets_samples_but_not_devices)
+{
+    latencies.add_device(keyboard, "keyboard");
+    latencies.record(keyboard, Stage::received, microseconds{10});
+
+    latencies.reset();
+
+    EXPECT_THAT(latencies.devices(), ElementsAre(keyboard));
+    EXPECT_THAT(latencies.summary(keyboard, Stage::received).count, Eq(0u));
+}
+
+TEST_F(InputLatencies, json_has_each_devices_name_and_stages)
+{
+    latencies.add_device(keyboard, "AT \"Translated\" Keyboard");
+    latencies.record(keyboard, Stage::sent, microseconds{900});
+
+    auto const json = latencies.to_json();
+
+    EXPECT_THAT(json, StartsWith("{\"devices\":[{\"id\":3,\"name\":\"AT \\\"Translated\\\" Keyboard\","));
+    EXPECT_THAT(json, HasSubstr("\"received\":{\"count\":0,"));
+    EXPECT_THAT(json, HasSubstr("\"sent\":{\"count\":1,\"mean_us\":900,"));
+    EXPECT_THAT(json, EndsWith("}}]}"));
+}
@@ -0,0 +1,238 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/input/motion_coalescing_dispatcher.h"
+
+#include "mir/compositor/frame_clock.h"
+#include "mir/dispatch/multiplexing_dispatchable.h"
+#include "mir/events/event_builders.h"
+#include "mir/geometry/rectangle.h"
+
+#include "mir/test/event_matchers.h"
+#include "mir/test/fd_utils.h"
+#include "mir/test/doubles/mock_input_dispatcher.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <vector>
+
+namespace mc = mir::compositor;
+namespace mi = mir::input;
+namespace md = mir::dispatch;
+namespace mev = mir::events;
+namespace mt = mir::test;
+namespace mtd = mt::doubles;
+namespace geom = mir::geometry;
+
+using namespace std::chrono;
+using namespace testing;
+
+namespace
+{
+struct StubFrameClock : mc::FrameClock
+{
+    void on_next_frame(geom::Rectangle const&, Callback&& callback) override
+    {
+        waiting.push_back(std::move(callback));
+    }
+
+    void present(steady_clock::time_point when)
+    {
+        auto callbacks = std::move(waiting);
+        waiting.clear();
+        for (auto const& callback : callbacks)
+            callback(when);
+    }
+
+    std::vector<Callback> waiting;
+};
+
+MirInputDeviceId const mouse{1};
+steady_clock::time_point const start{seconds{100}};
+
+auto at(milliseconds time) -> nanoseconds
+{
+    return start.time_since_epoch() + time;
+}
+
+auto motion(milliseconds time, float x, float y, float dx, float dy) -> mir::EventUPtr
+{
+    return mev::make_event(
+        mouse, at(time), std::vector<uint8_t>{}, mir_input_event_modifier_none, mir_pointer_action_motion, 0,
+        x, y, 0, 0, dx, dy);
+}
+
+auto button_down(milliseconds time, float x, float y) -> mir::EventUPtr
+{
+    return mev::make_event(
+        mouse, at(time), std::vector<uint8_t>{}, mir_input_event_modifier_none, mir_pointer_action_button_down,
+        mir_pointer_button_primary, x, y, 0, 0, 0, 0);
+}
+
+struct MotionCoalescingDispatcher : Test
+{
+    auto make_dispatcher(bool resample) -> std::shared_ptr<mi::MotionCoalescingDispatcher>
+    {
+        return std::make_shared<mi::MotionCoalescingDispatcher>(next, frame_clock, input_thread, resample);
+    }
+
+    /// Presents a frame, then lets the input thread send what was held for it
+    void present(steady_clock::time_point when)
+    {
+        frame_clock->present(when);
+        run_input_thread();
+    }
+
+    void run_input_thread()
+    {
+        while (mt::fd_is_readable(input_thread->watch_fd()))
+            input_thread->dispatch(md::FdEvent::readable);
+    }
+
+    std::shared_ptr<NiceMock<mtd::MockInputDispatcher>> const next{
+        std::make_shared<NiceMock<mtd::MockInputDispatcher>>()};
+    std::shared_ptr<StubFrameClock> const frame_clock{std::make_shared<StubFrameClock>()};
+    std::shared_ptr<md::MultiplexingDispatchable> const input_thread{std::make_shared<md::MultiplexingDispatchable>()};
+    std::shared_ptr<mi::MotionCoalescingDispatcher> const dispatcher{make_dispatcher(false)};
+};
+}
+
+TEST_F(MotionCoalescingDispatcher, holds_motion_until_the_next_frame_is_presented)
+{
+    EXPECT_CALL(*next, dispatch(_)).Times(0);
+
+    dispatcher->dispatch(motion(1ms, 10, 10, 1, 0));
+    dispatcher->dispatch(motion(2ms, 11, 10, 1, 0));
+
+    Mock::VerifyAndClearExpectations(next.get());
+
+    EXPECT_CALL(*next, dispatch(mt::PointerEventWithPosition(12, 10)));
+    dispatcher->dispatch(motion(3ms, 12, 10, 1, 0));
+    present(start + 4ms);
+}
+
+TEST_F(MotionCoalescingDispatcher, sends_held_motion_from_the_input_thread_rather_than_the_frame_clock)
+{
+    dispatcher->dispatch(motion(1ms, 10, 10, 1, 0));
+
+    EXPECT_CALL(*next, dispatch(_)).Times(0);
+    frame_clock->present(start + 4ms);
+    Mock::VerifyAndClearExpectations(next.get());
+
+    EXPECT_CALL(*next, dispatch(mt::PointerEventWithPosition(10, 10)));
+    run_input_thread();
+}
+
+TEST_F(MotionCoalescingDispatcher, sums_relative_motion)
+{
+    EXPECT_CALL(*next, dispatch(mt::PointerEventWithDiff(3.5f, -2.0f)));
+
+    dispatcher->dispatch(motion(1ms, 10, 10, 1, -1));
+    dispatcher->dispatch(motion(2ms, 11, 9, 2, -1));
+    dispatcher->dispatch(motion(3ms, 11, 9, 0.5f, 0));
+    present(start + 4ms);
+}
+
+TEST_F(MotionCoalescingDispatcher, sends_a_lone_motion_event_as_it_is)
+{
+    std::shared_ptr<MirEvent const> const event{motion(1ms, 10, 10, 1, 0)};
+    EXPECT_CALL(*next, dispatch(Eq(event)));
+
+    dispatcher->dispatch(event);
+    present(start + 4ms);
+}
+
+TEST_F(MotionCoalescingDispatcher, asks_for_one_frame_at_a_time)
+{
+    dispatcher->dispatch(motion(1ms, 10, 10, 1, 0));
+    dispatcher->dispatch(motion(2ms, 11, 10, 1, 0));
+
+    EXPECT_THAT(frame_clock->waiting.size(), Eq(1u));
+
+    present(start + 4ms);
+    dispatcher->dispatch(motion(5ms, 12, 10, 1, 0));
+
+    EXPECT_THAT(frame_clock->waiting.size(), Eq(1u));
+}
+
+TEST_F(MotionCoalescingDispatcher, sends_held_motion_before_a_button_press)
+{
+    InSequence seq;
+    EXPECT_CALL(*next, dispatch(mt::PointerEventWithPosition(11, 10)));
+    EXPECT_CALL(*next, dispatch(mt::ButtonDownEvent(11, 10)));
+
+    dispatcher->dispatch(motion(1ms, 10, 10, 1, 0));
+    dispatcher->dispatch(motion(2ms, 11, 10, 1, 0));
+    dispatcher->dispatch(button_down(3ms, 11, 10));
+}
+
+TEST_F(MotionCoalescingDispatcher, sends_nothing_extra_when_the_frame_comes_after_a_button_press)
+{
+    dispatcher->dispatch(motion(1ms, 10, 10, 1, 0));
+    dispatcher->dispatch(button_down(2ms, 10, 10));
+
+    EXPECT_CALL(*next, dispatch(_)).Times(0);
+    present(start + 4ms);
+}
+
+TEST_F(MotionCoalescingDispatcher, without_resampling_sends_the_latest_position)
+{
+    present(start);
+    dispatcher->dispatch(motion(2ms, 2, 0, 2, 0));
+    dispatcher->dispatch(motion(10ms, 10, 0, 8, 0));
+
+    EXPECT_CALL(*next, dispatch(mt::PointerEventWithPosition(10, 0)));
+    present(start + 16ms);
+}
+
+TEST_F(MotionCoalescingDispatcher, resampling_predicts_the_position_at_the_next_frame_but_not_the_relative_motion)
+{
+    auto const resampling = make_dispatcher(true);
+
+    // Two frames, so the frame period is known
+    resampling->dispatch(motion(0ms, 0, 0, 0, 0));
+    present(start);
+    resampling->dispatch(motion(2ms, 2, 0, 2, 0));
+    resampling->dispatch(motion(10ms, 10, 0, 8, 0));
+
+    // Moving at 1px/ms, and predicted as far ahead as allowed
+    auto const predicted = 10.0f + mi::MotionCoalescingDispatcher::max_prediction.count();
+    EXPECT_CALL(*next, dispatch(AllOf(
+        mt::PointerEventWithPosition(predicted, 0.0f),
+        mt::PointerEventWithDiff(10.0f, 0.0f))));
+    present(start + 16ms);
+}
+
+TEST_F(MotionCoalescingDispatcher, frames_after_the_dispatcher_is_gone_are_harmless)
+{
+    {
+        auto const short_lived = make_dispatcher(false);
+        short_lived->dispatch(motion(1ms, 10, 10, 1, 0));
+    }
+
+    EXPECT_CALL(*next, dispatch(_)).Times(0);
+    present(start + 4ms);
+}
+
+TEST_F(MotionCoalescingDispatcher, stop_discards_held_motion)
+{
+    dispatcher->dispatch(motion(1ms, 10, 10, 1, 0));
+    dispatcher->stop();
+
+    EXPECT_CALL(*next, dispatch(_)).Times(0);
+    present(start + 4ms);
+}
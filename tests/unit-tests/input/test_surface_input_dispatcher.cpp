@@ -17,6 +17,7 @@
  */
 
 #include "src/server/input/surface_input_dispatcher.h"
+#include "mir/input/input_latencies.h"
 
 #include "mir/events/event_builders.h"
 #include "mir/events/event_private.h"
@@ -27,6 +28,7 @@
 #include "mir/test/fake_shared.h"
 #include "mir/test/doubles/stub_input_scene.h"
 #include "mir/test/doubles/mock_surface.h"
+#include "mir/test/doubles/advanceable_clock.h"
 
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
@@ -62,6 +64,11 @@ struct MockSurfaceWithGeometry : public mtd::MockSurface
     {
         return geom;
     }
+
+    geom::Rectangle input_area_bounds() const override
+    {
+        return geom;
+    }
     
     geom::Rectangle const geom;
 };
@@ -120,13 +127,15 @@ struct StubInputScene : public mtd::StubInputScene
 struct SurfaceInputDispatcher : public testing::Test
 {
     SurfaceInputDispatcher()
-        : dispatcher(mt::fake_shared(scene))
+        : dispatcher(mt::fake_shared(scene), latencies)
     {
     }
 
     void TearDown() override { dispatcher.stop(); }
 
     StubInputScene scene;
+    std::shared_ptr<mi::InputLatencies> const latencies{
+        std::make_shared<mi::InputLatencies>(std::make_shared<mtd::AdvanceableClock>())};
     mi::SurfaceInputDispatcher dispatcher;
 };
 
@@ -284,6 +293,22 @@ TEST_F(SurfaceInputDispatcher, key_event_dropped_if_no_surface_focused)
     EXPECT_FALSE(dispatcher.dispatch(keyboard.press()));
 }
 
+TEST_F(SurfaceInputDispatcher, records_latency_of_delivered_events_only)
+{
+    using Stage = mi::InputLatencies::Stage;
+    auto surface = scene.add_surface();
+    FakeKeyboard keyboard{3};
+
+    dispatcher.start();
+
+    dispatcher.dispatch(keyboard.press());
+    EXPECT_THAT(latencies->summary(keyboard.id, Stage::dispatched).count, Eq(0u));
+
+    dispatcher.set_focus(surface);
+    dispatcher.dispatch(keyboard.release());
+    EXPECT_THAT(latencies->summary(keyboard.id, Stage::dispatched).count, Eq(1u));
+}
+
 TEST_F(SurfaceInputDispatcher, pointer_motion_delivered_to_client_under_pointer)
 {
     auto surface = scene.add_surface({{0, 0}, {5, 5}});
@@ -302,6 +327,21 @@ TEST_F(SurfaceInputDispatcher, pointer_motion_delivered_to_client_under_pointer)
     EXPECT_TRUE(dispatcher.dispatch(pointer.move_to({5, 0})));
 }
 
+TEST_F(SurfaceInputDispatcher, pointer_event_delivered_to_surface_at_origin_without_a_copy)
+{
+    auto surface = scene.add_surface({{0, 0}, {5, 5}});
+
+    FakePointer pointer;
+
+    dispatcher.start();
+    EXPECT_TRUE(dispatcher.dispatch(pointer.move_to({1, 0})));
+
+    std::shared_ptr<MirEvent const> const motion{pointer.move_to({2, 0})};
+    EXPECT_CALL(*surface, consume(Eq(motion.get()))).Times(1);
+
+    EXPECT_TRUE(dispatcher.dispatch(motion));
+}
+
 TEST_F(SurfaceInputDispatcher, pointer_delivered_only_to_top_surface)
 {
     auto surface = scene.add_surface({{0, 0}, {5, 5}});
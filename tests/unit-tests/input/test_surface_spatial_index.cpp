@@ -0,0 +1,163 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/input/surface_spatial_index.h"
+
+#include "mir/input/surface.h"
+
+#include <experimental/optional>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace mi = mir::input;
+namespace geom = mir::geometry;
+
+using namespace ::testing;
+
+namespace
+{
+struct StubSurface : mi::Surface
+{
+    explicit StubSurface(geom::Rectangle const& area)
+        : area{area}
+    {
+    }
+
+    std::string name() const override { return {}; }
+    geom::Rectangle input_bounds() const override { return area; }
+    bool input_area_contains(geom::Point const& point) const override
+    {
+        return area.contains(point) && !(hole && hole.value().contains(point));
+    }
+    std::shared_ptr<mir::graphics::CursorImage> cursor_image() const override { return nullptr; }
+    mi::InputReceptionMode reception_mode() const override { return mi::InputReceptionMode::normal; }
+    void consume(MirEvent const*) override {}
+
+    geom::Rectangle area;
+    std::experimental::optional<geom::Rectangle> hole;
+};
+
+struct SurfaceSpatialIndex : Test
+{
+    std::shared_ptr<StubSurface> add_surface(geom::Rectangle const& area)
+    {
+        auto const surface = std::make_shared<StubSurface>(area);
+        stacking_order.push_back(surface);
+        index.rebuild(stacking_order);
+        return surface;
+    }
+
+    int const cell_size{100};
+    mi::SurfaceSpatialIndex index{cell_size};
+    std::vector<std::shared_ptr<mi::Surface>> stacking_order;
+};
+}
+
+TEST_F(SurfaceSpatialIndex, finds_nothing_when_empty)
+{
+    EXPECT_THAT(index.surface_at({10, 10}), IsNull());
+}
+
+TEST_F(SurfaceSpatialIndex, finds_surface_under_point)
+{
+    auto const surface = add_surface({{120, 120}, {50, 50}});
+
+    EXPECT_THAT(index.surface_at({130, 140}), Eq(surface));
+    EXPECT_THAT(index.surface_at({110, 140}), IsNull());
+    EXPECT_THAT(index.surface_at({170, 140}), IsNull());
+}
+
+TEST_F(SurfaceSpatialIndex, finds_top_most_of_overlapping_surfaces)
+{
+    auto const bottom = add_surface({{0, 0}, {300, 300}});
+    auto const top = add_surface({{50, 50}, {300, 300}});
+
+    EXPECT_THAT(index.surface_at({10, 10}), Eq(bottom));
+    EXPECT_THAT(index.surface_at({60, 60}), Eq(top));
+    EXPECT_THAT(index.surface_at({299, 299}), Eq(top));
+}
+
+TEST_F(SurfaceSpatialIndex, looks_through_holes_in_the_input_area)
+{
+    auto const bottom = add_surface({{0, 0}, {300, 300}});
+    auto const top = add_surface({{0, 0}, {300, 300}});
+    top->hole = geom::Rectangle{{100, 100}, {10, 10}};
+
+    EXPECT_THAT(index.surface_at({105, 105}), Eq(bottom));
+    EXPECT_THAT(index.surface_at({115, 115}), Eq(top));
+}
+
+TEST_F(SurfaceSpatialIndex, follows_surface_after_update)
+{
+    auto const surface = add_surface({{0, 0}, {50, 50}});
+
+    surface->area = {{500, 500}, {50, 50}};
+    index.update(surface.get());
+
+    EXPECT_THAT(index.surface_at({10, 10}), IsNull());
+    EXPECT_THAT(index.surface_at({510, 510}), Eq(surface));
+}
+
+TEST_F(SurfaceSpatialIndex, update_keeps_stacking_order)
+{
+    auto const bottom = add_surface({{0, 0}, {50, 50}});
+    auto const top = add_surface({{200, 200}, {50, 50}});
+
+    bottom->area = {{200, 200}, {50, 50}};
+    index.update(bottom.get());
+
+    EXPECT_THAT(index.surface_at({210, 210}), Eq(top));
+}
+
+TEST_F(SurfaceSpatialIndex, forgets_removed_surface)
+{
+    auto const bottom = add_surface({{0, 0}, {50, 50}});
+    auto const top = add_surface({{0, 0}, {50, 50}});
+
+    index.remove(top.get());
+
+    EXPECT_THAT(index.surface_at({10, 10}), Eq(bottom));
+    EXPECT_THAT(index.size(), Eq(1u));
+}
+
+TEST_F(SurfaceSpatialIndex, handles_negative_coordinates)
+{
+    auto const surface = add_surface({{-150, -150}, {100, 100}});
+
+    EXPECT_THAT(index.surface_at({-100, -100}), Eq(surface));
+    EXPECT_THAT(index.surface_at({-40, -40}), IsNull());
+    EXPECT_THAT(index.surface_at({10, 10}), IsNull());
+}
+
+TEST_F(SurfaceSpatialIndex, surfaces_spanning_many_cells_keep_their_stacking_order)
+{
+    int const huge = cell_size * 100;
+    auto const huge_bottom = add_surface({{0, 0}, {huge, huge}});
+    auto const small = add_surface({{10, 10}, {10, 10}});
+    auto const huge_top = add_surface({{huge / 2, huge / 2}, {huge, huge}});
+
+    EXPECT_THAT(index.surface_at({15, 15}), Eq(small));
+    EXPECT_THAT(index.surface_at({25, 25}), Eq(huge_bottom));
+    EXPECT_THAT(index.surface_at({huge - 1, huge - 1}), Eq(huge_top));
+}
+
+TEST_F(SurfaceSpatialIndex, surface_without_input_area_is_never_found)
+{
+    add_surface({{10, 10}, {0, 0}});
+
+    EXPECT_THAT(index.surface_at({10, 10}), IsNull());
+}
@@ -59,6 +59,12 @@ struct MockKMSOutput : public graphics::gbm::KMSOutput
     MOCK_METHOD1(schedule_page_flip_thunk, bool(graphics::gbm::FBHandle const*));
     MOCK_METHOD0(wait_for_page_flip, void());
 
+    bool set_overlays(graphics::gbm::FBHandle const& primary, std::vector<Overlay> const& overlays) override
+    {
+        return set_overlays_thunk(&primary, overlays);
+    }
+    MOCK_METHOD2(set_overlays_thunk, bool(graphics::gbm::FBHandle const*, std::vector<Overlay> const&));
+
     MOCK_CONST_METHOD0(last_frame, graphics::Frame());
 
     MOCK_METHOD1(set_cursor, bool(gbm_bo*));
@@ -0,0 +1,516 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/platforms/gbm-kms/server/kms/atomic_kms_output.h"
+#include "src/platforms/gbm-kms/server/kms/real_kms_output_container.h"
+#include "src/platforms/gbm-kms/server/kms/page_flipper.h"
+#include "mir/graphics/gamma_curves.h"
+
+#include "mir/test/fake_shared.h"
+
+#include "mir/test/doubles/mock_drm.h"
+#include "mir/test/doubles/mock_gbm.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <fcntl.h>
+
+namespace mg = mir::graphics;
+namespace mgg = mir::graphics::gbm;
+namespace geom = mir::geometry;
+namespace mt = mir::test;
+namespace mtd = mir::test::doubles;
+
+using namespace ::testing;
+using namespace std::chrono_literals;
+
+namespace
+{
+/// The (object, property) → value pairs added to an atomic request
+using Request = std::map<std::pair<uint32_t, uint32_t>, uint64_t>;
+
+/**
+ * Backs the DRM property and plane queries AtomicKMSOutput makes, and
+ * records what it adds to each atomic request.
+ */
+class FakeAtomicDRM
+{
+public:
+    static uint32_t constexpr primary_plane_id{40};
+    static uint32_t constexpr cursor_plane_id{41};
+
+    FakeAtomicDRM(uint32_t crtc_id, uint32_t connector_id)
+    {
+        char const* const plane_props[] = {
+            "FB_ID", "CRTC_ID", "SRC_X", "SRC_Y", "SRC_W", "SRC_H", "CRTC_X", "CRTC_Y", "CRTC_W", "CRTC_H"};
+
+        add_object(crtc_id, {{"MODE_ID", 0}, {"ACTIVE", 1}, {"GAMMA_LUT", 0}});
+        add_object(connector_id, {{"CRTC_ID", crtc_id}});
+
+        std::vector<std::pair<char const*, uint64_t>> primary{{"type", DRM_PLANE_TYPE_PRIMARY}};
+        std::vector<std::pair<char const*, uint64_t>> cursor{{"type", DRM_PLANE_TYPE_CURSOR}};
+        for (auto const name : plane_props)
+        {
+            primary.emplace_back(name, 0);
+            cursor.emplace_back(name, 0);
+        }
+        add_object(primary_plane_id, primary);
+        add_object(cursor_plane_id, cursor);
+
+        for (auto const id : {primary_plane_id, cursor_plane_id})
+        {
+            drmModePlane plane;
+            memset(&plane, 0, sizeof plane);
+            plane.plane_id = id;
+            plane.possible_crtcs = 0x1;
+            planes[id] = plane;
+            plane_ids.push_back(id);
+        }
+
+        memset(&plane_resources, 0, sizeof plane_resources);
+        plane_resources.count_planes = plane_ids.size();
+        plane_resources.planes = plane_ids.data();
+    }
+
+    void setup_mock_drm(mtd::MockDRM& mock)
+    {
+        ON_CALL(mock, drmModeObjectGetProperties(_, _, _))
+            .WillByDefault(Invoke(
+                [this](int, uint32_t id, uint32_t) { return &objects.at(id).props; }));
+        ON_CALL(mock, drmModeGetProperty(_, _))
+            .WillByDefault(Invoke(
+                [this](int, uint32_t id) { return &properties.at(id); }));
+        ON_CALL(mock, drmModeGetPlaneResources(_))
+            .WillByDefault(Return(&plane_resources));
+        ON_CALL(mock, drmModeGetPlane(_, _))
+            .WillByDefault(Invoke(
+                [this](int, uint32_t id) { return &planes.at(id); }));
+        ON_CALL(mock, drmModeAtomicAddProperty(_, _, _, _))
+            .WillByDefault(Invoke(
+                [this](drmModeAtomicReqPtr req, uint32_t object_id, uint32_t property_id, uint64_t value)
+                {
+                    std::lock_guard<std::mutex> lock{mutex};
+                    auto& request = requests[req];
+                    request[{object_id, property_id}] = value;
+                    return static_cast<int>(request.size());
+                }));
+    }
+
+    /// Takes what was added to req, so the pointer can be reused by a later request
+    auto take(drmModeAtomicReqPtr req) -> Request
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        auto request = std::move(requests[req]);
+        requests.erase(req);
+        return request;
+    }
+
+    auto value_of(Request const& request, uint32_t object_id, char const* name) const -> std::optional<uint64_t>
+    {
+        auto const found = request.find({object_id, property_ids.at(name)});
+        if (found == request.end())
+            return std::nullopt;
+        return found->second;
+    }
+
+private:
+    struct Object
+    {
+        std::vector<uint32_t> ids;
+        std::vector<uint64_t> values;
+        drmModeObjectProperties props;
+    };
+
+    void add_object(uint32_t id, std::vector<std::pair<char const*, uint64_t>> const& props)
+    {
+        auto& object = objects[id];
+        for (auto const& prop : props)
+        {
+            object.ids.push_back(property_id_for(prop.first));
+            object.values.push_back(prop.second);
+        }
+        object.props.count_props = object.ids.size();
+        object.props.props = object.ids.data();
+        object.props.prop_values = object.values.data();
+    }
+
+    uint32_t property_id_for(std::string const& name)
+    {
+        auto const existing = property_ids.find(name);
+        if (existing != property_ids.end())
+            return existing->second;
+
+        auto const id = next_property_id++;
+        property_ids[name] = id;
+
+        drmModePropertyRes prop;
+        memset(&prop, 0, sizeof prop);
+        prop.prop_id = id;
+        strncpy(prop.name, name.c_str(), sizeof(prop.name) - 1);
+        properties[id] = prop;
+        return id;
+    }
+
+    std::map<uint32_t, Object> objects;
+    std::map<std::string, uint32_t> property_ids;
+    std::map<uint32_t, drmModePropertyRes> properties;
+    uint32_t next_property_id{100};
+
+    std::map<uint32_t, drmModePlane> planes;
+    std::vector<uint32_t> plane_ids;
+    drmModePlaneRes plane_resources;
+
+    std::mutex mutex;
+    std::map<drmModeAtomicReqPtr, Request> requests;
+};
+
+/**
+ * Accepts one atomic commit in flight per CRTC, like the kernel, rejecting
+ * any other until that one has completed.
+ */
+class FakePageFlipper : public mgg::PageFlipper
+{
+public:
+    explicit FakePageFlipper(FakeAtomicDRM& drm)
+        : drm{drm}
+    {
+    }
+
+    bool schedule_flip(uint32_t, uint32_t, uint32_t) override { return true; }
+
+    bool schedule_atomic_flip(uint32_t, drmModeAtomicReq* request, uint32_t) override
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        if (in_flight)
+        {
+            ++rejected;
+            return false;
+        }
+        in_flight = true;
+        commits.push_back(drm.take(request));
+        cv.notify_all();
+        return true;
+    }
+
+    mg::Frame wait_for_flip(uint32_t) override
+    {
+        std::unique_lock<std::mutex> lock{mutex};
+        cv.wait(lock, [this] { return !holding; });
+        in_flight = false;
+        return {};
+    }
+
+    /// Keeps commits in flight until release() is called
+    void hold()
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        holding = true;
+    }
+
+    void release()
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        holding = false;
+        cv.notify_all();
+    }
+
+    bool wait_for_commits(size_t count)
+    {
+        std::unique_lock<std::mutex> lock{mutex};
+        return cv.wait_for(lock, 5s, [&] { return commits.size() >= count; });
+    }
+
+    auto committed() -> std::vector<Request>
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        return commits;
+    }
+
+    int rejections()
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        return rejected;
+    }
+
+private:
+    FakeAtomicDRM& drm;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool in_flight{false};
+    bool holding{false};
+    int rejected{0};
+    std::vector<Request> commits;
+};
+
+class NullPageFlipper : public mgg::PageFlipper
+{
+public:
+    bool schedule_flip(uint32_t,uint32_t,uint32_t) override { return true; }
+    bool schedule_atomic_flip(uint32_t, drmModeAtomicReq*, uint32_t) override { return true; }
+    mg::Frame wait_for_flip(uint32_t) override { return {}; }
+};
+
+class AtomicKMSOutputTest : public ::testing::Test
+{
+public:
+    AtomicKMSOutputTest()
+        : drm_fd{open(drm_device, 0, 0)},
+          fake_drm{crtc_id, connector_id},
+          page_flipper{fake_drm}
+    {
+        fake_drm.setup_mock_drm(mock_drm);
+
+        ON_CALL(mock_gbm, gbm_bo_get_handle(_))
+            .WillByDefault(Return(gbm_bo_handle{0}));
+        ON_CALL(mock_gbm, gbm_bo_get_width(cursor_bo))
+            .WillByDefault(Return(64));
+        ON_CALL(mock_gbm, gbm_bo_get_height(cursor_bo))
+            .WillByDefault(Return(64));
+
+        /* A 1Hz mode gives the next frame half a second to carry cursor
+         * changes left over from the last one, which is plenty for a test
+         * to schedule it.
+         */
+        drmModeModeInfo mode;
+        memset(&mode, 0, sizeof mode);
+        mode.hdisplay = 1920;
+        mode.vdisplay = 1080;
+        mode.vrefresh = 1;
+        modes.push_back(mode);
+
+        mock_drm.reset(drm_device);
+        mock_drm.add_crtc(drm_device, crtc_id, mode);
+        mock_drm.add_encoder(drm_device, encoder_id, crtc_id, 0x1);
+        mock_drm.add_connector(
+            drm_device,
+            connector_id,
+            DRM_MODE_CONNECTOR_HDMIA,
+            DRM_MODE_CONNECTED,
+            encoder_id,
+            modes,
+            possible_encoder_ids,
+            geom::Size{});
+        mock_drm.prepare(drm_device);
+    }
+
+    auto create_output(std::shared_ptr<mgg::PageFlipper> const& flipper) -> std::unique_ptr<mgg::AtomicKMSOutput>
+    {
+        return std::make_unique<mgg::AtomicKMSOutput>(
+            drm_fd,
+            mg::kms::get_connector(drm_fd, connector_id),
+            flipper);
+    }
+
+    auto cursor_position_in(Request const& request) -> std::optional<geom::Point>
+    {
+        auto const x = fake_drm.value_of(request, FakeAtomicDRM::cursor_plane_id, "CRTC_X");
+        auto const y = fake_drm.value_of(request, FakeAtomicDRM::cursor_plane_id, "CRTC_Y");
+        if (!x || !y)
+            return std::nullopt;
+        return geom::Point{static_cast<int>(*x), static_cast<int>(*y)};
+    }
+
+    NiceMock<mtd::MockDRM> mock_drm;
+    NiceMock<mtd::MockGBM> mock_gbm;
+
+    char const* const drm_device = "/dev/dri/card0";
+    int const drm_fd;
+
+    uint32_t const crtc_id{10};
+    uint32_t const encoder_id{20};
+    uint32_t const connector_id{30};
+    std::vector<drmModeModeInfo> modes;
+    std::vector<uint32_t> possible_encoder_ids{encoder_id};
+
+    gbm_bo* const primary_bo{reinterpret_cast<gbm_bo*>(0x123ba)};
+    gbm_bo* const cursor_bo{reinterpret_cast<gbm_bo*>(0x456cd)};
+
+    FakeAtomicDRM fake_drm;
+    FakePageFlipper page_flipper;
+};
+}
+
+TEST_F(AtomicKMSOutputTest, modeset_is_tested_before_it_is_committed)
+{
+    {
+        InSequence s;
+        EXPECT_CALL(mock_drm, drmModeAtomicCommit(
+            drm_fd, _, DRM_MODE_ATOMIC_TEST_ONLY | DRM_MODE_ATOMIC_ALLOW_MODESET, nullptr))
+            .WillOnce(Return(0));
+        EXPECT_CALL(mock_drm, drmModeAtomicCommit(drm_fd, _, DRM_MODE_ATOMIC_ALLOW_MODESET, nullptr))
+            .WillOnce(Return(0));
+    }
+
+    auto const output = create_output(mt::fake_shared(page_flipper));
+    auto const fb = output->fb_for(primary_bo);
+
+    EXPECT_TRUE(output->set_crtc(*fb));
+}
+
+TEST_F(AtomicKMSOutputTest, modeset_failing_its_test_is_not_committed)
+{
+    EXPECT_CALL(mock_drm, drmModeAtomicCommit(
+        drm_fd, _, DRM_MODE_ATOMIC_TEST_ONLY | DRM_MODE_ATOMIC_ALLOW_MODESET, nullptr))
+        .WillOnce(Return(-EINVAL));
+    EXPECT_CALL(mock_drm, drmModeAtomicCommit(drm_fd, _, DRM_MODE_ATOMIC_ALLOW_MODESET, nullptr))
+        .Times(0);
+
+    auto const output = create_output(mt::fake_shared(page_flipper));
+    auto const fb = output->fb_for(primary_bo);
+
+    EXPECT_FALSE(output->set_crtc(*fb));
+}
+
+TEST_F(AtomicKMSOutputTest, outputs_fall_back_to_legacy_kms_when_atomic_cap_is_refused)
+{
+    // MockDRM refuses DRM_CLIENT_CAP_ATOMIC by default
+    EXPECT_CALL(mock_drm, drmSetClientCap(drm_fd, DRM_CLIENT_CAP_ATOMIC, 1));
+
+    NullPageFlipper null_page_flipper;
+    mgg::RealKMSOutputContainer outputs{
+        {drm_fd},
+        [&](int) { return mt::fake_shared(null_page_flipper); }};
+    outputs.update_from_hardware_state();
+
+    int count{0};
+    outputs.for_each_output(
+        [&count](std::shared_ptr<mgg::KMSOutput> const& output)
+        {
+            EXPECT_THAT(std::dynamic_pointer_cast<mgg::AtomicKMSOutput>(output), IsNull());
+            ++count;
+        });
+    EXPECT_THAT(count, Eq(1));
+}
+
+TEST_F(AtomicKMSOutputTest, outputs_use_atomic_kms_when_atomic_cap_is_accepted)
+{
+    ON_CALL(mock_drm, drmSetClientCap(_, _, _))
+        .WillByDefault(Return(0));
+
+    NullPageFlipper null_page_flipper;
+    mgg::RealKMSOutputContainer outputs{
+        {drm_fd},
+        [&](int) { return mt::fake_shared(null_page_flipper); }};
+    outputs.update_from_hardware_state();
+
+    int count{0};
+    outputs.for_each_output(
+        [&count](std::shared_ptr<mgg::KMSOutput> const& output)
+        {
+            EXPECT_THAT(std::dynamic_pointer_cast<mgg::AtomicKMSOutput>(output), NotNull());
+            ++count;
+        });
+    EXPECT_THAT(count, Eq(1));
+}
+
+TEST_F(AtomicKMSOutputTest, idle_cursor_move_is_committed_with_a_completion_event)
+{
+    // Cursor updates go through the page flipper, never as event-less nonblocking commits
+    EXPECT_CALL(mock_drm, drmModeAtomicCommit(_, _, DRM_MODE_ATOMIC_NONBLOCK, _))
+        .Times(0);
+
+    auto const output = create_output(mt::fake_shared(page_flipper));
+    auto const fb = output->fb_for(primary_bo);
+    ASSERT_TRUE(output->set_crtc(*fb));
+
+    ASSERT_TRUE(output->set_cursor(cursor_bo));
+    output->move_cursor({100, 200});
+
+    ASSERT_TRUE(page_flipper.wait_for_commits(2));
+    auto const commits = page_flipper.committed();
+    EXPECT_THAT(cursor_position_in(commits.back()), Eq(geom::Point{100, 200}));
+    EXPECT_THAT(page_flipper.rejections(), Eq(0));
+}
+
+TEST_F(AtomicKMSOutputTest, cursor_and_gamma_changes_are_folded_into_pending_flip)
+{
+    auto const output = create_output(mt::fake_shared(page_flipper));
+    auto const fb = output->fb_for(primary_bo);
+    ASSERT_TRUE(output->set_crtc(*fb));
+    ASSERT_TRUE(output->set_cursor(cursor_bo));
+    ASSERT_TRUE(page_flipper.wait_for_commits(1));
+
+    ASSERT_TRUE(output->schedule_page_flip(*fb));
+
+    // Neither change may be committed on its own while the flip is pending
+    EXPECT_CALL(mock_drm, drmModeAtomicCommit(_, _, _, _))
+        .Times(0);
+
+    output->move_cursor({10, 20});
+    output->set_gamma(mg::GammaCurves{{1, 2}, {3, 4}, {5, 6}});
+
+    output->wait_for_page_flip();
+    ASSERT_TRUE(output->schedule_page_flip(*fb));
+    output->wait_for_page_flip();
+
+    auto const commits = page_flipper.committed();
+    ASSERT_THAT(commits.size(), Eq(3u));
+    EXPECT_THAT(cursor_position_in(commits[2]), Eq(geom::Point{10, 20}));
+    EXPECT_THAT(fake_drm.value_of(commits[2], crtc_id, "GAMMA_LUT"), Ne(std::nullopt));
+    EXPECT_THAT(page_flipper.rejections(), Eq(0));
+}
+
+TEST_F(AtomicKMSOutputTest, cursor_change_no_frame_carries_is_committed_alone)
+{
+    auto const output = create_output(mt::fake_shared(page_flipper));
+    auto const fb = output->fb_for(primary_bo);
+    ASSERT_TRUE(output->set_crtc(*fb));
+    ASSERT_TRUE(output->set_cursor(cursor_bo));
+    ASSERT_TRUE(page_flipper.wait_for_commits(1));
+
+    ASSERT_TRUE(output->schedule_page_flip(*fb));
+    output->move_cursor({10, 20});
+    output->wait_for_page_flip();
+
+    // No frame follows, so the move must go by itself
+    ASSERT_TRUE(page_flipper.wait_for_commits(3));
+    auto const commits = page_flipper.committed();
+    EXPECT_THAT(cursor_position_in(commits[2]), Eq(geom::Point{10, 20}));
+    EXPECT_THAT(fake_drm.value_of(commits[2], FakeAtomicDRM::primary_plane_id, "FB_ID"), Eq(std::nullopt));
+}
+
+TEST_F(AtomicKMSOutputTest, flip_waits_for_cursor_commit_in_flight_instead_of_being_rejected)
+{
+    auto const output = create_output(mt::fake_shared(page_flipper));
+    auto const fb = output->fb_for(primary_bo);
+    ASSERT_TRUE(output->set_crtc(*fb));
+
+    page_flipper.hold();
+    ASSERT_TRUE(output->set_cursor(cursor_bo));
+    ASSERT_TRUE(page_flipper.wait_for_commits(1));
+
+    auto flip = std::async(std::launch::async, [&] { return output->schedule_page_flip(*fb); });
+
+    // The kernel would answer a flip now with EBUSY; it must wait instead
+    EXPECT_THAT(flip.wait_for(100ms), Eq(std::future_status::timeout));
+
+    page_flipper.release();
+
+    EXPECT_TRUE(flip.get());
+    output->wait_for_page_flip();
+
+    EXPECT_THAT(page_flipper.committed().size(), Eq(2u));
+    EXPECT_THAT(page_flipper.rejections(), Eq(0));
+}
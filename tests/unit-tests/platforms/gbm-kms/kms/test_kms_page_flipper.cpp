@@ -103,6 +103,55 @@ TEST_F(KMSPageFlipperTest, double_schedule_flip_throws)
     }, std::logic_error);
 }
 
+TEST_F(KMSPageFlipperTest, schedule_atomic_flip_requests_nonblocking_commit_with_event)
+{
+    using namespace testing;
+
+    uint32_t const crtc_id{10};
+    uint32_t const connector_id{345};
+    auto const request = reinterpret_cast<drmModeAtomicReq*>(0x1234);
+
+    EXPECT_CALL(mock_drm, drmModeAtomicCommit(
+        drm_fd, request, DRM_MODE_ATOMIC_NONBLOCK | DRM_MODE_PAGE_FLIP_EVENT, NotNull()))
+        .WillOnce(Return(0));
+
+    EXPECT_TRUE(page_flipper.schedule_atomic_flip(crtc_id, request, connector_id));
+}
+
+TEST_F(KMSPageFlipperTest, failed_atomic_flip_can_be_rescheduled)
+{
+    using namespace testing;
+
+    uint32_t const crtc_id{10};
+    uint32_t const connector_id{345};
+    auto const request = reinterpret_cast<drmModeAtomicReq*>(0x1234);
+
+    EXPECT_CALL(mock_drm, drmModeAtomicCommit(drm_fd, request, _, _))
+        .WillOnce(Return(-EINVAL))
+        .WillOnce(Return(0));
+
+    EXPECT_FALSE(page_flipper.schedule_atomic_flip(crtc_id, request, connector_id));
+    EXPECT_TRUE(page_flipper.schedule_atomic_flip(crtc_id, request, connector_id));
+}
+
+TEST_F(KMSPageFlipperTest, busy_atomic_flip_fails_without_blocking_retry)
+{
+    using namespace testing;
+
+    uint32_t const crtc_id{10};
+    uint32_t const connector_id{345};
+    auto const request = reinterpret_cast<drmModeAtomicReq*>(0x1234);
+
+    // Only ever committed nonblocking, and just the once
+    EXPECT_CALL(mock_drm, drmModeAtomicCommit(drm_fd, request, _, _))
+        .Times(0);
+    EXPECT_CALL(mock_drm, drmModeAtomicCommit(
+        drm_fd, request, DRM_MODE_ATOMIC_NONBLOCK | DRM_MODE_PAGE_FLIP_EVENT, NotNull()))
+        .WillOnce(Return(-EBUSY));
+
+    EXPECT_FALSE(page_flipper.schedule_atomic_flip(crtc_id, request, connector_id));
+}
+
 TEST_F(KMSPageFlipperTest, wait_for_flip_handles_drm_event)
 {
     using namespace testing;
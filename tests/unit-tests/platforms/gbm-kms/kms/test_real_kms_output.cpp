@@ -46,6 +46,7 @@ class NullPageFlipper : public mgg::PageFlipper
 {
 public:
     bool schedule_flip(uint32_t,uint32_t,uint32_t) override { return true; }
+    bool schedule_atomic_flip(uint32_t, drmModeAtomicReq*, uint32_t) override { return true; }
     mg::Frame wait_for_flip(uint32_t) override { return {}; }
 };
 
@@ -53,6 +54,7 @@ class MockPageFlipper : public mgg::PageFlipper
 {
 public:
     MOCK_METHOD3(schedule_flip, bool(uint32_t,uint32_t,uint32_t));
+    MOCK_METHOD3(schedule_atomic_flip, bool(uint32_t, drmModeAtomicReq*, uint32_t));
     MOCK_METHOD1(wait_for_flip, mg::Frame(uint32_t));
 };
 
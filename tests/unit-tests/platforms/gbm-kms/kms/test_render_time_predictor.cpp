@@ -0,0 +1,107 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/platforms/gbm-kms/server/kms/render_time_predictor.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+using namespace testing;
+using namespace std::chrono_literals;
+namespace mgg = mir::graphics::gbm;
+namespace mt = mir::time;
+
+namespace
+{
+struct RenderTimePredictor : Test
+{
+    std::chrono::nanoseconds const interval{16'666'667ns};
+    mt::PosixTimestamp const first_vblank{CLOCK_MONOTONIC, 1s};
+
+    mgg::RenderTimePredictor predictor{50ms};
+
+    /// Record a frame started offset after previous_vblank which took render_time and hit the next vblank
+    auto frame_on_time(mt::PosixTimestamp const& previous_vblank, std::chrono::nanoseconds offset, std::chrono::nanoseconds render_time)
+        -> mt::PosixTimestamp
+    {
+        auto const started = previous_vblank + offset;
+        auto const vblank = previous_vblank + interval;
+        predictor.record_frame(started, started + render_time, previous_vblank, vblank, interval);
+        return vblank;
+    }
+};
+}
+
+TEST_F(RenderTimePredictor, predicts_initial_value_before_any_frames)
+{
+    EXPECT_THAT(predictor.prediction(), Eq(50ms));
+}
+
+TEST_F(RenderTimePredictor, prediction_covers_slowest_recent_frame)
+{
+    auto vblank = first_vblank;
+    vblank = frame_on_time(vblank, 0ms, 2ms);
+    vblank = frame_on_time(vblank, 0ms, 6ms);
+    vblank = frame_on_time(vblank, 0ms, 3ms);
+
+    EXPECT_THAT(predictor.prediction(), Ge(6ms));
+    EXPECT_THAT(predictor.prediction(), Lt(8ms));
+}
+
+TEST_F(RenderTimePredictor, slow_frames_are_forgotten_eventually)
+{
+    auto vblank = first_vblank;
+    vblank = frame_on_time(vblank, 0ms, 10ms);
+
+    for (int i = 0; i != 100; ++i)
+        vblank = frame_on_time(vblank, 0ms, 2ms);
+
+    EXPECT_THAT(predictor.prediction(), Lt(4ms));
+}
+
+TEST_F(RenderTimePredictor, missed_vblank_raises_prediction_beyond_measured_time)
+{
+    auto vblank = first_vblank;
+    for (int i = 0; i != 10; ++i)
+        vblank = frame_on_time(vblank, 0ms, 2ms);
+
+    auto const before = predictor.prediction();
+
+    // Started late enough to just make the next vblank, but something else held it up by a frame
+    auto const started = vblank + interval - before;
+    predictor.record_frame(started, started + 2ms, vblank, vblank + 2*interval, interval);
+
+    EXPECT_THAT(predictor.prediction(), Gt(before + interval/8));
+}
+
+TEST_F(RenderTimePredictor, delays_start_until_prediction_before_next_vblank)
+{
+    auto vblank = first_vblank;
+    for (int i = 0; i != 10; ++i)
+        vblank = frame_on_time(vblank, 0ms, 4ms);
+
+    auto const now = vblank + 1ms;
+    auto const delay = predictor.delay_before_next_frame(now, vblank, interval);
+
+    EXPECT_THAT(now + delay + predictor.prediction(), Eq(vblank + interval));
+}
+
+TEST_F(RenderTimePredictor, does_not_delay_when_already_late)
+{
+    auto const now = first_vblank + interval;
+
+    EXPECT_THAT(predictor.delay_before_next_frame(now, first_vblank, interval), Eq(0ns));
+}
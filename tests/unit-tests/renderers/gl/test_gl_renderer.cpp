@@ -316,6 +316,48 @@ TEST_F(GLRenderer, dont_set_scissor_test_when_unnecessary)
 }
 
 
+TEST_F(GLRenderer, draws_only_the_visible_parts_of_partly_hidden_renderables)
+{
+    ON_CALL(mock_egl, eglQuerySurface(_,_,EGL_WIDTH,_))
+        .WillByDefault(DoAll(SetArgPointee<3>(3), Return(EGL_TRUE)));
+    ON_CALL(mock_egl, eglQuerySurface(_,_,EGL_HEIGHT,_))
+        .WillByDefault(DoAll(SetArgPointee<3>(4), Return(EGL_TRUE)));
+    EXPECT_CALL(*renderable, transformation()).WillRepeatedly(Return(glm::mat4(1)));
+
+    EXPECT_CALL(mock_gl, glScissor(0, 0, 1, 4));
+    EXPECT_CALL(mock_gl, glScissor(2, 0, 1, 4));
+    EXPECT_CALL(mock_gl, glDrawArrays(_, _, _)).Times(2);
+
+    mrg::Renderer renderer(display_buffer);
+
+    renderer.set_visible_regions({{renderable->id(), {{{1, 2}, {1, 4}}, {{3, 2}, {1, 4}}}}});
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRenderer, draws_the_opaque_part_of_rgba_surfaces_without_blending)
+{
+    ON_CALL(mock_egl, eglQuerySurface(_,_,EGL_WIDTH,_))
+        .WillByDefault(DoAll(SetArgPointee<3>(3), Return(EGL_TRUE)));
+    ON_CALL(mock_egl, eglQuerySurface(_,_,EGL_HEIGHT,_))
+        .WillByDefault(DoAll(SetArgPointee<3>(4), Return(EGL_TRUE)));
+    EXPECT_CALL(*renderable, transformation()).WillRepeatedly(Return(glm::mat4(1)));
+    EXPECT_CALL(*renderable, shaped()).WillRepeatedly(Return(true));
+    EXPECT_CALL(*renderable, opaque_region())
+        .WillRepeatedly(Return(std::vector<mir::geometry::Rectangle>{{{2, 3}, {1, 2}}}));
+
+    EXPECT_CALL(mock_gl, glEnable(_)).Times(AnyNumber());
+    EXPECT_CALL(mock_gl, glScissor(_, _, _, _)).Times(AnyNumber());
+
+    // The opaque interior in one unblended draw, and the four sides around it blended
+    EXPECT_CALL(mock_gl, glScissor(1, 1, 1, 2));
+    EXPECT_CALL(mock_gl, glDisable(GL_BLEND)).Times(1);
+    EXPECT_CALL(mock_gl, glEnable(GL_BLEND)).Times(4);
+    EXPECT_CALL(mock_gl, glDrawArrays(_, _, _)).Times(5);
+
+    mrg::Renderer renderer(display_buffer);
+    renderer.render(renderable_list);
+}
+
 TEST_F(GLRenderer, unchanged_viewport_avoids_gl_calls)
 {
     int const screen_width = 1920;
@@ -1230,6 +1230,33 @@ TEST_F(BasicSurfaceTest, adds_buffer_streams)
 
 }
 
+TEST_F(BasicSurfaceTest, renderables_have_the_opaque_region_of_their_stream_in_screen_coordinates)
+{
+    using namespace testing;
+    ON_CALL(*mock_buffer_stream, stream_size()).WillByDefault(Return(rect.size));
+    ON_CALL(*mock_buffer_stream, opaque_region())
+        .WillByDefault(Return(std::vector<geom::Rectangle>{{{2, 2}, {8, 20}}}));
+
+    auto const renderables = surface.generate_renderables(this);
+
+    ASSERT_THAT(renderables.size(), Eq(1u));
+    EXPECT_THAT(renderables[0]->opaque_region(), ElementsAre(geom::Rectangle{{6, 9}, {8, 13}}));
+}
+
+TEST_F(BasicSurfaceTest, renderables_of_stretched_streams_have_no_opaque_region)
+{
+    using namespace testing;
+    ON_CALL(*mock_buffer_stream, stream_size()).WillByDefault(Return(rect.size));
+    ON_CALL(*mock_buffer_stream, opaque_region())
+        .WillByDefault(Return(std::vector<geom::Rectangle>{{{0, 0}, rect.size}}));
+    surface.set_streams({{mock_buffer_stream, {}, geom::Size{24, 30}}});
+
+    auto const renderables = surface.generate_renderables(this);
+
+    ASSERT_THAT(renderables.size(), Eq(1u));
+    EXPECT_THAT(renderables[0]->opaque_region(), IsEmpty());
+}
+
 TEST_F(BasicSurfaceTest, moving_surface_repositions_all_associated_streams)
 {
     using namespace testing;
@@ -225,3 +225,31 @@ TEST_F(GLPixelBufferTest, returns_data_from_rgba_buffer_texture)
     EXPECT_EQ(width - 1,
               static_cast<uint32_t const*>(data)[width * height - 1]);
 }
+
+TEST_F(GLPixelBufferTest, converts_and_flips_every_pixel_of_rgba_buffer_texture)
+{
+    using namespace testing;
+    uint32_t const width{mock_buffer.size().width.as_uint32_t()};
+    uint32_t const height{mock_buffer.size().height.as_uint32_t()};
+
+    EXPECT_CALL(mock_context, make_current()).Times(AnyNumber());
+    EXPECT_CALL(mock_gl, glGetError())
+        .WillOnce(Return(GL_NO_ERROR))
+        .WillOnce(Return(GL_INVALID_ENUM));
+    EXPECT_CALL(mock_gl, glReadPixels(0, 0, width, height, GL_BGRA_EXT, GL_UNSIGNED_BYTE, _));
+    EXPECT_CALL(mock_gl, glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, _))
+        .WillOnce(FillPixelsRGBA());
+
+    ms::GLPixelBuffer pixels{std::move(context)};
+
+    pixels.fill_from(mock_buffer);
+    auto const data = static_cast<uint32_t const*>(pixels.as_argb_8888());
+
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            ASSERT_THAT(data[y * width + x], Eq((height - y - 1) * width + x)) << "at " << x << ", " << y;
+        }
+    }
+}
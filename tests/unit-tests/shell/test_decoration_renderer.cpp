@@ -0,0 +1,252 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/shell/decoration/renderer.h"
+#include "src/server/shell/decoration/window.h"
+#include "src/server/shell/decoration/input.h"
+#include "src/server/scene/basic_surface.h"
+#include "src/server/report/null_report_factory.h"
+
+#include "mir/test/fake_shared.h"
+#include "mir/test/doubles/mock_buffer_stream.h"
+#include "mir/test/doubles/stub_buffer_allocator.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace ms = mir::scene;
+namespace mg = mir::graphics;
+namespace geom = mir::geometry;
+namespace msd = mir::shell::decoration;
+namespace mt = mir::test;
+namespace mtd = mir::test::doubles;
+
+using namespace testing;
+
+namespace
+{
+/// How glyph pixels were blended before blend() took over, one channel at a time
+auto per_byte_blend(uint32_t dest, uint32_t color, unsigned alpha) -> uint32_t
+{
+    uint32_t result = dest & 0xFF000000;
+    for (int shift = 0; shift < 24; shift += 8)
+    {
+        unsigned const dest_channel = (dest >> shift) & 0xFF;
+        unsigned const color_channel = (color >> shift) & 0xFF;
+        result |= ((dest_channel * (255 - alpha)) / 255 + (color_channel * alpha) / 255) << shift;
+    }
+    return result;
+}
+
+MATCHER_P(EachChannelWithinOneOf, expected, "")
+{
+    for (int shift = 0; shift < 32; shift += 8)
+    {
+        int const channel = (arg >> shift) & 0xFF;
+        int const expected_channel = (expected >> shift) & 0xFF;
+        if (std::abs(channel - expected_channel) > 1)
+            return false;
+    }
+    return true;
+}
+
+struct DecorationBlend : TestWithParam<unsigned>
+{
+};
+
+struct DecorationRenderer : Test
+{
+    DecorationRenderer()
+    {
+        surface.set_focus_state(mir_window_focus_state_focused);
+    }
+
+    void update(msd::ButtonState close_state = msd::ButtonState::Up, bool minimizable = true)
+    {
+        msd::WindowState const window_state{static_geometry, mt::fake_shared(surface)};
+
+        std::vector<msd::ButtonInfo> buttons{
+            {msd::ButtonFunction::Close, close_state, window_state.button_rect(0)},
+            {msd::ButtonFunction::Maximize, msd::ButtonState::Up, window_state.button_rect(1)}};
+        if (minimizable)
+            buttons.push_back({msd::ButtonFunction::Minimize, msd::ButtonState::Up, window_state.button_rect(2)});
+
+        renderer.update_state(window_state, msd::InputState{buttons, {}});
+    }
+
+    auto titlebar() -> std::shared_ptr<mg::Buffer>
+    {
+        auto const buffer = renderer.render_titlebar();
+        EXPECT_TRUE(buffer);
+        return buffer.value_or(nullptr);
+    }
+
+    static auto pixels_of(std::shared_ptr<mg::Buffer> const& buffer) -> std::vector<unsigned char>
+    {
+        return std::dynamic_pointer_cast<mtd::StubBuffer>(buffer)->written_pixels;
+    }
+
+    std::shared_ptr<msd::StaticGeometry const> const static_geometry{
+        std::make_shared<msd::StaticGeometry>(msd::StaticGeometry{
+            geom::Height{24},   // titlebar_height
+            geom::Width{6},     // side_border_width
+            geom::Height{6},    // bottom_border_height
+            geom::Size{16, 16}, // resize_corner_input_size
+            geom::Width{24},    // button_width
+            geom::Width{6},     // padding_between_buttons
+            geom::Height{14},   // title_font_height
+            geom::Point{8, 2},  // title_font_top_left
+            geom::Displacement{5, 5}, // icon_padding
+            geom::Width{1},     // detail_line_width
+        })};
+
+    ms::BasicSurface surface{
+        nullptr,
+        "Decorated window",
+        {{}, {240, 120}},
+        mir_pointer_unconfined,
+        {{std::make_shared<NiceMock<mtd::MockBufferStream>>(), {0, 0}, {}}},
+        {},
+        mir::report::null_scene_report()};
+
+    mtd::StubBufferAllocator buffer_allocator;
+    msd::Renderer renderer{mt::fake_shared(buffer_allocator), static_geometry};
+};
+}
+
+TEST_P(DecorationBlend, matches_per_byte_blend)
+{
+    auto const alpha = GetParam();
+
+    // Every value of every channel, against a different value in each of the others
+    for (uint32_t dest_value = 0; dest_value < 256; dest_value++)
+    {
+        for (uint32_t color_value = 0; color_value < 256; color_value++)
+        {
+            uint32_t const dest = 0x80000000 | dest_value << 16 | (255 - dest_value) << 8 | dest_value / 2;
+            uint32_t const color = 0xFF000000 | (255 - color_value) << 16 | color_value / 3 << 8 | color_value;
+
+            auto const blended = msd::blend(dest, color, alpha);
+            auto const expected = per_byte_blend(dest, color, alpha);
+
+            if (alpha == 0 || alpha == 255)
+                ASSERT_THAT(blended, Eq(expected)) << std::hex << "dest " << dest << ", color " << color;
+            else
+                ASSERT_THAT(blended, EachChannelWithinOneOf(expected)) << std::hex << "dest " << dest << ", color " << color;
+        }
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(DecorationBlend, DecorationBlend, Values(0u, 1u, 128u, 254u, 255u));
+
+TEST_F(DecorationRenderer, cached_glyphs_render_the_same_as_freshly_rasterized_ones)
+{
+    surface.rename("");
+    update();
+    auto const untitled = pixels_of(titlebar());
+
+    surface.rename("Glyph cache");
+    update();
+    auto const rasterized = pixels_of(titlebar());
+
+    if (rasterized == untitled)
+        GTEST_SKIP() << "No font to render titles with";
+
+    // The title is drawn again from scratch, from the glyphs rasterized for it before
+    surface.rename("");
+    update();
+    titlebar();
+    surface.rename("Glyph cache");
+    update();
+    auto const cached = pixels_of(titlebar());
+
+    EXPECT_THAT(cached, Eq(rasterized));
+}
+
+TEST_F(DecorationRenderer, unchanged_titlebar_reuses_its_buffer)
+{
+    update();
+    auto const first = titlebar();
+
+    update();
+    EXPECT_THAT(titlebar(), Eq(first));
+}
+
+TEST_F(DecorationRenderer, returning_to_a_theme_reuses_its_buffer)
+{
+    update();
+    auto const focused = titlebar();
+
+    surface.set_focus_state(mir_window_focus_state_unfocused);
+    update();
+    auto const unfocused = titlebar();
+    EXPECT_THAT(unfocused, Ne(focused));
+
+    surface.set_focus_state(mir_window_focus_state_focused);
+    update();
+    EXPECT_THAT(titlebar(), Eq(focused));
+}
+
+TEST_F(DecorationRenderer, returning_to_a_button_state_reuses_its_buffer)
+{
+    update();
+    auto const normal = titlebar();
+
+    update(msd::ButtonState::Hovered);
+    auto const hovered = titlebar();
+    EXPECT_THAT(hovered, Ne(normal));
+    EXPECT_THAT(pixels_of(hovered), Ne(pixels_of(normal)));
+
+    update(msd::ButtonState::Up);
+    EXPECT_THAT(titlebar(), Eq(normal));
+    update(msd::ButtonState::Hovered);
+    EXPECT_THAT(titlebar(), Eq(hovered));
+}
+
+TEST_F(DecorationRenderer, title_change_drops_cached_buffers)
+{
+    update();
+    auto const before = titlebar();
+
+    surface.rename("Renamed window");
+    update();
+    EXPECT_THAT(titlebar(), Ne(before));
+}
+
+TEST_F(DecorationRenderer, size_change_drops_cached_buffers)
+{
+    update();
+    auto const before = titlebar();
+
+    surface.resize({300, 120});
+    update();
+    auto const after = titlebar();
+    EXPECT_THAT(after, Ne(before));
+    EXPECT_THAT(after->size().width, Eq(geom::Width{300}));
+}
+
+TEST_F(DecorationRenderer, button_layout_change_drops_cached_buffers)
+{
+    update();
+    auto const before = titlebar();
+
+    update(msd::ButtonState::Up, false);
+    EXPECT_THAT(titlebar(), Ne(before));
+
+    // The earlier layout was dropped too, so going back to it draws it again
+    update(msd::ButtonState::Up, true);
+    EXPECT_THAT(titlebar(), Ne(before));
+}
@@ -0,0 +1,186 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/events/event_ring.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <poll.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace mev = mir::events;
+
+using namespace testing;
+
+namespace
+{
+struct EventRing : Test
+{
+    bool push(std::string const& message)
+    {
+        return writer.push(message.size(), [&](void* data) { memcpy(data, message.data(), message.size()); });
+    }
+
+    auto consume() -> std::vector<std::string>
+    {
+        std::vector<std::string> messages;
+        reader.consume(
+            [&](void const* data, size_t size) { messages.emplace_back(static_cast<char const*>(data), size); });
+        return messages;
+    }
+
+    auto signalled() -> bool
+    {
+        pollfd fd{reader.notify_fd(), POLLIN, 0};
+        return poll(&fd, 1, 0) == 1;
+    }
+
+    size_t const capacity{256};
+    mev::EventRing writer{capacity};
+    mev::EventRing reader{writer.shm_fd(), writer.notify_fd()};
+};
+}
+
+TEST_F(EventRing, reader_gets_what_the_writer_pushed_in_order)
+{
+    push("one");
+    push("two");
+    push("three");
+
+    EXPECT_THAT(consume(), ElementsAre("one", "two", "three"));
+    EXPECT_THAT(consume(), IsEmpty());
+}
+
+TEST_F(EventRing, events_are_word_aligned)
+{
+    push("odd");
+    push("sized");
+
+    reader.consume(
+        [](void const* data, size_t)
+        {
+            EXPECT_THAT(reinterpret_cast<uintptr_t>(data) % sizeof(uint64_t), Eq(0u));
+        });
+}
+
+TEST_F(EventRing, writing_into_an_empty_ring_wakes_the_reader)
+{
+    EXPECT_FALSE(signalled());
+
+    push("one");
+
+    EXPECT_TRUE(signalled());
+}
+
+TEST_F(EventRing, consuming_clears_the_wakeup)
+{
+    push("one");
+    consume();
+
+    EXPECT_FALSE(signalled());
+}
+
+TEST_F(EventRing, drops_and_counts_events_that_do_not_fit)
+{
+    std::string const big(100, 'x');
+
+    EXPECT_TRUE(push(big));
+    EXPECT_TRUE(push(big));
+    EXPECT_FALSE(push(big));
+
+    EXPECT_THAT(writer.dropped(), Eq(1u));
+    EXPECT_THAT(reader.dropped(), Eq(1u));
+    EXPECT_THAT(consume(), ElementsAre(big, big));
+}
+
+TEST_F(EventRing, consuming_makes_room)
+{
+    std::string const big(100, 'x');
+    push(big);
+    push(big);
+    consume();
+
+    EXPECT_TRUE(push(big));
+}
+
+TEST_F(EventRing, events_wrap_around_the_end)
+{
+    std::vector<std::string> pushed;
+    std::vector<std::string> consumed;
+
+    for (int i = 0; i != 100; ++i)
+    {
+        auto const message = std::string(i % 37 + 1, 'a' + i % 26);
+        ASSERT_TRUE(push(message));
+        pushed.push_back(message);
+
+        for (auto const& message : consume())
+            consumed.push_back(message);
+    }
+
+    EXPECT_THAT(consumed, Eq(pushed));
+}
+
+TEST_F(EventRing, rejects_an_event_larger_than_the_ring)
+{
+    EXPECT_FALSE(push(std::string(capacity + 1, 'x')));
+    EXPECT_THAT(consume(), IsEmpty());
+}
+
+TEST_F(EventRing, rejects_fds_that_are_not_a_ring)
+{
+    mir::Fd const empty{memfd_create("not-a-ring", MFD_CLOEXEC)};
+
+    EXPECT_THROW((mev::EventRing{empty, writer.notify_fd()}), std::invalid_argument);
+}
+
+TEST_F(EventRing, reader_on_another_thread_sees_every_event_in_order)
+{
+    int const count{100000};
+    std::vector<int> received;
+
+    std::thread reading{[&]
+        {
+            while (received.size() != count)
+            {
+                pollfd fd{reader.notify_fd(), POLLIN, 0};
+                poll(&fd, 1, 1000);
+                reader.consume(
+                    [&](void const* data, size_t) { received.push_back(*static_cast<int const*>(data)); });
+            }
+        }};
+
+    for (int i = 0; i != count;)
+    {
+        if (writer.push(sizeof i, [&](void* data) { memcpy(data, &i, sizeof i); }))
+            ++i;
+        else
+            std::this_thread::yield();
+    }
+
+    reading.join();
+
+    ASSERT_THAT(received.size(), Eq(size_t(count)));
+    for (int i = 0; i != count; ++i)
+        ASSERT_THAT(received[i], Eq(i));
+}
@@ -0,0 +1,117 @@
+/*
+ * Copyright © 2020 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/thread/mpsc_queue.h"
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace mth = mir::thread;
+
+using namespace testing;
+
+TEST(MpscQueue, is_empty_when_created)
+{
+    mth::MpscQueue<int> queue;
+
+    EXPECT_TRUE(queue.empty());
+    EXPECT_FALSE(queue.pop());
+}
+
+TEST(MpscQueue, pops_items_in_the_order_they_were_pushed)
+{
+    mth::MpscQueue<int> queue;
+
+    queue.push(1);
+    queue.push(2);
+    queue.push(3);
+
+    EXPECT_FALSE(queue.empty());
+    EXPECT_THAT(queue.pop().value(), Eq(1));
+    EXPECT_THAT(queue.pop().value(), Eq(2));
+    EXPECT_THAT(queue.pop().value(), Eq(3));
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(MpscQueue, holds_move_only_items)
+{
+    mth::MpscQueue<std::unique_ptr<int>> queue;
+
+    queue.push(std::make_unique<int>(42));
+
+    auto const item = queue.pop();
+    ASSERT_TRUE(item);
+    EXPECT_THAT(*item.value(), Eq(42));
+}
+
+TEST(MpscQueue, destroys_items_left_in_the_queue)
+{
+    auto const item = std::make_shared<int>(0);
+
+    {
+        mth::MpscQueue<std::shared_ptr<int>> queue;
+        queue.push(std::shared_ptr<int>{item});
+        queue.push(std::shared_ptr<int>{item});
+        EXPECT_THAT(item.use_count(), Eq(3));
+    }
+
+    EXPECT_THAT(item.use_count(), Eq(1));
+}
+
+TEST(MpscQueue, keeps_each_producers_order_under_contention)
+{
+    int const producer_count{4};
+    int const items_per_producer{10000};
+
+    mth::MpscQueue<std::pair<int, int>> queue;
+
+    std::vector<std::thread> producers;
+    for (int producer = 0; producer != producer_count; ++producer)
+    {
+        producers.emplace_back(
+            [&queue, producer]
+            {
+                for (int i = 0; i != items_per_producer; ++i)
+                    queue.push({producer, i});
+            });
+    }
+
+    std::vector<int> next_expected(producer_count, 0);
+    int popped{0};
+    while (popped != producer_count * items_per_producer)
+    {
+        if (auto const item = queue.pop())
+        {
+            auto const producer = item.value().first;
+            ASSERT_THAT(item.value().second, Eq(next_expected[producer]));
+            ++next_expected[producer];
+            ++popped;
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    for (auto& producer : producers)
+        producer.join();
+
+    EXPECT_TRUE(queue.empty());
+}